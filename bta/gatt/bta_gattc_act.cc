@@ -657,8 +657,8 @@ void bta_gattc_start_discover(tBTA_GATTC_CLCB* p_clcb,
       bta_gattc_set_discover_st(p_clcb->p_srcb);
 
       bta_gattc_init_cache(p_clcb->p_srcb);
-      p_clcb->status = bta_gattc_discover_pri_service(
-          p_clcb->bta_conn_id, p_clcb->p_srcb, GATT_DISC_SRVC_ALL);
+      p_clcb->status =
+          bta_gattc_discover_db_hash(p_clcb->bta_conn_id, p_clcb->p_srcb);
       if (p_clcb->status != GATT_SUCCESS) {
         LOG(ERROR) << "discovery on server failed";
         bta_gattc_reset_discover_st(p_clcb->p_srcb, p_clcb->status);
@@ -974,8 +974,11 @@ void bta_gattc_op_cmpl(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
 }
 
 /** operation completed */
-void bta_gattc_ignore_op_cmpl(UNUSED_ATTR tBTA_GATTC_CLCB* p_clcb,
+void bta_gattc_ignore_op_cmpl(tBTA_GATTC_CLCB* p_clcb,
                               tBTA_GATTC_DATA* p_data) {
+  /* the Database Hash read issued at the start of discovery */
+  if (bta_gattc_db_hash_read_cmpl(p_clcb, &p_data->op_cmpl)) return;
+
   /* receive op complete when discovery is started, ignore the response,
       and wait for discovery finish and resent */
   VLOG(1) << __func__ << ": op = " << +p_data->hdr.layer_specific;
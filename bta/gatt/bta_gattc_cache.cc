@@ -31,7 +31,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <memory>
 #include <sstream>
+#include <utility>
 
 #include "bt_common.h"
 #include "bta_gattc_int.h"
@@ -41,6 +43,7 @@
 #include "btm_int.h"
 #include "database.h"
 #include "database_builder.h"
+#include "database_hash_cache.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "sdp_api.h"
@@ -52,6 +55,7 @@ using bluetooth::Uuid;
 using gatt::Characteristic;
 using gatt::Database;
 using gatt::DatabaseBuilder;
+using gatt::DatabaseHashCache;
 using gatt::Descriptor;
 using gatt::IncludedService;
 using gatt::Service;
@@ -71,7 +75,8 @@ static void bta_gattc_explore_srvc_finished(uint16_t conn_id,
 #define BTA_GATT_SDP_DB_SIZE 4096
 
 #define GATT_CACHE_PREFIX "/data/misc/bluetooth/gatt_cache_"
-#define GATT_CACHE_VERSION 5
+#define GATT_HASH_CACHE_PREFIX "/data/misc/bluetooth/gatt_hash_"
+#define GATT_HASH_CACHE_MAX_ENTRIES 32
 
 static void bta_gattc_generate_cache_file_name(char* buffer, size_t buffer_len,
                                                const RawAddress& bda) {
@@ -80,6 +85,17 @@ static void bta_gattc_generate_cache_file_name(char* buffer, size_t buffer_len,
            bda.address[4], bda.address[5]);
 }
 
+/* Databases shared between all servers, keyed by their Database Hash */
+static std::unique_ptr<DatabaseHashCache> hash_cache;
+
+static DatabaseHashCache& bta_gattc_hash_cache() {
+  if (!hash_cache) {
+    hash_cache = std::make_unique<DatabaseHashCache>(
+        GATT_HASH_CACHE_PREFIX, GATT_HASH_CACHE_MAX_ENTRIES);
+  }
+  return *hash_cache;
+}
+
 /*****************************************************************************
  *  Constants and data types
  ****************************************************************************/
@@ -117,6 +133,8 @@ static void bta_gattc_display_explore_record(const DatabaseBuilder& database) {
 void bta_gattc_init_cache(tBTA_GATTC_SERV* p_srvc_cb) {
   p_srvc_cb->gatt_database = gatt::Database();
   p_srvc_cb->pending_discovery.Clear();
+  p_srvc_cb->db_hash_read_conn_id = GATT_INVALID_CONN_ID;
+  p_srvc_cb->db_hash_valid = false;
 }
 
 const Service* bta_gattc_find_matching_service(
@@ -144,6 +162,80 @@ tGATT_STATUS bta_gattc_discover_pri_service(uint16_t conn_id,
   return bta_gattc_sdp_service_disc(conn_id, p_server_cb);
 }
 
+/** Start discovery by reading the Database Hash of an LE server, so that a
+ * database discovered on any server with the same hash can be used instead.
+ * Servers that don't expose the hash go through full discovery.
+ *
+ * The read completes as an ordinary read on |conn_id|, so it is only issued
+ * while that connection has no command of its own outstanding; commands sent
+ * later are queued until discovery is done.
+ */
+tGATT_STATUS bta_gattc_discover_db_hash(uint16_t conn_id,
+                                        tBTA_GATTC_SERV* p_server_cb) {
+  tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
+  if (!p_clcb) return GATT_ERROR;
+
+  if (p_clcb->transport == BTA_TRANSPORT_LE && p_clcb->p_q_cmd == NULL) {
+    tGATT_READ_PARAM read_param;
+    memset(&read_param, 0, sizeof(tGATT_READ_PARAM));
+    read_param.char_type.s_handle = 0x0001;
+    read_param.char_type.e_handle = 0xFFFF;
+    read_param.char_type.auth_req = GATT_AUTH_REQ_NONE;
+    read_param.char_type.uuid = Uuid::From16Bit(GATT_UUID_DATABASE_HASH);
+
+    if (GATTC_Read(conn_id, GATT_READ_BY_TYPE, &read_param) == GATT_SUCCESS) {
+      p_server_cb->db_hash_read_conn_id = conn_id;
+      return GATT_SUCCESS;
+    }
+  }
+
+  return bta_gattc_discover_pri_service(conn_id, p_server_cb,
+                                        GATT_DISC_SRVC_ALL);
+}
+
+/** Handle a read completed on |p_clcb| while its server is being discovered.
+ * If it is the Database Hash read, either reuse a database with the same hash
+ * or fall back to full discovery, and return true. Reads of other connections
+ * to the server return false. */
+bool bta_gattc_db_hash_read_cmpl(tBTA_GATTC_CLCB* p_clcb,
+                                 tBTA_GATTC_OP_CMPL* p_data) {
+  tBTA_GATTC_SERV* p_srcb = p_clcb->p_srcb;
+  if (p_data->op_code != GATTC_OPTYPE_READ ||
+      p_srcb->db_hash_read_conn_id == GATT_INVALID_CONN_ID ||
+      p_srcb->db_hash_read_conn_id != p_clcb->bta_conn_id) {
+    return false;
+  }
+  p_srcb->db_hash_read_conn_id = GATT_INVALID_CONN_ID;
+
+  if (p_data->status == GATT_SUCCESS && p_data->p_cmpl &&
+      p_data->p_cmpl->att_value.len == p_srcb->db_hash.size()) {
+    memcpy(p_srcb->db_hash.data(), p_data->p_cmpl->att_value.value,
+           p_srcb->db_hash.size());
+    p_srcb->db_hash_valid = true;
+
+    if (bta_gattc_hash_cache().Load(p_srcb->db_hash, &p_srcb->gatt_database)) {
+      LOG(INFO) << __func__ << ": database hash "
+                << DatabaseHashCache::HashToString(p_srcb->db_hash)
+                << " known, skipping discovery";
+      p_srcb->state = BTA_GATTC_SERV_SAVE;
+      if (btm_sec_is_a_bonded_dev(p_srcb->server_bda)) {
+        bta_gattc_cache_write(p_srcb->server_bda,
+                              p_srcb->gatt_database.Serialize());
+      }
+      bta_gattc_reset_discover_st(p_srcb, GATT_SUCCESS);
+      return true;
+    }
+  }
+
+  p_clcb->status = bta_gattc_discover_pri_service(p_clcb->bta_conn_id, p_srcb,
+                                                  GATT_DISC_SRVC_ALL);
+  if (p_clcb->status != GATT_SUCCESS) {
+    LOG(ERROR) << "discovery on server failed";
+    bta_gattc_reset_discover_st(p_srcb, p_clcb->status);
+  }
+  return true;
+}
+
 /** start exploring next service, or finish discovery if no more services left
  */
 static void bta_gattc_explore_next_service(uint16_t conn_id,
@@ -190,6 +282,11 @@ static void bta_gattc_explore_srvc_finished(uint16_t conn_id,
                           p_clcb->p_srcb->gatt_database.Serialize());
   }
 
+  /* other servers with the same database can skip discovery from now on */
+  if (p_srvc_cb->db_hash_valid) {
+    bta_gattc_hash_cache().Store(p_srvc_cb->db_hash, p_srvc_cb->gatt_database);
+  }
+
   bta_gattc_reset_discover_st(p_clcb->p_srcb, GATT_SUCCESS);
 }
 
@@ -712,46 +809,9 @@ bool bta_gattc_cache_load(tBTA_GATTC_SERV* p_srcb) {
   char fname[255] = {0};
   bta_gattc_generate_cache_file_name(fname, sizeof(fname), p_srcb->server_bda);
 
-  FILE* fd = fopen(fname, "rb");
-  if (!fd) {
-    LOG(ERROR) << __func__ << ": can't open GATT cache file " << fname
-               << " for reading, error: " << strerror(errno);
-    return false;
-  }
-
-  uint16_t cache_ver = 0;
   bool success = false;
-  uint16_t num_attr = 0;
-
-  if (fread(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__ << ": can't read GATT cache version from: " << fname;
-    goto done;
-  }
-
-  if (cache_ver != GATT_CACHE_VERSION) {
-    LOG(ERROR) << __func__ << ": wrong GATT cache version: " << fname;
-    goto done;
-  }
-
-  if (fread(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__
-               << ": can't read number of GATT attributes: " << fname;
-    goto done;
-  }
-
-  {
-    std::vector<StoredAttribute> attr(num_attr);
-
-    if (fread(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
-      LOG(ERROR) << __func__ << "s: can't read GATT attributes: " << fname;
-      goto done;
-    }
-
-    p_srcb->gatt_database = gatt::Database::Deserialize(attr, &success);
-  }
-
-done:
-  fclose(fd);
+  Database database = gatt::LoadDatabaseFile(fname, &success);
+  if (success) p_srcb->gatt_database = std::move(database);
   return success;
 }
 
@@ -772,35 +832,7 @@ static void bta_gattc_cache_write(const RawAddress& server_bda,
   char fname[255] = {0};
   bta_gattc_generate_cache_file_name(fname, sizeof(fname), server_bda);
 
-  FILE* fd = fopen(fname, "wb");
-  if (!fd) {
-    LOG(ERROR) << __func__
-               << ": can't open GATT cache file for writing: " << fname;
-    return;
-  }
-
-  uint16_t cache_ver = GATT_CACHE_VERSION;
-  if (fwrite(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__ << ": can't write GATT cache version: " << fname;
-    fclose(fd);
-    return;
-  }
-
-  uint16_t num_attr = attr.size();
-  if (fwrite(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__
-               << ": can't write GATT cache attribute count: " << fname;
-    fclose(fd);
-    return;
-  }
-
-  if (fwrite(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
-    LOG(ERROR) << __func__ << ": can't write GATT cache attributes: " << fname;
-    fclose(fd);
-    return;
-  }
-
-  fclose(fd);
+  gatt::StoreDatabaseFile(fname, attr);
 }
 
 /*******************************************************************************
@@ -217,6 +217,12 @@ typedef struct {
   uint16_t attr_index;  /* cahce NV saving/loading attribute index */
 
   uint16_t mtu;
+
+  /* connection that read the Database Hash to start discovery, or
+   * GATT_INVALID_CONN_ID if no read is pending */
+  uint16_t db_hash_read_conn_id;
+  bool db_hash_valid;        /* db_hash was read from the server */
+  Octet16 db_hash;
 } tBTA_GATTC_SERV;
 
 #ifndef BTA_GATTC_NOTIF_REG_MAX
@@ -424,6 +430,10 @@ extern void bta_gattc_disc_cmpl_cback(uint16_t conn_id,
 extern tGATT_STATUS bta_gattc_discover_pri_service(uint16_t conn_id,
                                                    tBTA_GATTC_SERV* p_server_cb,
                                                    uint8_t disc_type);
+extern tGATT_STATUS bta_gattc_discover_db_hash(uint16_t conn_id,
+                                               tBTA_GATTC_SERV* p_server_cb);
+extern bool bta_gattc_db_hash_read_cmpl(tBTA_GATTC_CLCB* p_clcb,
+                                        tBTA_GATTC_OP_CMPL* p_data);
 extern void bta_gattc_search_service(tBTA_GATTC_CLCB* p_clcb,
                                      bluetooth::Uuid* p_uuid);
 extern const std::list<gatt::Service>* bta_gattc_get_services(uint16_t conn_id);
@@ -0,0 +1,235 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "database_hash_cache.h"
+
+#include <base/logging.h>
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <algorithm>
+#include <utility>
+
+namespace gatt {
+
+namespace {
+constexpr uint16_t DATABASE_FILE_VERSION = 5;
+
+bool IsHashKey(const std::string& key) {
+  if (key.size() != 2 * sizeof(DatabaseHashCache::Hash)) return false;
+  return std::all_of(key.begin(), key.end(), [](char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+  });
+}
+}  // namespace
+
+Database LoadDatabaseFile(const std::string& path, bool* success) {
+  *success = false;
+
+  FILE* fd = fopen(path.c_str(), "rb");
+  if (!fd) {
+    LOG(ERROR) << __func__ << ": can't open GATT cache file " << path
+               << " for reading, error: " << strerror(errno);
+    return Database();
+  }
+
+  Database database;
+  uint16_t cache_ver = 0;
+  uint16_t num_attr = 0;
+
+  if (fread(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
+    LOG(ERROR) << __func__ << ": can't read GATT cache version from: " << path;
+  } else if (cache_ver != DATABASE_FILE_VERSION) {
+    LOG(ERROR) << __func__ << ": wrong GATT cache version: " << path;
+  } else if (fread(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
+    LOG(ERROR) << __func__
+               << ": can't read number of GATT attributes: " << path;
+  } else {
+    std::vector<StoredAttribute> attr(num_attr);
+    if (fread(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
+      LOG(ERROR) << __func__ << ": can't read GATT attributes: " << path;
+    } else {
+      database = Database::Deserialize(attr, success);
+    }
+  }
+
+  fclose(fd);
+  return database;
+}
+
+bool StoreDatabaseFile(const std::string& path,
+                       const std::vector<StoredAttribute>& attr) {
+  FILE* fd = fopen(path.c_str(), "wb");
+  if (!fd) {
+    LOG(ERROR) << __func__
+               << ": can't open GATT cache file for writing: " << path;
+    return false;
+  }
+
+  bool success = false;
+  uint16_t cache_ver = DATABASE_FILE_VERSION;
+  uint16_t num_attr = attr.size();
+
+  if (fwrite(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
+    LOG(ERROR) << __func__ << ": can't write GATT cache version: " << path;
+  } else if (fwrite(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
+    LOG(ERROR) << __func__
+               << ": can't write GATT cache attribute count: " << path;
+  } else if (fwrite(attr.data(), sizeof(StoredAttribute), num_attr, fd) !=
+             num_attr) {
+    LOG(ERROR) << __func__ << ": can't write GATT cache attributes: " << path;
+  } else {
+    success = true;
+  }
+
+  fclose(fd);
+  return success;
+}
+
+DatabaseHashCache::DatabaseHashCache(std::string prefix, size_t max_entries)
+    : prefix_(std::move(prefix)),
+      max_entries_(max_entries),
+      index_loaded_(false) {}
+
+bool DatabaseHashCache::Load(const Hash& hash, Database* database) {
+  LoadIndex();
+
+  std::string key = HashToString(hash);
+  if (entries_.find(key) == entries_.end()) return false;
+
+  bool success = false;
+  Database loaded = LoadDatabaseFile(PathFor(key), &success);
+  if (!success) {
+    LOG(ERROR) << __func__ << ": dropping unreadable database " << key;
+    Remove(hash);
+    return false;
+  }
+
+  Touch(key);
+  *database = std::move(loaded);
+  return true;
+}
+
+bool DatabaseHashCache::Store(const Hash& hash, const Database& database) {
+  LoadIndex();
+
+  std::string key = HashToString(hash);
+  if (!StoreDatabaseFile(PathFor(key), database.Serialize())) {
+    Remove(hash);
+    return false;
+  }
+
+  Touch(key);
+  EvictIfNeeded();
+  return true;
+}
+
+void DatabaseHashCache::Remove(const Hash& hash) {
+  LoadIndex();
+
+  std::string key = HashToString(hash);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    lru_.erase(it->second);
+    entries_.erase(it);
+  }
+  unlink(PathFor(key).c_str());
+}
+
+size_t DatabaseHashCache::Size() {
+  LoadIndex();
+  return lru_.size();
+}
+
+std::string DatabaseHashCache::HashToString(const Hash& hash) {
+  static const char hex[] = "0123456789abcdef";
+  std::string key;
+  key.reserve(2 * hash.size());
+  for (uint8_t octet : hash) {
+    key.push_back(hex[octet >> 4]);
+    key.push_back(hex[octet & 0x0f]);
+  }
+  return key;
+}
+
+void DatabaseHashCache::LoadIndex() {
+  if (index_loaded_) return;
+  index_loaded_ = true;
+
+  size_t separator = prefix_.rfind('/');
+  std::string directory =
+      separator == std::string::npos ? "." : prefix_.substr(0, separator);
+  std::string name_prefix =
+      separator == std::string::npos ? prefix_ : prefix_.substr(separator + 1);
+
+  DIR* dir = opendir(directory.c_str());
+  if (!dir) return;
+
+  std::vector<std::pair<time_t, std::string>> found;
+  while (struct dirent* entry = readdir(dir)) {
+    std::string name(entry->d_name);
+    if (name.compare(0, name_prefix.size(), name_prefix) != 0) continue;
+
+    std::string key = name.substr(name_prefix.size());
+    if (!IsHashKey(key)) continue;
+
+    struct stat st;
+    if (stat(PathFor(key).c_str(), &st) != 0) continue;
+    found.emplace_back(st.st_mtime, key);
+  }
+  closedir(dir);
+
+  /* access time is kept in the file modification time, oldest first */
+  std::sort(found.begin(), found.end());
+  for (const auto& entry : found) {
+    lru_.push_front(entry.second);
+    entries_[entry.second] = lru_.begin();
+  }
+
+  EvictIfNeeded();
+}
+
+void DatabaseHashCache::Touch(const std::string& key) {
+  auto it = entries_.find(key);
+  if (it != entries_.end()) lru_.erase(it->second);
+  lru_.push_front(key);
+  entries_[key] = lru_.begin();
+
+  /* persist the access order for the next LoadIndex */
+  utime(PathFor(key).c_str(), nullptr);
+}
+
+void DatabaseHashCache::EvictIfNeeded() {
+  while (lru_.size() > max_entries_) {
+    const std::string& key = lru_.back();
+    VLOG(1) << __func__ << ": evicting GATT database " << key;
+    unlink(PathFor(key).c_str());
+    entries_.erase(key);
+    lru_.pop_back();
+  }
+}
+
+std::string DatabaseHashCache::PathFor(const std::string& key) const {
+  return prefix_ + key;
+}
+
+}  // namespace gatt
@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "database.h"
+
+namespace gatt {
+
+/* Read a database stored with StoreDatabaseFile from |path|. Returns an empty
+ * database and sets |success| to false if the file is missing or corrupt. */
+Database LoadDatabaseFile(const std::string& path, bool* success);
+
+/* Write |attr| to |path| in the on-disk GATT cache format. */
+bool StoreDatabaseFile(const std::string& path,
+                       const std::vector<StoredAttribute>& attr);
+
+/* Content addressed store of GATT databases, keyed by the value of the
+ * server's Database Hash characteristic (Core 5.1, Vol 3, Part G, 7.3).
+ *
+ * The hash only depends on the attribute layout of the server, so a database
+ * discovered on one peer can be reused for any other peer that reports the
+ * same hash, no matter which address it uses. Each database is kept in its own
+ * file named |prefix| followed by the hash in hex. Once more than
+ * |max_entries| databases are stored, the least recently used one is removed.
+ *
+ * Not thread safe, all calls are expected to come from the BTA thread. */
+class DatabaseHashCache {
+ public:
+  using Hash = std::array<uint8_t, 16>;
+
+  DatabaseHashCache(std::string prefix, size_t max_entries);
+
+  /* Fill |database| with the database stored for |hash|, and mark it as most
+   * recently used. Returns false, leaving |database| untouched, on a miss. */
+  bool Load(const Hash& hash, Database* database);
+
+  /* Store |database| for |hash|, evicting least recently used entries if the
+   * store is full. */
+  bool Store(const Hash& hash, const Database& database);
+
+  /* Drop the database stored for |hash|, if any. */
+  void Remove(const Hash& hash);
+
+  /* Number of databases currently stored. */
+  size_t Size();
+
+  static std::string HashToString(const Hash& hash);
+
+ private:
+  /* Pick up databases stored by a previous instance, oldest first. */
+  void LoadIndex();
+  void Touch(const std::string& key);
+  void EvictIfNeeded();
+  std::string PathFor(const std::string& key) const;
+
+  const std::string prefix_;
+  const size_t max_entries_;
+  bool index_loaded_;
+
+  /* keys of stored databases, most recently used first */
+  std::list<std::string> lru_;
+  std::unordered_map<std::string, std::list<std::string>::iterator> entries_;
+};
+
+}  // namespace gatt
@@ -1163,8 +1163,8 @@ class HearingAidImpl : public HearingAid {
       return;
     }
 
-    std::vector<uint16_t> chan_left;
-    std::vector<uint16_t> chan_right;
+    chan_left.clear();
+    chan_right.clear();
     if (left == nullptr || right == nullptr) {
       for (int i = 0; i < num_samples; i++) {
         const uint8_t* sample = data.data() + i * 4;
@@ -1195,19 +1195,32 @@ class HearingAidImpl : public HearingAid {
 
     // divide encoded data into packets, add header, send.
 
-    // TODO: make those buffers static and global to prevent constant
-    // reallocations
-    // TODO: this should basically fit the encoded data, tune the size later
-    std::vector<uint8_t> encoded_data_left;
-    if (left) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
-      encoded_data_left.resize(4000);
+    // G.722 encodes the samples into at most one byte each. The buffers keep
+    // their capacity between the frames.
+    encoded_data_left.clear();
+    encoded_data_right.clear();
+    if (left) encoded_data_left.resize(chan_left.size());
+    if (right) encoded_data_right.resize(chan_right.size());
+    if (left && right) {
+      int encoded_size = g722_encode_stereo(
+          encoder_state_left, encoder_state_right, encoded_data_left.data(),
+          encoded_data_right.data(), (const int16_t*)chan_left.data(),
+          (const int16_t*)chan_right.data(), chan_left.size());
+      encoded_data_left.resize(encoded_size);
+      encoded_data_right.resize(encoded_size);
+    } else if (left) {
       int encoded_size =
           g722_encode(encoder_state_left, encoded_data_left.data(),
                       (const int16_t*)chan_left.data(), chan_left.size());
       encoded_data_left.resize(encoded_size);
+    } else {
+      int encoded_size =
+          g722_encode(encoder_state_right, encoded_data_right.data(),
+                      (const int16_t*)chan_right.data(), chan_right.size());
+      encoded_data_right.resize(encoded_size);
+    }
 
+    if (left) {
       uint16_t cid = GAP_ConnGetL2CAPCid(left->gap_handle);
       uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
       if (packets_to_flush) {
@@ -1222,16 +1235,7 @@ class HearingAidImpl : public HearingAid {
       check_and_do_rssi_read(left);
     }
 
-    std::vector<uint8_t> encoded_data_right;
     if (right) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
-      encoded_data_right.resize(4000);
-      int encoded_size =
-          g722_encode(encoder_state_right, encoded_data_right.data(),
-                      (const int16_t*)chan_right.data(), chan_right.size());
-      encoded_data_right.resize(encoded_size);
-
       uint16_t cid = GAP_ConnGetL2CAPCid(right->gap_handle);
       uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
       if (packets_to_flush) {
@@ -1594,6 +1598,13 @@ class HearingAidImpl : public HearingAid {
 
   HearingDevices hearingDevices;
 
+  /* audio samples of each side, and their encoded data, reused between the
+   * frames */
+  std::vector<uint16_t> chan_left;
+  std::vector<uint16_t> chan_right;
+  std::vector<uint8_t> encoded_data_left;
+  std::vector<uint8_t> encoded_data_right;
+
   void find_server_changed_ccc_handle(uint16_t conn_id,
                                       const gatt::Service* service) {
     HearingDevice* hearingDevice = hearingDevices.FindByConnId(conn_id);
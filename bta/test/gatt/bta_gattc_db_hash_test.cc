@@ -0,0 +1,449 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <base/logging.h>
+#include <gtest/gtest.h>
+
+#include <dirent.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <deque>
+#include <functional>
+#include <string>
+
+#include "bta/gatt/bta_gattc_cache.cc"
+
+namespace {
+
+constexpr uint16_t CONN_ID = 0x0005;
+constexpr uint16_t OTHER_CONN_ID = 0x0006;
+constexpr uint16_t DATABASE_HASH_HANDLE = 0x0010;
+
+const DatabaseHashCache::Hash HASH = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+                                      0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c,
+                                      0x0d, 0x0e, 0x0f, 0x10};
+
+const DatabaseHashCache::Hash OTHER_HASH = {0xa0};
+
+const RawAddress SERVER_1({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress SERVER_2({0x66, 0x55, 0x44, 0x33, 0x22, 0x11});
+
+/* Database of the remote devices used in the tests */
+Database SampleDatabase() {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x0005, Uuid::From16Bit(0x1800), true);
+  builder.AddService(0x0006, 0x000b, Uuid::From16Bit(0x180f), true);
+  builder.AddService(0x000c, 0x0010, Uuid::From16Bit(0x1801), true);
+  builder.AddCharacteristic(0x0002, 0x0003, Uuid::From16Bit(0x2a00), 0x02);
+  builder.AddCharacteristic(0x0004, 0x0005, Uuid::From16Bit(0x2a01), 0x02);
+  builder.AddIncludedService(0x0007, Uuid::From16Bit(0x1800), 0x0001, 0x0005);
+  builder.AddCharacteristic(0x0008, 0x0009, Uuid::From16Bit(0x2a19), 0x12);
+  builder.AddDescriptor(0x000a, Uuid::From16Bit(0x2902));
+  builder.AddDescriptor(0x000b, Uuid::From16Bit(0x2904));
+  builder.AddCharacteristic(0x000d, 0x000e, Uuid::From16Bit(0x2a05), 0x20);
+  builder.AddDescriptor(0x000f, Uuid::From16Bit(0x2902));
+  builder.AddCharacteristic(0x0010, DATABASE_HASH_HANDLE,
+                            Uuid::From16Bit(GATT_UUID_DATABASE_HASH), 0x02);
+  return builder.Build();
+}
+
+/* Remote GATT server answering the requests bta_gattc_cache.cc sends through
+ * GATTC_Read and GATTC_Discover. Every request is one ATT round trip, its
+ * response is delivered from Run() like the GATT stack would from the BTU
+ * thread. */
+struct FakeServer {
+  Database database;
+  bool has_hash;
+  DatabaseHashCache::Hash hash;
+  int round_trips;
+  int discoveries;
+  std::deque<std::function<void()>> responses;
+
+  void Run() {
+    while (!responses.empty()) {
+      auto response = std::move(responses.front());
+      responses.pop_front();
+      response();
+    }
+  }
+};
+
+FakeServer fake_server;
+tBTA_GATTC_SERV srcb;
+tBTA_GATTC_CLCB clcb;
+
+bool discovery_done;
+tGATT_STATUS discovery_status;
+
+void SendDiscoveryResults(tGATT_DISC_TYPE disc_type, uint16_t start_handle,
+                          uint16_t end_handle) {
+  for (const Service& service : fake_server.database.Services()) {
+    tGATT_DISC_RES result;
+    if (disc_type == GATT_DISC_SRVC_ALL) {
+      result.handle = service.handle;
+      result.value.group_value.e_handle = service.end_handle;
+      result.value.group_value.service_type = service.uuid;
+      bta_gattc_disc_res_cback(CONN_ID, disc_type, &result);
+      continue;
+    }
+
+    for (const IncludedService& is : service.included_services) {
+      if (disc_type != GATT_DISC_INC_SRVC || is.handle < start_handle ||
+          is.handle > end_handle)
+        continue;
+      result.handle = is.handle;
+      result.value.incl_service.service_type = is.uuid;
+      result.value.incl_service.s_handle = is.start_handle;
+      result.value.incl_service.e_handle = is.end_handle;
+      bta_gattc_disc_res_cback(CONN_ID, disc_type, &result);
+    }
+
+    for (const Characteristic& c : service.characteristics) {
+      if (disc_type == GATT_DISC_CHAR && c.declaration_handle >= start_handle &&
+          c.declaration_handle <= end_handle) {
+        result.handle = c.declaration_handle;
+        result.value.dclr_value.val_handle = c.value_handle;
+        result.value.dclr_value.char_uuid = c.uuid;
+        result.value.dclr_value.char_prop = c.properties;
+        bta_gattc_disc_res_cback(CONN_ID, disc_type, &result);
+      }
+
+      for (const Descriptor& d : c.descriptors) {
+        if (disc_type != GATT_DISC_CHAR_DSCPT || d.handle < start_handle ||
+            d.handle > end_handle)
+          continue;
+        result.handle = d.handle;
+        result.type = d.uuid;
+        bta_gattc_disc_res_cback(CONN_ID, disc_type, &result);
+      }
+    }
+  }
+
+  bta_gattc_disc_cmpl_cback(CONN_ID, disc_type, GATT_SUCCESS);
+}
+
+/* Complete a read of |len| bytes of |value| on |p_clcb| the way
+ * bta_gattc_ignore_op_cmpl sees it during discovery */
+bool ReadCmpl(tBTA_GATTC_CLCB* p_clcb, tGATT_STATUS status, uint16_t handle,
+              const uint8_t* value, uint16_t len) {
+  tBTA_GATTC_CMPL cmpl;
+  memset(&cmpl, 0, sizeof(cmpl));
+  cmpl.att_value.conn_id = p_clcb->bta_conn_id;
+  cmpl.att_value.handle = handle;
+  cmpl.att_value.len = len;
+  memcpy(cmpl.att_value.value, value, len);
+
+  tBTA_GATTC_OP_CMPL op_cmpl;
+  memset(&op_cmpl, 0, sizeof(op_cmpl));
+  op_cmpl.op_code = GATTC_OPTYPE_READ;
+  op_cmpl.status = status;
+  op_cmpl.p_cmpl = &cmpl;
+
+  return bta_gattc_db_hash_read_cmpl(p_clcb, &op_cmpl);
+}
+
+void SendDatabaseHash() {
+  bool handled;
+  if (fake_server.has_hash) {
+    handled = ReadCmpl(&clcb, GATT_SUCCESS, DATABASE_HASH_HANDLE,
+                       fake_server.hash.data(), fake_server.hash.size());
+  } else {
+    handled = ReadCmpl(&clcb, GATT_NOT_FOUND, 0, nullptr, 0);
+  }
+  EXPECT_TRUE(handled);
+}
+
+}  // namespace
+
+tGATT_STATUS GATTC_Read(uint16_t conn_id, tGATT_READ_TYPE type,
+                        tGATT_READ_PARAM* p_read) {
+  EXPECT_EQ(CONN_ID, conn_id);
+  EXPECT_EQ(GATT_READ_BY_TYPE, type);
+  EXPECT_EQ(Uuid::From16Bit(GATT_UUID_DATABASE_HASH), p_read->char_type.uuid);
+
+  fake_server.round_trips++;
+  fake_server.responses.push_back(SendDatabaseHash);
+  return GATT_SUCCESS;
+}
+
+tGATT_STATUS GATTC_Discover(uint16_t conn_id, tGATT_DISC_TYPE disc_type,
+                            uint16_t start_handle, uint16_t end_handle) {
+  EXPECT_EQ(CONN_ID, conn_id);
+
+  fake_server.round_trips++;
+  fake_server.discoveries++;
+  fake_server.responses.push_back([=]() {
+    SendDiscoveryResults(disc_type, start_handle, end_handle);
+  });
+  return GATT_SUCCESS;
+}
+
+tBTA_GATTC_CLCB* bta_gattc_find_clcb_by_conn_id(uint16_t conn_id) {
+  return conn_id == CONN_ID ? &clcb : nullptr;
+}
+
+tBTA_GATTC_SERV* bta_gattc_find_scb_by_cid(uint16_t conn_id) {
+  return conn_id == CONN_ID ? &srcb : nullptr;
+}
+
+void bta_gattc_reset_discover_st(tBTA_GATTC_SERV* p_srcb,
+                                 tGATT_STATUS status) {
+  clcb.state = BTA_GATTC_CONN_ST;
+  discovery_done = true;
+  discovery_status = status;
+}
+
+bool bta_gattc_sm_execute(tBTA_GATTC_CLCB* p_clcb, uint16_t event,
+                          tBTA_GATTC_DATA* p_data) {
+  if (event == BTA_GATTC_DISCOVER_CMPL_EVT)
+    bta_gattc_reset_discover_st(p_clcb->p_srcb, p_clcb->status);
+  return true;
+}
+
+bool btm_sec_is_a_bonded_dev(const RawAddress& bda) { return false; }
+
+bool SDP_InitDiscoveryDb(tSDP_DISCOVERY_DB* p_db, uint32_t len,
+                         uint16_t num_uuid, const Uuid* p_uuid_list,
+                         uint16_t num_attr, uint16_t* p_attr_list) {
+  return false;
+}
+
+bool SDP_ServiceSearchAttributeRequest2(const RawAddress& p_bd_addr,
+                                        tSDP_DISCOVERY_DB* p_db,
+                                        tSDP_DISC_CMPL_CB2* p_cb,
+                                        void* user_data) {
+  return false;
+}
+
+tSDP_DISC_REC* SDP_FindServiceInDb(tSDP_DISCOVERY_DB* p_db,
+                                   uint16_t service_uuid,
+                                   tSDP_DISC_REC* p_start_rec) {
+  return nullptr;
+}
+
+bool SDP_FindServiceUUIDInRec(tSDP_DISC_REC* p_rec, Uuid* p_uuid) {
+  return false;
+}
+
+bool SDP_FindProtocolListElemInRec(tSDP_DISC_REC* p_rec, uint16_t layer_uuid,
+                                   tSDP_PROTOCOL_ELEM* p_elem) {
+  return false;
+}
+
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+class BtaGattcDbHashTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+#if defined(OS_GENERIC)
+    tmp_dir_ = "/tmp/btgattXXXXXX";
+#else
+    tmp_dir_ = "/data/local/tmp/btgattXXXXXX";
+#endif  // !defined(OS_GENERIC)
+
+    char* buffer = const_cast<char*>(tmp_dir_.c_str());
+    char* dtemp = mkdtemp(buffer);
+    if (!dtemp) {
+      perror("Can't make GATT cache test directory: ");
+      CHECK(false);
+    }
+
+    hash_cache =
+        std::make_unique<DatabaseHashCache>(tmp_dir_ + "/gatt_hash_", 4);
+    fake_server = FakeServer();
+    fake_server.database = SampleDatabase();
+    fake_server.has_hash = true;
+    fake_server.hash = HASH;
+  }
+
+  void TearDown() override {
+    hash_cache.reset();
+    DIR* dir = opendir(tmp_dir_.c_str());
+    if (dir) {
+      while (struct dirent* entry = readdir(dir)) {
+        std::string name(entry->d_name);
+        if (name == "." || name == "..") continue;
+        unlink((tmp_dir_ + "/" + name).c_str());
+      }
+      closedir(dir);
+    }
+    rmdir(tmp_dir_.c_str());
+  }
+
+  /* Connect to |server_bda| and start discovery the way
+   * bta_gattc_start_discover does */
+  void StartDiscovery(const RawAddress& server_bda,
+                      tBTA_GATTC_DATA* p_q_cmd = nullptr) {
+    srcb = tBTA_GATTC_SERV();
+    srcb.in_use = true;
+    srcb.connected = true;
+    srcb.server_bda = server_bda;
+    srcb.state = BTA_GATTC_SERV_DISC_ACT;
+
+    clcb = tBTA_GATTC_CLCB();
+    clcb.bta_conn_id = CONN_ID;
+    clcb.bda = server_bda;
+    clcb.transport = BTA_TRANSPORT_LE;
+    clcb.p_srcb = &srcb;
+    clcb.in_use = true;
+    clcb.state = BTA_GATTC_DISCOVER_ST;
+    clcb.p_q_cmd = p_q_cmd;
+
+    fake_server.round_trips = 0;
+    fake_server.discoveries = 0;
+    discovery_done = false;
+    discovery_status = GATT_ERROR;
+
+    bta_gattc_init_cache(&srcb);
+    clcb.status = bta_gattc_discover_db_hash(CONN_ID, &srcb);
+    ASSERT_EQ(GATT_SUCCESS, clcb.status);
+  }
+
+  /* Run discovery until the server has no more responses */
+  void Discover(const RawAddress& server_bda) {
+    StartDiscovery(server_bda);
+    fake_server.Run();
+  }
+
+  std::string tmp_dir_;
+};
+
+/* A server whose hash was never seen is discovered, and its database is
+ * stored for the hash */
+TEST_F(BtaGattcDbHashTest, miss_discovers_and_stores) {
+  Discover(SERVER_1);
+
+  EXPECT_TRUE(discovery_done);
+  EXPECT_EQ(GATT_SUCCESS, discovery_status);
+  EXPECT_EQ(BTA_GATTC_SERV_SAVE, srcb.state);
+  EXPECT_TRUE(srcb.db_hash_valid);
+  EXPECT_EQ(HASH, srcb.db_hash);
+  EXPECT_GT(fake_server.discoveries, 0);
+  EXPECT_EQ(fake_server.database.ToString(), srcb.gatt_database.ToString());
+
+  EXPECT_EQ(1u, hash_cache->Size());
+  Database stored;
+  EXPECT_TRUE(hash_cache->Load(HASH, &stored));
+  EXPECT_EQ(fake_server.database.ToString(), stored.ToString());
+}
+
+/* Another server reporting the same hash only costs the hash read */
+TEST_F(BtaGattcDbHashTest, hit_skips_discovery) {
+  Discover(SERVER_1);
+  int cold_round_trips = fake_server.round_trips;
+
+  Discover(SERVER_2);
+  int warm_round_trips = fake_server.round_trips;
+
+  EXPECT_TRUE(discovery_done);
+  EXPECT_EQ(GATT_SUCCESS, discovery_status);
+  EXPECT_EQ(BTA_GATTC_SERV_SAVE, srcb.state);
+  EXPECT_EQ(0, fake_server.discoveries);
+  EXPECT_EQ(1, warm_round_trips);
+  EXPECT_EQ(fake_server.database.ToString(), srcb.gatt_database.ToString());
+  EXPECT_EQ(1u, hash_cache->Size());
+  EXPECT_LT(warm_round_trips, cold_round_trips);
+
+  RecordProperty("cold_round_trips", cold_round_trips);
+  RecordProperty("warm_round_trips", warm_round_trips);
+}
+
+/* A different hash is a miss, even if a database is already stored */
+TEST_F(BtaGattcDbHashTest, changed_hash_discovers) {
+  Discover(SERVER_1);
+
+  fake_server.database = DatabaseBuilder().Build();
+  fake_server.hash[0] ^= 0xff;
+  Discover(SERVER_2);
+
+  EXPECT_TRUE(discovery_done);
+  EXPECT_GT(fake_server.discoveries, 0);
+  EXPECT_TRUE(srcb.gatt_database.IsEmpty());
+  EXPECT_EQ(2u, hash_cache->Size());
+}
+
+/* Servers without the Database Hash characteristic go through full discovery,
+ * and nothing is stored */
+TEST_F(BtaGattcDbHashTest, no_hash_discovers) {
+  fake_server.has_hash = false;
+  Discover(SERVER_1);
+
+  EXPECT_TRUE(discovery_done);
+  EXPECT_EQ(GATT_SUCCESS, discovery_status);
+  EXPECT_FALSE(srcb.db_hash_valid);
+  EXPECT_GT(fake_server.discoveries, 0);
+  EXPECT_EQ(fake_server.database.ToString(), srcb.gatt_database.ToString());
+  EXPECT_EQ(0u, hash_cache->Size());
+}
+
+/* A read another client started before discovery completes on its own
+ * connection. Its value must not be taken for the Database Hash. */
+TEST_F(BtaGattcDbHashTest, other_client_read_is_not_hash) {
+  hash_cache->Store(OTHER_HASH, DatabaseBuilder().Build());
+  StartDiscovery(SERVER_1);
+
+  tBTA_GATTC_CLCB other_clcb = tBTA_GATTC_CLCB();
+  other_clcb.bta_conn_id = OTHER_CONN_ID;
+  other_clcb.bda = SERVER_1;
+  other_clcb.transport = BTA_TRANSPORT_LE;
+  other_clcb.p_srcb = &srcb;
+  other_clcb.in_use = true;
+  other_clcb.state = BTA_GATTC_DISCOVER_ST;
+
+  EXPECT_FALSE(ReadCmpl(&other_clcb, GATT_SUCCESS, 0x0003, OTHER_HASH.data(),
+                        OTHER_HASH.size()));
+  EXPECT_FALSE(ReadCmpl(&other_clcb, GATT_SUCCESS, 0x0003, OTHER_HASH.data(),
+                        2));
+  EXPECT_FALSE(discovery_done);
+  EXPECT_FALSE(srcb.db_hash_valid);
+  EXPECT_EQ(0, fake_server.discoveries);
+
+  /* the real hash read still completes discovery */
+  fake_server.Run();
+  EXPECT_TRUE(discovery_done);
+  EXPECT_EQ(GATT_SUCCESS, discovery_status);
+  EXPECT_EQ(HASH, srcb.db_hash);
+  EXPECT_EQ(fake_server.database.ToString(), srcb.gatt_database.ToString());
+  EXPECT_EQ(2u, hash_cache->Size());
+}
+
+/* Once the hash is read, later reads on the same connection are ignored */
+TEST_F(BtaGattcDbHashTest, read_after_hash_is_not_hash) {
+  StartDiscovery(SERVER_1);
+  fake_server.Run();
+  ASSERT_TRUE(discovery_done);
+
+  EXPECT_FALSE(ReadCmpl(&clcb, GATT_SUCCESS, DATABASE_HASH_HANDLE,
+                        OTHER_HASH.data(), OTHER_HASH.size()));
+  EXPECT_EQ(HASH, srcb.db_hash);
+}
+
+/* A connection with a command of its own outstanding can't tell that
+ * command's read completion from the hash read, so it discovers in full */
+TEST_F(BtaGattcDbHashTest, pending_command_skips_hash_read) {
+  tBTA_GATTC_DATA pending_read;
+  memset(&pending_read, 0, sizeof(pending_read));
+  StartDiscovery(SERVER_1, &pending_read);
+  fake_server.Run();
+
+  EXPECT_TRUE(discovery_done);
+  EXPECT_EQ(GATT_SUCCESS, discovery_status);
+  EXPECT_FALSE(srcb.db_hash_valid);
+  EXPECT_EQ(fake_server.discoveries, fake_server.round_trips);
+  EXPECT_EQ(fake_server.database.ToString(), srcb.gatt_database.ToString());
+}
@@ -0,0 +1,188 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <base/logging.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+
+#include "gatt/database.h"
+#include "gatt/database_builder.h"
+#include "gatt/database_hash_cache.h"
+
+using bluetooth::Uuid;
+
+namespace gatt {
+
+namespace {
+const DatabaseHashCache::Hash HASH_1 = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+                                        0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c,
+                                        0x0d, 0x0e, 0x0f, 0x10};
+const DatabaseHashCache::Hash HASH_2 = {0xf0};
+const DatabaseHashCache::Hash HASH_3 = {0xe0};
+
+Uuid SERVICE_1_UUID = Uuid::FromString("1800");
+Uuid SERVICE_2_UUID = Uuid::FromString("180f");
+Uuid SERVICE_3_UUID = Uuid::FromString("180a");
+Uuid SERVICE_1_CHAR_1_UUID = Uuid::FromString("2a00");
+Uuid SERVICE_1_CHAR_2_UUID = Uuid::FromString("2a01");
+Uuid SERVICE_2_CHAR_1_UUID = Uuid::FromString("2a19");
+Uuid SERVICE_3_CHAR_1_UUID = Uuid::FromString("2a29");
+Uuid SERVICE_3_CHAR_2_UUID = Uuid::FromString("2a24");
+Uuid CCC_UUID = Uuid::FromString("2902");
+
+/* Database of the remote device used in the tests */
+Database SampleDatabase() {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x0005, SERVICE_1_UUID, true);
+  builder.AddService(0x0006, 0x0009, SERVICE_2_UUID, true);
+  builder.AddService(0x000a, 0x000e, SERVICE_3_UUID, true);
+  builder.AddCharacteristic(0x0002, 0x0003, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddCharacteristic(0x0004, 0x0005, SERVICE_1_CHAR_2_UUID, 0x02);
+  builder.AddCharacteristic(0x0007, 0x0008, SERVICE_2_CHAR_1_UUID, 0x12);
+  builder.AddDescriptor(0x0009, CCC_UUID);
+  builder.AddCharacteristic(0x000b, 0x000c, SERVICE_3_CHAR_1_UUID, 0x02);
+  builder.AddCharacteristic(0x000d, 0x000e, SERVICE_3_CHAR_2_UUID, 0x02);
+  return builder.Build();
+}
+}  // namespace
+
+class DatabaseHashCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+#if defined(OS_GENERIC)
+    tmp_dir_ = "/tmp/btgattXXXXXX";
+#else
+    tmp_dir_ = "/data/local/tmp/btgattXXXXXX";
+#endif  // !defined(OS_GENERIC)
+
+    char* buffer = const_cast<char*>(tmp_dir_.c_str());
+    char* dtemp = mkdtemp(buffer);
+    if (!dtemp) {
+      perror("Can't make GATT cache test directory: ");
+      CHECK(false);
+    }
+
+    prefix_ = tmp_dir_ + "/gatt_hash_";
+  }
+
+  void TearDown() override {
+    DIR* dir = opendir(tmp_dir_.c_str());
+    if (dir) {
+      while (struct dirent* entry = readdir(dir)) {
+        std::string name(entry->d_name);
+        if (name == "." || name == "..") continue;
+        unlink((tmp_dir_ + "/" + name).c_str());
+      }
+      closedir(dir);
+    }
+    rmdir(tmp_dir_.c_str());
+  }
+
+  bool Exists(const DatabaseHashCache::Hash& hash) {
+    return access((prefix_ + DatabaseHashCache::HashToString(hash)).c_str(),
+                  F_OK) == 0;
+  }
+
+  std::string tmp_dir_;
+  std::string prefix_;
+};
+
+TEST_F(DatabaseHashCacheTest, store_and_load) {
+  DatabaseHashCache cache(prefix_, 4);
+  Database database = SampleDatabase();
+
+  EXPECT_TRUE(cache.Store(HASH_1, database));
+  EXPECT_TRUE(Exists(HASH_1));
+  EXPECT_EQ(cache.Size(), 1u);
+
+  Database loaded;
+  EXPECT_TRUE(cache.Load(HASH_1, &loaded));
+  EXPECT_EQ(loaded.ToString(), database.ToString());
+}
+
+TEST_F(DatabaseHashCacheTest, miss_keeps_database) {
+  DatabaseHashCache cache(prefix_, 4);
+  Database database = SampleDatabase();
+  cache.Store(HASH_1, database);
+
+  Database loaded = database;
+  EXPECT_FALSE(cache.Load(HASH_2, &loaded));
+  EXPECT_EQ(loaded.ToString(), database.ToString());
+}
+
+TEST_F(DatabaseHashCacheTest, hash_to_string) {
+  EXPECT_EQ(DatabaseHashCache::HashToString(HASH_1),
+            "0102030405060708090a0b0c0d0e0f10");
+}
+
+/* A database stored while talking to one device is found by a new instance,
+ * as after a restart, and is not tied to any address */
+TEST_F(DatabaseHashCacheTest, entries_survive_new_instance) {
+  Database database = SampleDatabase();
+  {
+    DatabaseHashCache cache(prefix_, 4);
+    cache.Store(HASH_1, database);
+  }
+
+  DatabaseHashCache cache(prefix_, 4);
+  EXPECT_EQ(cache.Size(), 1u);
+  Database loaded;
+  EXPECT_TRUE(cache.Load(HASH_1, &loaded));
+  EXPECT_EQ(loaded.ToString(), database.ToString());
+}
+
+TEST_F(DatabaseHashCacheTest, evict_least_recently_used) {
+  DatabaseHashCache cache(prefix_, 2);
+  Database database = SampleDatabase();
+  Database loaded;
+
+  cache.Store(HASH_1, database);
+  cache.Store(HASH_2, database);
+  /* HASH_1 is now more recently used than HASH_2 */
+  EXPECT_TRUE(cache.Load(HASH_1, &loaded));
+
+  cache.Store(HASH_3, database);
+  EXPECT_EQ(cache.Size(), 2u);
+  EXPECT_TRUE(Exists(HASH_1));
+  EXPECT_FALSE(Exists(HASH_2));
+  EXPECT_TRUE(Exists(HASH_3));
+  EXPECT_FALSE(cache.Load(HASH_2, &loaded));
+}
+
+TEST_F(DatabaseHashCacheTest, corrupt_entry_is_dropped) {
+  DatabaseHashCache cache(prefix_, 4);
+  cache.Store(HASH_1, SampleDatabase());
+
+  std::string path = prefix_ + DatabaseHashCache::HashToString(HASH_1);
+  FILE* fd = fopen(path.c_str(), "wb");
+  ASSERT_NE(fd, nullptr);
+  fputs("garbage", fd);
+  fclose(fd);
+
+  Database loaded;
+  EXPECT_FALSE(cache.Load(HASH_1, &loaded));
+  EXPECT_TRUE(loaded.IsEmpty());
+  EXPECT_FALSE(Exists(HASH_1));
+  EXPECT_EQ(cache.Size(), 0u);
+}
+
+}  // namespace gatt
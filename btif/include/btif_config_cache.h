@@ -19,6 +19,7 @@
 #include <map>
 #include <unordered_set>
 
+#include "btif_config_journal.h"
 #include "common/lru.h"
 #include "osi/include/config.h"
 #include "osi/include/log.h"
@@ -39,6 +40,9 @@ class BtifConfigCache {
   bool HasKey(const std::string& section_name, const std::string& key);
   bool RemoveKey(const std::string& section_name, const std::string& key);
   void RemovePersistentSectionsWithKey(const std::string& key);
+  // Record every change to the persistent sections into |journal|, may be
+  // nullptr to stop recording.
+  void SetJournal(BtifConfigJournal* journal);
 
   // Setters and getters
   void SetString(std::string section_name, std::string key, std::string value);
@@ -57,4 +61,5 @@ class BtifConfigCache {
  private:
   bluetooth::common::LruCache<std::string, section_t> unpaired_devices_cache_;
   config_t paired_devices_list_;
+  BtifConfigJournal* journal_;
 };
@@ -0,0 +1,82 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "osi/include/config.h"
+
+// Append-only log of changes made to the persistent part of the btif config
+// since it was last written out in full.
+//
+// Changes are recorded in memory and appended to the journal file on Flush(),
+// so that saving a single key costs one small append instead of a rewrite of
+// the whole config file. Once the journal has been compacted into the config
+// file, Reset() drops it. On startup, Replay() applies the journal on top of
+// the config file that was read from disk.
+//
+// The journal file starts with the checksum of the file it applies on top of,
+// its base, so that it is only replayed on that exact file: whether that is
+// still the config file or the backup it was moved to, and never on a config
+// file that already contains its changes.
+//
+// Records are checksummed; a record torn by a crash in the middle of an append
+// ends the replay and is dropped.
+class BtifConfigJournal {
+ public:
+  explicit BtifConfigJournal(std::string path);
+
+  // Compute the checksum identifying the file at |path| as a journal base.
+  static bool GetFileChecksum(const std::string& path, uint32_t* checksum);
+
+  // Apply the records of the journal file to |config|, read from the file
+  // with checksum |base_checksum|, and truncate a torn record at the tail of
+  // the journal file. A journal with another base is dropped. Returns the
+  // number of records applied.
+  size_t Replay(config_t* config, uint32_t base_checksum);
+
+  // Base of the journal file created by the next Flush() after a Reset().
+  void SetBase(uint32_t base_checksum) { base_checksum_ = base_checksum; }
+
+  // Record a change, it is written to the journal file by the next Flush().
+  void Set(const std::string& section, const std::string& key,
+           const std::string& value);
+  void RemoveKey(const std::string& section, const std::string& key);
+  void RemoveSection(const std::string& section);
+
+  // Append the changes recorded since the last Flush() or Reset() to the
+  // journal file and sync it to disk.
+  bool Flush();
+
+  // Drop the journal file and any unflushed changes, after the config has been
+  // saved in full.
+  bool Reset();
+
+  // Size of the journal file, in bytes
+  size_t Size() const { return size_; }
+  // Size of the changes not yet written by Flush(), in bytes
+  size_t PendingSize() const { return pending_.size(); }
+
+ private:
+  void Append(char type, const std::string& section, const std::string& key,
+              const std::string& value);
+
+  const std::string path_;
+  std::string pending_;
+  size_t size_;
+  uint32_t base_checksum_;
+};
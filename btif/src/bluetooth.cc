@@ -71,9 +71,12 @@
 #include "main/shim/shim.h"
 #include "osi/include/alarm.h"
 #include "osi/include/allocation_tracker.h"
+#include "osi/include/buffer_pool.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/wakelock.h"
+#include "stack/btm/btm_ble_adv_reassembly.h"
+#include "stack/btm/btm_ble_rpa_cache.h"
 #include "stack/gatt/connection_manager.h"
 #include "stack_manager.h"
 
@@ -341,9 +344,12 @@ static void dump(int fd, const char** arguments) {
   BTA_HfClientDumpStatistics(fd);
   wakelock_debug_dump(fd);
   osi_allocator_debug_dump(fd);
+  buffer_pool_debug_dump(fd);
   alarm_debug_dump(fd);
   HearingAid::DebugDump(fd);
   connection_manager::dump(fd);
+  rpa_cache::dump(fd);
+  adv_reassembly::dump(fd);
   bluetooth::bqr::DebugDump(fd);
   if (bluetooth::shim::is_gd_shim_enabled()) {
     bluetooth::shim::Dump(fd);
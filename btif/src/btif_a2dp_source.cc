@@ -29,6 +29,7 @@
 #include <string.h>
 #include <algorithm>
 
+#include "a2dp_encoder_fanout.h"
 #include "audio_a2dp_hw/include/audio_a2dp_hw.h"
 #include "audio_hal_interface/a2dp_encoding.h"
 #include "bt_common.h"
@@ -190,6 +191,8 @@ class BtifA2dpSource {
     wakelock_release();
     encoder_interface = nullptr;
     encoder_interval_ms = 0;
+    encoder_peer_address = RawAddress::kEmpty;
+    encoder_fanout.reset();
     stats.Reset();
     accumulated_stats.Reset();
     state_ = kStateOff;
@@ -216,6 +219,10 @@ class BtifA2dpSource {
   RepeatingTimer media_alarm;
   const tA2DP_ENCODER_INTERFACE* encoder_interface;
   uint64_t encoder_interval_ms; /* Local copy of the encoder interval */
+  RawAddress encoder_peer_address; /* The peer of |encoder_interface| */
+  // Fan-out of the audio to the encoder of |encoder_peer_address|, and to the
+  // encoder sessions of the other peers
+  std::unique_ptr<A2dpEncoderFanout> encoder_fanout;
   BtifMediaStats stats;
   BtifMediaStats accumulated_stats;
 
@@ -252,6 +259,9 @@ static void btif_a2dp_source_audio_feeding_update_event(
     const btav_a2dp_codec_config_t& codec_audio_config);
 static bool btif_a2dp_source_audio_tx_flush_req(void);
 static void btif_a2dp_source_audio_handle_timer(void);
+static void btif_a2dp_source_fanout_debug_dump(int fd,
+                                               std::promise<void> dump_promise);
+static uint32_t btif_a2dp_source_read_audio(uint8_t* p_buf, uint32_t len);
 static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len);
 static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
                                               uint32_t bytes_read);
@@ -343,6 +353,8 @@ bool btif_a2dp_source_startup(void) {
   btif_a2dp_source_cb.Reset();
   btif_a2dp_source_cb.SetState(BtifA2dpSource::kStateStartingUp);
   btif_a2dp_source_cb.tx_audio_queue = fixed_queue_new(SIZE_MAX);
+  btif_a2dp_source_cb.encoder_fanout.reset(
+      new A2dpEncoderFanout(btif_a2dp_source_read_audio));
 
   // Schedule the rest of the operations
   btif_a2dp_source_thread.DoInThread(
@@ -512,6 +524,7 @@ static void btif_a2dp_source_shutdown_delayed(void) {
   }
   fixed_queue_free(btif_a2dp_source_cb.tx_audio_queue, nullptr);
   btif_a2dp_source_cb.tx_audio_queue = nullptr;
+  btif_a2dp_source_cb.encoder_fanout.reset();
 
   btif_a2dp_source_cb.SetState(BtifA2dpSource::kStateOff);
 }
@@ -595,6 +608,15 @@ static void btif_a2dp_source_setup_codec_delayed(
       &peer_params, a2dp_codec_config, btif_a2dp_source_read_callback,
       btif_a2dp_source_enqueue_callback);
 
+  // The encoder above reads the audio of the new active peer, which doesn't
+  // need an encoder session anymore
+  if (btif_a2dp_source_cb.encoder_fanout != nullptr) {
+    btif_a2dp_source_cb.encoder_fanout->RemovePeer(
+        btif_a2dp_source_cb.encoder_peer_address);
+    btif_a2dp_source_cb.encoder_fanout->AddReader(peer_address);
+  }
+  btif_a2dp_source_cb.encoder_peer_address = peer_address;
+
   // Save a local copy of the encoder_interval_ms
   btif_a2dp_source_cb.encoder_interval_ms =
       btif_a2dp_source_cb.encoder_interface->get_encoder_interval_ms();
@@ -792,6 +814,8 @@ static void btif_a2dp_source_audio_tx_start_event(void) {
   /* Reset the media feeding state */
   CHECK(btif_a2dp_source_cb.encoder_interface != nullptr);
   btif_a2dp_source_cb.encoder_interface->feeding_reset();
+  if (btif_a2dp_source_cb.encoder_fanout != nullptr)
+    btif_a2dp_source_cb.encoder_fanout->FeedingReset();
 
   APPL_TRACE_EVENT(
       "%s: starting timer %" PRIu64 " ms", __func__,
@@ -881,6 +905,8 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
   /* Reset the media feeding state */
   if (btif_a2dp_source_cb.encoder_interface != nullptr)
     btif_a2dp_source_cb.encoder_interface->feeding_reset();
+  if (btif_a2dp_source_cb.encoder_fanout != nullptr)
+    btif_a2dp_source_cb.encoder_fanout->FeedingReset();
 }
 
 static void btif_a2dp_source_audio_handle_timer(void) {
@@ -906,13 +932,15 @@ static void btif_a2dp_source_audio_handle_timer(void) {
         transmit_queue_length);
   }
   btif_a2dp_source_cb.encoder_interface->send_frames(timestamp_us);
+  btif_a2dp_source_cb.encoder_fanout->SendFrames(timestamp_us);
   bta_av_ci_src_data_ready(BTA_AV_CHNL_AUDIO);
   update_scheduling_stats(&btif_a2dp_source_cb.stats.tx_queue_enqueue_stats,
                           timestamp_us,
                           btif_a2dp_source_cb.encoder_interval_ms * 1000);
 }
 
-static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
+// Reads the audio from the audio HAL, for the encoder fan-out
+static uint32_t btif_a2dp_source_read_audio(uint8_t* p_buf, uint32_t len) {
   uint16_t event;
   uint32_t bytes_read = 0;
 
@@ -921,6 +949,16 @@ static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
   } else if (a2dp_uipc != nullptr) {
     bytes_read = UIPC_Read(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, &event, p_buf, len);
   }
+  return bytes_read;
+}
+
+static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
+  uint32_t bytes_read = 0;
+
+  if (btif_a2dp_source_cb.encoder_fanout != nullptr) {
+    bytes_read = btif_a2dp_source_cb.encoder_fanout->Read(
+        btif_a2dp_source_cb.encoder_peer_address, p_buf, len);
+  }
 
   if (bytes_read < len) {
     LOG_WARN(LOG_TAG, "%s: UNDERFLOW: ONLY READ %d BYTES OUT OF %d", __func__,
@@ -1041,6 +1079,8 @@ static void btif_a2dp_source_audio_tx_flush_event(void) {
 
   if (btif_a2dp_source_cb.encoder_interface != nullptr)
     btif_a2dp_source_cb.encoder_interface->feeding_flush();
+  if (btif_a2dp_source_cb.encoder_fanout != nullptr)
+    btif_a2dp_source_cb.encoder_fanout->FeedingFlush();
 
   btif_a2dp_source_cb.stats.tx_queue_total_flushed_messages +=
       fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
@@ -1290,6 +1330,22 @@ void btif_a2dp_source_debug_dump(int fd) {
       (unsigned long long)dequeue_stats->max_premature_scheduling_delta_us /
           1000,
       (unsigned long long)ave_time_us / 1000);
+
+  // The fan-out is used from the A2DP Source thread: dump it from there
+  std::promise<void> dump_promise;
+  std::future<void> dump_future = dump_promise.get_future();
+  if (btif_a2dp_source_thread.DoInThread(
+          FROM_HERE, base::BindOnce(&btif_a2dp_source_fanout_debug_dump, fd,
+                                    std::move(dump_promise)))) {
+    dump_future.wait();
+  }
+}
+
+static void btif_a2dp_source_fanout_debug_dump(
+    int fd, std::promise<void> dump_promise) {
+  if (btif_a2dp_source_cb.encoder_fanout != nullptr)
+    btif_a2dp_source_cb.encoder_fanout->DebugDump(fd);
+  dump_promise.set_value();
 }
 
 static void btif_a2dp_source_update_metrics(void) {
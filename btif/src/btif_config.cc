@@ -22,6 +22,8 @@
 
 #include <base/logging.h>
 #include <ctype.h>
+#include <errno.h>
+#include <sys/stat.h>
 #include <openssl/rand.h>
 #include <openssl/sha.h>
 #include <private/android_filesystem_config.h>
@@ -29,6 +31,7 @@
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <algorithm>
 #include <functional>
 #include <mutex>
 #include <sstream>
@@ -41,6 +44,7 @@
 #include "btif_api.h"
 #include "btif_common.h"
 #include "btif_config_cache.h"
+#include "btif_config_journal.h"
 #include "btif_config_transcode.h"
 #include "btif_util.h"
 #include "common/address_obfuscator.h"
@@ -78,14 +82,25 @@ using bluetooth::common::MetricIdAllocator;
 #if defined(OS_GENERIC)
 static const char* CONFIG_FILE_PATH = "bt_config.conf";
 static const char* CONFIG_BACKUP_PATH = "bt_config.bak";
+static const char* CONFIG_JOURNAL_PATH = "bt_config.journal";
 static const char* CONFIG_LEGACY_FILE_PATH = "bt_config.xml";
 #else   // !defined(OS_GENERIC)
 static const char* CONFIG_FILE_PATH = "/data/misc/bluedroid/bt_config.conf";
 static const char* CONFIG_BACKUP_PATH = "/data/misc/bluedroid/bt_config.bak";
+static const char* CONFIG_JOURNAL_PATH =
+    "/data/misc/bluedroid/bt_config.journal";
 static const char* CONFIG_LEGACY_FILE_PATH =
     "/data/misc/bluedroid/bt_config.xml";
 #endif  // defined(OS_GENERIC)
 static const uint64_t CONFIG_SETTLE_PERIOD_MS = 3000;
+// Changes are appended to the journal until it grows to half the size of the
+// config file (and at least this size), then the config file is rewritten.
+// This keeps the bytes written per change within a small multiple of the
+// change itself, no matter how many devices are stored.
+// While changes are journaled, the backup file is only refreshed by these
+// compactions, so it can be older than the previous full save by up to one
+// journal worth of changes.
+static const size_t CONFIG_JOURNAL_MIN_COMPACT_SIZE = 16 * 1024;
 
 static void timer_config_save_cb(void* data);
 static void btif_config_write(uint16_t event, char* p_param);
@@ -270,6 +285,55 @@ static alarm_t* config_timer;
 // limited btif config cache capacity
 static BtifConfigCache btif_config_cache(TEMPORARY_SECTION_CAPACITY);
 
+// changes since the config file was last written in full
+static BtifConfigJournal btif_config_journal(CONFIG_JOURNAL_PATH);
+static bool btif_config_journal_enabled;
+// set when the config file on disk is not the base of the journal
+static bool btif_config_needs_compaction;
+// set when the journal applies on top of the backup file instead
+static bool btif_config_journal_on_backup;
+static size_t btif_config_file_size;
+
+static size_t btif_config_get_file_size() {
+  struct stat st;
+  if (stat(CONFIG_FILE_PATH, &st) != 0) return 0;
+  return st.st_size;
+}
+
+// Start a new journal on top of the config file that was just saved in full.
+static bool btif_config_journal_rebase() {
+  uint32_t base_checksum;
+  btif_config_journal.Reset();
+  btif_config_file_size = btif_config_get_file_size();
+  if (!BtifConfigJournal::GetFileChecksum(CONFIG_FILE_PATH, &base_checksum)) {
+    return false;
+  }
+  btif_config_journal.SetBase(base_checksum);
+  btif_config_journal_on_backup = false;
+  return true;
+}
+
+// Refresh the backup file with the config file before it is saved in full.
+// The config file is hard linked rather than moved, so that there is no window
+// without a config file; the journal stays on top of the config file.
+static void btif_config_backup() {
+  std::string temp_path = std::string(CONFIG_BACKUP_PATH) + ".new";
+  unlink(temp_path.c_str());
+  if (link(CONFIG_FILE_PATH, temp_path.c_str()) == 0) {
+    if (rename(temp_path.c_str(), CONFIG_BACKUP_PATH) == 0) return;
+    unlink(temp_path.c_str());
+  } else if (errno == ENOENT) {
+    // no config file to back up yet
+    return;
+  }
+
+  LOG_WARN(LOG_TAG, "%s unable to link %s: %s; moving it", __func__,
+           CONFIG_FILE_PATH, strerror(errno));
+  if (rename(CONFIG_FILE_PATH, CONFIG_BACKUP_PATH) == 0) {
+    btif_config_journal_on_backup = true;
+  }
+}
+
 // Module lifecycle functions
 
 static future_t* init(void) {
@@ -310,8 +374,37 @@ static future_t* init(void) {
     file_source = "Empty";
   }
 
+  // The journal is not covered by the config checksums checked in NIAP mode,
+  // and the GD stack manages its own storage
+  btif_config_journal_enabled =
+      !btif_is_niap_mode() && !bluetooth::shim::is_gd_stack_started_up();
+  btif_config_needs_compaction = true;
+  btif_config_journal_on_backup = btif_config_source == BACKUP;
+  // The journal applies on top of the file it was based on, which is the
+  // backup when the config file was lost while being saved in full
+  uint32_t base_checksum;
+  if (btif_config_journal_enabled &&
+      (btif_config_source == ORIGINAL || btif_config_source == BACKUP) &&
+      BtifConfigJournal::GetFileChecksum(btif_config_source == ORIGINAL
+                                             ? CONFIG_FILE_PATH
+                                             : CONFIG_BACKUP_PATH,
+                                         &base_checksum)) {
+    size_t records = btif_config_journal.Replay(config.get(), base_checksum);
+    if (records > 0) {
+      LOG_INFO(LOG_TAG, "%s replayed %zu config journal records", __func__,
+               records);
+    }
+    // a config read from the backup is saved in full on the next write
+    btif_config_needs_compaction = btif_config_source != ORIGINAL;
+  } else {
+    btif_config_journal.Reset();
+  }
+  btif_config_file_size = btif_config_get_file_size();
+
   // move persistent config data from btif_config file to btif config cache
   btif_config_cache.Init(std::move(config));
+  btif_config_cache.SetJournal(
+      btif_config_journal_enabled ? &btif_config_journal : nullptr);
 
   if (!file_source.empty()) {
     btif_config_cache.SetString(INFO_SECTION, FILE_SOURCE, file_source);
@@ -390,6 +483,7 @@ static future_t* clean_up(void) {
   std::unique_lock<std::recursive_mutex> lock(config_lock);
   get_bluetooth_keystore_interface()->clear_map();
   MetricIdAllocator::GetInstance().Close();
+  btif_config_cache.SetJournal(nullptr);
   btif_config_cache.Clear();
   return future_new_immediate(FUTURE_SUCCESS);
 }
@@ -620,6 +714,7 @@ bool btif_config_clear(void) {
   btif_config_cache.Clear();
   bool ret = storage_config_get_interface()->config_save(
       btif_config_cache.PersistentSectionCopy(), CONFIG_FILE_PATH);
+  btif_config_needs_compaction = !btif_config_journal_rebase();
   btif_config_source = RESET;
 
   return ret;
@@ -637,9 +732,30 @@ static void btif_config_write(UNUSED_ATTR uint16_t event,
   CHECK(config_timer != NULL);
 
   std::unique_lock<std::recursive_mutex> lock(config_lock);
-  rename(CONFIG_FILE_PATH, CONFIG_BACKUP_PATH);
-  storage_config_get_interface()->config_save(
+  if (!btif_config_journal_enabled) {
+    rename(CONFIG_FILE_PATH, CONFIG_BACKUP_PATH);
+  } else {
+    if (!btif_config_needs_compaction) {
+      size_t journal_size =
+          btif_config_journal.Size() + btif_config_journal.PendingSize();
+      size_t compact_size =
+          std::max(CONFIG_JOURNAL_MIN_COMPACT_SIZE, btif_config_file_size / 2);
+      if (journal_size < compact_size && btif_config_journal.Flush()) return;
+    }
+    // The changes stay in the journal until the full save succeeds, so a
+    // crash or a failure in the middle of it loses nothing
+    btif_config_journal.Flush();
+    // The file the journal is based on is the only copy of the config not to
+    // be replaced
+    if (!btif_config_journal_on_backup) btif_config_backup();
+  }
+
+  bool saved = storage_config_get_interface()->config_save(
       btif_config_cache.PersistentSectionCopy(), CONFIG_FILE_PATH);
+  if (btif_config_journal_enabled) {
+    // on failure, retry the full save next time
+    btif_config_needs_compaction = !saved || !btif_config_journal_rebase();
+  }
   if (btif_is_niap_mode()) {
     get_bluetooth_keystore_interface()->set_encrypt_key_or_remove_key(
         CONFIG_FILE_PREFIX, CONFIG_FILE_HASH);
@@ -680,6 +796,9 @@ void btif_debug_config_dump(int fd) {
           btif_config_cache.GetPersistentSections().size());
   dprintf(fd, "  File created/tagged: %s\n", btif_config_time_created);
   dprintf(fd, "  File source: %s\n", file_source->c_str());
+  if (btif_config_journal_enabled) {
+    dprintf(fd, "  Journal size: %zu bytes\n", btif_config_journal.Size());
+  }
 }
 
 static bool is_factory_reset(void) {
@@ -691,5 +810,6 @@ static bool is_factory_reset(void) {
 static void delete_config_files(void) {
   remove(CONFIG_FILE_PATH);
   remove(CONFIG_BACKUP_PATH);
+  remove(CONFIG_JOURNAL_PATH);
   osi_property_set("persist.bluetooth.factoryreset", "false");
 }
@@ -57,7 +57,8 @@ bool trim_new_line(std::string& value) {
 }  // namespace
 
 BtifConfigCache::BtifConfigCache(size_t capacity)
-    : unpaired_devices_cache_(capacity, "bt_config_cache") {
+    : unpaired_devices_cache_(capacity, "bt_config_cache"),
+      journal_(nullptr) {
   LOG(INFO) << __func__ << ", capacity: " << capacity;
 }
 
@@ -105,6 +106,7 @@ void BtifConfigCache::RemovePersistentSectionsWithKey(const std::string& key) {
   for (auto it = paired_devices_list_.sections.begin();
        it != paired_devices_list_.sections.end();) {
     if (it->Has(key)) {
+      if (journal_) journal_->RemoveSection(it->name);
       it = paired_devices_list_.sections.erase(it);
       continue;
     }
@@ -138,16 +140,24 @@ bool BtifConfigCache::RemoveKey(const std::string& section_name,
     section_iter->entries.erase(entry_iter);
     if (section_iter->entries.empty()) {
       paired_devices_list_.sections.erase(section_iter);
+      if (journal_) journal_->RemoveSection(section_name);
     } else if (!has_link_key_in_section(*section_iter)) {
       // if no link key in section after removal, move it to unpaired section
       auto moved_section = std::move(*section_iter);
       paired_devices_list_.sections.erase(section_iter);
       unpaired_devices_cache_.Put(section_name, std::move(moved_section));
+      if (journal_) journal_->RemoveSection(section_name);
+    } else if (journal_) {
+      journal_->RemoveKey(section_name, key);
     }
     return true;
   }
 }
 
+void BtifConfigCache::SetJournal(BtifConfigJournal* journal) {
+  journal_ = journal;
+}
+
 /* clone persistent sections (Local Adapter sections, remote paired devices
  * section,..) */
 config_t BtifConfigCache::PersistentSectionCopy() {
@@ -192,6 +202,11 @@ void BtifConfigCache::SetString(std::string section_name, std::string key,
       }
       // when a unpaired section got the LinkKey, move this section to the
       // paired devices list
+      if (journal_) {
+        for (const auto& entry : section.entries) {
+          journal_->Set(section_name, entry.key, entry.value);
+        }
+      }
       paired_devices_list_.sections.emplace_back(std::move(section));
     } else {
       // update to the unpaired devices cache
@@ -204,6 +219,14 @@ void BtifConfigCache::SetString(std::string section_name, std::string key,
       LOG(WARNING) << __func__ << " , section_found not found!";
       return;
     }
+    if (journal_) {
+      // rewriting a key with its current value doesn't need a record
+      auto entry_iter = section_found->Find(key);
+      if (entry_iter == section_found->entries.end() ||
+          entry_iter->value != value) {
+        journal_->Set(section_name, key, value);
+      }
+    }
     section_found->Set(key, value);
   }
 }
@@ -0,0 +1,252 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "btif_config_journal.h"
+
+#include <base/logging.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+#include "osi/include/osi.h"
+
+namespace {
+
+// The file starts with a header: magic, then the checksum of the base file.
+constexpr char kHeaderMagic[] = {'B', 'T', 'C', 'J'};
+constexpr size_t kHeaderSize = sizeof(kHeaderMagic) + sizeof(uint32_t);
+
+// Record layout: type, section length, key length, value length, then the
+// section, key and value bytes, followed by a checksum of everything before it.
+// Lengths and checksum are little endian.
+constexpr char kRecordSet = 'S';
+constexpr char kRecordRemoveKey = 'K';
+constexpr char kRecordRemoveSection = 'R';
+constexpr size_t kRecordHeaderSize = 1 + 3 * sizeof(uint32_t);
+constexpr size_t kRecordChecksumSize = sizeof(uint32_t);
+
+// FNV-1a
+uint32_t checksum(const char* data, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+void put_uint32(std::string* out, uint32_t value) {
+  for (int i = 0; i < 4; i++) out->push_back((value >> (8 * i)) & 0xff);
+}
+
+uint32_t get_uint32(const char* in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++)
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+  return value;
+}
+
+bool read_file(const std::string& path, std::string* content) {
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (!fp) return false;
+
+  char buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+    content->append(buffer, read);
+  }
+  bool success = !ferror(fp);
+  fclose(fp);
+  return success;
+}
+
+}  // namespace
+
+BtifConfigJournal::BtifConfigJournal(std::string path)
+    : path_(std::move(path)), size_(0), base_checksum_(0) {}
+
+bool BtifConfigJournal::GetFileChecksum(const std::string& path,
+                                        uint32_t* checksum) {
+  std::string content;
+  if (!read_file(path, &content)) return false;
+  *checksum = ::checksum(content.data(), content.size());
+  return true;
+}
+
+size_t BtifConfigJournal::Replay(config_t* config, uint32_t base_checksum) {
+  base_checksum_ = base_checksum;
+  std::string content;
+  if (!read_file(path_, &content) || content.empty()) {
+    size_ = 0;
+    return 0;
+  }
+
+  if (content.size() < kHeaderSize ||
+      memcmp(content.data(), kHeaderMagic, sizeof(kHeaderMagic)) != 0 ||
+      get_uint32(content.data() + sizeof(kHeaderMagic)) != base_checksum) {
+    LOG(WARNING) << __func__ << ": dropping " << path_
+                 << ", it doesn't apply to the config that was read";
+    Reset();
+    return 0;
+  }
+
+  size_t offset = kHeaderSize;
+  size_t records = 0;
+  while (content.size() - offset >= kRecordHeaderSize) {
+    const char* record = content.data() + offset;
+    uint64_t section_length = get_uint32(record + 1);
+    uint64_t key_length = get_uint32(record + 5);
+    uint64_t value_length = get_uint32(record + 9);
+    uint64_t record_length = kRecordHeaderSize + section_length + key_length +
+                             value_length + kRecordChecksumSize;
+    if (record_length > content.size() - offset) break;
+
+    size_t checked_length = record_length - kRecordChecksumSize;
+    if (checksum(record, checked_length) !=
+        get_uint32(record + checked_length)) {
+      break;
+    }
+
+    const char* data = record + kRecordHeaderSize;
+    std::string section(data, section_length);
+    std::string key(data + section_length, key_length);
+    std::string value(data + section_length + key_length, value_length);
+    switch (record[0]) {
+      case kRecordSet:
+        config_set_string(config, section, key, value);
+        break;
+      case kRecordRemoveKey:
+        config_remove_key(config, section, key);
+        break;
+      case kRecordRemoveSection:
+        config_remove_section(config, section);
+        break;
+      default:
+        LOG(WARNING) << __func__ << ": unknown record type " << +record[0];
+        break;
+    }
+
+    offset += record_length;
+    records++;
+  }
+
+  if (offset != content.size()) {
+    LOG(WARNING) << __func__ << ": dropping " << content.size() - offset
+                 << " bytes of torn or corrupt journal in " << path_;
+    if (truncate(path_.c_str(), offset) == -1) {
+      LOG(ERROR) << __func__ << ": unable to truncate " << path_ << ": "
+                 << strerror(errno);
+    }
+  }
+
+  size_ = offset;
+  return records;
+}
+
+void BtifConfigJournal::Set(const std::string& section, const std::string& key,
+                            const std::string& value) {
+  Append(kRecordSet, section, key, value);
+}
+
+void BtifConfigJournal::RemoveKey(const std::string& section,
+                                  const std::string& key) {
+  Append(kRecordRemoveKey, section, key, "");
+}
+
+void BtifConfigJournal::RemoveSection(const std::string& section) {
+  Append(kRecordRemoveSection, section, "", "");
+}
+
+bool BtifConfigJournal::Flush() {
+  if (pending_.empty()) return true;
+
+  // A new journal file starts with its header, replacing any leftover bytes
+  std::string header;
+  int flags = O_WRONLY | O_CREAT | O_APPEND;
+  if (size_ == 0) {
+    header.assign(kHeaderMagic, sizeof(kHeaderMagic));
+    put_uint32(&header, base_checksum_);
+    flags |= O_TRUNC;
+  }
+  const std::string& data = header.empty() ? pending_ : header.append(pending_);
+
+  int fd;
+  OSI_NO_INTR(fd = open(path_.c_str(), flags,
+                        S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP));
+  if (fd == -1) {
+    LOG(ERROR) << __func__ << ": unable to open " << path_ << ": "
+               << strerror(errno);
+    return false;
+  }
+
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t ret;
+    OSI_NO_INTR(ret = write(fd, data.data() + written, data.size() - written));
+    if (ret == -1) {
+      LOG(ERROR) << __func__ << ": unable to write " << path_ << ": "
+                 << strerror(errno);
+      // Don't leave a partial record behind, it would hide later appends
+      if (ftruncate(fd, size_) == -1) {
+        LOG(ERROR) << __func__ << ": unable to truncate " << path_ << ": "
+                   << strerror(errno);
+      }
+      close(fd);
+      return false;
+    }
+    written += ret;
+  }
+
+  if (fsync(fd) == -1) {
+    LOG(WARNING) << __func__ << ": unable to fsync " << path_ << ": "
+                 << strerror(errno);
+  }
+  close(fd);
+
+  size_ += data.size();
+  pending_.clear();
+  return true;
+}
+
+bool BtifConfigJournal::Reset() {
+  pending_.clear();
+  size_ = 0;
+  if (unlink(path_.c_str()) == -1 && errno != ENOENT) {
+    LOG(ERROR) << __func__ << ": unable to remove " << path_ << ": "
+               << strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+void BtifConfigJournal::Append(char type, const std::string& section,
+                               const std::string& key,
+                               const std::string& value) {
+  size_t start = pending_.size();
+  pending_.push_back(type);
+  put_uint32(&pending_, section.size());
+  put_uint32(&pending_, key.size());
+  put_uint32(&pending_, value.size());
+  pending_.append(section);
+  pending_.append(key);
+  pending_.append(value);
+  put_uint32(&pending_,
+             checksum(pending_.data() + start, pending_.size() - start));
+}
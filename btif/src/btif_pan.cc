@@ -42,10 +42,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/ioctl.h>
-#include <sys/poll.h>
 #include <sys/prctl.h>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -417,18 +417,21 @@ int btpan_tap_send(int tap_fd, const RawAddress& src, const RawAddress& dst,
     eth_hdr.h_dest = dst;
     eth_hdr.h_src = src;
     eth_hdr.h_proto = htons(proto);
-    char packet[TAP_MAX_PKT_WRITE_LEN + sizeof(tETH_HDR)];
-    memcpy(packet, &eth_hdr, sizeof(tETH_HDR));
     if (len > TAP_MAX_PKT_WRITE_LEN) {
       LOG_ERROR(LOG_TAG, "btpan_tap_send eth packet size:%d is exceeded limit!",
                 len);
       return -1;
     }
-    memcpy(packet + sizeof(tETH_HDR), buf, len);
 
-    /* Send data to network interface */
+    /* Send data to network interface, prepending the ethernet header without
+     * copying the payload */
+    struct iovec iov[2];
+    iov[0].iov_base = &eth_hdr;
+    iov[0].iov_len = sizeof(tETH_HDR);
+    iov[1].iov_base = (void*)buf;
+    iov[1].iov_len = len;
     ssize_t ret;
-    OSI_NO_INTR(ret = write(tap_fd, packet, len + sizeof(tETH_HDR)));
+    OSI_NO_INTR(ret = writev(tap_fd, iov, 2));
     BTIF_TRACE_DEBUG("ret:%d", ret);
     return (int)ret;
   }
@@ -665,42 +668,33 @@ static void bta_pan_callback(tBTA_PAN_EVT event, tBTA_PAN* p_data) {
                         sizeof(tBTA_PAN), NULL);
 }
 
-#define IS_EXCEPTION(e) ((e) & (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL))
 static void btu_exec_tap_fd_read(int fd) {
-  struct pollfd ufd;
-
   if (fd == INVALID_FD || fd != btpan_cb.tap_fd) return;
 
   // Don't occupy BTU context too long, avoid buffer overruns and
   // give other profiles a chance to run by limiting the amount of memory
   // PAN can use.
+  // Frames are read until the TAP fd would block or BNEP stops taking them.
+  // The fd is non-blocking so no poll() is needed between reads.
   for (int i = 0; i < PAN_BUF_MAX && btif_is_enabled() && btpan_cb.flow; i++) {
-    BT_HDR* buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
-    buffer->offset = PAN_MINIMUM_OFFSET;
-    buffer->len = PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset;
-
-    uint8_t* packet = (uint8_t*)buffer + sizeof(BT_HDR) + buffer->offset;
-
     // If we don't have an undelivered packet left over, pull one from the TAP
     // driver.
     // We save it in the congest_packet right away in case we can't deliver it
-    // in this
-    // attempt.
+    // in this attempt: BNEP frees the buffer when its transmit queue is full.
     if (!btpan_cb.congest_packet_size) {
       ssize_t ret;
       OSI_NO_INTR(ret = read(fd, btpan_cb.congest_packet,
                              sizeof(btpan_cb.congest_packet)));
+      if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
       switch (ret) {
         case -1:
           BTIF_TRACE_ERROR("%s unable to read from driver: %s", __func__,
                            strerror(errno));
-          osi_free(buffer);
           // add fd back to monitor thread to try it again later
           btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
           return;
         case 0:
           BTIF_TRACE_WARNING("%s end of file reached.", __func__);
-          osi_free(buffer);
           // add fd back to monitor thread to process the exception
           btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
           return;
@@ -710,38 +704,31 @@ static void btu_exec_tap_fd_read(int fd) {
       }
     }
 
-    memcpy(packet, btpan_cb.congest_packet,
-           MIN(btpan_cb.congest_packet_size, buffer->len));
-    buffer->len = MIN(btpan_cb.congest_packet_size, buffer->len);
-
-    if (buffer->len > sizeof(tETH_HDR) && should_forward((tETH_HDR*)packet)) {
-      // Extract the ethernet header from the buffer since the PAN_WriteBuf
-      // inside
-      // forward_bnep can't handle two pointers that point inside the same GKI
-      // buffer.
-      tETH_HDR hdr;
-      memcpy(&hdr, packet, sizeof(tETH_HDR));
-
-      // Skip the ethernet header.
-      buffer->len -= sizeof(tETH_HDR);
-      buffer->offset += sizeof(tETH_HDR);
-      if (forward_bnep(&hdr, buffer) != FORWARD_CONGEST)
-        btpan_cb.congest_packet_size = 0;
-    } else {
+    // Extract the ethernet header and copy only the payload into the buffer,
+    // since the PAN_WriteBuf inside forward_bnep can't handle two pointers
+    // that point inside the same buffer.
+    int packet_size = btpan_cb.congest_packet_size;
+    tETH_HDR hdr;
+    if (packet_size > (int)sizeof(tETH_HDR))
+      memcpy(&hdr, btpan_cb.congest_packet, sizeof(tETH_HDR));
+    if (packet_size <= (int)sizeof(tETH_HDR) || !should_forward(&hdr)) {
       BTIF_TRACE_WARNING("%s dropping packet of length %d", __func__,
-                         buffer->len);
+                         packet_size);
       btpan_cb.congest_packet_size = 0;
-      osi_free(buffer);
+      continue;
     }
 
-    // Bail out of the loop if reading from the TAP fd would block.
-    ufd.fd = fd;
-    ufd.events = POLLIN;
-    ufd.revents = 0;
-
-    int ret;
-    OSI_NO_INTR(ret = poll(&ufd, 1, 0));
-    if (ret <= 0 || IS_EXCEPTION(ufd.revents)) break;
+    BT_HDR* buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
+    buffer->offset = PAN_MINIMUM_OFFSET;
+    buffer->len = MIN(packet_size - sizeof(tETH_HDR),
+                      PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset);
+    memcpy((uint8_t*)(buffer + 1) + buffer->offset,
+           btpan_cb.congest_packet + sizeof(tETH_HDR), buffer->len);
+
+    // Keep the frame for the next wakeup once BNEP's transmit queue is full;
+    // retrying it now cannot succeed before the queue drains.
+    if (forward_bnep(&hdr, buffer) == FORWARD_CONGEST) break;
+    btpan_cb.congest_packet_size = 0;
   }
 
   if (btpan_cb.flow) {
@@ -0,0 +1,155 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+
+#include "btif/include/btif_config_cache.h"
+#include "btif/include/btif_config_journal.h"
+
+using ::benchmark::State;
+
+namespace {
+
+const size_t kCapacity = 10000;
+const size_t kJournalMinCompactSize = 16 * 1024;
+const std::filesystem::path kConfigFile =
+    std::filesystem::temp_directory_path() / "config_journal_benchmark.conf";
+const std::filesystem::path kJournalFile =
+    std::filesystem::temp_directory_path() / "config_journal_benchmark.journal";
+
+std::string AddressFor(size_t index) {
+  char address[18];
+  snprintf(address, sizeof(address), "00:11:22:%02zx:%02zx:%02zx",
+           (index >> 16) & 0xff, (index >> 8) & 0xff, index & 0xff);
+  return address;
+}
+
+// A config with |num_sections| bonded devices, each with a typical set of keys
+void FillConfig(BtifConfigCache* cache, size_t num_sections) {
+  cache->SetString("Adapter", "Address", "12:34:56:78:90:ab");
+  for (size_t i = 0; i < num_sections; i++) {
+    std::string address = AddressFor(i);
+    cache->SetString(address, "Name", "Device " + std::to_string(i));
+    cache->SetInt(address, "DevClass", 0x240404);
+    cache->SetInt(address, "DevType", 1);
+    cache->SetInt(address, "AddrType", 0);
+    cache->SetString(address, "Service",
+                     "0000110b-0000-1000-8000-00805f9b34fb "
+                     "0000110e-0000-1000-8000-00805f9b34fb");
+    cache->SetString(address, "LinkKey", "fedcba0987654321fedcba0987654321");
+    cache->SetInt(address, "LinkKeyType", 5);
+  }
+}
+
+// Bytes of the logical change made by one iteration
+size_t ChangeSize(const std::string& section, const std::string& key,
+                  const std::string& value) {
+  return section.size() + key.size() + value.size();
+}
+
+// Baseline: every save rewrites the whole config file
+void BM_SaveFullFile(State& state) {
+  BtifConfigCache cache(kCapacity);
+  FillConfig(&cache, state.range(0));
+
+  size_t bytes_written = 0;
+  size_t change_bytes = 0;
+  size_t i = 0;
+  for (auto _ : state) {
+    std::string section = AddressFor(i % state.range(0));
+    std::string value = std::to_string(i++);
+    cache.SetString(section, "Timestamp", value);
+    change_bytes += ChangeSize(section, "Timestamp", value);
+
+    config_save(cache.PersistentSectionCopy(), kConfigFile);
+    bytes_written += std::filesystem::file_size(kConfigFile);
+  }
+
+  state.counters["bytes_per_save"] =
+      static_cast<double>(bytes_written) / state.iterations();
+  state.counters["write_amplification"] =
+      static_cast<double>(bytes_written) / change_bytes;
+  std::filesystem::remove(kConfigFile);
+}
+
+// Every save appends to the journal, which is compacted into the config file
+// once it reaches half the size of the file, as btif_config.cc does
+void BM_SaveJournal(State& state) {
+  BtifConfigCache cache(kCapacity);
+  FillConfig(&cache, state.range(0));
+  config_save(cache.PersistentSectionCopy(), kConfigFile);
+  size_t file_size = std::filesystem::file_size(kConfigFile);
+
+  BtifConfigJournal journal(kJournalFile);
+  journal.Reset();
+  cache.SetJournal(&journal);
+
+  size_t bytes_written = 0;
+  size_t change_bytes = 0;
+  size_t compactions = 0;
+  size_t i = 0;
+  for (auto _ : state) {
+    std::string section = AddressFor(i % state.range(0));
+    std::string value = std::to_string(i++);
+    cache.SetString(section, "Timestamp", value);
+    change_bytes += ChangeSize(section, "Timestamp", value);
+
+    size_t journal_size = journal.Size() + journal.PendingSize();
+    if (journal_size < std::max(kJournalMinCompactSize, file_size / 2)) {
+      bytes_written += journal.PendingSize();
+      journal.Flush();
+    } else {
+      config_save(cache.PersistentSectionCopy(), kConfigFile);
+      journal.Reset();
+      file_size = std::filesystem::file_size(kConfigFile);
+      bytes_written += file_size;
+      compactions++;
+    }
+  }
+
+  cache.SetJournal(nullptr);
+  state.counters["bytes_per_save"] =
+      static_cast<double>(bytes_written) / state.iterations();
+  state.counters["write_amplification"] =
+      static_cast<double>(bytes_written) / change_bytes;
+  state.counters["compactions"] = compactions;
+  journal.Reset();
+  std::filesystem::remove(kConfigFile);
+}
+
+}  // namespace
+
+BENCHMARK(BM_SaveFullFile)->Arg(10)->Arg(100)->Arg(1000)->Arg(5000);
+BENCHMARK(BM_SaveJournal)->Arg(10)->Arg(100)->Arg(1000)->Arg(5000);
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
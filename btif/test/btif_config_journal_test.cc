@@ -0,0 +1,294 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "btif/include/btif_config_journal.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "btif/include/btif_config_cache.h"
+
+namespace {
+
+const int kCapacity = 3;
+const std::string kBtAddr1 = "11:22:33:44:55:66";
+const std::string kBtAddr2 = "AA:BB:CC:DD:EE:FF";
+const std::string kBtAdapter = "Adapter";
+const uint32_t kBaseChecksum = 0x2f5a1c08;
+const std::filesystem::path kTestJournalFile =
+    std::filesystem::temp_directory_path() / "config_journal_test.journal";
+const std::filesystem::path kTestConfigFile =
+    std::filesystem::temp_directory_path() / "config_journal_test.conf";
+const std::filesystem::path kTestBackupFile =
+    std::filesystem::temp_directory_path() / "config_journal_test.bak";
+
+std::string ConfigToString(const config_t& config) {
+  std::stringstream out;
+  for (const auto& section : config.sections) {
+    out << "[" << section.name << "]\n";
+    for (const auto& entry : section.entries) {
+      out << entry.key << " = " << entry.value << "\n";
+    }
+  }
+  return out.str();
+}
+
+class BtifConfigJournalTest : public ::testing::Test {
+ protected:
+  void SetUp() override { RemoveFiles(); }
+  void TearDown() override { RemoveFiles(); }
+
+  void RemoveFiles() {
+    std::filesystem::remove(kTestJournalFile);
+    std::filesystem::remove(kTestConfigFile);
+    std::filesystem::remove(kTestBackupFile);
+  }
+};
+
+}  // namespace
+
+namespace testing {
+
+TEST_F(BtifConfigJournalTest, test_replay_set_and_remove) {
+  BtifConfigJournal journal(kTestJournalFile);
+  journal.SetBase(kBaseChecksum);
+  journal.Set(kBtAdapter, "Address", "12:34:56:78:90:AB");
+  journal.Set(kBtAddr1, "Name", "Headset_1");
+  journal.Set(kBtAddr1, "LinkKey", "fedcba0987654321fedcba0987654321");
+  journal.Set(kBtAddr2, "Name", "Headset_2");
+  journal.RemoveKey(kBtAddr1, "Name");
+  journal.RemoveSection(kBtAddr2);
+  EXPECT_TRUE(journal.Flush());
+  EXPECT_EQ(journal.PendingSize(), 0u);
+  EXPECT_EQ(journal.Size(), std::filesystem::file_size(kTestJournalFile));
+
+  config_t expected;
+  config_set_string(&expected, kBtAdapter, "Address", "12:34:56:78:90:AB");
+  config_set_string(&expected, kBtAddr1, "LinkKey",
+                    "fedcba0987654321fedcba0987654321");
+
+  config_t config;
+  BtifConfigJournal reopened(kTestJournalFile);
+  EXPECT_EQ(reopened.Replay(&config, kBaseChecksum), 6u);
+  EXPECT_EQ(ConfigToString(config), ConfigToString(expected));
+  EXPECT_EQ(reopened.Size(), journal.Size());
+}
+
+TEST_F(BtifConfigJournalTest, test_changes_written_on_flush_only) {
+  BtifConfigJournal journal(kTestJournalFile);
+  journal.SetBase(kBaseChecksum);
+  journal.Set(kBtAdapter, "Address", "12:34:56:78:90:AB");
+  EXPECT_GT(journal.PendingSize(), 0u);
+  EXPECT_FALSE(std::filesystem::exists(kTestJournalFile));
+
+  EXPECT_TRUE(journal.Flush());
+  size_t size = journal.Size();
+  journal.Set(kBtAdapter, "Name", "Phone");
+  EXPECT_TRUE(journal.Flush());
+  EXPECT_GT(journal.Size(), size);
+
+  config_t config;
+  EXPECT_EQ(
+      BtifConfigJournal(kTestJournalFile).Replay(&config, kBaseChecksum),
+      2u);
+}
+
+TEST_F(BtifConfigJournalTest, test_reset_drops_journal) {
+  BtifConfigJournal journal(kTestJournalFile);
+  journal.SetBase(kBaseChecksum);
+  journal.Set(kBtAdapter, "Address", "12:34:56:78:90:AB");
+  EXPECT_TRUE(journal.Flush());
+  journal.Set(kBtAdapter, "Name", "Phone");
+
+  EXPECT_TRUE(journal.Reset());
+  EXPECT_FALSE(std::filesystem::exists(kTestJournalFile));
+  EXPECT_EQ(journal.Size(), 0u);
+  EXPECT_EQ(journal.PendingSize(), 0u);
+
+  config_t config;
+  EXPECT_EQ(journal.Replay(&config, kBaseChecksum), 0u);
+  EXPECT_TRUE(config.sections.empty());
+}
+
+/* A record torn by a crash during an append is dropped, together with the
+ * bytes after it, so that later appends are not hidden behind it */
+TEST_F(BtifConfigJournalTest, test_torn_record_truncated) {
+  BtifConfigJournal journal(kTestJournalFile);
+  journal.SetBase(kBaseChecksum);
+  journal.Set(kBtAdapter, "Address", "12:34:56:78:90:AB");
+  EXPECT_TRUE(journal.Flush());
+  size_t valid_size = journal.Size();
+  journal.Set(kBtAdapter, "Name", "Phone");
+  EXPECT_TRUE(journal.Flush());
+  std::filesystem::resize_file(kTestJournalFile, journal.Size() - 3);
+
+  config_t config;
+  BtifConfigJournal reopened(kTestJournalFile);
+  EXPECT_EQ(reopened.Replay(&config, kBaseChecksum), 1u);
+  EXPECT_EQ(reopened.Size(), valid_size);
+  EXPECT_EQ(std::filesystem::file_size(kTestJournalFile), valid_size);
+  EXPECT_FALSE(config_has_key(config, kBtAdapter, "Name"));
+
+  reopened.Set(kBtAdapter, "Name", "Phone");
+  EXPECT_TRUE(reopened.Flush());
+  config_t replayed;
+  EXPECT_EQ(
+      BtifConfigJournal(kTestJournalFile).Replay(&replayed, kBaseChecksum),
+      2u);
+  EXPECT_TRUE(config_has_key(replayed, kBtAdapter, "Name"));
+}
+
+TEST_F(BtifConfigJournalTest, test_corrupt_record_stops_replay) {
+  BtifConfigJournal journal(kTestJournalFile);
+  journal.SetBase(kBaseChecksum);
+  journal.Set(kBtAdapter, "Address", "12:34:56:78:90:AB");
+  journal.Set(kBtAdapter, "Name", "Phone");
+  EXPECT_TRUE(journal.Flush());
+
+  // flip the last byte of the value of the second record
+  std::fstream file(kTestJournalFile,
+                    std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp(journal.Size() - sizeof(uint32_t) - 1);
+  file.put('X');
+  file.close();
+
+  config_t config;
+  EXPECT_EQ(
+      BtifConfigJournal(kTestJournalFile).Replay(&config, kBaseChecksum),
+      1u);
+  EXPECT_TRUE(config_has_key(config, kBtAdapter, "Address"));
+  EXPECT_FALSE(config_has_key(config, kBtAdapter, "Name"));
+}
+
+/* Only changes to persistent sections are journaled, and replaying them on top
+ * of the initial config gives the persistent sections of the cache */
+TEST_F(BtifConfigJournalTest, test_cache_journals_persistent_changes) {
+  config_t initial;
+  config_set_string(&initial, kBtAdapter, "Address", "12:34:56:78:90:AB");
+
+  BtifConfigCache cache(kCapacity);
+  BtifConfigJournal journal(kTestJournalFile);
+  journal.SetBase(kBaseChecksum);
+  cache.Init(std::make_unique<config_t>(initial));
+  cache.SetJournal(&journal);
+
+  // unpaired devices are not persisted
+  cache.SetString(kBtAddr1, "Name", "Headset_1");
+  cache.SetInt(kBtAddr1, "DevClass", 0x240404);
+  EXPECT_EQ(journal.PendingSize(), 0u);
+
+  // pairing moves the whole section to the persistent sections
+  cache.SetString(kBtAddr1, "LinkKey", "fedcba0987654321fedcba0987654321");
+  EXPECT_GT(journal.PendingSize(), 0u);
+
+  // rewriting a value that didn't change is not recorded
+  size_t pending = journal.PendingSize();
+  cache.SetString(kBtAddr1, "Name", "Headset_1");
+  EXPECT_EQ(journal.PendingSize(), pending);
+
+  cache.SetString(kBtAdapter, "Name", "Phone");
+  cache.SetString(kBtAddr2, "Name", "Headset_2");
+  cache.SetString(kBtAddr2, "LinkKey", "0123456789abcdef0123456789abcdef");
+  cache.RemoveKey(kBtAddr1, "DevClass");
+  // removing the link key unpairs the device
+  cache.RemoveKey(kBtAddr2, "LinkKey");
+  EXPECT_TRUE(journal.Flush());
+
+  config_t replayed = initial;
+  EXPECT_GT(
+      BtifConfigJournal(kTestJournalFile).Replay(&replayed, kBaseChecksum),
+      0u);
+  EXPECT_EQ(ConfigToString(replayed),
+            ConfigToString(cache.PersistentSectionCopy()));
+  EXPECT_FALSE(replayed.Has(kBtAddr2));
+}
+
+/* The process dies while compacting, after the config file was moved to the
+ * backup and before the new config file was saved: the journaled changes are
+ * replayed on top of the backup on the next start */
+TEST_F(BtifConfigJournalTest, test_replay_on_backup_after_crash_in_compaction) {
+  config_t base;
+  config_set_string(&base, kBtAdapter, "Address", "12:34:56:78:90:AB");
+  ASSERT_TRUE(config_save(base, kTestConfigFile));
+  uint32_t base_checksum;
+  ASSERT_TRUE(
+      BtifConfigJournal::GetFileChecksum(kTestConfigFile, &base_checksum));
+
+  BtifConfigJournal journal(kTestJournalFile);
+  journal.SetBase(base_checksum);
+  journal.Set(kBtAddr1, "LinkKey", "fedcba0987654321fedcba0987654321");
+  journal.Set(kBtAddr1, "Name", "Headset_1");
+  EXPECT_TRUE(journal.Flush());
+
+  // compaction starts: the config file becomes the backup, then the crash
+  std::filesystem::rename(kTestConfigFile, kTestBackupFile);
+  ASSERT_FALSE(std::filesystem::exists(kTestConfigFile));
+
+  std::unique_ptr<config_t> config = config_new(kTestBackupFile.c_str());
+  ASSERT_NE(config, nullptr);
+  uint32_t backup_checksum;
+  ASSERT_TRUE(
+      BtifConfigJournal::GetFileChecksum(kTestBackupFile, &backup_checksum));
+  EXPECT_EQ(backup_checksum, base_checksum);
+  EXPECT_EQ(BtifConfigJournal(kTestJournalFile)
+                .Replay(config.get(), backup_checksum),
+            2u);
+  const std::string* link_key =
+      config_get_string(*config, kBtAddr1, "LinkKey", nullptr);
+  ASSERT_NE(link_key, nullptr);
+  EXPECT_EQ(*link_key, "fedcba0987654321fedcba0987654321");
+  EXPECT_TRUE(config_has_key(*config, kBtAddr1, "Name"));
+  EXPECT_TRUE(config_has_key(*config, kBtAdapter, "Address"));
+}
+
+/* The process dies after the config file was saved in full and before the
+ * journal was dropped: the journal doesn't apply to the new config file */
+TEST_F(BtifConfigJournalTest, test_journal_dropped_on_other_base) {
+  config_t base;
+  config_set_string(&base, kBtAdapter, "Address", "12:34:56:78:90:AB");
+  ASSERT_TRUE(config_save(base, kTestConfigFile));
+  uint32_t base_checksum;
+  ASSERT_TRUE(
+      BtifConfigJournal::GetFileChecksum(kTestConfigFile, &base_checksum));
+
+  BtifConfigJournal journal(kTestJournalFile);
+  journal.SetBase(base_checksum);
+  journal.RemoveSection(kBtAddr1);
+  EXPECT_TRUE(journal.Flush());
+
+  // the new config file was paired again since the journaled removal
+  config_t saved = base;
+  config_set_string(&saved, kBtAddr1, "LinkKey",
+                    "fedcba0987654321fedcba0987654321");
+  ASSERT_TRUE(config_save(saved, kTestConfigFile));
+  uint32_t saved_checksum;
+  ASSERT_TRUE(
+      BtifConfigJournal::GetFileChecksum(kTestConfigFile, &saved_checksum));
+  EXPECT_NE(saved_checksum, base_checksum);
+
+  std::unique_ptr<config_t> config = config_new(kTestConfigFile.c_str());
+  ASSERT_NE(config, nullptr);
+  BtifConfigJournal reopened(kTestJournalFile);
+  EXPECT_EQ(reopened.Replay(config.get(), saved_checksum), 0u);
+  EXPECT_TRUE(config_has_key(*config, kBtAddr1, "LinkKey"));
+  EXPECT_FALSE(std::filesystem::exists(kTestJournalFile));
+  EXPECT_EQ(reopened.Size(), 0u);
+}
+
+}  // namespace testing
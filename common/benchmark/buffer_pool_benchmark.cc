@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+
+#include <array>
+
+#include "internal_include/bt_target.h"
+#include "osi/include/allocator.h"
+#include "osi/include/buffer_pool.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// Number of buffers each simulated link keeps in flight before releasing the
+// oldest one, roughly the controller's ACL buffer count.
+constexpr size_t kInFlight = 8;
+
+// Buffer sizes (BT_HDR included) for the simulated traffic.
+constexpr size_t kA2dpMediaSize = 1021 + 32;
+constexpr size_t kLeDataSize = 251 + 32;
+
+// Thread 0 streams A2DP media, every other thread is an LE link. Each thread
+// keeps |kInFlight| buffers alive and recycles them in FIFO order.
+void RunTraffic(State& state, const allocator_t* allocator) {
+  const size_t size =
+      (state.thread_index == 0) ? kA2dpMediaSize : kLeDataSize;
+  std::array<void*, kInFlight> in_flight{};
+  size_t next = 0;
+  for (auto _ : state) {
+    if (in_flight[next] != nullptr) allocator->free(in_flight[next]);
+    in_flight[next] = allocator->alloc(size);
+    ::benchmark::DoNotOptimize(in_flight[next]);
+    next = (next + 1) % kInFlight;
+  }
+  for (void* buffer : in_flight) {
+    if (buffer != nullptr) allocator->free(buffer);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+static void BM_OsiMallocTraffic(State& state) {
+  RunTraffic(state, &allocator_malloc);
+}
+BENCHMARK(BM_OsiMallocTraffic)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_BufferPoolTraffic(State& state) {
+  RunTraffic(state, &allocator_buffer_pool);
+}
+BENCHMARK(BM_BufferPoolTraffic)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_OsiMallocDefaultBuffer(State& state) {
+  for (auto _ : state) {
+    void* buffer = osi_malloc(BT_DEFAULT_BUFFER_SIZE);
+    ::benchmark::DoNotOptimize(buffer);
+    osi_free(buffer);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OsiMallocDefaultBuffer);
+
+static void BM_BufferPoolDefaultBuffer(State& state) {
+  for (auto _ : state) {
+    void* buffer = buffer_pool_alloc(BT_DEFAULT_BUFFER_SIZE);
+    ::benchmark::DoNotOptimize(buffer);
+    buffer_pool_free(buffer);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BufferPoolDefaultBuffer);
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
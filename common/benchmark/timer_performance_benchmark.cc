@@ -19,6 +19,7 @@
 #include <base/threading/thread.h>
 #include <benchmark/benchmark.h>
 #include <future>
+#include <vector>
 
 #include "common/message_loop_thread.h"
 #include "common/once_timer.h"
@@ -203,6 +204,69 @@ BENCHMARK_REGISTER_F(BM_OsiPeriodicAlarmTimer, periodic_accuracy)
     ->Iterations(1)
     ->UseRealTime();
 
+void AlarmNoop(void*) {}
+
+// Measures the cost of arming and canceling one alarm while a given number of
+// other alarms are pending. The pending alarms are spread over a long period
+// so that none of them fire during the measurement.
+class BM_OsiAlarmArmCancel : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    auto pending_count = static_cast<size_t>(st.range(0));
+    for (size_t i = 0; i < pending_count; i++) {
+      alarm_t* alarm = alarm_new("osi_alarm_pending");
+      alarm_set(alarm, kPendingBaseMs + (i * 7919) % kPendingSpreadMs,
+                &AlarmNoop, nullptr);
+      pending_alarms_.push_back(alarm);
+    }
+    alarm_ = alarm_new("osi_alarm_arm_cancel");
+  }
+
+  void TearDown(State& st) override {
+    alarm_free(alarm_);
+    alarm_ = nullptr;
+    for (alarm_t* alarm : pending_alarms_) alarm_free(alarm);
+    pending_alarms_.clear();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  static constexpr uint64_t kPendingBaseMs = 60 * 60 * 1000;
+  static constexpr uint64_t kPendingSpreadMs = 60 * 60 * 1000;
+  std::vector<alarm_t*> pending_alarms_;
+  alarm_t* alarm_ = nullptr;
+};
+
+BENCHMARK_DEFINE_F(BM_OsiAlarmArmCancel, arm_cancel)(State& state) {
+  uint64_t offset_ms = 0;
+  for (auto _ : state) {
+    alarm_set(alarm_, kPendingBaseMs + offset_ms, &AlarmNoop, nullptr);
+    alarm_cancel(alarm_);
+    offset_ms = (offset_ms + 104729) % kPendingSpreadMs;
+  }
+  state.SetItemsProcessed(state.iterations());
+};
+
+BENCHMARK_REGISTER_F(BM_OsiAlarmArmCancel, arm_cancel)
+    ->Arg(10)
+    ->Arg(1000)
+    ->Arg(100000);
+
+BENCHMARK_DEFINE_F(BM_OsiAlarmArmCancel, rearm)(State& state) {
+  uint64_t offset_ms = 0;
+  for (auto _ : state) {
+    alarm_set(alarm_, kPendingBaseMs + offset_ms, &AlarmNoop, nullptr);
+    offset_ms = (offset_ms + 104729) % kPendingSpreadMs;
+  }
+  alarm_cancel(alarm_);
+  state.SetItemsProcessed(state.iterations());
+};
+
+BENCHMARK_REGISTER_F(BM_OsiAlarmArmCancel, rearm)
+    ->Arg(10)
+    ->Arg(1000)
+    ->Arg(100000);
+
 class BM_AlarmTaskPeriodicTimer : public ::benchmark::Fixture {
  protected:
   void SetUp(State& st) override {
@@ -136,6 +136,15 @@ extern "C" {
 g722_encode_state_t *g722_encode_init(g722_encode_state_t *s, unsigned int rate, int options);
 int g722_encode_release(g722_encode_state_t *s);
 int g722_encode(g722_encode_state_t *s, uint8_t g722_data[], const int16_t amp[], int len);
+/* Encode the |len| samples of |left_amp| and of |right_amp| with the |left| and
+   |right| encoders into |left_data| and |right_data|, with the same result as
+   calling g722_encode() on each channel but faster. |len| must be even.
+   Returns the number of bytes written to each of |left_data| and
+   |right_data|. */
+int g722_encode_stereo(g722_encode_state_t *left, g722_encode_state_t *right,
+                       uint8_t left_data[], uint8_t right_data[],
+                       const int16_t left_amp[], const int16_t right_amp[],
+                       int len);
 
 g722_decode_state_t *g722_decode_init(g722_decode_state_t *s, unsigned int rate, int options);
 int g722_decode_release(g722_decode_state_t *s);
@@ -32,6 +32,12 @@
 #include "g722_typedefs.h"
 #include "g722_enc_dec.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #if !defined(FALSE)
 #define FALSE 0
 #endif
@@ -268,8 +274,23 @@ static int16_t ihp[3] = {0, 3, 2};
 static int16_t wh[3] = {0, -214, 798};
 static int16_t rh2[4] = {2, 1, 2, 1};
 
-int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
-                       const int16_t amp[], int len)
+/* Taps of the transmit QMF, applied to the 24 samples of the signal history:
+   the sum and the difference of the even and odd tap accumulators, that give
+   the low band and the high band. */
+static const int16_t qmf_low_taps[24] =
+{
+       3,  -11,  -11,   53,   12, -156,   32,  362, -210, -805,  951, 3876,
+    3876,  951, -805, -210,  362,   32, -156,   12,   53,  -11,  -11,    3
+};
+static const int16_t qmf_high_taps[24] =
+{
+      -3,  -11,   11,   53,  -12, -156,  -32,  362,  210, -805, -951, 3876,
+   -3876,  951,  805, -210, -362,   32,  156,   12,  -53,  -11,   11,    3
+};
+
+/* Encode the low band sample |xlow| and the high band sample |xhigh|, and
+   return their G.722 code. */
+static __inline int encode_bands(g722_encode_state_t *s, int xlow, int xhigh)
 {
     int dlow;
     int dhigh;
@@ -283,6 +304,118 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
     int wd3;
     int eh;
     int mih;
+    int i;
+    int ihigh;
+    int ilow;
+    int code;
+
+    /* Block 1L, SUBTRA */
+    el = saturate(xlow - s->band[0].s);
+
+    /* Block 1L, QUANTL */
+    wd = (el >= 0)  ?  el  :  -(el + 1);
+
+    for (i = 1;  i < 30;  i++)
+    {
+        wd1 = (q6[i]*s->band[0].det) >> 12;
+        if (wd < wd1)
+            break;
+    }
+    ilow = (el < 0)  ?  iln[i]  :  ilp[i];
+
+    /* Block 2L, INVQAL */
+    ril = ilow >> 2;
+    wd2 = qm4[ril];
+    dlow = (s->band[0].det*wd2) >> 15;
+
+    /* Block 3L, LOGSCL */
+    il4 = rl42[ril];
+    wd = (s->band[0].nb*127) >> 7;
+    s->band[0].nb = wd + wl[il4];
+    if (s->band[0].nb < 0)
+        s->band[0].nb = 0;
+    else if (s->band[0].nb > 18432)
+        s->band[0].nb = 18432;
+
+    /* Block 3L, SCALEL */
+    wd1 = (s->band[0].nb >> 6) & 31;
+    wd2 = 8 - (s->band[0].nb >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    s->band[0].det = wd3 << 2;
+
+    block4(&s->band[0], dlow);
+    {
+        int nb;
+
+        /* Block 1H, SUBTRA */
+        eh = saturate(xhigh - s->band[1].s);
+
+        /* Block 1H, QUANTH */
+        wd = (eh >= 0)  ?  eh  :  -(eh + 1);
+        wd1 = (564*s->band[1].det) >> 12;
+        mih = (wd >= wd1)  ?  2  :  1;
+        ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
+
+        /* Block 2H, INVQAH */
+        wd2 = qm2[ihigh];
+        dhigh = (s->band[1].det*wd2) >> 15;
+
+        /* Block 3H, LOGSCH */
+        ih2 = rh2[ihigh];
+        wd = (s->band[1].nb*127) >> 7;
+
+        nb = wd + wh[ih2];
+        if (nb < 0)
+            nb = 0;
+        else if (nb > 22528)
+            nb = 22528;
+        s->band[1].nb = nb;
+
+        /* Block 3H, SCALEH */
+        wd1 = (s->band[1].nb >> 6) & 31;
+        wd2 = 10 - (s->band[1].nb >> 11);
+        wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+        s->band[1].det = wd3 << 2;
+
+        block4(&s->band[1], dhigh);
+#if   BITS_PER_SAMPLE == 8
+        code = ((ihigh << 6) | ilow);
+#elif BITS_PER_SAMPLE == 7
+        code = ((ihigh << 6) | ilow) >> 1;
+#elif BITS_PER_SAMPLE == 6
+        code = ((ihigh << 6) | ilow) >> 2;
+#endif
+    }
+    return code;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Write |code| to |g722_data|, that holds |g722_bytes| bytes, and return the
+   new number of bytes. */
+static __inline int put_code(g722_encode_state_t *s, uint8_t g722_data[],
+                             int g722_bytes, int code)
+{
+#if PACKED_OUTPUT == 1
+    /* Pack the code bits */
+    s->out_buffer |= (code << s->out_bits);
+    s->out_bits += s->bits_per_sample;
+    if (s->out_bits >= 8)
+    {
+        g722_data[g722_bytes++] = (uint8_t) (s->out_buffer & 0xFF);
+        s->out_bits -= 8;
+        s->out_buffer >>= 8;
+    }
+#else
+    (void) s;
+    g722_data[g722_bytes++] = (uint8_t) code;
+#endif
+    return g722_bytes;
+}
+/*- End of function --------------------------------------------------------*/
+
+int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
+                       const int16_t amp[], int len)
+{
     int i;
     int j;
     /* Low and high band PCM from the QMF */
@@ -292,9 +425,6 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
     /* Even and odd tap accumulators */
     int sumeven;
     int sumodd;
-    int ihigh;
-    int ilow;
-    int code;
 
     g722_bytes = 0;
     xhigh = 0;
@@ -340,99 +470,179 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
 #endif
             }
         }
-        /* Block 1L, SUBTRA */
-        el = saturate(xlow - s->band[0].s);
+        g722_bytes = put_code(s, g722_data, g722_bytes,
+                              encode_bands(s, xlow, xhigh));
+    }
+    return g722_bytes;
+}
+/*- End of function --------------------------------------------------------*/
 
-        /* Block 1L, QUANTL */
-        wd = (el >= 0)  ?  el  :  -(el + 1);
+/* Apply the transmit QMF to the 24 samples of history at |xl| and |xr|, of the
+   left and right channels. |sums| gets the low band and high band sums of the
+   left channel, then of the right channel, before scaling. */
+#if defined(__SSE2__)
+static __inline void qmf_stereo(const int16_t *xl, const int16_t *xr,
+                                int32_t sums[4])
+{
+    __m128i low[3];
+    __m128i high[3];
+    __m128i acc[4];
+    __m128i x;
+    __m128i s01;
+    __m128i s23;
+    int i;
 
-        for (i = 1;  i < 30;  i++)
-        {
-            wd1 = (q6[i]*s->band[0].det) >> 12;
-            if (wd < wd1)
-                break;
-        }
-        ilow = (el < 0)  ?  iln[i]  :  ilp[i];
-
-        /* Block 2L, INVQAL */
-        ril = ilow >> 2;
-        wd2 = qm4[ril];
-        dlow = (s->band[0].det*wd2) >> 15;
-
-        /* Block 3L, LOGSCL */
-        il4 = rl42[ril];
-        wd = (s->band[0].nb*127) >> 7;
-        s->band[0].nb = wd + wl[il4];
-        if (s->band[0].nb < 0)
-            s->band[0].nb = 0;
-        else if (s->band[0].nb > 18432)
-            s->band[0].nb = 18432;
-
-        /* Block 3L, SCALEL */
-        wd1 = (s->band[0].nb >> 6) & 31;
-        wd2 = 8 - (s->band[0].nb >> 11);
-        wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-        s->band[0].det = wd3 << 2;
+    for (i = 0;  i < 4;  i++)
+        acc[i] = _mm_setzero_si128();
+    for (i = 0;  i < 3;  i++)
+    {
+        low[i] = _mm_loadu_si128((const __m128i *) &qmf_low_taps[8*i]);
+        high[i] = _mm_loadu_si128((const __m128i *) &qmf_high_taps[8*i]);
+        x = _mm_loadu_si128((const __m128i *) &xl[8*i]);
+        acc[0] = _mm_add_epi32(acc[0], _mm_madd_epi16(x, low[i]));
+        acc[1] = _mm_add_epi32(acc[1], _mm_madd_epi16(x, high[i]));
+        x = _mm_loadu_si128((const __m128i *) &xr[8*i]);
+        acc[2] = _mm_add_epi32(acc[2], _mm_madd_epi16(x, low[i]));
+        acc[3] = _mm_add_epi32(acc[3], _mm_madd_epi16(x, high[i]));
+    }
+    /* Sum the lanes of each accumulator */
+    s01 = _mm_add_epi32(_mm_unpacklo_epi32(acc[0], acc[1]),
+                        _mm_unpackhi_epi32(acc[0], acc[1]));
+    s23 = _mm_add_epi32(_mm_unpacklo_epi32(acc[2], acc[3]),
+                        _mm_unpackhi_epi32(acc[2], acc[3]));
+    _mm_storeu_si128((__m128i *) sums,
+                     _mm_add_epi32(_mm_unpacklo_epi64(s01, s23),
+                                   _mm_unpackhi_epi64(s01, s23)));
+}
+#elif defined(__ARM_NEON)
+static __inline int32x2_t qmf_pair_sum(int32x4_t a, int32x4_t b)
+{
+    return vpadd_s32(vpadd_s32(vget_low_s32(a), vget_high_s32(a)),
+                     vpadd_s32(vget_low_s32(b), vget_high_s32(b)));
+}
+
+static __inline void qmf_stereo(const int16_t *xl, const int16_t *xr,
+                                int32_t sums[4])
+{
+    int16x4_t low;
+    int16x4_t high;
+    int16x4_t x;
+    int32x4_t acc[4];
+    int i;
 
-        block4(&s->band[0], dlow);
+    for (i = 0;  i < 4;  i++)
+        acc[i] = vdupq_n_s32(0);
+    for (i = 0;  i < 6;  i++)
+    {
+        low = vld1_s16(&qmf_low_taps[4*i]);
+        high = vld1_s16(&qmf_high_taps[4*i]);
+        x = vld1_s16(&xl[4*i]);
+        acc[0] = vmlal_s16(acc[0], x, low);
+        acc[1] = vmlal_s16(acc[1], x, high);
+        x = vld1_s16(&xr[4*i]);
+        acc[2] = vmlal_s16(acc[2], x, low);
+        acc[3] = vmlal_s16(acc[3], x, high);
+    }
+    vst1q_s32(sums, vcombine_s32(qmf_pair_sum(acc[0], acc[1]),
+                                 qmf_pair_sum(acc[2], acc[3])));
+}
+#else
+static __inline void qmf_stereo(const int16_t *xl, const int16_t *xr,
+                                int32_t sums[4])
+{
+    int i;
+
+    for (i = 0;  i < 4;  i++)
+        sums[i] = 0;
+    for (i = 0;  i < 24;  i++)
+    {
+        sums[0] += xl[i]*qmf_low_taps[i];
+        sums[1] += xl[i]*qmf_high_taps[i];
+        sums[2] += xr[i]*qmf_low_taps[i];
+        sums[3] += xr[i]*qmf_high_taps[i];
+    }
+}
+#endif
+/*- End of function --------------------------------------------------------*/
+
+/* Sample pairs filtered at once by g722_encode_stereo() */
+#define STEREO_BLOCK_PAIRS (64)
+
+int g722_encode_stereo(g722_encode_state_t *left, g722_encode_state_t *right,
+                       uint8_t left_data[], uint8_t right_data[],
+                       const int16_t left_amp[], const int16_t right_amp[],
+                       int len)
+{
+    /* Signal history for the QMF, followed by the samples of the block */
+    int16_t x[2][22 + 2*STEREO_BLOCK_PAIRS];
+    int32_t sums[4];
+    int xlow;
+    int xhigh;
+    int left_bytes;
+    int right_bytes;
+    int pairs;
+    int i;
+    int j;
+    int k;
+
+    if (left->itu_test_mode  ||  right->itu_test_mode)
+    {
+        g722_encode(left, left_data, left_amp, len);
+        return g722_encode(right, right_data, right_amp, len);
+    }
+
+    /* The samples come from the audio, so the history fits in 16 bits */
+    for (i = 0;  i < 22;  i++)
+    {
+        x[0][i] = (int16_t) left->x[i + 2];
+        x[1][i] = (int16_t) right->x[i + 2];
+    }
+
+    left_bytes = 0;
+    right_bytes = 0;
+    for (j = 0;  j + 1 < len;  j += 2*pairs)
+    {
+        pairs = (len - j)/2;
+        if (pairs > STEREO_BLOCK_PAIRS)
+            pairs = STEREO_BLOCK_PAIRS;
+        memcpy(&x[0][22], &left_amp[j], 2*pairs*sizeof(int16_t));
+        memcpy(&x[1][22], &right_amp[j], 2*pairs*sizeof(int16_t));
+
+        for (k = 0;  k < pairs;  k++)
         {
-	    int nb;
-
-            /* Block 1H, SUBTRA */
-            eh = saturate(xhigh - s->band[1].s);
-
-            /* Block 1H, QUANTH */
-            wd = (eh >= 0)  ?  eh  :  -(eh + 1);
-            wd1 = (564*s->band[1].det) >> 12;
-            mih = (wd >= wd1)  ?  2  :  1;
-            ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
-
-            /* Block 2H, INVQAH */
-            wd2 = qm2[ihigh];
-            dhigh = (s->band[1].det*wd2) >> 15;
-
-            /* Block 3H, LOGSCH */
-            ih2 = rh2[ihigh];
-            wd = (s->band[1].nb*127) >> 7;
-
-            nb = wd + wh[ih2];
-            if (nb < 0)
-                nb = 0;
-            else if (nb > 22528)
-                nb = 22528;
-	    s->band[1].nb = nb;
-
-            /* Block 3H, SCALEH */
-            wd1 = (s->band[1].nb >> 6) & 31;
-            wd2 = 10 - (s->band[1].nb >> 11);
-            wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-            s->band[1].det = wd3 << 2;
-
-            block4(&s->band[1], dhigh);
-#if   BITS_PER_SAMPLE == 8
-            code = ((ihigh << 6) | ilow);
-#elif BITS_PER_SAMPLE == 7
-            code = ((ihigh << 6) | ilow) >> 1;
-#elif BITS_PER_SAMPLE == 6
-            code = ((ihigh << 6) | ilow) >> 2;
+            qmf_stereo(&x[0][2*k], &x[1][2*k], sums);
+
+            /* Same scaling as in g722_encode() */
+            xlow = sums[0] >> 14;
+            xhigh = sums[1] >> 14;
+#ifdef RUN_LIKE_REFERENCE_G722
+            xlow = limitValues(xlow);
+            xhigh = limitValues(xhigh);
 #endif
-        }
+            left_bytes = put_code(left, left_data, left_bytes,
+                                  encode_bands(left, xlow, xhigh));
 
-#if PACKED_OUTPUT == 1
-            /* Pack the code bits */
-            s->out_buffer |= (code << s->out_bits);
-            s->out_bits += s->bits_per_sample;
-            if (s->out_bits >= 8)
-            {
-                g722_data[g722_bytes++] = (uint8_t) (s->out_buffer & 0xFF);
-                s->out_bits -= 8;
-                s->out_buffer >>= 8;
-            }
-#else
-            g722_data[g722_bytes++] = (uint8_t) code;
+            xlow = sums[2] >> 14;
+            xhigh = sums[3] >> 14;
+#ifdef RUN_LIKE_REFERENCE_G722
+            xlow = limitValues(xlow);
+            xhigh = limitValues(xhigh);
 #endif
+            right_bytes = put_code(right, right_data, right_bytes,
+                                   encode_bands(right, xlow, xhigh));
+        }
+
+        /* Save the history where g722_encode() keeps it, and move the end of
+           the block to the start for the next one */
+        for (i = 0;  i < 24;  i++)
+        {
+            left->x[i] = x[0][2*pairs - 2 + i];
+            right->x[i] = x[1][2*pairs - 2 + i];
+        }
+        memmove(&x[0][0], &x[0][2*pairs], 22*sizeof(int16_t));
+        memmove(&x[1][0], &x[1][2*pairs], 22*sizeof(int16_t));
     }
-    return g722_bytes;
+    return left_bytes;
 }
 /*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
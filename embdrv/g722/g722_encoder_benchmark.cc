@@ -0,0 +1,98 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "g722_enc_dec.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// 20 ms of 16 kHz audio per channel, as sent to the hearing aids
+constexpr int kFrameSamples = 320;
+// One second of speech-like 16 kHz audio: a voice with harmonics over noise
+constexpr int kSamples = 16000;
+
+const std::vector<int16_t>& Corpus(int channel) {
+  static const std::vector<std::vector<int16_t>> pcm = [] {
+    const double kPi = std::acos(-1);
+    std::mt19937 random(1);
+    std::normal_distribution<double> noise(0, 200);
+    std::vector<std::vector<int16_t>> samples(2,
+                                              std::vector<int16_t>(kSamples));
+    for (int i = 0; i < kSamples; i++) {
+      for (int ch = 0; ch < 2; ch++) {
+        double pitch = 120 + 40 * std::sin(2 * kPi * 3 * i / 16000) + 30 * ch;
+        double value = noise(random);
+        for (int harmonic = 1; harmonic <= 20; harmonic++) {
+          value += 4000.0 / harmonic *
+                   std::sin(2 * kPi * pitch * harmonic * i / 16000);
+        }
+        samples[ch][i] = std::max(-32768.0, std::min(32767.0, value));
+      }
+    }
+    return samples;
+  }();
+  return pcm[channel];
+}
+
+void BM_G722EncodeTwoChannels(State& state) {
+  g722_encode_state_t left, right;
+  g722_encode_init(&left, 64000, G722_PACKED);
+  g722_encode_init(&right, 64000, G722_PACKED);
+  std::vector<uint8_t> left_data(kFrameSamples), right_data(kFrameSamples);
+  int offset = 0;
+
+  for (auto _ : state) {
+    g722_encode(&left, left_data.data(), Corpus(0).data() + offset,
+                kFrameSamples);
+    g722_encode(&right, right_data.data(), Corpus(1).data() + offset,
+                kFrameSamples);
+    benchmark::DoNotOptimize(left_data.data());
+    benchmark::DoNotOptimize(right_data.data());
+    offset = (offset + kFrameSamples) % (kSamples - kFrameSamples);
+  }
+  state.SetItemsProcessed(state.iterations() * kFrameSamples * 2);
+}
+BENCHMARK(BM_G722EncodeTwoChannels);
+
+void BM_G722EncodeStereo(State& state) {
+  g722_encode_state_t left, right;
+  g722_encode_init(&left, 64000, G722_PACKED);
+  g722_encode_init(&right, 64000, G722_PACKED);
+  std::vector<uint8_t> left_data(kFrameSamples), right_data(kFrameSamples);
+  int offset = 0;
+
+  for (auto _ : state) {
+    g722_encode_stereo(&left, &right, left_data.data(), right_data.data(),
+                       Corpus(0).data() + offset, Corpus(1).data() + offset,
+                       kFrameSamples);
+    benchmark::DoNotOptimize(left_data.data());
+    benchmark::DoNotOptimize(right_data.data());
+    offset = (offset + kFrameSamples) % (kSamples - kFrameSamples);
+  }
+  state.SetItemsProcessed(state.iterations() * kFrameSamples * 2);
+}
+BENCHMARK(BM_G722EncodeStereo);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "g722_enc_dec.h"
+
+namespace {
+
+// 16 kHz audio: tones sweeping over the low and high bands, with noise and
+// some full scale clipping.
+std::vector<int16_t> MakeAudio(int samples, uint32_t seed) {
+  const double kPi = std::acos(-1);
+  std::mt19937 random(seed);
+  std::normal_distribution<double> noise(0, 500);
+  std::vector<int16_t> audio(samples);
+  for (int i = 0; i < samples; i++) {
+    double t = i / 16000.0;
+    double value = 12000 * std::sin(2 * kPi * (200 + 3000 * t) * t) +
+                   9000 * std::sin(2 * kPi * 6000 * t + seed) + noise(random);
+    if ((i / 1600) % 4 == 3) value *= 4;
+    audio[i] = std::max(-32768.0, std::min(32767.0, value));
+  }
+  return audio;
+}
+
+class G722StereoEncoderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    for (auto* state : {&mono_left_, &mono_right_, &stereo_left_,
+                        &stereo_right_}) {
+      g722_encode_init(state, 64000, G722_PACKED);
+    }
+  }
+
+  // Encode |len| samples from |offset| of |left| and |right| both ways, and
+  // check that the output is the same.
+  void EncodeAndCompare(const std::vector<int16_t>& left,
+                        const std::vector<int16_t>& right, int offset,
+                        int len) {
+    std::vector<uint8_t> mono_left(len), mono_right(len);
+    std::vector<uint8_t> stereo_left(len), stereo_right(len);
+
+    int mono_left_bytes = g722_encode(&mono_left_, mono_left.data(),
+                                      left.data() + offset, len);
+    int mono_right_bytes = g722_encode(&mono_right_, mono_right.data(),
+                                       right.data() + offset, len);
+    int stereo_bytes = g722_encode_stereo(
+        &stereo_left_, &stereo_right_, stereo_left.data(), stereo_right.data(),
+        left.data() + offset, right.data() + offset, len);
+
+    ASSERT_EQ(mono_left_bytes, stereo_bytes);
+    ASSERT_EQ(mono_right_bytes, stereo_bytes);
+    mono_left.resize(mono_left_bytes);
+    mono_right.resize(mono_right_bytes);
+    stereo_left.resize(stereo_bytes);
+    stereo_right.resize(stereo_bytes);
+    ASSERT_EQ(mono_left, stereo_left);
+    ASSERT_EQ(mono_right, stereo_right);
+  }
+
+  g722_encode_state_t mono_left_;
+  g722_encode_state_t mono_right_;
+  g722_encode_state_t stereo_left_;
+  g722_encode_state_t stereo_right_;
+};
+
+TEST_F(G722StereoEncoderTest, bit_exact_with_mono_encoder) {
+  constexpr int kSamples = 16000 * 4;
+  std::vector<int16_t> left = MakeAudio(kSamples, 1);
+  std::vector<int16_t> right = MakeAudio(kSamples, 2);
+
+  // The hearing aid frame sizes, then sizes around the internal block size,
+  // so that the state carries over between calls of any length
+  int offset = 0;
+  for (int len : {320, 160, 2, 126, 128, 130, 256, 1000, 4}) {
+    EncodeAndCompare(left, right, offset, len);
+    offset += len;
+  }
+  while (offset + 320 <= kSamples) {
+    EncodeAndCompare(left, right, offset, 320);
+    offset += 320;
+  }
+}
+
+TEST_F(G722StereoEncoderTest, bit_exact_on_full_scale_input) {
+  std::vector<int16_t> left(4096), right(4096);
+  for (size_t i = 0; i < left.size(); i++) {
+    left[i] = (i / 3) % 2 ? INT16_MAX : INT16_MIN;
+    right[i] = (i % 7) < 3 ? INT16_MIN : INT16_MAX;
+  }
+  EncodeAndCompare(left, right, 0, left.size());
+}
+
+TEST_F(G722StereoEncoderTest, same_channels) {
+  std::vector<int16_t> audio = MakeAudio(3200, 3);
+  EncodeAndCompare(audio, audio, 0, audio.size());
+}
+
+}  // namespace
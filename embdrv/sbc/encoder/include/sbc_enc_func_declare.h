@@ -40,13 +40,26 @@ extern const int32_t gas32CoeffFor8SBs[];
 extern void sbc_enc_bit_alloc_mono(SBC_ENC_PARAMS* CodecParams);
 extern void sbc_enc_bit_alloc_ste(SBC_ENC_PARAMS* CodecParams);
 
-extern void SbcAnalysisInit(void);
+extern void SbcAnalysisInit(SBC_ENC_PARAMS* strEncParams);
 
 extern void SbcAnalysisFilter4(SBC_ENC_PARAMS* strEncParams, int16_t* input);
 extern void SbcAnalysisFilter8(SBC_ENC_PARAMS* strEncParams, int16_t* input);
 
-extern void SBC_FastIDCT8(int32_t* pInVect, int32_t* pOutVect);
-extern void SBC_FastIDCT4(int32_t* x0, int32_t* pOutVect);
+extern void SBC_FastIDCT8(const int32_t* pInVect, int32_t* pOutVect);
+extern void SBC_FastIDCT4(const int32_t* pInVect, int32_t* pOutVect);
+
+/* C variant of the kernels of sbc_enc_kernels.h */
+extern void SbcWindow4_C(const int16_t* s16X, int32_t* s32DCTY);
+extern void SbcWindow8_C(const int16_t* s16X, int32_t* s32DCTY);
+extern void SbcFastIDCT4Rows_C(const int32_t* ps32In, int32_t* ps32Out,
+                               int32_t s32Rows);
+extern void SbcFastIDCT8Rows_C(const int32_t* ps32In, int32_t* ps32Out,
+                               int32_t s32Rows);
+extern void SbcMaxAbs_C(const int32_t* ps32Sb, int32_t s32Columns,
+                        int32_t s32Rows, int32_t* ps32Max);
+extern void SbcQuantize_C(const int32_t* ps32Sb, int32_t s32Columns,
+                          int32_t s32Rows, const int16_t* ps16ScaleFactor,
+                          const int16_t* ps16Bits, uint16_t* pu16Out);
 
 extern uint32_t EncPacking(SBC_ENC_PARAMS* strEncParams, uint8_t* output);
 extern void EncQuantizer(SBC_ENC_PARAMS*);
@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Inner loops of the encoder, with SIMD variants selected at runtime.
+ *
+ *  Every variant gives bit-exact the same results as the C one, which is the
+ *  scalar code of the analysis filter, DCT and quantizer.
+ *
+ ******************************************************************************/
+
+#ifndef SBC_ENC_KERNELS_H
+#define SBC_ENC_KERNELS_H
+
+#include "sbc_encoder.h"
+
+/* The SIMD variants implement the default arithmetic of the encoder: 16 bits
+ * window coefficients, 32x16 bits multiplications in the DCT and 64 bits
+ * multiplications in the quantizer. Other configurations use the C variant.
+ */
+#ifndef SBC_ENC_SIMD
+#if (SBC_ARM_ASM_OPT == FALSE && SBC_IPAQ_OPT == TRUE &&          \
+     SBC_IS_64_MULT_IN_WINDOW_ACCU == FALSE &&                    \
+     SBC_IS_64_MULT_IN_IDCT == FALSE && SBC_FAST_DCT == TRUE &&   \
+     SBC_IS_64_MULT_IN_QUANTIZER == TRUE)
+#define SBC_ENC_SIMD TRUE
+#else
+#define SBC_ENC_SIMD FALSE
+#endif
+#endif
+
+/* Number of windowed values per block and channel, input of the DCT */
+#define SBC_DCT_IN_4 8
+#define SBC_DCT_IN_8 16
+
+typedef struct SBC_ENC_KERNELS_TAG {
+  const char* name;
+
+  /* Windowing of one block of one channel: computes the SBC_DCT_IN_x inputs
+   * of the DCT into ps32Y from the X buffer of the channel at ps16X.
+   */
+  void (*Window4)(const int16_t* ps16X, int32_t* ps32Y);
+  void (*Window8)(const int16_t* ps16X, int32_t* ps32Y);
+
+  /* DCT of s32Rows windowed blocks: reads SBC_DCT_IN_x values and writes 4 or
+   * 8 subband samples per row. s32Rows is a multiple of 4.
+   */
+  void (*FastIDCT4)(const int32_t* ps32In, int32_t* ps32Out, int32_t s32Rows);
+  void (*FastIDCT8)(const int32_t* ps32In, int32_t* ps32Out, int32_t s32Rows);
+
+  /* Largest absolute value of each of the s32Columns columns of the s32Rows
+   * rows of subband samples. s32Columns is 4, 8 or 16.
+   */
+  void (*MaxAbs)(const int32_t* ps32Sb, int32_t s32Columns, int32_t s32Rows,
+                 int32_t* ps32Max);
+
+  /* Quantizes the s32Rows rows of s32Columns subband samples to the scale
+   * factor and number of bits of their column. Values of columns without
+   * bits are undefined.
+   */
+  void (*Quantize)(const int32_t* ps32Sb, int32_t s32Columns, int32_t s32Rows,
+                   const int16_t* ps16ScaleFactor, const int16_t* ps16Bits,
+                   uint16_t* pu16Out);
+} SBC_ENC_KERNELS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Window coefficients of block value k and tap j at index j * 16 + k (8
+ * subbands) or j * 8 + k (4 subbands), used by the SIMD variants.
+ */
+extern const int16_t gas16SbcWindow4[5 * SBC_DCT_IN_4];
+extern const int16_t gas16SbcWindow8[5 * SBC_DCT_IN_8];
+
+extern const SBC_ENC_KERNELS gstrSbcEncKernelsC;
+#if (SBC_ENC_SIMD == TRUE)
+#if defined(__x86_64__) || defined(__i386__)
+extern const SBC_ENC_KERNELS gstrSbcEncKernelsSse4;
+extern const SBC_ENC_KERNELS gstrSbcEncKernelsAvx2;
+#endif
+#if defined(__ARM_NEON)
+extern const SBC_ENC_KERNELS gstrSbcEncKernelsNeon;
+#endif
+#endif
+
+/* Fastest variant supported by this CPU */
+extern const SBC_ENC_KERNELS* SbcEncGetKernels(void);
+
+/* Variant u8Index, from the C one to the fastest one supported by this CPU.
+ * Returns NULL past the last one.
+ */
+extern const SBC_ENC_KERNELS* SbcEncGetKernelsAt(uint8_t u8Index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SBC_ENC_KERNELS_H */
@@ -159,6 +159,8 @@
 
 #include "sbc_types.h"
 
+struct SBC_ENC_KERNELS_TAG;
+
 typedef struct SBC_ENC_PARAMS_TAG {
   int16_t s16SamplingFreq;  /* 16k, 32k, 44.1k or 48k*/
   int16_t s16ChannelMode;   /* mono, dual, streo or joint streo*/
@@ -185,6 +187,16 @@ typedef struct SBC_ENC_PARAMS_TAG {
 
   uint16_t FrameHeader;
 
+  /* Analysis filter state: the X buffer of the last input samples of each
+   * channel and its shift position, so that encoders are independent */
+  int32_t as32X[ENC_VX_BUFFER_SIZE / 2];
+  int16_t s16ShiftCounter;
+  int16_t s16MaxShiftCounter;
+
+  /* Inner loops, the fastest ones for this CPU unless changed after
+   * SBC_Encoder_Init() */
+  const struct SBC_ENC_KERNELS_TAG* pstrKernels;
+
 } SBC_ENC_PARAMS;
 
 #ifdef __cplusplus
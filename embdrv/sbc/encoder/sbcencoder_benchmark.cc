@@ -0,0 +1,113 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "sbc_enc_kernels.h"
+#include "sbc_encoder.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// One second of music-like stereo PCM at 48 kHz: chords with harmonics over
+// a noise floor, the same for every configuration
+const std::vector<int16_t>& Corpus() {
+  static const std::vector<int16_t> pcm = [] {
+    constexpr int kSamples = 48000;
+    const double kPi = std::acos(-1);
+    std::mt19937 random(1);
+    std::normal_distribution<double> noise(0, 300);
+    std::vector<int16_t> samples(kSamples * 2);
+    for (int i = 0; i < kSamples; i++) {
+      for (int ch = 0; ch < 2; ch++) {
+        double value = noise(random);
+        for (double freq : {220.0, 277.2, 329.6, 440.0 * (ch + 1)}) {
+          for (int harmonic = 1; harmonic <= 4; harmonic++) {
+            value += 3000.0 / harmonic *
+                     std::sin(2 * kPi * freq * harmonic * i / 48000);
+          }
+        }
+        samples[i * 2 + ch] = std::max(-32768.0, std::min(32767.0, value));
+      }
+    }
+    return samples;
+  }();
+  return pcm;
+}
+
+// Arguments: kernels index, sampling frequency, subbands, blocks and channel
+// mode, as in SBC_ENC_PARAMS
+void BM_SbcEncode(State& state) {
+  const SBC_ENC_KERNELS* kernels = SbcEncGetKernelsAt(state.range(0));
+  if (kernels == nullptr) {
+    state.SkipWithError("kernels not supported by this CPU");
+    return;
+  }
+  SBC_ENC_PARAMS params;
+  memset(&params, 0, sizeof(params));
+  params.s16SamplingFreq = state.range(1);
+  params.s16NumOfSubBands = state.range(2);
+  params.s16NumOfBlocks = state.range(3);
+  params.s16ChannelMode = state.range(4);
+  params.s16AllocationMethod = SBC_LOUDNESS;
+  params.u16BitRate = params.s16ChannelMode == SBC_MONO ? 200 : 345;
+  SBC_Encoder_Init(&params);
+  params.pstrKernels = kernels;
+  state.SetLabel(kernels->name);
+
+  const std::vector<int16_t>& pcm = Corpus();
+  size_t frame_samples =
+      params.s16NumOfSubBands * params.s16NumOfBlocks * params.s16NumOfChannels;
+  size_t offset = 0;
+  uint8_t frame[512];
+  for (auto _ : state) {
+    if (offset + frame_samples > pcm.size()) offset = 0;
+    ::benchmark::DoNotOptimize(
+        SBC_Encode(&params, const_cast<int16_t*>(pcm.data() + offset), frame));
+    offset += frame_samples;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void SbcConfigurations(::benchmark::internal::Benchmark* benchmark) {
+  for (int kernels = 0; SbcEncGetKernelsAt(kernels) != nullptr; kernels++) {
+    for (int sampling_freq :
+         {SBC_sf16000, SBC_sf32000, SBC_sf44100, SBC_sf48000}) {
+      for (int subbands : {SUB_BANDS_4, SUB_BANDS_8}) {
+        for (int blocks :
+             {SBC_BLOCK_0, SBC_BLOCK_1, SBC_BLOCK_2, SBC_BLOCK_3}) {
+          for (int channel_mode :
+               {SBC_MONO, SBC_DUAL, SBC_STEREO, SBC_JOINT_STEREO}) {
+            benchmark->Args(
+                {kernels, sampling_freq, subbands, blocks, channel_mode});
+          }
+        }
+      }
+    }
+  }
+}
+
+BENCHMARK(BM_SbcEncode)->Apply(SbcConfigurations);
+
+}  // namespace
@@ -0,0 +1,233 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "sbc_enc_kernels.h"
+#include "sbc_encoder.h"
+
+namespace {
+
+constexpr int kFrames = 50;
+
+// Every variant supported by this CPU but the C one
+std::vector<const SBC_ENC_KERNELS*> SimdKernels() {
+  std::vector<const SBC_ENC_KERNELS*> kernels;
+  for (uint8_t i = 1; SbcEncGetKernelsAt(i) != nullptr; i++) {
+    kernels.push_back(SbcEncGetKernelsAt(i));
+  }
+  return kernels;
+}
+
+// A chirp over white noise, loud enough to use every scale factor
+std::vector<int16_t> MakePcm(size_t samples, int channels, uint32_t seed) {
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<int> noise(-2000, 2000);
+  std::vector<int16_t> pcm(samples * channels);
+  for (size_t i = 0; i < samples; i++) {
+    double phase = 0.00002 * i * i;
+    for (int ch = 0; ch < channels; ch++) {
+      int value = 28000 * std::sin(phase * (ch + 1)) + noise(random);
+      pcm[i * channels + ch] = std::max(-32768, std::min(32767, value));
+    }
+  }
+  return pcm;
+}
+
+std::vector<uint8_t> Encode(const SBC_ENC_PARAMS& config,
+                            const SBC_ENC_KERNELS* kernels,
+                            std::vector<int16_t> pcm) {
+  SBC_ENC_PARAMS params = config;
+  SBC_Encoder_Init(&params);
+  params.pstrKernels = kernels;
+
+  size_t frame_samples =
+      params.s16NumOfSubBands * params.s16NumOfBlocks * params.s16NumOfChannels;
+  std::vector<uint8_t> sbc;
+  uint8_t frame[512];
+  for (size_t offset = 0; offset + frame_samples <= pcm.size();
+       offset += frame_samples) {
+    uint32_t size = SBC_Encode(&params, pcm.data() + offset, frame);
+    sbc.insert(sbc.end(), frame, frame + size);
+  }
+  return sbc;
+}
+
+TEST(SbcEncoderTest, simd_encoding_is_bit_exact) {
+  for (int16_t sampling_freq :
+       {SBC_sf16000, SBC_sf32000, SBC_sf44100, SBC_sf48000}) {
+    for (int16_t subbands : {SUB_BANDS_4, SUB_BANDS_8}) {
+      for (int16_t blocks :
+           {SBC_BLOCK_0, SBC_BLOCK_1, SBC_BLOCK_2, SBC_BLOCK_3}) {
+        for (int16_t channel_mode :
+             {SBC_MONO, SBC_DUAL, SBC_STEREO, SBC_JOINT_STEREO}) {
+          for (int16_t allocation : {SBC_LOUDNESS, SBC_SNR}) {
+            SBC_ENC_PARAMS config;
+            memset(&config, 0, sizeof(config));
+            config.s16SamplingFreq = sampling_freq;
+            config.s16NumOfSubBands = subbands;
+            config.s16NumOfBlocks = blocks;
+            config.s16ChannelMode = channel_mode;
+            config.s16AllocationMethod = allocation;
+            config.u16BitRate = channel_mode == SBC_MONO ? 200 : 345;
+            int channels = channel_mode == SBC_MONO ? 1 : 2;
+
+            std::vector<int16_t> pcm =
+                MakePcm(kFrames * subbands * blocks, channels, blocks);
+            std::vector<uint8_t> expected =
+                Encode(config, &gstrSbcEncKernelsC, pcm);
+            ASSERT_FALSE(expected.empty());
+            for (const SBC_ENC_KERNELS* kernels : SimdKernels()) {
+              EXPECT_EQ(expected, Encode(config, kernels, pcm))
+                  << kernels->name << " freq " << sampling_freq
+                  << " subbands " << subbands << " blocks " << blocks
+                  << " mode " << channel_mode << " allocation "
+                  << allocation;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(SbcEncoderTest, interleaved_encoders_are_independent) {
+  SBC_ENC_PARAMS configs[2];
+  memset(configs, 0, sizeof(configs));
+  configs[0].s16SamplingFreq = SBC_sf44100;
+  configs[0].s16NumOfSubBands = SUB_BANDS_8;
+  configs[0].s16NumOfBlocks = SBC_BLOCK_3;
+  configs[0].s16ChannelMode = SBC_JOINT_STEREO;
+  configs[0].s16AllocationMethod = SBC_LOUDNESS;
+  configs[0].u16BitRate = 328;
+  configs[1].s16SamplingFreq = SBC_sf44100;
+  configs[1].s16NumOfSubBands = SUB_BANDS_4;
+  configs[1].s16NumOfBlocks = SBC_BLOCK_1;
+  configs[1].s16ChannelMode = SBC_STEREO;
+  configs[1].s16AllocationMethod = SBC_SNR;
+  configs[1].u16BitRate = 229;
+
+  // The same PCM, in frames of each configuration
+  std::vector<int16_t> pcm = MakePcm(kFrames * 8 * 16, 2, 3);
+  std::vector<uint8_t> expected[2];
+  for (int i = 0; i < 2; i++) {
+    expected[i] = Encode(configs[i], &gstrSbcEncKernelsC, pcm);
+    ASSERT_FALSE(expected[i].empty());
+  }
+
+  SBC_ENC_PARAMS params[2] = {configs[0], configs[1]};
+  std::vector<uint8_t> actual[2];
+  size_t offsets[2] = {0, 0};
+  for (int i = 0; i < 2; i++) {
+    SBC_Encoder_Init(&params[i]);
+    params[i].pstrKernels = &gstrSbcEncKernelsC;
+  }
+  // 32 samples per channel for the first one, twice 16 for the second one
+  for (int frame = 0; frame < kFrames * 4; frame++) {
+    for (int i = 0; i < 2; i++) {
+      size_t frame_samples = params[i].s16NumOfSubBands *
+                             params[i].s16NumOfBlocks *
+                             params[i].s16NumOfChannels;
+      if (offsets[i] + frame_samples > pcm.size()) continue;
+      uint8_t output[512];
+      uint32_t size = SBC_Encode(&params[i], pcm.data() + offsets[i], output);
+      actual[i].insert(actual[i].end(), output, output + size);
+      offsets[i] += frame_samples;
+    }
+  }
+  EXPECT_EQ(expected[0], actual[0]);
+  EXPECT_EQ(expected[1], actual[1]);
+}
+
+TEST(SbcEncoderTest, simd_kernels_match_c_on_full_range_input) {
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> sample(-32768, 32767);
+  std::uniform_int_distribution<int32_t> windowed(-(1 << 29), 1 << 29);
+
+  for (const SBC_ENC_KERNELS* kernels : SimdKernels()) {
+    for (int round = 0; round < 1000; round++) {
+      int16_t x[SBC_DCT_IN_8 * 5];
+      for (int16_t& value : x) value = sample(random);
+      int32_t expected[SBC_DCT_IN_8], actual[SBC_DCT_IN_8];
+      gstrSbcEncKernelsC.Window8(x, expected);
+      kernels->Window8(x, actual);
+      ASSERT_EQ(0, memcmp(expected, actual, sizeof(expected)))
+          << kernels->name;
+      gstrSbcEncKernelsC.Window4(x, expected);
+      kernels->Window4(x, actual);
+      ASSERT_EQ(0, memcmp(expected, actual, SBC_DCT_IN_4 * sizeof(int32_t)))
+          << kernels->name;
+
+      constexpr int kRows = SBC_MAX_NUM_OF_BLOCKS * SBC_MAX_NUM_OF_CHANNELS;
+      int32_t in[kRows * SBC_DCT_IN_8];
+      for (int32_t& value : in) value = windowed(random);
+      int32_t expected_out[kRows * SUB_BANDS_8], out[kRows * SUB_BANDS_8];
+      gstrSbcEncKernelsC.FastIDCT8(in, expected_out, kRows);
+      kernels->FastIDCT8(in, out, kRows);
+      ASSERT_EQ(0, memcmp(expected_out, out, sizeof(out))) << kernels->name;
+      gstrSbcEncKernelsC.FastIDCT4(in, expected_out, kRows);
+      kernels->FastIDCT4(in, out, kRows);
+      ASSERT_EQ(0, memcmp(expected_out, out, kRows * SUB_BANDS_4 * 4))
+          << kernels->name;
+    }
+  }
+}
+
+TEST(SbcEncoderTest, simd_quantizer_matches_c) {
+  constexpr int kColumns = SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS;
+  constexpr int kRows = SBC_MAX_NUM_OF_BLOCKS;
+  std::mt19937 random(7);
+
+  for (const SBC_ENC_KERNELS* kernels : SimdKernels()) {
+    for (int round = 0; round < 1000; round++) {
+      int16_t scale_factors[kColumns], bits[kColumns];
+      int32_t sb[kRows * kColumns];
+      for (int column = 0; column < kColumns; column++) {
+        scale_factors[column] = random() % 16;
+        bits[column] = random() % 17;
+        // What the scale factor allows, the edges included
+        int32_t max = 0x8000 << scale_factors[column];
+        for (int row = 0; row < kRows; row++) {
+          int32_t value = random() % (2 * max + 1) - max;
+          sb[row * kColumns + column] = value;
+        }
+      }
+
+      int32_t expected_max[kColumns], max[kColumns];
+      gstrSbcEncKernelsC.MaxAbs(sb, kColumns, kRows, expected_max);
+      kernels->MaxAbs(sb, kColumns, kRows, max);
+      ASSERT_EQ(0, memcmp(expected_max, max, sizeof(max))) << kernels->name;
+
+      uint16_t expected[kRows * kColumns], actual[kRows * kColumns];
+      gstrSbcEncKernelsC.Quantize(sb, kColumns, kRows, scale_factors, bits,
+                                  expected);
+      kernels->Quantize(sb, kColumns, kRows, scale_factors, bits, actual);
+      for (int i = 0; i < kRows * kColumns; i++) {
+        if (bits[i % kColumns] == 0) continue;
+        ASSERT_EQ(expected[i], actual[i]) << kernels->name << " index " << i;
+      }
+    }
+  }
+}
+
+}  // namespace
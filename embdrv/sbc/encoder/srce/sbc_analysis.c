@@ -24,6 +24,7 @@
  ******************************************************************************/
 #include <string.h>
 #include "sbc_enc_func_declare.h"
+#include "sbc_enc_kernels.h"
 #include "sbc_encoder.h"
 /*#include <math.h>*/
 
@@ -200,10 +201,10 @@
 #if (SBC_USE_ARM_PRAGMA == TRUE)
 #pragma arm section zidata = "sbc_s32_analysis_section"
 #endif
-static int32_t s32DCTY[16] = {0};
-static int32_t s32X[ENC_VX_BUFFER_SIZE / 2];
-static int16_t* s16X =
-    (int16_t*)s32X; /* s16X must be 32 bits aligned cf  SHIFTUP_X8_2*/
+/* Windowed blocks of a frame, input of the DCT. Scratch memory of one call,
+ * the X buffers of the encoders are in their SBC_ENC_PARAMS */
+static int32_t s32DCTY[SBC_MAX_NUM_OF_BLOCKS * SBC_MAX_NUM_OF_CHANNELS *
+                       SBC_DCT_IN_8] = {0};
 #if (SBC_USE_ARM_PRAGMA == TRUE)
 #pragma arm section zidata
 #endif
@@ -1185,20 +1186,92 @@ static int16_t* s16X =
 #endif
 #endif
 
-static int16_t ShiftCounter = 0;
-extern int16_t EncMaxShiftCounter;
+#if (SBC_ENC_SIMD == TRUE)
+/* Window coefficients for the SIMD kernels */
+const int16_t gas16SbcWindow4[5 * SBC_DCT_IN_4] = {
+    /* tap 0 */
+    0, (int16_t)(WIND_4_SUBBANDS_1_0), (int16_t)(WIND_4_SUBBANDS_2_0),
+    (int16_t)(WIND_4_SUBBANDS_3_0), (int16_t)(WIND_4_SUBBANDS_4_0),
+    (int16_t)(WIND_4_SUBBANDS_3_4), (int16_t)(WIND_4_SUBBANDS_2_4),
+    (int16_t)(WIND_4_SUBBANDS_1_4),
+    /* tap 1 */
+    (int16_t)(WIND_4_SUBBANDS_0_1), (int16_t)(WIND_4_SUBBANDS_1_1),
+    (int16_t)(WIND_4_SUBBANDS_2_1), (int16_t)(WIND_4_SUBBANDS_3_1),
+    (int16_t)(WIND_4_SUBBANDS_4_1), (int16_t)(WIND_4_SUBBANDS_3_3),
+    (int16_t)(WIND_4_SUBBANDS_2_3), (int16_t)(WIND_4_SUBBANDS_1_3),
+    /* tap 2 */
+    (int16_t)(WIND_4_SUBBANDS_0_2), (int16_t)(WIND_4_SUBBANDS_1_2),
+    (int16_t)(WIND_4_SUBBANDS_2_2), (int16_t)(WIND_4_SUBBANDS_3_2),
+    (int16_t)(WIND_4_SUBBANDS_4_2), (int16_t)(WIND_4_SUBBANDS_3_2),
+    (int16_t)(WIND_4_SUBBANDS_2_2), (int16_t)(WIND_4_SUBBANDS_1_2),
+    /* tap 3 */
+    (int16_t)(-WIND_4_SUBBANDS_0_2), (int16_t)(WIND_4_SUBBANDS_1_3),
+    (int16_t)(WIND_4_SUBBANDS_2_3), (int16_t)(WIND_4_SUBBANDS_3_3),
+    (int16_t)(WIND_4_SUBBANDS_4_1), (int16_t)(WIND_4_SUBBANDS_3_1),
+    (int16_t)(WIND_4_SUBBANDS_2_1), (int16_t)(WIND_4_SUBBANDS_1_1),
+    /* tap 4 */
+    (int16_t)(-WIND_4_SUBBANDS_0_1), (int16_t)(WIND_4_SUBBANDS_1_4),
+    (int16_t)(WIND_4_SUBBANDS_2_4), (int16_t)(WIND_4_SUBBANDS_3_4),
+    (int16_t)(WIND_4_SUBBANDS_4_0), (int16_t)(WIND_4_SUBBANDS_3_0),
+    (int16_t)(WIND_4_SUBBANDS_2_0), (int16_t)(WIND_4_SUBBANDS_1_0)
+};
+
+const int16_t gas16SbcWindow8[5 * SBC_DCT_IN_8] = {
+    /* tap 0 */
+    0, (int16_t)(WIND_8_SUBBANDS_1_0), (int16_t)(WIND_8_SUBBANDS_2_0),
+    (int16_t)(WIND_8_SUBBANDS_3_0), (int16_t)(WIND_8_SUBBANDS_4_0),
+    (int16_t)(WIND_8_SUBBANDS_5_0), (int16_t)(WIND_8_SUBBANDS_6_0),
+    (int16_t)(WIND_8_SUBBANDS_7_0), (int16_t)(WIND_8_SUBBANDS_8_0),
+    (int16_t)(WIND_8_SUBBANDS_7_4), (int16_t)(WIND_8_SUBBANDS_6_4),
+    (int16_t)(WIND_8_SUBBANDS_5_4), (int16_t)(WIND_8_SUBBANDS_4_4),
+    (int16_t)(WIND_8_SUBBANDS_3_4), (int16_t)(WIND_8_SUBBANDS_2_4),
+    (int16_t)(WIND_8_SUBBANDS_1_4),
+    /* tap 1 */
+    (int16_t)(WIND_8_SUBBANDS_0_1), (int16_t)(WIND_8_SUBBANDS_1_1),
+    (int16_t)(WIND_8_SUBBANDS_2_1), (int16_t)(WIND_8_SUBBANDS_3_1),
+    (int16_t)(WIND_8_SUBBANDS_4_1), (int16_t)(WIND_8_SUBBANDS_5_1),
+    (int16_t)(WIND_8_SUBBANDS_6_1), (int16_t)(WIND_8_SUBBANDS_7_1),
+    (int16_t)(WIND_8_SUBBANDS_8_1), (int16_t)(WIND_8_SUBBANDS_7_3),
+    (int16_t)(WIND_8_SUBBANDS_6_3), (int16_t)(WIND_8_SUBBANDS_5_3),
+    (int16_t)(WIND_8_SUBBANDS_4_3), (int16_t)(WIND_8_SUBBANDS_3_3),
+    (int16_t)(WIND_8_SUBBANDS_2_3), (int16_t)(WIND_8_SUBBANDS_1_3),
+    /* tap 2 */
+    (int16_t)(WIND_8_SUBBANDS_0_2), (int16_t)(WIND_8_SUBBANDS_1_2),
+    (int16_t)(WIND_8_SUBBANDS_2_2), (int16_t)(WIND_8_SUBBANDS_3_2),
+    (int16_t)(WIND_8_SUBBANDS_4_2), (int16_t)(WIND_8_SUBBANDS_5_2),
+    (int16_t)(WIND_8_SUBBANDS_6_2), (int16_t)(WIND_8_SUBBANDS_7_2),
+    (int16_t)(WIND_8_SUBBANDS_8_2), (int16_t)(WIND_8_SUBBANDS_7_2),
+    (int16_t)(WIND_8_SUBBANDS_6_2), (int16_t)(WIND_8_SUBBANDS_5_2),
+    (int16_t)(WIND_8_SUBBANDS_4_2), (int16_t)(WIND_8_SUBBANDS_3_2),
+    (int16_t)(WIND_8_SUBBANDS_2_2), (int16_t)(WIND_8_SUBBANDS_1_2),
+    /* tap 3 */
+    (int16_t)(-WIND_8_SUBBANDS_0_2), (int16_t)(WIND_8_SUBBANDS_1_3),
+    (int16_t)(WIND_8_SUBBANDS_2_3), (int16_t)(WIND_8_SUBBANDS_3_3),
+    (int16_t)(WIND_8_SUBBANDS_4_3), (int16_t)(WIND_8_SUBBANDS_5_3),
+    (int16_t)(WIND_8_SUBBANDS_6_3), (int16_t)(WIND_8_SUBBANDS_7_3),
+    (int16_t)(WIND_8_SUBBANDS_8_1), (int16_t)(WIND_8_SUBBANDS_7_1),
+    (int16_t)(WIND_8_SUBBANDS_6_1), (int16_t)(WIND_8_SUBBANDS_5_1),
+    (int16_t)(WIND_8_SUBBANDS_4_1), (int16_t)(WIND_8_SUBBANDS_3_1),
+    (int16_t)(WIND_8_SUBBANDS_2_1), (int16_t)(WIND_8_SUBBANDS_1_1),
+    /* tap 4 */
+    (int16_t)(-WIND_8_SUBBANDS_0_1), (int16_t)(WIND_8_SUBBANDS_1_4),
+    (int16_t)(WIND_8_SUBBANDS_2_4), (int16_t)(WIND_8_SUBBANDS_3_4),
+    (int16_t)(WIND_8_SUBBANDS_4_4), (int16_t)(WIND_8_SUBBANDS_5_4),
+    (int16_t)(WIND_8_SUBBANDS_6_4), (int16_t)(WIND_8_SUBBANDS_7_4),
+    (int16_t)(WIND_8_SUBBANDS_8_0), (int16_t)(WIND_8_SUBBANDS_7_0),
+    (int16_t)(WIND_8_SUBBANDS_6_0), (int16_t)(WIND_8_SUBBANDS_5_0),
+    (int16_t)(WIND_8_SUBBANDS_4_0), (int16_t)(WIND_8_SUBBANDS_3_0),
+    (int16_t)(WIND_8_SUBBANDS_2_0), (int16_t)(WIND_8_SUBBANDS_1_0)
+};
+#endif
+
 /****************************************************************************
-* SbcAnalysisFilter - performs Analysis of the input audio stream
+* SbcWindow4_C, SbcWindow8_C - C variant of the windowing kernels
 *
 * RETURNS : N/A
 */
-void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
-  int16_t* ps16PcmBuf;
-  int32_t* ps32SbBuf;
-  int32_t s32Blk, s32Ch;
-  int32_t s32NumOfChannels, s32NumOfBlocks;
-  int32_t i, *ps32X, *ps32X2;
-  int32_t Offset, Offset2, ChOffset;
+void SbcWindow4_C(const int16_t* s16X, int32_t* s32DCTY) {
+  const int32_t ChOffset = 0;
 #if (SBC_ARM_ASM_OPT == TRUE)
   register int32_t s32Hi, s32Hi2;
 #else
@@ -1217,12 +1290,57 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
 #endif
 #endif
 
+  WINDOW_PARTIAL_4
+}
+
+void SbcWindow8_C(const int16_t* s16X, int32_t* s32DCTY) {
+  const int32_t ChOffset = 0;
+#if (SBC_ARM_ASM_OPT == TRUE)
+  register int32_t s32Hi, s32Hi2;
+#else
+#if (SBC_IPAQ_OPT == TRUE)
+#if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
+  register int64_t s64Temp, s64Temp2;
+#else
+  register int32_t s32Temp, s32Temp2;
+#endif
+#else
+#if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
+  int64_t s64Temp;
+#endif
+#endif
+#endif
+
+  WINDOW_PARTIAL_8
+}
+
+/****************************************************************************
+* SbcAnalysisFilter - performs Analysis of the input audio stream
+*
+* The blocks are windowed one by one, as the X buffer shifts, then go through
+* the DCT all at once so that the SIMD kernels work on several blocks.
+*
+* RETURNS : N/A
+*/
+void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
+  const SBC_ENC_KERNELS* pstrKernels = pstrEncParams->pstrKernels;
+  int16_t* ps16PcmBuf;
+  int32_t* ps32DCTY;
+  int32_t s32Blk, s32Ch;
+  int32_t s32NumOfChannels, s32NumOfBlocks;
+  int32_t i, *ps32X, *ps32X2;
+  int32_t Offset, Offset2, ChOffset;
+  /* s16X must be 32 bits aligned cf SHIFTUP_X8_2 */
+  int16_t* s16X = (int16_t*)pstrEncParams->as32X;
+  int16_t ShiftCounter = pstrEncParams->s16ShiftCounter;
+  const int16_t EncMaxShiftCounter = pstrEncParams->s16MaxShiftCounter;
+
   s32NumOfChannels = pstrEncParams->s16NumOfChannels;
   s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
 
   ps16PcmBuf = input;
 
-  ps32SbBuf = pstrEncParams->s32SbBuffer;
+  ps32DCTY = s32DCTY;
   Offset2 = (int32_t)(EncMaxShiftCounter + 40);
   for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
     Offset = (int32_t)(EncMaxShiftCounter - ShiftCounter);
@@ -1257,11 +1375,8 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
     for (s32Ch = 0; s32Ch < s32NumOfChannels; s32Ch++) {
       ChOffset = s32Ch * Offset2 + Offset;
 
-      WINDOW_PARTIAL_4
-
-      SBC_FastIDCT4(s32DCTY, ps32SbBuf);
-
-      ps32SbBuf += SUB_BANDS_4;
+      pstrKernels->Window4(s16X + ChOffset, ps32DCTY);
+      ps32DCTY += SBC_DCT_IN_4;
     }
     if (s32NumOfChannels == 1) {
       if (ShiftCounter >= EncMaxShiftCounter) {
@@ -1279,39 +1394,34 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
       }
     }
   }
+
+  pstrEncParams->s16ShiftCounter = ShiftCounter;
+
+  pstrKernels->FastIDCT4(s32DCTY, pstrEncParams->s32SbBuffer,
+                         s32NumOfBlocks * s32NumOfChannels);
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
 void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
+  const SBC_ENC_KERNELS* pstrKernels = pstrEncParams->pstrKernels;
   int16_t* ps16PcmBuf;
-  int32_t* ps32SbBuf;
+  int32_t* ps32DCTY;
   int32_t s32Blk, s32Ch; /* counter for block*/
   int32_t Offset, Offset2;
   int32_t s32NumOfChannels, s32NumOfBlocks;
   int32_t i, *ps32X, *ps32X2;
   int32_t ChOffset;
-#if (SBC_ARM_ASM_OPT == TRUE)
-  register int32_t s32Hi, s32Hi2;
-#else
-#if (SBC_IPAQ_OPT == TRUE)
-#if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
-  register int64_t s64Temp, s64Temp2;
-#else
-  register int32_t s32Temp, s32Temp2;
-#endif
-#else
-#if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
-  int64_t s64Temp;
-#endif
-#endif
-#endif
+  /* s16X must be 32 bits aligned cf SHIFTUP_X8_2 */
+  int16_t* s16X = (int16_t*)pstrEncParams->as32X;
+  int16_t ShiftCounter = pstrEncParams->s16ShiftCounter;
+  const int16_t EncMaxShiftCounter = pstrEncParams->s16MaxShiftCounter;
 
   s32NumOfChannels = pstrEncParams->s16NumOfChannels;
   s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
 
   ps16PcmBuf = input;
 
-  ps32SbBuf = pstrEncParams->s32SbBuffer;
+  ps32DCTY = s32DCTY;
   Offset2 = (int32_t)(EncMaxShiftCounter + 80);
   for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
     Offset = (int32_t)(EncMaxShiftCounter - ShiftCounter);
@@ -1370,11 +1480,8 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
     for (s32Ch = 0; s32Ch < s32NumOfChannels; s32Ch++) {
       ChOffset = s32Ch * Offset2 + Offset;
 
-      WINDOW_PARTIAL_8
-
-      SBC_FastIDCT8(s32DCTY, ps32SbBuf);
-
-      ps32SbBuf += SUB_BANDS_8;
+      pstrKernels->Window8(s16X + ChOffset, ps32DCTY);
+      ps32DCTY += SBC_DCT_IN_8;
     }
     if (s32NumOfChannels == 1) {
       if (ShiftCounter >= EncMaxShiftCounter) {
@@ -1392,9 +1499,14 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
       }
     }
   }
+
+  pstrEncParams->s16ShiftCounter = ShiftCounter;
+
+  pstrKernels->FastIDCT8(s32DCTY, pstrEncParams->s32SbBuffer,
+                         s32NumOfBlocks * s32NumOfChannels);
 }
 
-void SbcAnalysisInit(void) {
-  memset(s16X, 0, ENC_VX_BUFFER_SIZE * sizeof(int16_t));
-  ShiftCounter = 0;
+void SbcAnalysisInit(SBC_ENC_PARAMS* pstrEncParams) {
+  memset(pstrEncParams->as32X, 0, sizeof(pstrEncParams->as32X));
+  pstrEncParams->s16ShiftCounter = 0;
 }
@@ -24,6 +24,7 @@
 
 #include "sbc_dct.h"
 #include "sbc_enc_func_declare.h"
+#include "sbc_enc_kernels.h"
 #include "sbc_encoder.h"
 
 /*******************************************************************************
@@ -38,47 +39,12 @@
  *
  ******************************************************************************/
 
-#if (SBC_IS_64_MULT_IN_IDCT == FALSE)
-#define SBC_COS_PI_SUR_4                              \
-  (0x00005a82) /* ((0x8000) * 0.7071)     = cos(pi/4) \
-                  */
-#define SBC_COS_PI_SUR_8 \
-  (0x00007641) /* ((0x8000) * 0.9239)     = (cos(pi/8)) */
-#define SBC_COS_3PI_SUR_8 \
-  (0x000030fb) /* ((0x8000) * 0.3827)     = (cos(3*pi/8)) */
-#define SBC_COS_PI_SUR_16 \
-  (0x00007d8a) /* ((0x8000) * 0.9808))     = (cos(pi/16)) */
-#define SBC_COS_3PI_SUR_16 \
-  (0x00006a6d) /* ((0x8000) * 0.8315))     = (cos(3*pi/16)) */
-#define SBC_COS_5PI_SUR_16 \
-  (0x0000471c) /* ((0x8000) * 0.5556))     = (cos(5*pi/16)) */
-#define SBC_COS_7PI_SUR_16 \
-  (0x000018f8) /* ((0x8000) * 0.1951))     = (cos(7*pi/16)) */
-#define SBC_IDCT_MULT(a, b, c) SBC_MULT_32_16_SIMPLIFIED(a, b, c)
-#else
-#define SBC_COS_PI_SUR_4 \
-  (0x5A827999) /* ((0x80000000) * 0.707106781)      = (cos(pi/4)   ) */
-#define SBC_COS_PI_SUR_8 \
-  (0x7641AF3C) /* ((0x80000000) * 0.923879533)      = (cos(pi/8)   ) */
-#define SBC_COS_3PI_SUR_8 \
-  (0x30FBC54D) /* ((0x80000000) * 0.382683432)      = (cos(3*pi/8) ) */
-#define SBC_COS_PI_SUR_16 \
-  (0x7D8A5F3F) /* ((0x80000000) * 0.98078528 ))     = (cos(pi/16)  ) */
-#define SBC_COS_3PI_SUR_16 \
-  (0x6A6D98A4) /* ((0x80000000) * 0.831469612))     = (cos(3*pi/16)) */
-#define SBC_COS_5PI_SUR_16 \
-  (0x471CECE6) /* ((0x80000000) * 0.555570233))     = (cos(5*pi/16)) */
-#define SBC_COS_7PI_SUR_16 \
-  (0x18F8B83C) /* ((0x80000000) * 0.195090322))     = (cos(7*pi/16)) */
-#define SBC_IDCT_MULT(a, b, c) SBC_MULT_32_32(a, b, c)
-#endif /* SBC_IS_64_MULT_IN_IDCT */
-
 #if (SBC_FAST_DCT == FALSE)
 extern const int16_t gas16AnalDCTcoeff8[];
 extern const int16_t gas16AnalDCTcoeff4[];
 #endif
 
-void SBC_FastIDCT8(int32_t* pInVect, int32_t* pOutVect) {
+void SBC_FastIDCT8(const int32_t* pInVect, int32_t* pOutVect) {
 #if (SBC_FAST_DCT == TRUE)
 #if (SBC_ARM_ASM_OPT == TRUE)
 #else
@@ -211,7 +177,7 @@ void SBC_FastIDCT8(int32_t* pInVect, int32_t* pOutVect) {
  *
  *
  ******************************************************************************/
-void SBC_FastIDCT4(int32_t* pInVect, int32_t* pOutVect) {
+void SBC_FastIDCT4(const int32_t* pInVect, int32_t* pOutVect) {
 #if (SBC_FAST_DCT == TRUE)
 #if (SBC_ARM_ASM_OPT == TRUE)
 #else
@@ -266,3 +232,31 @@ void SBC_FastIDCT4(int32_t* pInVect, int32_t* pOutVect) {
   }
 #endif
 }
+
+/*******************************************************************************
+ *
+ * Function         SbcFastIDCT4Rows_C, SbcFastIDCT8Rows_C
+ *
+ * Description      C variant of the DCT kernels: fast DCT of s32Rows
+ *                  windowed blocks, one after the other
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SbcFastIDCT4Rows_C(const int32_t* ps32In, int32_t* ps32Out,
+                        int32_t s32Rows) {
+  for (; s32Rows > 0; s32Rows--) {
+    SBC_FastIDCT4(ps32In, ps32Out);
+    ps32In += SBC_DCT_IN_4;
+    ps32Out += SUB_BANDS_4;
+  }
+}
+
+void SbcFastIDCT8Rows_C(const int32_t* ps32In, int32_t* ps32Out,
+                        int32_t s32Rows) {
+  for (; s32Rows > 0; s32Rows--) {
+    SBC_FastIDCT8(ps32In, ps32Out);
+    ps32In += SBC_DCT_IN_8;
+    ps32Out += SUB_BANDS_8;
+  }
+}
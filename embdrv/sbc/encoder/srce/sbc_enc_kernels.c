@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Runtime selection of the encoder kernels.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "sbc_enc_func_declare.h"
+#include "sbc_enc_kernels.h"
+
+const SBC_ENC_KERNELS gstrSbcEncKernelsC = {
+    "c",
+    SbcWindow4_C,
+    SbcWindow8_C,
+    SbcFastIDCT4Rows_C,
+    SbcFastIDCT8Rows_C,
+    SbcMaxAbs_C,
+    SbcQuantize_C,
+};
+
+const SBC_ENC_KERNELS* SbcEncGetKernelsAt(uint8_t u8Index) {
+  /* From the slowest to the fastest: each one needs the CPU features of the
+   * previous ones */
+  const SBC_ENC_KERNELS* apstrKernels[] = {
+      &gstrSbcEncKernelsC,
+#if (SBC_ENC_SIMD == TRUE)
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_cpu_supports("sse4.1") ? &gstrSbcEncKernelsSse4 : NULL,
+      __builtin_cpu_supports("avx2") ? &gstrSbcEncKernelsAvx2 : NULL,
+#endif
+#if defined(__ARM_NEON)
+      &gstrSbcEncKernelsNeon,
+#endif
+#endif
+  };
+
+  if (u8Index >= sizeof(apstrKernels) / sizeof(apstrKernels[0])) return NULL;
+  return apstrKernels[u8Index];
+}
+
+const SBC_ENC_KERNELS* SbcEncGetKernels(void) {
+  const SBC_ENC_KERNELS* pstrKernels = &gstrSbcEncKernelsC;
+  const SBC_ENC_KERNELS* pstrNext;
+  uint8_t u8Index;
+
+  for (u8Index = 1; (pstrNext = SbcEncGetKernelsAt(u8Index)) != NULL;
+       u8Index++) {
+    pstrKernels = pstrNext;
+  }
+  return pstrKernels;
+}
@@ -0,0 +1,209 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  NEON variant of the encoder kernels, for the ARM targets built with NEON.
+ *
+ ******************************************************************************/
+
+#include "sbc_enc_kernels.h"
+
+#if (SBC_ENC_SIMD == TRUE) && defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+#include "sbc_dct.h"
+
+/* Windowing of 4 values: ps16X and ps16Coeff point to the first tap of the
+ * values, s32Stride apart from the next taps */
+static inline int32x4_t SbcWindowNeon(const int16_t* ps16X,
+                                      const int16_t* ps16Coeff,
+                                      int32_t s32Stride) {
+  int32x4_t acc = vmull_s16(vld1_s16(ps16X), vld1_s16(ps16Coeff));
+  int32_t j;
+
+  for (j = 1; j < 5; j++) {
+    acc = vmlal_s16(acc, vld1_s16(ps16X + j * s32Stride),
+                    vld1_s16(ps16Coeff + j * s32Stride));
+  }
+  return acc;
+}
+
+static void SbcWindow4Neon(const int16_t* ps16X, int32_t* ps32Y) {
+  int32_t k;
+
+  for (k = 0; k < SBC_DCT_IN_4; k += 4) {
+    vst1q_s32(ps32Y + k,
+              SbcWindowNeon(ps16X + k, gas16SbcWindow4 + k, SBC_DCT_IN_4));
+  }
+}
+
+static void SbcWindow8Neon(const int16_t* ps16X, int32_t* ps32Y) {
+  int32_t k;
+
+  for (k = 0; k < SBC_DCT_IN_8; k += 4) {
+    vst1q_s32(ps32Y + k,
+              SbcWindowNeon(ps16X + k, gas16SbcWindow8 + k, SBC_DCT_IN_8));
+  }
+}
+
+/* Transposes the 4x4 matrix of 32 bits values in v */
+static inline void SbcTranspose4Neon(int32x4_t* v) {
+  int32x4x2_t t0 = vtrnq_s32(v[0], v[1]);
+  int32x4x2_t t1 = vtrnq_s32(v[2], v[3]);
+  v[0] = vcombine_s32(vget_low_s32(t0.val[0]), vget_low_s32(t1.val[0]));
+  v[1] = vcombine_s32(vget_low_s32(t0.val[1]), vget_low_s32(t1.val[1]));
+  v[2] = vcombine_s32(vget_high_s32(t0.val[0]), vget_high_s32(t1.val[0]));
+  v[3] = vcombine_s32(vget_high_s32(t0.val[1]), vget_high_s32(t1.val[1]));
+}
+
+/* (int32_t)(((int64_t)s32C * a) >> 15) in each lane */
+static inline int32x4_t SbcMultNeon(int32_t s32C, int32x4_t a) {
+  int32x2_t c = vdup_n_s32(s32C);
+  return vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(a), c), 15),
+                      vshrn_n_s64(vmull_s32(vget_high_s32(a), c), 15));
+}
+
+#define SIMD_VEC int32x4_t
+#define SIMD_ADD(a, b) vaddq_s32(a, b)
+#define SIMD_SUB(a, b) vsubq_s32(a, b)
+#define SIMD_SRA1(a) vshrq_n_s32(a, 1)
+#define SIMD_SLL1(a) vshlq_n_s32(a, 1)
+#define SIMD_MULT(c, a) SbcMultNeon(c, a)
+
+/* DCT of 4 blocks at once, one block per lane */
+static void SbcFastIDCT4Neon(const int32_t* ps32In, int32_t* ps32Out,
+                             int32_t s32Rows) {
+  int32x4_t in[SBC_DCT_IN_4], out[SUB_BANDS_4];
+  int32_t r, k;
+
+  for (; s32Rows > 0; s32Rows -= 4) {
+    for (k = 0; k < SBC_DCT_IN_4; k += 4) {
+      for (r = 0; r < 4; r++) {
+        in[k + r] = vld1q_s32(ps32In + r * SBC_DCT_IN_4 + k);
+      }
+      SbcTranspose4Neon(in + k);
+    }
+#define NROF_SUBBANDS 4
+#include "sbc_dct_simd.inc"
+#undef NROF_SUBBANDS
+    SbcTranspose4Neon(out);
+    for (r = 0; r < 4; r++) {
+      vst1q_s32(ps32Out + r * SUB_BANDS_4, out[r]);
+    }
+    ps32In += 4 * SBC_DCT_IN_4;
+    ps32Out += 4 * SUB_BANDS_4;
+  }
+}
+
+static void SbcFastIDCT8Neon(const int32_t* ps32In, int32_t* ps32Out,
+                             int32_t s32Rows) {
+  int32x4_t in[SBC_DCT_IN_8], out[SUB_BANDS_8];
+  int32_t r, k;
+
+  for (; s32Rows > 0; s32Rows -= 4) {
+    for (k = 0; k < SBC_DCT_IN_8; k += 4) {
+      for (r = 0; r < 4; r++) {
+        in[k + r] = vld1q_s32(ps32In + r * SBC_DCT_IN_8 + k);
+      }
+      SbcTranspose4Neon(in + k);
+    }
+#define NROF_SUBBANDS 8
+#include "sbc_dct_simd.inc"
+#undef NROF_SUBBANDS
+    for (k = 0; k < SUB_BANDS_8; k += 4) {
+      SbcTranspose4Neon(out + k);
+      for (r = 0; r < 4; r++) {
+        vst1q_s32(ps32Out + r * SUB_BANDS_8 + k, out[k + r]);
+      }
+    }
+    ps32In += 4 * SBC_DCT_IN_8;
+    ps32Out += 4 * SUB_BANDS_8;
+  }
+}
+
+#undef SIMD_VEC
+#undef SIMD_ADD
+#undef SIMD_SUB
+#undef SIMD_SRA1
+#undef SIMD_SLL1
+#undef SIMD_MULT
+
+static void SbcMaxAbsNeon(const int32_t* ps32Sb, int32_t s32Columns,
+                          int32_t s32Rows, int32_t* ps32Max) {
+  int32x4_t max;
+  int32_t s32Column, s32Blk;
+
+  for (s32Column = 0; s32Column < s32Columns; s32Column += 4) {
+    max = vdupq_n_s32(0);
+    for (s32Blk = 0; s32Blk < s32Rows; s32Blk++) {
+      max = vmaxq_s32(
+          max, vabsq_s32(vld1q_s32(ps32Sb + s32Column + s32Blk * s32Columns)));
+    }
+    vst1q_s32(ps32Max + s32Column, max);
+  }
+}
+
+/* Same computation as SbcQuantizeSse4(): the arithmetic shift of the 64 bits
+ * products only differs from the logical one above the 16 kept bits */
+static void SbcQuantizeNeon(const int32_t* ps32Sb, int32_t s32Columns,
+                            int32_t s32Rows, const int16_t* ps16ScaleFactor,
+                            const int16_t* ps16Bits, uint16_t* pu16Out) {
+  int32_t as32Offset[4], as32Levels[4];
+  int64_t as64Shift[4];
+  int32x4_t offset, levels, t;
+  int64x2_t shift_lo, shift_hi;
+  int32x2_t lo, hi;
+  int32_t s32Column, s32Blk, i;
+
+  for (s32Column = 0; s32Column < s32Columns; s32Column += 4) {
+    for (i = 0; i < 4; i++) {
+      as32Offset[i] = 1 << (ps16ScaleFactor[s32Column + i] + 13);
+      as32Levels[i] = (1 << ps16Bits[s32Column + i]) - 1;
+      as64Shift[i] = -(ps16ScaleFactor[s32Column + i] + 14);
+    }
+    offset = vld1q_s32(as32Offset);
+    levels = vld1q_s32(as32Levels);
+    shift_lo = vld1q_s64(as64Shift);
+    shift_hi = vld1q_s64(as64Shift + 2);
+
+    for (s32Blk = 0; s32Blk < s32Rows; s32Blk++) {
+      t = vld1q_s32(ps32Sb + s32Column + s32Blk * s32Columns);
+      t = vaddq_s32(vshrq_n_s32(t, 2), offset);
+      lo = vmovn_s64(vshlq_s64(
+          vmull_s32(vget_low_s32(t), vget_low_s32(levels)), shift_lo));
+      hi = vmovn_s64(vshlq_s64(
+          vmull_s32(vget_high_s32(t), vget_high_s32(levels)), shift_hi));
+      vst1_u16(pu16Out + s32Column + s32Blk * s32Columns,
+               vreinterpret_u16_s16(vmovn_s32(vcombine_s32(lo, hi))));
+    }
+  }
+}
+
+const SBC_ENC_KERNELS gstrSbcEncKernelsNeon = {
+    "neon",
+    SbcWindow4Neon,
+    SbcWindow8Neon,
+    SbcFastIDCT4Neon,
+    SbcFastIDCT8Neon,
+    SbcMaxAbsNeon,
+    SbcQuantizeNeon,
+};
+
+#endif
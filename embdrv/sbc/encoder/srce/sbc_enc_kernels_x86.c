@@ -0,0 +1,295 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  SSE4.1 and AVX2 variants of the encoder kernels.
+ *
+ *  The functions are compiled for their instruction set with target
+ *  attributes, the rest of the encoder is not: SbcEncGetKernels() only picks
+ *  them when the CPU has it.
+ *
+ ******************************************************************************/
+
+#include "sbc_enc_kernels.h"
+
+#if (SBC_ENC_SIMD == TRUE) && (defined(__x86_64__) || defined(__i386__))
+
+#include <immintrin.h>
+
+#include "sbc_dct.h"
+
+#define SSE4_TARGET __attribute__((target("sse4.1")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+/*******************************************************************************
+ * SSE4.1
+ ******************************************************************************/
+
+/* Windowing of 8 values: ps16X and ps16Coeff point to the first tap of the
+ * values, s32Stride apart from the next taps */
+static inline SSE4_TARGET void SbcWindowSse4(const int16_t* ps16X,
+                                             const int16_t* ps16Coeff,
+                                             int32_t s32Stride,
+                                             int32_t* ps32Y) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i x[5], c[5], lo, hi;
+  int32_t j;
+
+  for (j = 0; j < 5; j++) {
+    x[j] = _mm_loadu_si128((const __m128i*)(ps16X + j * s32Stride));
+    c[j] = _mm_loadu_si128((const __m128i*)(ps16Coeff + j * s32Stride));
+  }
+  /* Taps interleaved in pairs, each pair summed by one multiply-add, the
+   * last one with zero */
+  lo = _mm_add_epi32(
+      _mm_madd_epi16(_mm_unpacklo_epi16(x[0], x[1]),
+                     _mm_unpacklo_epi16(c[0], c[1])),
+      _mm_madd_epi16(_mm_unpacklo_epi16(x[2], x[3]),
+                     _mm_unpacklo_epi16(c[2], c[3])));
+  lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(x[4], zero),
+                                        _mm_unpacklo_epi16(c[4], zero)));
+  hi = _mm_add_epi32(
+      _mm_madd_epi16(_mm_unpackhi_epi16(x[0], x[1]),
+                     _mm_unpackhi_epi16(c[0], c[1])),
+      _mm_madd_epi16(_mm_unpackhi_epi16(x[2], x[3]),
+                     _mm_unpackhi_epi16(c[2], c[3])));
+  hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(x[4], zero),
+                                        _mm_unpackhi_epi16(c[4], zero)));
+  _mm_storeu_si128((__m128i*)ps32Y, lo);
+  _mm_storeu_si128((__m128i*)(ps32Y + 4), hi);
+}
+
+static SSE4_TARGET void SbcWindow4Sse4(const int16_t* ps16X, int32_t* ps32Y) {
+  SbcWindowSse4(ps16X, gas16SbcWindow4, SBC_DCT_IN_4, ps32Y);
+}
+
+static SSE4_TARGET void SbcWindow8Sse4(const int16_t* ps16X, int32_t* ps32Y) {
+  SbcWindowSse4(ps16X, gas16SbcWindow8, SBC_DCT_IN_8, ps32Y);
+  SbcWindowSse4(ps16X + 8, gas16SbcWindow8 + 8, SBC_DCT_IN_8, ps32Y + 8);
+}
+
+/* Transposes the 4x4 matrix of 32 bits values in v */
+static inline SSE4_TARGET void SbcTranspose4Sse4(__m128i* v) {
+  __m128i t0 = _mm_unpacklo_epi32(v[0], v[1]);
+  __m128i t1 = _mm_unpacklo_epi32(v[2], v[3]);
+  __m128i t2 = _mm_unpackhi_epi32(v[0], v[1]);
+  __m128i t3 = _mm_unpackhi_epi32(v[2], v[3]);
+  v[0] = _mm_unpacklo_epi64(t0, t1);
+  v[1] = _mm_unpackhi_epi64(t0, t1);
+  v[2] = _mm_unpacklo_epi64(t2, t3);
+  v[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+/* (int32_t)(((int64_t)s32C * a) >> 15) in each lane */
+static inline SSE4_TARGET __m128i SbcMultSse4(int32_t s32C, __m128i a) {
+  __m128i c = _mm_set1_epi32(s32C);
+  __m128i even = _mm_srli_epi64(_mm_mul_epi32(a, c), 15);
+  __m128i odd = _mm_slli_epi64(_mm_mul_epi32(_mm_srli_epi64(a, 32), c), 17);
+  return _mm_blend_epi16(even, odd, 0xCC);
+}
+
+#define SIMD_VEC __m128i
+#define SIMD_ADD(a, b) _mm_add_epi32(a, b)
+#define SIMD_SUB(a, b) _mm_sub_epi32(a, b)
+#define SIMD_SRA1(a) _mm_srai_epi32(a, 1)
+#define SIMD_SLL1(a) _mm_slli_epi32(a, 1)
+#define SIMD_MULT(c, a) SbcMultSse4(c, a)
+
+/* DCT of 4 blocks at once, one block per lane */
+static SSE4_TARGET void SbcFastIDCT4Sse4(const int32_t* ps32In,
+                                         int32_t* ps32Out, int32_t s32Rows) {
+  __m128i in[SBC_DCT_IN_4], out[SUB_BANDS_4];
+  int32_t r, k;
+
+  for (; s32Rows > 0; s32Rows -= 4) {
+    for (k = 0; k < SBC_DCT_IN_4; k += 4) {
+      for (r = 0; r < 4; r++) {
+        in[k + r] = _mm_loadu_si128(
+            (const __m128i*)(ps32In + r * SBC_DCT_IN_4 + k));
+      }
+      SbcTranspose4Sse4(in + k);
+    }
+#define NROF_SUBBANDS 4
+#include "sbc_dct_simd.inc"
+#undef NROF_SUBBANDS
+    SbcTranspose4Sse4(out);
+    for (r = 0; r < 4; r++) {
+      _mm_storeu_si128((__m128i*)(ps32Out + r * SUB_BANDS_4), out[r]);
+    }
+    ps32In += 4 * SBC_DCT_IN_4;
+    ps32Out += 4 * SUB_BANDS_4;
+  }
+}
+
+static SSE4_TARGET void SbcFastIDCT8Sse4(const int32_t* ps32In,
+                                         int32_t* ps32Out, int32_t s32Rows) {
+  __m128i in[SBC_DCT_IN_8], out[SUB_BANDS_8];
+  int32_t r, k;
+
+  for (; s32Rows > 0; s32Rows -= 4) {
+    for (k = 0; k < SBC_DCT_IN_8; k += 4) {
+      for (r = 0; r < 4; r++) {
+        in[k + r] = _mm_loadu_si128(
+            (const __m128i*)(ps32In + r * SBC_DCT_IN_8 + k));
+      }
+      SbcTranspose4Sse4(in + k);
+    }
+#define NROF_SUBBANDS 8
+#include "sbc_dct_simd.inc"
+#undef NROF_SUBBANDS
+    for (k = 0; k < SUB_BANDS_8; k += 4) {
+      SbcTranspose4Sse4(out + k);
+      for (r = 0; r < 4; r++) {
+        _mm_storeu_si128((__m128i*)(ps32Out + r * SUB_BANDS_8 + k),
+                         out[k + r]);
+      }
+    }
+    ps32In += 4 * SBC_DCT_IN_8;
+    ps32Out += 4 * SUB_BANDS_8;
+  }
+}
+
+#undef SIMD_VEC
+#undef SIMD_ADD
+#undef SIMD_SUB
+#undef SIMD_SRA1
+#undef SIMD_SLL1
+#undef SIMD_MULT
+
+static SSE4_TARGET void SbcMaxAbsSse4(const int32_t* ps32Sb, int32_t s32Columns,
+                                      int32_t s32Rows, int32_t* ps32Max) {
+  __m128i max;
+  int32_t s32Column, s32Blk;
+
+  for (s32Column = 0; s32Column < s32Columns; s32Column += 4) {
+    max = _mm_setzero_si128();
+    for (s32Blk = 0; s32Blk < s32Rows; s32Blk++) {
+      max = _mm_max_epi32(max, _mm_abs_epi32(_mm_loadu_si128(
+                                   (const __m128i*)(ps32Sb + s32Column +
+                                                    s32Blk * s32Columns))));
+    }
+    _mm_storeu_si128((__m128i*)(ps32Max + s32Column), max);
+  }
+}
+
+/* The quantizer of SbcQuantize_C() with 64 bits multiplications comes down to
+ * (uint16_t)((((sb >> 2) + (1 << (scf + 13))) * levels) >> (scf + 14)) */
+static SSE4_TARGET void SbcQuantizeSse4(const int32_t* ps32Sb,
+                                        int32_t s32Columns, int32_t s32Rows,
+                                        const int16_t* ps16ScaleFactor,
+                                        const int16_t* ps16Bits,
+                                        uint16_t* pu16Out) {
+  /* Low 16 bits of each 32 bits lane */
+  const __m128i low16 =
+      _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+  __m128i offset, levels, levels_odd, shift[4], t, even, odd;
+  int32_t s32Column, s32Blk, i;
+
+  for (s32Column = 0; s32Column < s32Columns; s32Column += 4) {
+    offset = _mm_setr_epi32(1 << (ps16ScaleFactor[s32Column] + 13),
+                            1 << (ps16ScaleFactor[s32Column + 1] + 13),
+                            1 << (ps16ScaleFactor[s32Column + 2] + 13),
+                            1 << (ps16ScaleFactor[s32Column + 3] + 13));
+    levels = _mm_setr_epi32((1 << ps16Bits[s32Column]) - 1,
+                            (1 << ps16Bits[s32Column + 1]) - 1,
+                            (1 << ps16Bits[s32Column + 2]) - 1,
+                            (1 << ps16Bits[s32Column + 3]) - 1);
+    levels_odd = _mm_srli_epi64(levels, 32);
+    for (i = 0; i < 4; i++) {
+      shift[i] = _mm_cvtsi32_si128(ps16ScaleFactor[s32Column + i] + 14);
+    }
+
+    for (s32Blk = 0; s32Blk < s32Rows; s32Blk++) {
+      t = _mm_loadu_si128(
+          (const __m128i*)(ps32Sb + s32Column + s32Blk * s32Columns));
+      t = _mm_add_epi32(_mm_srai_epi32(t, 2), offset);
+      even = _mm_mul_epi32(t, levels);
+      odd = _mm_mul_epi32(_mm_srli_epi64(t, 32), levels_odd);
+      /* Each 64 bits lane has its own shift */
+      even = _mm_blend_epi16(_mm_srl_epi64(even, shift[0]),
+                             _mm_srl_epi64(even, shift[2]), 0xF0);
+      odd = _mm_blend_epi16(_mm_srl_epi64(odd, shift[1]),
+                            _mm_srl_epi64(odd, shift[3]), 0xF0);
+      t = _mm_blend_epi16(even, _mm_slli_epi64(odd, 32), 0xCC);
+      _mm_storel_epi64(
+          (__m128i*)(pu16Out + s32Column + s32Blk * s32Columns),
+          _mm_shuffle_epi8(t, low16));
+    }
+  }
+}
+
+const SBC_ENC_KERNELS gstrSbcEncKernelsSse4 = {
+    "sse4.1",
+    SbcWindow4Sse4,
+    SbcWindow8Sse4,
+    SbcFastIDCT4Sse4,
+    SbcFastIDCT8Sse4,
+    SbcMaxAbsSse4,
+    SbcQuantizeSse4,
+};
+
+/*******************************************************************************
+ * AVX2: the 16 values of the 8 subbands windowing in one pass, the other
+ * kernels work on 4 blocks and are the SSE4.1 ones.
+ ******************************************************************************/
+
+static AVX2_TARGET void SbcWindow8Avx2(const int16_t* ps16X, int32_t* ps32Y) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i x[5], c[5], lo, hi;
+  int32_t j;
+
+  for (j = 0; j < 5; j++) {
+    x[j] = _mm256_loadu_si256((const __m256i*)(ps16X + j * SBC_DCT_IN_8));
+    c[j] = _mm256_loadu_si256(
+        (const __m256i*)(gas16SbcWindow8 + j * SBC_DCT_IN_8));
+  }
+  /* Unpacking works within 128 bits lanes: lo holds the values 0-3 and 8-11,
+   * hi the values 4-7 and 12-15 */
+  lo = _mm256_add_epi32(
+      _mm256_madd_epi16(_mm256_unpacklo_epi16(x[0], x[1]),
+                        _mm256_unpacklo_epi16(c[0], c[1])),
+      _mm256_madd_epi16(_mm256_unpacklo_epi16(x[2], x[3]),
+                        _mm256_unpacklo_epi16(c[2], c[3])));
+  lo = _mm256_add_epi32(lo,
+                        _mm256_madd_epi16(_mm256_unpacklo_epi16(x[4], zero),
+                                          _mm256_unpacklo_epi16(c[4], zero)));
+  hi = _mm256_add_epi32(
+      _mm256_madd_epi16(_mm256_unpackhi_epi16(x[0], x[1]),
+                        _mm256_unpackhi_epi16(c[0], c[1])),
+      _mm256_madd_epi16(_mm256_unpackhi_epi16(x[2], x[3]),
+                        _mm256_unpackhi_epi16(c[2], c[3])));
+  hi = _mm256_add_epi32(hi,
+                        _mm256_madd_epi16(_mm256_unpackhi_epi16(x[4], zero),
+                                          _mm256_unpackhi_epi16(c[4], zero)));
+  _mm256_storeu_si256((__m256i*)ps32Y, _mm256_permute2x128_si256(lo, hi, 0x20));
+  _mm256_storeu_si256((__m256i*)(ps32Y + 8),
+                      _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+const SBC_ENC_KERNELS gstrSbcEncKernelsAvx2 = {
+    "avx2",
+    SbcWindow4Sse4,
+    SbcWindow8Avx2,
+    SbcFastIDCT4Sse4,
+    SbcFastIDCT8Sse4,
+    SbcMaxAbsSse4,
+    SbcQuantizeSse4,
+};
+
+#endif
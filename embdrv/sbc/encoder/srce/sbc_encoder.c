@@ -26,8 +26,7 @@
 #include <string.h>
 #include "bt_target.h"
 #include "sbc_enc_func_declare.h"
-
-int16_t EncMaxShiftCounter;
+#include "sbc_enc_kernels.h"
 
 #if (SBC_JOINT_STE_INCLUDED == TRUE)
 int32_t s32LRDiff[SBC_MAX_NUM_OF_BLOCKS] = {0};
@@ -40,6 +39,7 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
   int32_t s32Sb;                 /* counter for sub-band*/
   uint32_t u32Count, maxBit = 0; /* loop count*/
   int32_t s32MaxValue;           /* temp variable to store max value */
+  int32_t as32MaxValue[SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS];
 
   int16_t* ps16ScfL;
   int32_t* SbBuffer;
@@ -62,13 +62,11 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
   ps16ScfL = pstrEncParams->as16ScaleFactor;
   s32Ch = pstrEncParams->s16NumOfChannels * s32NumOfSubBands;
 
+  pstrEncParams->pstrKernels->MaxAbs(pstrEncParams->s32SbBuffer, s32Ch,
+                                     s32NumOfBlocks, as32MaxValue);
+
   for (s32Sb = 0; s32Sb < s32Ch; s32Sb++) {
-    SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
-    s32MaxValue = 0;
-    for (s32Blk = s32NumOfBlocks; s32Blk > 0; s32Blk--) {
-      if (s32MaxValue < abs32(*SbBuffer)) s32MaxValue = abs32(*SbBuffer);
-      SbBuffer += s32Ch;
-    }
+    s32MaxValue = as32MaxValue[s32Sb];
 
     u32Count = (s32MaxValue > 0x800000) ? 9 : 0;
 
@@ -155,6 +153,27 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
   return EncPacking(pstrEncParams, output);
 }
 
+/****************************************************************************
+* SbcMaxAbs_C - C variant of the scale factor kernel
+*
+* RETURNS : N/A
+*/
+void SbcMaxAbs_C(const int32_t* ps32Sb, int32_t s32Columns, int32_t s32Rows,
+                 int32_t* ps32Max) {
+  const int32_t* SbBuffer;
+  int32_t s32Column, s32Blk, s32MaxValue;
+
+  for (s32Column = 0; s32Column < s32Columns; s32Column++) {
+    SbBuffer = ps32Sb + s32Column;
+    s32MaxValue = 0;
+    for (s32Blk = s32Rows; s32Blk > 0; s32Blk--) {
+      if (s32MaxValue < abs32(*SbBuffer)) s32MaxValue = abs32(*SbBuffer);
+      SbBuffer += s32Columns;
+    }
+    ps32Max[s32Column] = s32MaxValue;
+  }
+}
+
 /****************************************************************************
 * InitSbcAnalysisFilt - Initalizes the input data to 0
 *
@@ -244,15 +263,21 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS* pstrEncParams) {
 
   if (pstrEncParams->s16NumOfSubBands == 4) {
     if (pstrEncParams->s16NumOfChannels == 1)
-      EncMaxShiftCounter = ((ENC_VX_BUFFER_SIZE - 4 * 10) >> 2) << 2;
+      pstrEncParams->s16MaxShiftCounter =
+          ((ENC_VX_BUFFER_SIZE - 4 * 10) >> 2) << 2;
     else
-      EncMaxShiftCounter = ((ENC_VX_BUFFER_SIZE - 4 * 10 * 2) >> 3) << 2;
+      pstrEncParams->s16MaxShiftCounter =
+          ((ENC_VX_BUFFER_SIZE - 4 * 10 * 2) >> 3) << 2;
   } else {
     if (pstrEncParams->s16NumOfChannels == 1)
-      EncMaxShiftCounter = ((ENC_VX_BUFFER_SIZE - 8 * 10) >> 3) << 3;
+      pstrEncParams->s16MaxShiftCounter =
+          ((ENC_VX_BUFFER_SIZE - 8 * 10) >> 3) << 3;
     else
-      EncMaxShiftCounter = ((ENC_VX_BUFFER_SIZE - 8 * 10 * 2) >> 4) << 3;
+      pstrEncParams->s16MaxShiftCounter =
+          ((ENC_VX_BUFFER_SIZE - 8 * 10 * 2) >> 4) << 3;
   }
 
-  SbcAnalysisInit();
+  pstrEncParams->pstrKernels = SbcEncGetKernels();
+
+  SbcAnalysisInit(pstrEncParams);
 }
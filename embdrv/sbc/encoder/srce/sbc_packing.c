@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include "sbc_enc_func_declare.h"
+#include "sbc_enc_kernels.h"
 #include "sbc_encoder.h"
 
 #if (SBC_ARM_ASM_OPT == TRUE)
@@ -47,6 +48,70 @@
   }
 #endif
 
+/****************************************************************************
+* SbcQuantize_C - C variant of the quantizer kernel
+*
+* RETURNS : N/A
+*/
+void SbcQuantize_C(const int32_t* ps32Sb, int32_t s32Columns, int32_t s32Rows,
+                   const int16_t* ps16ScaleFactor, const int16_t* ps16Bits,
+                   uint16_t* pu16Out) {
+  int32_t s32Blk;             /* counter for block*/
+  int32_t s32Column;          /* counter for channel and sub-band*/
+  int32_t s32LoopCount;       /* number of bits*/
+  uint32_t u32SfRaisedToPow2; /*scale factor raised to power 2*/
+  uint16_t u16Levels;         /*to store levels*/
+  int32_t s32Temp1;           /*used in 64-bit multiplication*/
+  int32_t s32Low;             /*used in 64-bit multiplication*/
+  const int32_t* ps32SbPtr = ps32Sb;
+  const int16_t* ps16ScfPtr;
+#if (SBC_IS_64_MULT_IN_QUANTIZER == TRUE)
+  int32_t s32Hi1, s32Low1, s32Hi, s32Temp2;
+#if (SBC_ARM_ASM_OPT != TRUE)
+  int64_t s64OutTemp;
+#endif
+#endif
+
+  for (s32Blk = 0; s32Blk < s32Rows; s32Blk++) {
+    ps16ScfPtr = ps16ScaleFactor;
+    for (s32Column = 0; s32Column < s32Columns; s32Column++) {
+      s32LoopCount = ps16Bits[s32Column];
+      if (s32LoopCount != 0) {
+#if (SBC_IS_64_MULT_IN_QUANTIZER == TRUE)
+        /* finding level from reconstruction part of decoder */
+        u32SfRaisedToPow2 = ((uint32_t)1 << ((*ps16ScfPtr) + 1));
+        u16Levels = (uint16_t)(((uint32_t)1 << s32LoopCount) - 1);
+
+        /* quantizer */
+        s32Temp1 = (*ps32SbPtr >> 2) + (int32_t)(u32SfRaisedToPow2 << 12);
+        s32Temp2 = u16Levels;
+
+        Mult64(s32Temp1, s32Temp2, s32Low, s32Hi);
+
+        s32Low1 = s32Low >> ((*ps16ScfPtr) + 2);
+        s32Low1 &= ((uint32_t)1 << (32 - ((*ps16ScfPtr) + 2))) - 1;
+        s32Hi1 = s32Hi << (32 - ((*ps16ScfPtr) + 2));
+
+        *pu16Out = (uint16_t)((s32Low1 | s32Hi1) >> 12);
+#else
+        /* finding level from reconstruction part of decoder */
+        u32SfRaisedToPow2 = ((uint32_t)1 << *ps16ScfPtr);
+        u16Levels = (uint16_t)(((uint32_t)1 << s32LoopCount) - 1);
+
+        /* quantizer */
+        s32Temp1 = (*ps32SbPtr >> 15) + u32SfRaisedToPow2;
+        Mult32(s32Temp1, u16Levels, s32Low);
+        s32Low >>= (*ps16ScfPtr + 1);
+        *pu16Out = (uint16_t)s32Low;
+#endif
+      }
+      ps16ScfPtr++;
+      ps32SbPtr++;
+      pu16Out++;
+    }
+  }
+}
+
 /* return number of bytes written to output */
 uint32_t EncPacking(SBC_ENC_PARAMS* pstrEncParams, uint8_t* output) {
   uint8_t* pu8PacketPtr; /* packet ptr*/
@@ -66,18 +131,10 @@ uint32_t EncPacking(SBC_ENC_PARAMS* pstrEncParams, uint8_t* output) {
   int32_t s32NumOfBlocks;
   int32_t s32NumOfSubBands = pstrEncParams->s16NumOfSubBands;
   int32_t s32NumOfChannels = pstrEncParams->s16NumOfChannels;
-  uint32_t u32SfRaisedToPow2; /*scale factor raised to power 2*/
-  int16_t* ps16ScfPtr;
-  int32_t* ps32SbPtr;
-  uint16_t u16Levels; /*to store levels*/
-  int32_t s32Temp1;   /*used in 64-bit multiplication*/
-  int32_t s32Low;     /*used in 64-bit multiplication*/
-#if (SBC_IS_64_MULT_IN_QUANTIZER == TRUE)
-  int32_t s32Hi1, s32Low1, s32Hi, s32Temp2;
-#if (SBC_ARM_ASM_OPT != TRUE)
-  int64_t s64OutTemp;
-#endif
-#endif
+  /* quantized sb samples of the frame */
+  uint16_t au16Quantized[SBC_MAX_NUM_OF_BLOCKS * SBC_MAX_NUM_OF_CHANNELS *
+                         SBC_MAX_NUM_OF_SUBBANDS];
+  uint16_t* pu16Quantized;
 
   pu8PacketPtr = output;           /*Initialize the ptr*/
   *pu8PacketPtr++ = (uint8_t)0x9C; /*Sync word*/
@@ -124,43 +181,21 @@ uint32_t EncPacking(SBC_ENC_PARAMS* pstrEncParams, uint8_t* output) {
     }
   }
 
+  /* Quantize samples */
+  s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
+  pstrEncParams->pstrKernels->Quantize(
+      pstrEncParams->s32SbBuffer, s32Sb, s32NumOfBlocks,
+      pstrEncParams->as16ScaleFactor, pstrEncParams->as16Bits, au16Quantized);
+
   /* Pack samples */
-  ps32SbPtr = pstrEncParams->s32SbBuffer;
+  pu16Quantized = au16Quantized;
   /*Temp=*pu8PacketPtr;*/
-  s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
   for (s32Blk = s32NumOfBlocks - 1; s32Blk >= 0; s32Blk--) {
     ps16GenPtr = pstrEncParams->as16Bits;
-    ps16ScfPtr = pstrEncParams->as16ScaleFactor;
     for (s32Ch = s32Sb - 1; s32Ch >= 0; s32Ch--) {
       s32LoopCount = *ps16GenPtr++;
       if (s32LoopCount != 0) {
-#if (SBC_IS_64_MULT_IN_QUANTIZER == TRUE)
-        /* finding level from reconstruction part of decoder */
-        u32SfRaisedToPow2 = ((uint32_t)1 << ((*ps16ScfPtr) + 1));
-        u16Levels = (uint16_t)(((uint32_t)1 << s32LoopCount) - 1);
-
-        /* quantizer */
-        s32Temp1 = (*ps32SbPtr >> 2) + (int32_t)(u32SfRaisedToPow2 << 12);
-        s32Temp2 = u16Levels;
-
-        Mult64(s32Temp1, s32Temp2, s32Low, s32Hi);
-
-        s32Low1 = s32Low >> ((*ps16ScfPtr) + 2);
-        s32Low1 &= ((uint32_t)1 << (32 - ((*ps16ScfPtr) + 2))) - 1;
-        s32Hi1 = s32Hi << (32 - ((*ps16ScfPtr) + 2));
-
-        u32QuantizedSbValue0 = (uint16_t)((s32Low1 | s32Hi1) >> 12);
-#else
-        /* finding level from reconstruction part of decoder */
-        u32SfRaisedToPow2 = ((uint32_t)1 << *ps16ScfPtr);
-        u16Levels = (uint16_t)(((uint32_t)1 << s32LoopCount) - 1);
-
-        /* quantizer */
-        s32Temp1 = (*ps32SbPtr >> 15) + u32SfRaisedToPow2;
-        Mult32(s32Temp1, u16Levels, s32Low);
-        s32Low >>= (*ps16ScfPtr + 1);
-        u32QuantizedSbValue0 = (uint16_t)s32Low;
-#endif
+        u32QuantizedSbValue0 = *pu16Quantized;
         /*store the number of bits required and the quantized s32Sb
         sample to ease the coding*/
         u32QuantizedSbValue = u32QuantizedSbValue0;
@@ -199,8 +234,7 @@ uint32_t EncPacking(SBC_ENC_PARAMS* pstrEncParams, uint8_t* output) {
           s32PresentBit -= s32LoopCount;
         }
       }
-      ps16ScfPtr++;
-      ps32SbPtr++;
+      pu16Quantized++;
     }
   }
 
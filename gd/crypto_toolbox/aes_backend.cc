@@ -0,0 +1,395 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crypto_toolbox/aes_backend.h"
+
+#include <string.h>
+
+#include "crypto_toolbox/aes.h"
+
+#if defined(__x86_64__)
+#include <wmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_AES
+#define HWCAP_AES (1 << 3)
+#endif
+#endif
+
+namespace bluetooth {
+namespace crypto_toolbox {
+
+namespace {
+
+constexpr int AES_BLOCK_SIZE = 16;
+constexpr int AES_128_ROUNDS = 10;
+constexpr int AES_128_SCHEDULE_SIZE = AES_BLOCK_SIZE * (AES_128_ROUNDS + 1);
+
+void aes_encrypt_table(const uint8_t* key, const uint8_t* in, uint8_t* out) {
+  aes_context ctx;
+  aes_set_key(key, AES_BLOCK_SIZE, &ctx);
+  aes_encrypt(in, out, &ctx);
+}
+
+/* Bitsliced AES S-box (Boyar-Peralta circuit). |q[i]| holds bit i of up to 32
+ * bytes, one byte per bit position. There are no table lookups and no data
+ * dependent branches, so the timing doesn't depend on key or data. */
+void sbox_bitsliced(uint32_t* q) {
+  uint32_t x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4];
+  uint32_t x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+  /* top linear transformation */
+  uint32_t y14 = x3 ^ x5;
+  uint32_t y13 = x0 ^ x6;
+  uint32_t y9 = x0 ^ x3;
+  uint32_t y8 = x0 ^ x5;
+  uint32_t t0 = x1 ^ x2;
+  uint32_t y1 = t0 ^ x7;
+  uint32_t y4 = y1 ^ x3;
+  uint32_t y12 = y13 ^ y14;
+  uint32_t y2 = y1 ^ x0;
+  uint32_t y5 = y1 ^ x6;
+  uint32_t y3 = y5 ^ y8;
+  uint32_t t1 = x4 ^ y12;
+  uint32_t y15 = t1 ^ x5;
+  uint32_t y20 = t1 ^ x1;
+  uint32_t y6 = y15 ^ x7;
+  uint32_t y10 = y15 ^ t0;
+  uint32_t y11 = y20 ^ y9;
+  uint32_t y7 = x7 ^ y11;
+  uint32_t y17 = y10 ^ y11;
+  uint32_t y19 = y10 ^ y8;
+  uint32_t y16 = t0 ^ y11;
+  uint32_t y21 = y13 ^ y16;
+  uint32_t y18 = x0 ^ y16;
+
+  /* non-linear section */
+  uint32_t t2 = y12 & y15;
+  uint32_t t3 = y3 & y6;
+  uint32_t t4 = t3 ^ t2;
+  uint32_t t5 = y4 & x7;
+  uint32_t t6 = t5 ^ t2;
+  uint32_t t7 = y13 & y16;
+  uint32_t t8 = y5 & y1;
+  uint32_t t9 = t8 ^ t7;
+  uint32_t t10 = y2 & y7;
+  uint32_t t11 = t10 ^ t7;
+  uint32_t t12 = y9 & y11;
+  uint32_t t13 = y14 & y17;
+  uint32_t t14 = t13 ^ t12;
+  uint32_t t15 = y8 & y10;
+  uint32_t t16 = t15 ^ t12;
+  uint32_t t17 = t4 ^ t14;
+  uint32_t t18 = t6 ^ t16;
+  uint32_t t19 = t9 ^ t14;
+  uint32_t t20 = t11 ^ t16;
+  uint32_t t21 = t17 ^ y20;
+  uint32_t t22 = t18 ^ y19;
+  uint32_t t23 = t19 ^ y21;
+  uint32_t t24 = t20 ^ y18;
+
+  uint32_t t25 = t21 ^ t22;
+  uint32_t t26 = t21 & t23;
+  uint32_t t27 = t24 ^ t26;
+  uint32_t t28 = t25 & t27;
+  uint32_t t29 = t28 ^ t22;
+  uint32_t t30 = t23 ^ t24;
+  uint32_t t31 = t22 ^ t26;
+  uint32_t t32 = t31 & t30;
+  uint32_t t33 = t32 ^ t24;
+  uint32_t t34 = t23 ^ t33;
+  uint32_t t35 = t27 ^ t33;
+  uint32_t t36 = t24 & t35;
+  uint32_t t37 = t36 ^ t34;
+  uint32_t t38 = t27 ^ t36;
+  uint32_t t39 = t29 & t38;
+  uint32_t t40 = t25 ^ t39;
+
+  uint32_t t41 = t40 ^ t37;
+  uint32_t t42 = t29 ^ t33;
+  uint32_t t43 = t29 ^ t40;
+  uint32_t t44 = t33 ^ t37;
+  uint32_t t45 = t42 ^ t41;
+  uint32_t z0 = t44 & y15;
+  uint32_t z1 = t37 & y6;
+  uint32_t z2 = t33 & x7;
+  uint32_t z3 = t43 & y16;
+  uint32_t z4 = t40 & y1;
+  uint32_t z5 = t29 & y7;
+  uint32_t z6 = t42 & y11;
+  uint32_t z7 = t45 & y17;
+  uint32_t z8 = t41 & y10;
+  uint32_t z9 = t44 & y12;
+  uint32_t z10 = t37 & y3;
+  uint32_t z11 = t33 & y4;
+  uint32_t z12 = t43 & y13;
+  uint32_t z13 = t40 & y5;
+  uint32_t z14 = t29 & y2;
+  uint32_t z15 = t42 & y9;
+  uint32_t z16 = t45 & y14;
+  uint32_t z17 = t41 & y8;
+
+  /* bottom linear transformation */
+  uint32_t t46 = z15 ^ z16;
+  uint32_t t47 = z10 ^ z11;
+  uint32_t t48 = z5 ^ z13;
+  uint32_t t49 = z9 ^ z10;
+  uint32_t t50 = z2 ^ z12;
+  uint32_t t51 = z2 ^ z5;
+  uint32_t t52 = z7 ^ z8;
+  uint32_t t53 = z0 ^ z3;
+  uint32_t t54 = z6 ^ z7;
+  uint32_t t55 = z16 ^ z17;
+  uint32_t t56 = z12 ^ t48;
+  uint32_t t57 = t50 ^ t53;
+  uint32_t t58 = z4 ^ t46;
+  uint32_t t59 = z3 ^ t54;
+  uint32_t t60 = t46 ^ t57;
+  uint32_t t61 = z14 ^ t57;
+  uint32_t t62 = t52 ^ t58;
+  uint32_t t63 = t49 ^ t58;
+  uint32_t t64 = z4 ^ t59;
+  uint32_t t65 = t61 ^ t62;
+  uint32_t t66 = z1 ^ t63;
+  uint32_t s0 = t59 ^ t63;
+  uint32_t s6 = t56 ^ ~t62;
+  uint32_t s7 = t48 ^ ~t60;
+  uint32_t t67 = t64 ^ t65;
+  uint32_t s3 = t53 ^ t66;
+  uint32_t s4 = t51 ^ t66;
+  uint32_t s5 = t47 ^ t65;
+  uint32_t s1 = t64 ^ ~s3;
+  uint32_t s2 = t55 ^ ~t67;
+
+  q[7] = s0;
+  q[6] = s1;
+  q[5] = s2;
+  q[4] = s3;
+  q[3] = s4;
+  q[2] = s5;
+  q[1] = s6;
+  q[0] = s7;
+}
+
+/* Substitute |length| <= 32 bytes through the S-box in one bitsliced pass */
+void sub_bytes_bitsliced(uint8_t* bytes, int length) {
+  uint32_t q[8] = {0};
+  for (int i = 0; i < length; i++) {
+    for (int bit = 0; bit < 8; bit++)
+      q[bit] |= static_cast<uint32_t>((bytes[i] >> bit) & 1) << i;
+  }
+
+  sbox_bitsliced(q);
+
+  for (int i = 0; i < length; i++) {
+    uint8_t byte = 0;
+    for (int bit = 0; bit < 8; bit++) byte |= ((q[bit] >> i) & 1) << bit;
+    bytes[i] = byte;
+  }
+}
+
+/* Multiplication by x in GF(2^8), without a branch on the top bit */
+inline uint8_t xtime(uint8_t b) { return (b << 1) ^ (0x1b & -(b >> 7)); }
+
+void aes_encrypt_bitsliced(const uint8_t* key, const uint8_t* in, uint8_t* out) {
+  uint8_t schedule[AES_128_SCHEDULE_SIZE];
+  memcpy(schedule, key, AES_BLOCK_SIZE);
+
+  uint8_t rcon = 0x01;
+  for (int i = AES_BLOCK_SIZE; i < AES_128_SCHEDULE_SIZE; i += 4) {
+    uint8_t word[4];
+    if (i % AES_BLOCK_SIZE == 0) {
+      /* RotWord then SubWord */
+      word[0] = schedule[i - 3];
+      word[1] = schedule[i - 2];
+      word[2] = schedule[i - 1];
+      word[3] = schedule[i - 4];
+      sub_bytes_bitsliced(word, 4);
+      word[0] ^= rcon;
+      rcon = xtime(rcon);
+    } else {
+      memcpy(word, &schedule[i - 4], 4);
+    }
+    for (int j = 0; j < 4; j++)
+      schedule[i + j] = schedule[i - AES_BLOCK_SIZE + j] ^ word[j];
+  }
+
+  /* byte 4 * c + r of the state is row r of column c */
+  uint8_t state[AES_BLOCK_SIZE];
+  for (int i = 0; i < AES_BLOCK_SIZE; i++) state[i] = in[i] ^ schedule[i];
+
+  for (int round = 1; round <= AES_128_ROUNDS; round++) {
+    sub_bytes_bitsliced(state, AES_BLOCK_SIZE);
+
+    uint8_t shifted[AES_BLOCK_SIZE];
+    for (int c = 0; c < 4; c++) {
+      for (int r = 0; r < 4; r++)
+        shifted[4 * c + r] = state[4 * ((c + r) % 4) + r];
+    }
+
+    if (round == AES_128_ROUNDS) {
+      memcpy(state, shifted, AES_BLOCK_SIZE);
+    } else {
+      for (int c = 0; c < 4; c++) {
+        const uint8_t* a = &shifted[4 * c];
+        uint8_t all = a[0] ^ a[1] ^ a[2] ^ a[3];
+        state[4 * c] = a[0] ^ all ^ xtime(a[0] ^ a[1]);
+        state[4 * c + 1] = a[1] ^ all ^ xtime(a[1] ^ a[2]);
+        state[4 * c + 2] = a[2] ^ all ^ xtime(a[2] ^ a[3]);
+        state[4 * c + 3] = a[3] ^ all ^ xtime(a[3] ^ a[0]);
+      }
+    }
+
+    const uint8_t* round_key = &schedule[round * AES_BLOCK_SIZE];
+    for (int i = 0; i < AES_BLOCK_SIZE; i++) state[i] ^= round_key[i];
+  }
+
+  memcpy(out, state, AES_BLOCK_SIZE);
+}
+
+#if defined(__x86_64__)
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+
+AESNI_TARGET inline __m128i aesni_expand_key(__m128i key, __m128i assist) {
+  assist = _mm_shuffle_epi32(assist, _MM_SHUFFLE(3, 3, 3, 3));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, assist);
+}
+
+/* aeskeygenassist takes the round constant as an immediate */
+#define AESNI_ROUND_KEY(prev, rcon) \
+  aesni_expand_key(prev, _mm_aeskeygenassist_si128(prev, rcon))
+
+AESNI_TARGET void aes_encrypt_aesni(const uint8_t* key, const uint8_t* in, uint8_t* out) {
+  __m128i k[AES_128_ROUNDS + 1];
+  k[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+  k[1] = AESNI_ROUND_KEY(k[0], 0x01);
+  k[2] = AESNI_ROUND_KEY(k[1], 0x02);
+  k[3] = AESNI_ROUND_KEY(k[2], 0x04);
+  k[4] = AESNI_ROUND_KEY(k[3], 0x08);
+  k[5] = AESNI_ROUND_KEY(k[4], 0x10);
+  k[6] = AESNI_ROUND_KEY(k[5], 0x20);
+  k[7] = AESNI_ROUND_KEY(k[6], 0x40);
+  k[8] = AESNI_ROUND_KEY(k[7], 0x80);
+  k[9] = AESNI_ROUND_KEY(k[8], 0x1b);
+  k[10] = AESNI_ROUND_KEY(k[9], 0x36);
+
+  __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+  m = _mm_xor_si128(m, k[0]);
+  for (int round = 1; round < AES_128_ROUNDS; round++)
+    m = _mm_aesenc_si128(m, k[round]);
+  m = _mm_aesenclast_si128(m, k[AES_128_ROUNDS]);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), m);
+}
+
+bool aesni_supported() { return __builtin_cpu_supports("aes"); }
+#endif
+
+#if defined(__aarch64__)
+#if defined(__clang__)
+#define ARMV8_CRYPTO_TARGET __attribute__((target("crypto")))
+#else
+#define ARMV8_CRYPTO_TARGET __attribute__((target("+crypto")))
+#endif
+
+/* AESE with an all zero round key is SubBytes and ShiftRows; with the word
+ * repeated in every column ShiftRows has no effect, leaving SubWord */
+ARMV8_CRYPTO_TARGET inline uint32_t armv8_sub_word(uint32_t word) {
+  uint8x16_t v = vreinterpretq_u8_u32(vdupq_n_u32(word));
+  v = vaeseq_u8(v, vdupq_n_u8(0));
+  return vgetq_lane_u32(vreinterpretq_u32_u8(v), 0);
+}
+
+ARMV8_CRYPTO_TARGET void aes_encrypt_armv8(const uint8_t* key, const uint8_t* in, uint8_t* out) {
+  /* words are loaded little endian: byte 0 of a word is its low byte */
+  uint32_t w[4 * (AES_128_ROUNDS + 1)];
+  memcpy(w, key, AES_BLOCK_SIZE);
+  uint32_t rcon = 0x01;
+  for (int i = 4; i < 4 * (AES_128_ROUNDS + 1); i++) {
+    uint32_t word = w[i - 1];
+    if (i % 4 == 0) {
+      word = armv8_sub_word((word >> 8) | (word << 24)) ^ rcon;
+      rcon = (rcon << 1) ^ (0x1b & -(rcon >> 7));
+    }
+    w[i] = w[i - 4] ^ word;
+  }
+
+  uint8x16_t k[AES_128_ROUNDS + 1];
+  for (int i = 0; i <= AES_128_ROUNDS; i++)
+    k[i] = vreinterpretq_u8_u32(vld1q_u32(&w[4 * i]));
+
+  uint8x16_t m = vld1q_u8(in);
+  for (int round = 0; round < AES_128_ROUNDS - 1; round++)
+    m = vaesmcq_u8(vaeseq_u8(m, k[round]));
+  m = vaeseq_u8(m, k[AES_128_ROUNDS - 1]);
+  m = veorq_u8(m, k[AES_128_ROUNDS]);
+  vst1q_u8(out, m);
+}
+
+bool armv8_supported() { return getauxval(AT_HWCAP) & HWCAP_AES; }
+#endif
+
+}  // namespace
+
+AesEncryptFunc aes_backend_get(AesBackend backend) {
+  switch (backend) {
+    case AesBackend::TABLE:
+      return aes_encrypt_table;
+    case AesBackend::BITSLICED:
+      return aes_encrypt_bitsliced;
+    case AesBackend::AESNI:
+#if defined(__x86_64__)
+      if (aesni_supported()) return aes_encrypt_aesni;
+#endif
+      return nullptr;
+    case AesBackend::ARMV8:
+#if defined(__aarch64__)
+      if (armv8_supported()) return aes_encrypt_armv8;
+#endif
+      return nullptr;
+  }
+  return nullptr;
+}
+
+AesBackend aes_backend_default() {
+  static const AesBackend backend = [] {
+    if (aes_backend_get(AesBackend::AESNI)) return AesBackend::AESNI;
+    if (aes_backend_get(AesBackend::ARMV8)) return AesBackend::ARMV8;
+    // Bitsliced only encrypts one block per S-box pass, which makes it much slower than the tables
+    return AesBackend::TABLE;
+  }();
+  return backend;
+}
+
+const char* aes_backend_name(AesBackend backend) {
+  switch (backend) {
+    case AesBackend::TABLE:
+      return "table";
+    case AesBackend::BITSLICED:
+      return "bitsliced";
+    case AesBackend::AESNI:
+      return "aesni";
+    case AesBackend::ARMV8:
+      return "armv8";
+  }
+  return "unknown";
+}
+
+}  // namespace crypto_toolbox
+}  // namespace bluetooth
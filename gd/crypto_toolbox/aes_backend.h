@@ -0,0 +1,54 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace bluetooth {
+namespace crypto_toolbox {
+
+/* Implementations of the AES-128 block cipher that aes_128() and aes_cmac()
+ * can run on. The one used is picked once, at runtime, from what the CPU
+ * supports. */
+enum class AesBackend {
+  /* byte oriented S-box tables of aes.cc, used when there is no hardware
+   * support */
+  TABLE,
+  /* constant time bitsliced S-box */
+  BITSLICED,
+  /* x86-64 AES-NI instructions */
+  AESNI,
+  /* ARMv8 cryptography extension */
+  ARMV8,
+};
+
+/* Encrypt one 16 byte block |in| with the 16 byte |key| into |out|. All are in
+ * the byte order of FIPS-197, not in the reversed order used by aes_128() */
+typedef void (*AesEncryptFunc)(const uint8_t* key, const uint8_t* in, uint8_t* out);
+
+/* Returns the implementation of |backend|, or nullptr if the CPU doesn't
+ * support it */
+extern AesEncryptFunc aes_backend_get(AesBackend backend);
+
+/* Returns the backend used by aes_128(): the hardware one if available, the
+ * table one otherwise */
+extern AesBackend aes_backend_default();
+
+extern const char* aes_backend_name(AesBackend backend);
+
+}  // namespace crypto_toolbox
+}  // namespace bluetooth
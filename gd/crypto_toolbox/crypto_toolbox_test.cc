@@ -19,8 +19,12 @@
 #include <gtest/gtest.h>
 
 #include "crypto_toolbox/aes.h"
+#include "crypto_toolbox/aes_backend.h"
 #include "crypto_toolbox/crypto_toolbox.h"
 
+#include <chrono>
+#include <random>
+#include <string>
 #include <vector>
 
 namespace bluetooth {
@@ -351,5 +355,80 @@ TEST(CryptoToolboxTest, bt_spec_example_d_12_test) {
   EXPECT_EQ(expected_ltk, ltk);
 }
 
+// FIPS-197 Appendix C.1
+TEST(CryptoToolboxTest, aes_backends_fips_197_test) {
+  uint8_t key[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+  uint8_t plaintext[] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                         0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+  Octet16 ciphertext{0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a};
+
+  for (AesBackend backend : {AesBackend::TABLE, AesBackend::BITSLICED, AesBackend::AESNI, AesBackend::ARMV8}) {
+    AesEncryptFunc aes_encrypt = aes_backend_get(backend);
+    if (aes_encrypt == nullptr) continue;
+
+    Octet16 output;
+    aes_encrypt(key, plaintext, output.data());
+    EXPECT_EQ(ciphertext, output) << aes_backend_name(backend);
+  }
+}
+
+/* Every backend available on this CPU must match the table implementation */
+TEST(CryptoToolboxTest, aes_backends_equivalence_test) {
+  AesEncryptFunc reference = aes_backend_get(AesBackend::TABLE);
+  ASSERT_NE(aes_backend_get(AesBackend::BITSLICED), nullptr);
+  ASSERT_NE(aes_backend_get(aes_backend_default()), nullptr);
+
+  std::mt19937 random(0x5eed);
+  for (int i = 0; i < 1000; i++) {
+    Octet16 key, plaintext, expected;
+    for (int j = 0; j < OCTET16_LEN; j++) {
+      key[j] = random();
+      plaintext[j] = random();
+    }
+    reference(key.data(), plaintext.data(), expected.data());
+
+    for (AesBackend backend : {AesBackend::BITSLICED, AesBackend::AESNI, AesBackend::ARMV8}) {
+      AesEncryptFunc aes_encrypt = aes_backend_get(backend);
+      if (aes_encrypt == nullptr) continue;
+
+      Octet16 output;
+      aes_encrypt(key.data(), plaintext.data(), output.data());
+      ASSERT_EQ(expected, output) << aes_backend_name(backend) << " iteration " << i;
+    }
+  }
+}
+
+/* Without hardware support aes_128() must use the tables, the fastest software
+ * backend */
+TEST(CryptoToolboxTest, aes_backend_default_test) {
+  AesBackend backend = aes_backend_default();
+  if (backend != AesBackend::AESNI && backend != AesBackend::ARMV8) {
+    EXPECT_EQ(AesBackend::TABLE, backend) << aes_backend_name(backend);
+  }
+}
+
+/* Blocks encrypted per second by each backend, key expansion included as
+ * aes_128() does it for every block */
+TEST(CryptoToolboxTest, aes_backends_throughput_test) {
+  constexpr int kBlocks = 20000;
+  uint8_t key[OCTET16_LEN] = {0};
+  uint8_t block[OCTET16_LEN] = {0};
+
+  for (AesBackend backend : {AesBackend::TABLE, AesBackend::BITSLICED, AesBackend::AESNI, AesBackend::ARMV8}) {
+    AesEncryptFunc aes_encrypt = aes_backend_get(backend);
+    if (aes_encrypt == nullptr) continue;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kBlocks; i++) {
+      aes_encrypt(key, block, block);
+      key[i % OCTET16_LEN] ^= block[0];
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    int blocks_per_second = kBlocks / elapsed.count();
+    RecordProperty(std::string(aes_backend_name(backend)) + "_blocks_per_s", blocks_per_second);
+  }
+}
+
 }  // namespace crypto_toolbox
 }  // namespace bluetooth
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/h4_deframer.h"
+
+#include <cstring>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hal {
+
+namespace {
+constexpr size_t kH4HeaderSize = 1;
+constexpr size_t kHciCommandHeaderSize = 3;
+constexpr size_t kHciAclHeaderSize = 4;
+constexpr size_t kHciScoHeaderSize = 3;
+constexpr size_t kHciEvtHeaderSize = 2;
+
+// Returns the size of the HCI header of |type|, or 0 for an unknown type
+size_t GetHeaderSize(uint8_t type) {
+  switch (static_cast<H4Deframer::PacketType>(type)) {
+    case H4Deframer::PacketType::COMMAND:
+      return kHciCommandHeaderSize;
+    case H4Deframer::PacketType::ACL:
+      return kHciAclHeaderSize;
+    case H4Deframer::PacketType::SCO:
+      return kHciScoHeaderSize;
+    case H4Deframer::PacketType::EVENT:
+      return kHciEvtHeaderSize;
+  }
+  return 0;
+}
+
+// Returns the payload size given in |header|
+size_t GetPayloadSize(uint8_t type, const uint8_t* header) {
+  switch (static_cast<H4Deframer::PacketType>(type)) {
+    case H4Deframer::PacketType::COMMAND:
+      return header[2];
+    case H4Deframer::PacketType::ACL:
+      return header[2] | (header[3] << 8);
+    case H4Deframer::PacketType::SCO:
+      return header[2];
+    case H4Deframer::PacketType::EVENT:
+      return header[1];
+  }
+  return 0;
+}
+}  // namespace
+
+H4Deframer::H4Deframer(size_t buffer_size) : buffer_(buffer_size) {
+  ASSERT(buffer_size > kH4HeaderSize + kHciAclHeaderSize);
+}
+
+uint8_t* H4Deframer::GetReceiveBuffer() {
+  return buffer_.data() + end_;
+}
+
+size_t H4Deframer::GetReceiveBufferSize() const {
+  return buffer_.size() - end_;
+}
+
+void H4Deframer::OnBytesReceived(size_t size) {
+  ASSERT(size <= GetReceiveBufferSize());
+  end_ += size;
+}
+
+bool H4Deframer::ExtractPackets(const PacketCallback& on_packet) {
+  // Size of the packet at begin_, once its header is received
+  size_t pending_size = 0;
+  while (end_ > begin_) {
+    const uint8_t* h4_packet = buffer_.data() + begin_;
+    size_t available = end_ - begin_;
+    uint8_t type = h4_packet[0];
+    size_t header_size = GetHeaderSize(type);
+    if (header_size == 0) {
+      LOG_ERROR("Unknown H4 packet type 0x%02hhx", type);
+      return false;
+    }
+    if (available < kH4HeaderSize + header_size) {
+      break;
+    }
+    size_t packet_size = header_size + GetPayloadSize(type, h4_packet + kH4HeaderSize);
+    if (available < kH4HeaderSize + packet_size) {
+      pending_size = kH4HeaderSize + packet_size;
+      break;
+    }
+    const uint8_t* packet = h4_packet + kH4HeaderSize;
+    begin_ += kH4HeaderSize + packet_size;
+    on_packet(static_cast<PacketType>(type), std::vector<uint8_t>(packet, packet + packet_size));
+  }
+
+  if (begin_ == end_) {
+    begin_ = 0;
+    end_ = 0;
+  } else if (begin_ > 0) {
+    std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+    end_ -= begin_;
+    begin_ = 0;
+  }
+  if (pending_size > buffer_.size()) {
+    buffer_.resize(pending_size);
+  }
+  return true;
+}
+
+}  // namespace hal
+}  // namespace bluetooth
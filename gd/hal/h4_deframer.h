@@ -0,0 +1,68 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+
+// Splits an H4 byte stream into HCI packets.
+//
+// Bytes are received straight into one buffer, as many as the transport has available, and every complete packet
+// in the buffer is handed out at once: a burst of packets costs a single read, instead of one read per header and
+// payload of each packet. The bytes of a packet not fully received yet are moved to the front of the buffer to wait
+// for the rest; the buffer grows if a packet doesn't fit.
+class H4Deframer {
+ public:
+  enum class PacketType : uint8_t {
+    COMMAND = 0x01,
+    ACL = 0x02,
+    SCO = 0x03,
+    EVENT = 0x04,
+  };
+
+  // |packet| is the HCI packet, without its H4 packet type
+  using PacketCallback = std::function<void(PacketType type, std::vector<uint8_t> packet)>;
+
+  static constexpr size_t kDefaultBufferSize = 16 * 1024;
+
+  explicit H4Deframer(size_t buffer_size = kDefaultBufferSize);
+
+  // Where the next bytes are to be received, and how many fit there
+  uint8_t* GetReceiveBuffer();
+  size_t GetReceiveBufferSize() const;
+
+  // |size| bytes were written to the receive buffer
+  void OnBytesReceived(size_t size);
+
+  // Hand out every complete packet received. Returns false if the stream holds an unknown packet type, after
+  // which it can't be split anymore.
+  bool ExtractPackets(const PacketCallback& on_packet);
+
+ private:
+  std::vector<uint8_t> buffer_;
+  // Received bytes not handed out yet are buffer_[begin_, end_)
+  size_t begin_ = 0;
+  size_t end_ = 0;
+};
+
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "hal/h4_deframer.h"
+#include "os/log.h"
+#include "os/utils.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hal {
+
+namespace {
+constexpr size_t kAclPayloadSize = 64;
+constexpr size_t kPacketsPerBatch = 32;
+
+std::vector<uint8_t> MakeH4AclBatch() {
+  std::vector<uint8_t> batch;
+  for (size_t i = 0; i < kPacketsPerBatch; i++) {
+    batch.insert(batch.end(), {0x02, 0x01, 0x00, kAclPayloadSize, 0x00});
+    batch.insert(batch.end(), kAclPayloadSize, static_cast<uint8_t>(i));
+  }
+  return batch;
+}
+
+void ReceiveExactly(int fd, uint8_t* buf, size_t size) {
+  while (size > 0) {
+    ssize_t received;
+    RUN_NO_INTR(received = recv(fd, buf, size, 0));
+    ASSERT(received > 0);
+    buf += received;
+    size -= received;
+  }
+}
+}  // namespace
+
+// Batches of ACL packets sent over a local stream socket, as between rootcanal and the host HAL
+class BM_H4Deframer : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds_) == 0);
+    batch_ = MakeH4AclBatch();
+  }
+
+  void TearDown(State& st) override {
+    close(fds_[0]);
+    close(fds_[1]);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  void SendBatch() {
+    ssize_t written;
+    RUN_NO_INTR(written = write(fds_[0], batch_.data(), batch_.size()));
+    ASSERT(written == static_cast<ssize_t>(batch_.size()));
+  }
+
+  int fds_[2];
+  std::vector<uint8_t> batch_;
+};
+
+// Previous HAL reads: H4 type, HCI header and payload of each packet, then a copy to a new vector
+BENCHMARK_DEFINE_F(BM_H4Deframer, three_reads_per_packet)(State& state) {
+  for (auto _ : state) {
+    SendBatch();
+    for (size_t i = 0; i < kPacketsPerBatch; i++) {
+      uint8_t buf[1024 + 4 + 1];
+      ReceiveExactly(fds_[1], buf, 1);
+      ReceiveExactly(fds_[1], buf + 1, 4);
+      size_t payload_size = buf[3] | (buf[4] << 8);
+      ReceiveExactly(fds_[1], buf + 5, payload_size);
+      std::vector<uint8_t> packet(buf + 1, buf + 5 + payload_size);
+      ::benchmark::DoNotOptimize(packet);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kPacketsPerBatch);
+}
+BENCHMARK_REGISTER_F(BM_H4Deframer, three_reads_per_packet);
+
+BENCHMARK_DEFINE_F(BM_H4Deframer, deframer)(State& state) {
+  H4Deframer deframer;
+  for (auto _ : state) {
+    SendBatch();
+    size_t received_packets = 0;
+    while (received_packets < kPacketsPerBatch) {
+      ssize_t received;
+      RUN_NO_INTR(received = recv(fds_[1], deframer.GetReceiveBuffer(), deframer.GetReceiveBufferSize(), 0));
+      ASSERT(received > 0);
+      deframer.OnBytesReceived(received);
+      deframer.ExtractPackets([&received_packets](H4Deframer::PacketType, std::vector<uint8_t> packet) {
+        ::benchmark::DoNotOptimize(packet);
+        received_packets++;
+      });
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kPacketsPerBatch);
+}
+BENCHMARK_REGISTER_F(BM_H4Deframer, deframer);
+
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/h4_deframer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+using PacketType = H4Deframer::PacketType;
+using Packets = std::vector<std::pair<PacketType, std::vector<uint8_t>>>;
+
+std::vector<uint8_t> MakeEvent(uint8_t size) {
+  std::vector<uint8_t> packet = {0x0e, size};
+  for (uint8_t i = 0; i < size; i++) packet.push_back(i);
+  return packet;
+}
+
+std::vector<uint8_t> MakeAcl(uint16_t size) {
+  std::vector<uint8_t> packet = {0x01, 0x20, static_cast<uint8_t>(size & 0xff), static_cast<uint8_t>(size >> 8)};
+  for (uint16_t i = 0; i < size; i++) packet.push_back(i & 0xff);
+  return packet;
+}
+
+std::vector<uint8_t> MakeSco(uint8_t size) {
+  std::vector<uint8_t> packet = {0x02, 0x00, size};
+  for (uint8_t i = 0; i < size; i++) packet.push_back(i);
+  return packet;
+}
+
+void AppendH4(std::vector<uint8_t>* stream, PacketType type, const std::vector<uint8_t>& packet) {
+  stream->push_back(static_cast<uint8_t>(type));
+  stream->insert(stream->end(), packet.begin(), packet.end());
+}
+
+// Feed |stream| to |deframer| in chunks of |chunk_size| bytes, as a socket would deliver it
+Packets Deframe(H4Deframer* deframer, const std::vector<uint8_t>& stream, size_t chunk_size) {
+  Packets packets;
+  size_t offset = 0;
+  while (offset < stream.size()) {
+    size_t size = std::min({chunk_size, stream.size() - offset, deframer->GetReceiveBufferSize()});
+    EXPECT_GT(size, 0u);
+    memcpy(deframer->GetReceiveBuffer(), stream.data() + offset, size);
+    deframer->OnBytesReceived(size);
+    offset += size;
+    EXPECT_TRUE(deframer->ExtractPackets([&packets](PacketType type, std::vector<uint8_t> packet) {
+      packets.emplace_back(type, std::move(packet));
+    }));
+  }
+  return packets;
+}
+
+TEST(H4DeframerTest, all_packets_of_one_read) {
+  Packets expected = {
+      {PacketType::EVENT, MakeEvent(4)},
+      {PacketType::ACL, MakeAcl(27)},
+      {PacketType::SCO, MakeSco(60)},
+      {PacketType::EVENT, MakeEvent(0)},
+  };
+  std::vector<uint8_t> stream;
+  for (auto& packet : expected) AppendH4(&stream, packet.first, packet.second);
+
+  H4Deframer deframer;
+  EXPECT_EQ(expected, Deframe(&deframer, stream, stream.size()));
+  EXPECT_EQ(H4Deframer::kDefaultBufferSize, deframer.GetReceiveBufferSize());
+}
+
+TEST(H4DeframerTest, packets_split_across_reads) {
+  Packets expected;
+  std::vector<uint8_t> stream;
+  for (uint16_t i = 0; i < 50; i++) {
+    expected.emplace_back(PacketType::ACL, MakeAcl(i * 7));
+    expected.emplace_back(PacketType::EVENT, MakeEvent(i));
+  }
+  for (auto& packet : expected) AppendH4(&stream, packet.first, packet.second);
+
+  for (size_t chunk_size : {1, 2, 3, 5, 64, 1000}) {
+    H4Deframer deframer(256);
+    EXPECT_EQ(expected, Deframe(&deframer, stream, chunk_size)) << "chunk size " << chunk_size;
+  }
+}
+
+TEST(H4DeframerTest, buffer_grows_for_large_packet) {
+  Packets expected = {{PacketType::ACL, MakeAcl(4000)}, {PacketType::EVENT, MakeEvent(3)}};
+  std::vector<uint8_t> stream;
+  for (auto& packet : expected) AppendH4(&stream, packet.first, packet.second);
+
+  H4Deframer deframer(64);
+  EXPECT_EQ(expected, Deframe(&deframer, stream, 512));
+}
+
+TEST(H4DeframerTest, unknown_packet_type) {
+  H4Deframer deframer;
+  deframer.GetReceiveBuffer()[0] = 0x42;
+  deframer.OnBytesReceived(1);
+  EXPECT_FALSE(deframer.ExtractPackets([](PacketType, std::vector<uint8_t>) { FAIL(); }));
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
@@ -20,12 +20,14 @@
 #include <netdb.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <chrono>
 #include <csignal>
 #include <mutex>
 #include <queue>
 
+#include "hal/h4_deframer.h"
 #include "hal/snoop_logger.h"
 #include "os/log.h"
 #include "os/reactor.h"
@@ -37,13 +39,8 @@ constexpr int INVALID_FD = -1;
 constexpr uint8_t kH4Command = 0x01;
 constexpr uint8_t kH4Acl = 0x02;
 constexpr uint8_t kH4Sco = 0x03;
-constexpr uint8_t kH4Event = 0x04;
 
 constexpr uint8_t kH4HeaderSize = 1;
-constexpr uint8_t kHciAclHeaderSize = 4;
-constexpr uint8_t kHciScoHeaderSize = 3;
-constexpr uint8_t kHciEvtHeaderSize = 2;
-constexpr int kBufSize = 1024 + 4 + 1;  // DeviceProperties::acl_data_packet_size_ + ACL header + H4 header
 
 int ConnectToRootCanal(const std::string& server, int port) {
   int socket_fd = socket(AF_INET, SOCK_STREAM, 0);
@@ -116,28 +113,22 @@ class HciHalHostRootcanal : public HciHal {
   void sendHciCommand(HciPacket command) override {
     std::lock_guard<std::mutex> lock(api_mutex_);
     ASSERT(sock_fd_ != INVALID_FD);
-    std::vector<uint8_t> packet = std::move(command);
-    btsnoop_logger_->capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
-    packet.insert(packet.cbegin(), kH4Command);
-    write_to_rootcanal_fd(packet);
+    btsnoop_logger_->capture(command, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
+    write_to_rootcanal_fd(kH4Command, std::move(command));
   }
 
   void sendAclData(HciPacket data) override {
     std::lock_guard<std::mutex> lock(api_mutex_);
     ASSERT(sock_fd_ != INVALID_FD);
-    std::vector<uint8_t> packet = std::move(data);
-    btsnoop_logger_->capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
-    packet.insert(packet.cbegin(), kH4Acl);
-    write_to_rootcanal_fd(packet);
+    btsnoop_logger_->capture(data, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+    write_to_rootcanal_fd(kH4Acl, std::move(data));
   }
 
   void sendScoData(HciPacket data) override {
     std::lock_guard<std::mutex> lock(api_mutex_);
     ASSERT(sock_fd_ != INVALID_FD);
-    std::vector<uint8_t> packet = std::move(data);
-    btsnoop_logger_->capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
-    packet.insert(packet.cbegin(), kH4Sco);
-    write_to_rootcanal_fd(packet);
+    btsnoop_logger_->capture(data, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
+    write_to_rootcanal_fd(kH4Sco, std::move(data));
   }
 
  protected:
@@ -188,12 +179,14 @@ class HciHalHostRootcanal : public HciHal {
   bluetooth::os::Thread hci_incoming_thread_ =
       bluetooth::os::Thread("hci_incoming_thread", bluetooth::os::Thread::Priority::NORMAL);
   bluetooth::os::Reactor::Reactable* reactable_ = nullptr;
-  std::queue<std::vector<uint8_t>> hci_outgoing_queue_;
+  // H4 packet type and HCI packet of each packet to send
+  std::queue<std::pair<uint8_t, HciPacket>> hci_outgoing_queue_;
   SnoopLogger* btsnoop_logger_ = nullptr;
+  H4Deframer h4_deframer_;
 
-  void write_to_rootcanal_fd(HciPacket packet) {
+  void write_to_rootcanal_fd(uint8_t h4_type, HciPacket packet) {
     // TODO: replace this with new queue when it's ready
-    hci_outgoing_queue_.emplace(packet);
+    hci_outgoing_queue_.emplace(h4_type, std::move(packet));
     if (hci_outgoing_queue_.size() == 1) {
       hci_incoming_thread_.GetReactor()->ModifyRegistration(
           reactable_, common::Bind(&HciHalHostRootcanal::incoming_packet_received, common::Unretained(this)),
@@ -203,12 +196,27 @@ class HciHalHostRootcanal : public HciHal {
 
   void send_packet_ready() {
     std::lock_guard<std::mutex> lock(this->api_mutex_);
-    auto packet_to_send = this->hci_outgoing_queue_.front();
-    auto bytes_written = write(this->sock_fd_, (void*)packet_to_send.data(), packet_to_send.size());
-    this->hci_outgoing_queue_.pop();
-    if (bytes_written == -1) {
-      abort();
+    uint8_t h4_type = hci_outgoing_queue_.front().first;
+    const HciPacket& packet = hci_outgoing_queue_.front().second;
+    // The H4 packet type goes in its own iovec, so the packet isn't moved to prepend it
+    size_t bytes_to_write = kH4HeaderSize + packet.size();
+    size_t bytes_written = 0;
+    while (bytes_written < bytes_to_write) {
+      struct iovec iov[2];
+      int iovcnt = 0;
+      if (bytes_written < kH4HeaderSize) {
+        iov[iovcnt++] = {.iov_base = &h4_type, .iov_len = kH4HeaderSize};
+      }
+      size_t offset = bytes_written > kH4HeaderSize ? bytes_written - kH4HeaderSize : 0;
+      iov[iovcnt++] = {.iov_base = const_cast<uint8_t*>(packet.data()) + offset, .iov_len = packet.size() - offset};
+      ssize_t result;
+      RUN_NO_INTR(result = writev(this->sock_fd_, iov, iovcnt));
+      if (result == -1) {
+        abort();
+      }
+      bytes_written += result;
     }
+    this->hci_outgoing_queue_.pop();
     if (hci_outgoing_queue_.empty()) {
       this->hci_incoming_thread_.GetReactor()->ModifyRegistration(
           this->reactable_, common::Bind(&HciHalHostRootcanal::incoming_packet_received, common::Unretained(this)),
@@ -224,94 +232,59 @@ class HciHalHostRootcanal : public HciHal {
         return;
       }
     }
-    uint8_t buf[kBufSize] = {};
 
+    // Receive as much as is available, and hand out every complete packet
     ssize_t received_size;
-    RUN_NO_INTR(received_size = recv(sock_fd_, buf, kH4HeaderSize, 0));
+    RUN_NO_INTR(received_size =
+                    recv(sock_fd_, h4_deframer_.GetReceiveBuffer(), h4_deframer_.GetReceiveBufferSize(), 0));
     ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
     if (received_size == 0) {
       LOG_WARN("Can't read H4 header. EOF received");
       raise(SIGINT);
       return;
     }
+    h4_deframer_.OnBytesReceived(received_size);
+    bool is_valid = h4_deframer_.ExtractPackets(
+        [this](H4Deframer::PacketType type, HciPacket packet) { deliver_packet(type, std::move(packet)); });
+    ASSERT_LOG(is_valid, "malformed H4 packet type received");
+  }
 
-    if (buf[0] == kH4Event) {
-      RUN_NO_INTR(received_size = recv(sock_fd_, buf + kH4HeaderSize, kHciEvtHeaderSize, 0));
-      ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(received_size == kHciEvtHeaderSize, "malformed HCI event header received");
-
-      uint8_t hci_evt_parameter_total_length = buf[2];
-      ssize_t payload_size;
-      RUN_NO_INTR(payload_size =
-                      recv(sock_fd_, buf + kH4HeaderSize + kHciEvtHeaderSize, hci_evt_parameter_total_length, 0));
-      ASSERT_LOG(payload_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(payload_size == hci_evt_parameter_total_length,
-                 "malformed HCI event total parameter size received: %zu != %d", payload_size,
-                 hci_evt_parameter_total_length);
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciEvtHeaderSize + payload_size);
-      btsnoop_logger_->capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::EVT);
-      {
+  void deliver_packet(H4Deframer::PacketType type, HciPacket packet) {
+    switch (type) {
+      case H4Deframer::PacketType::EVENT: {
+        btsnoop_logger_->capture(packet, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::EVT);
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
         if (incoming_packet_callback_ == nullptr) {
           LOG_INFO("Dropping an event after processing");
           return;
         }
-        incoming_packet_callback_->hciEventReceived(receivedHciPacket);
+        incoming_packet_callback_->hciEventReceived(std::move(packet));
+        return;
       }
-    }
-
-    if (buf[0] == kH4Acl) {
-      RUN_NO_INTR(received_size = recv(sock_fd_, buf + kH4HeaderSize, kHciAclHeaderSize, 0));
-      ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(received_size == kHciAclHeaderSize, "malformed ACL header received");
-
-      uint16_t hci_acl_data_total_length = (buf[4] << 8) + buf[3];
-      int payload_size;
-      RUN_NO_INTR(payload_size = recv(sock_fd_, buf + kH4HeaderSize + kHciAclHeaderSize, hci_acl_data_total_length, 0));
-      ASSERT_LOG(payload_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(payload_size == hci_acl_data_total_length, "malformed ACL length received: %d != %d", payload_size,
-                 hci_acl_data_total_length);
-      ASSERT_LOG(hci_acl_data_total_length <= kBufSize - kH4HeaderSize - kHciAclHeaderSize, "packet too long");
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciAclHeaderSize + payload_size);
-      btsnoop_logger_->capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ACL);
-      {
+      case H4Deframer::PacketType::ACL: {
+        btsnoop_logger_->capture(packet, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ACL);
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
         if (incoming_packet_callback_ == nullptr) {
           LOG_INFO("Dropping an ACL packet after processing");
           return;
         }
-        incoming_packet_callback_->aclDataReceived(receivedHciPacket);
+        incoming_packet_callback_->aclDataReceived(std::move(packet));
+        return;
       }
-    }
-
-    if (buf[0] == kH4Sco) {
-      RUN_NO_INTR(received_size = recv(sock_fd_, buf + kH4HeaderSize, kHciScoHeaderSize, 0));
-      ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(received_size == kHciScoHeaderSize, "malformed SCO header received");
-
-      uint8_t hci_sco_data_total_length = buf[3];
-      int payload_size;
-      RUN_NO_INTR(payload_size = recv(sock_fd_, buf + kH4HeaderSize + kHciScoHeaderSize, hci_sco_data_total_length, 0));
-      ASSERT_LOG(payload_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(payload_size == hci_sco_data_total_length, "malformed SCO packet received: size mismatch");
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciScoHeaderSize + payload_size);
-      btsnoop_logger_->capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::SCO);
-      {
+      case H4Deframer::PacketType::SCO: {
+        btsnoop_logger_->capture(packet, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::SCO);
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
         if (incoming_packet_callback_ == nullptr) {
           LOG_INFO("Dropping a SCO packet after processing");
           return;
         }
-        incoming_packet_callback_->scoDataReceived(receivedHciPacket);
+        incoming_packet_callback_->scoDataReceived(std::move(packet));
+        return;
       }
+      case H4Deframer::PacketType::COMMAND:
+        LOG_WARN("Dropping an HCI command received from the controller");
+        return;
     }
-    memset(buf, 0, kBufSize);
   }
 };
 
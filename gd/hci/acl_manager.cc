@@ -16,6 +16,7 @@
 
 #include "hci/acl_manager.h"
 
+#include <algorithm>
 #include <future>
 #include <queue>
 #include <set>
@@ -24,6 +25,7 @@
 #include "acl_fragmenter.h"
 #include "acl_manager.h"
 #include "common/bidi_queue.h"
+#include "hci/acl_scheduler.h"
 #include "hci/controller.h"
 #include "hci/hci_layer.h"
 
@@ -61,10 +63,11 @@ uint16_t GetL2capPduSize(AclPacketView packet) {
 }  // namespace
 
 struct AclManager::acl_connection {
-  acl_connection(AddressWithType address_with_type, os::Handler* handler)
-      : address_with_type_(address_with_type), handler_(handler) {}
+  acl_connection(AddressWithType address_with_type, AclScheduler::Transport transport, os::Handler* handler)
+      : address_with_type_(address_with_type), transport_(transport), handler_(handler) {}
   friend AclConnection;
   AddressWithType address_with_type_;
+  AclScheduler::Transport transport_;
   os::Handler* handler_;
   std::unique_ptr<AclConnection::Queue> queue_ = std::make_unique<AclConnection::Queue>(10);
   bool is_disconnected_ = false;
@@ -76,10 +79,10 @@ struct AclManager::acl_connection {
   // For LE Connection parameter update from L2CAP
   common::OnceCallback<void(ErrorCode)> on_connection_update_complete_callback_;
   os::Handler* on_connection_update_complete_callback_handler_ = nullptr;
-  // Round-robin: Track if dequeue is registered for this connection
+  // Scheduler: Track if dequeue is registered for this connection
   bool is_registered_ = false;
-  // Credits: Track the number of packets which have been sent to the controller
-  uint16_t number_of_sent_packets_ = 0;
+  // Scheduler: Fragments of the packet being sent, in the order the scheduler was given their sizes
+  std::queue<std::unique_ptr<AclPacketBuilder>> fragments_to_send_;
   PacketViewForRecombination recombination_stage_{std::make_shared<std::vector<uint8_t>>()};
   int remaining_sdu_continuation_packet_size_ = 0;
   bool enqueue_registered_ = false;
@@ -157,9 +160,18 @@ struct AclManager::impl {
     hci_layer_ = acl_manager_.GetDependency<HciLayer>();
     handler_ = acl_manager_.GetHandler();
     controller_ = acl_manager_.GetDependency<Controller>();
-    max_acl_packet_credits_ = controller_->GetControllerNumAclPacketBuffers();
-    acl_packet_credits_ = max_acl_packet_credits_;
     acl_buffer_length_ = controller_->GetControllerAclPacketLength();
+    hci_mtu_ = controller_->GetControllerAclPacketLength();
+    // Controllers without LE buffers share the BR/EDR ones with LE links
+    auto le_buffer_size = controller_->GetControllerLeBufferSize();
+    uint16_t le_credits = 0;
+    le_hci_mtu_ = hci_mtu_;
+    if (le_buffer_size.total_num_le_packets_ != 0 && le_buffer_size.le_data_packet_length_ != 0) {
+      le_credits = le_buffer_size.total_num_le_packets_;
+      le_hci_mtu_ = le_buffer_size.le_data_packet_length_;
+    }
+    scheduler_ = std::make_unique<AclScheduler>(controller_->GetControllerNumAclPacketBuffers(), le_credits,
+                                                std::max(hci_mtu_, le_hci_mtu_));
     controller_->RegisterCompletedAclPacketsCallback(
         common::Bind(&impl::incoming_acl_credits, common::Unretained(this)), handler_);
 
@@ -213,7 +225,6 @@ struct AclManager::impl {
     hci_layer_->RegisterEventHandler(EventCode::LINK_SUPERVISION_TIMEOUT_CHANGED,
                                      Bind(&impl::on_link_supervision_timeout_changed, common::Unretained(this)),
                                      handler_);
-    hci_mtu_ = controller_->GetControllerAclPacketLength();
   }
 
   void Stop() {
@@ -225,108 +236,102 @@ struct AclManager::impl {
     hci_layer_->UnregisterEventHandler(EventCode::READ_REMOTE_EXTENDED_FEATURES_COMPLETE);
     hci_queue_end_->UnregisterDequeue();
     unregister_all_connections();
+    if (enqueue_registered_) {
+      enqueue_registered_ = false;
+      hci_queue_end_->UnregisterEnqueue();
+    }
     acl_connections_.clear();
+    scheduler_.reset();
     hci_queue_end_ = nullptr;
     handler_ = nullptr;
     hci_layer_ = nullptr;
   }
 
   void incoming_acl_credits(uint16_t handle, uint16_t credits) {
-    auto connection_pair = acl_connections_.find(handle);
-    if (connection_pair == acl_connections_.end()) {
-      LOG_INFO("Dropping %hx received credits to unknown connection 0x%0hx", credits, handle);
-      return;
-    }
-    if (connection_pair->second.is_disconnected_) {
-      LOG_INFO("Dropping %hx received credits to disconnected connection 0x%0hx", credits, handle);
+    if (!scheduler_->OnPacketsCompleted(handle, credits)) {
+      LOG_INFO("Dropping %hx received credits to unknown or disconnected connection 0x%0hx", credits, handle);
       return;
     }
-    connection_pair->second.number_of_sent_packets_ -= credits;
-    acl_packet_credits_ += credits;
-    ASSERT(acl_packet_credits_ <= max_acl_packet_credits_);
-    start_round_robin();
+    update_hci_enqueue();
   }
 
-  // Round-robin scheduler
-  void start_round_robin() {
-    if (acl_packet_credits_ == 0) {
-      return;
-    }
-    if (!fragments_to_send_.empty()) {
-      send_next_fragment();
+  // Scheduler: each connection hands over one packet at a time; the scheduler picks which connection's fragment
+  // goes to the controller next, and the connection gets its next packet once all fragments of this one are out.
+  void register_dequeue_from_upper(uint16_t handle) {
+    auto& connection = acl_connections_.find(handle)->second;
+    if (connection.is_registered_ || connection.is_disconnected_) {
       return;
     }
-    for (auto connection_pair = acl_connections_.begin(); connection_pair != acl_connections_.end();
-         connection_pair = std::next(connection_pair)) {
-      if (connection_pair->second.is_registered_) {
-        continue;
-      }
-      connection_pair->second.is_registered_ = true;
-      connection_pair->second.queue_->GetDownEnd()->RegisterDequeue(
-          handler_, common::Bind(&impl::handle_dequeue_from_upper, common::Unretained(this), connection_pair));
-    }
+    connection.is_registered_ = true;
+    connection.queue_->GetDownEnd()->RegisterDequeue(
+        handler_, common::Bind(&impl::handle_dequeue_from_upper, common::Unretained(this), handle));
   }
 
-  void handle_dequeue_from_upper(std::map<uint16_t, acl_connection>::iterator connection_pair) {
-    current_connection_pair_ = connection_pair;
-    buffer_packet();
+  void unregister_dequeue_from_upper(acl_connection& connection) {
+    if (connection.is_registered_) {
+      connection.is_registered_ = false;
+      connection.queue_->GetDownEnd()->UnregisterDequeue();
+    }
   }
 
   void unregister_all_connections() {
-    for (auto connection_pair = acl_connections_.begin(); connection_pair != acl_connections_.end();
-         connection_pair = std::next(connection_pair)) {
-      if (connection_pair->second.is_registered_) {
-        connection_pair->second.is_registered_ = false;
-        connection_pair->second.queue_->GetDownEnd()->UnregisterDequeue();
-      }
+    for (auto& connection_pair : acl_connections_) {
+      unregister_dequeue_from_upper(connection_pair.second);
     }
   }
 
-  void buffer_packet() {
-    unregister_all_connections();
+  void handle_dequeue_from_upper(uint16_t handle) {
+    auto& connection = acl_connections_.find(handle)->second;
+    unregister_dequeue_from_upper(connection);
     BroadcastFlag broadcast_flag = BroadcastFlag::POINT_TO_POINT;
-    //   Wrap packet and enqueue it
-    uint16_t handle = current_connection_pair_->first;
+    size_t mtu = connection.transport_ == AclScheduler::Transport::LE ? le_hci_mtu_ : hci_mtu_;
 
-    auto packet = current_connection_pair_->second.queue_->GetDownEnd()->TryDequeue();
+    auto packet = connection.queue_->GetDownEnd()->TryDequeue();
     ASSERT(packet != nullptr);
 
-    if (packet->size() <= hci_mtu_) {
-      fragments_to_send_.push_front(AclPacketBuilder::Create(handle, PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE,
-                                                             broadcast_flag, std::move(packet)));
+    if (packet->size() <= mtu) {
+      scheduler_->Enqueue(handle, packet->size());
+      connection.fragments_to_send_.push(AclPacketBuilder::Create(
+          handle, PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE, broadcast_flag, std::move(packet)));
     } else {
-      auto fragments = AclFragmenter(hci_mtu_, std::move(packet)).GetFragments();
+      auto fragments = AclFragmenter(mtu, std::move(packet)).GetFragments();
       PacketBoundaryFlag packet_boundary_flag = PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE;
       for (size_t i = 0; i < fragments.size(); i++) {
-        fragments_to_send_.push_back(
+        scheduler_->Enqueue(handle, fragments[i]->size());
+        connection.fragments_to_send_.push(
             AclPacketBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(fragments[i])));
         packet_boundary_flag = PacketBoundaryFlag::CONTINUING_FRAGMENT;
       }
     }
-    ASSERT(fragments_to_send_.size() > 0);
-
-    current_connection_pair_->second.number_of_sent_packets_ += fragments_to_send_.size();
-    send_next_fragment();
+    ASSERT(connection.fragments_to_send_.size() > 0);
+    update_hci_enqueue();
   }
 
-  void send_next_fragment() {
-    hci_queue_end_->RegisterEnqueue(handler_,
-                                    common::Bind(&impl::handle_enqueue_next_fragment, common::Unretained(this)));
+  // Keep the HCI enqueue registered exactly while the scheduler has a fragment it can send
+  void update_hci_enqueue() {
+    bool can_dequeue = scheduler_->CanDequeue();
+    if (can_dequeue && !enqueue_registered_) {
+      enqueue_registered_ = true;
+      hci_queue_end_->RegisterEnqueue(handler_,
+                                      common::Bind(&impl::handle_enqueue_next_fragment, common::Unretained(this)));
+    } else if (!can_dequeue && enqueue_registered_) {
+      enqueue_registered_ = false;
+      hci_queue_end_->UnregisterEnqueue();
+    }
   }
 
   std::unique_ptr<AclPacketBuilder> handle_enqueue_next_fragment() {
-    ASSERT(acl_packet_credits_ > 0);
-    if (acl_packet_credits_ == 1 || fragments_to_send_.size() == 1) {
-      hci_queue_end_->UnregisterEnqueue();
-      if (fragments_to_send_.size() == 1) {
-        handler_->Post(common::BindOnce(&impl::start_round_robin, common::Unretained(this)));
-      }
+    auto handle = scheduler_->Dequeue();
+    ASSERT(handle.has_value());
+    auto& connection = acl_connections_.find(*handle)->second;
+    ASSERT(connection.fragments_to_send_.size() > 0);
+    auto fragment = std::move(connection.fragments_to_send_.front());
+    connection.fragments_to_send_.pop();
+    if (connection.fragments_to_send_.empty()) {
+      register_dequeue_from_upper(*handle);
     }
-    ASSERT(fragments_to_send_.size() > 0);
-    auto raw_pointer = fragments_to_send_.front().release();
-    acl_packet_credits_ -= 1;
-    fragments_to_send_.pop_front();
-    return std::unique_ptr<AclPacketBuilder>(raw_pointer);
+    update_hci_enqueue();
+    return fragment;
   }
 
   void dequeue_and_route_acl_packet_to_connection() {
@@ -407,10 +412,9 @@ struct AclManager::impl {
     uint16_t handle = connection_complete.GetConnectionHandle();
     ASSERT(acl_connections_.count(handle) == 0);
     acl_connections_.emplace(std::piecewise_construct, std::forward_as_tuple(handle),
-                             std::forward_as_tuple(address_with_type, handler_));
-    if (acl_connections_.size() == 1 && fragments_to_send_.size() == 0) {
-      start_round_robin();
-    }
+                             std::forward_as_tuple(address_with_type, AclScheduler::Transport::LE, handler_));
+    scheduler_->AddLink(handle, AclScheduler::Transport::LE);
+    register_dequeue_from_upper(handle);
     auto role = connection_complete.GetRole();
     std::unique_ptr<AclConnection> connection_proxy(
         new AclConnection(&acl_manager_, handle, address, peer_address_type, role));
@@ -441,10 +445,9 @@ struct AclManager::impl {
     uint16_t handle = connection_complete.GetConnectionHandle();
     ASSERT(acl_connections_.count(handle) == 0);
     acl_connections_.emplace(std::piecewise_construct, std::forward_as_tuple(handle),
-                             std::forward_as_tuple(reporting_address_with_type, handler_));
-    if (acl_connections_.size() == 1 && fragments_to_send_.size() == 0) {
-      start_round_robin();
-    }
+                             std::forward_as_tuple(reporting_address_with_type, AclScheduler::Transport::LE, handler_));
+    scheduler_->AddLink(handle, AclScheduler::Transport::LE);
+    register_dequeue_from_upper(handle);
     auto role = connection_complete.GetRole();
     std::unique_ptr<AclConnection> connection_proxy(
         new AclConnection(&acl_manager_, handle, address, peer_address_type, role));
@@ -468,10 +471,10 @@ struct AclManager::impl {
     ASSERT(acl_connections_.count(handle) == 0);
     acl_connections_.emplace(
         std::piecewise_construct, std::forward_as_tuple(handle),
-        std::forward_as_tuple(AddressWithType{address, AddressType::PUBLIC_DEVICE_ADDRESS}, handler_));
-    if (acl_connections_.size() == 1 && fragments_to_send_.size() == 0) {
-      start_round_robin();
-    }
+        std::forward_as_tuple(AddressWithType{address, AddressType::PUBLIC_DEVICE_ADDRESS},
+                              AclScheduler::Transport::BR_EDR, handler_));
+    scheduler_->AddLink(handle, AclScheduler::Transport::BR_EDR);
+    register_dequeue_from_upper(handle);
     std::unique_ptr<AclConnection> connection_proxy(new AclConnection(&acl_manager_, handle, address));
     client_handler_->Post(common::BindOnce(&ConnectionCallbacks::OnConnectSuccess,
                                            common::Unretained(client_callbacks_), std::move(connection_proxy)));
@@ -502,9 +505,11 @@ struct AclManager::impl {
       acl_connection.is_disconnected_ = true;
       acl_connection.disconnect_reason_ = disconnection_complete.GetReason();
       acl_connection.call_disconnect_callback();
-      // Reclaim outstanding packets
-      acl_packet_credits_ += acl_connection.number_of_sent_packets_;
-      acl_connection.number_of_sent_packets_ = 0;
+      // Reclaim outstanding packets, and drop the ones not sent yet
+      unregister_dequeue_from_upper(acl_connection);
+      scheduler_->RemoveLink(handle);
+      acl_connection.fragments_to_send_ = {};
+      update_hci_enqueue();
     } else {
       std::string error_code = ErrorCodeText(status);
       LOG_ERROR("Received disconnection complete with error code %s, handle 0x%02hx", error_code.c_str(), handle);
@@ -1458,11 +1463,10 @@ struct AclManager::impl {
   void cleanup(uint16_t handle) {
     ASSERT(acl_connections_.count(handle) == 1);
     auto& acl_connection = acl_connections_.find(handle)->second;
-    if (acl_connection.is_registered_) {
-      acl_connection.is_registered_ = false;
-      acl_connection.queue_->GetDownEnd()->UnregisterDequeue();
-    }
+    unregister_dequeue_from_upper(acl_connection);
+    scheduler_->RemoveLink(handle);
     acl_connections_.erase(handle);
+    update_hci_enqueue();
   }
 
   void on_accept_connection_status(Address address, CommandStatusView status) {
@@ -1852,6 +1856,24 @@ struct AclManager::impl {
     return true;
   }
 
+  bool SetAclPriority(uint16_t handle, AclPriority priority) {
+    auto& connection = check_and_get_connection(handle);
+    if (connection.is_disconnected_) {
+      LOG_INFO("Already disconnected");
+      return false;
+    }
+    handler_->Post(BindOnce(&impl::handle_set_acl_priority, common::Unretained(this), handle, priority));
+    return true;
+  }
+
+  void handle_set_acl_priority(uint16_t handle, AclPriority priority) {
+    if (acl_connections_.count(handle) == 0 || acl_connections_.find(handle)->second.is_disconnected_) {
+      return;
+    }
+    scheduler_->SetPriority(handle, priority);
+    update_hci_enqueue();
+  }
+
   bool LeConnectionUpdate(uint16_t handle, uint16_t conn_interval_min, uint16_t conn_interval_max,
                           uint16_t conn_latency, uint16_t supervision_timeout,
                           common::OnceCallback<void(ErrorCode)> done_callback, os::Handler* handler) {
@@ -1889,12 +1911,10 @@ struct AclManager::impl {
   static constexpr uint16_t kMaximumCeLength = 0x0C00;
 
   Controller* controller_ = nullptr;
-  uint16_t max_acl_packet_credits_ = 0;
-  uint16_t acl_packet_credits_ = 0;
   uint16_t acl_buffer_length_ = 0;
 
-  std::list<std::unique_ptr<AclPacketBuilder>> fragments_to_send_;
-  std::map<uint16_t, acl_connection>::iterator current_connection_pair_;
+  std::unique_ptr<AclScheduler> scheduler_;
+  bool enqueue_registered_ = false;
 
   HciLayer* hci_layer_ = nullptr;
   os::Handler* handler_ = nullptr;
@@ -1913,6 +1933,7 @@ struct AclManager::impl {
   common::Callback<bool(Address, ClassOfDevice)> should_accept_connection_;
   std::queue<std::pair<Address, std::unique_ptr<CreateConnectionBuilder>>> pending_outgoing_connections_;
   size_t hci_mtu_{0};
+  size_t le_hci_mtu_{0};
 };
 
 AclConnection::QueueUpEnd* AclConnection::GetAclQueueEnd() const {
@@ -2056,6 +2077,10 @@ bool AclConnection::ReadClock(WhichClock which_clock) {
   return manager_->pimpl_->ReadClock(handle_, which_clock);
 }
 
+bool AclConnection::SetAclPriority(AclPriority priority) {
+  return manager_->pimpl_->SetAclPriority(handle_, priority);
+}
+
 bool AclConnection::LeConnectionUpdate(uint16_t conn_interval_min, uint16_t conn_interval_max, uint16_t conn_latency,
                                        uint16_t supervision_timeout,
                                        common::OnceCallback<void(ErrorCode)> done_callback, os::Handler* handler) {
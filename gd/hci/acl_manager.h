@@ -20,6 +20,7 @@
 
 #include "common/bidi_queue.h"
 #include "common/callback.h"
+#include "hci/acl_scheduler.h"
 #include "hci/address.h"
 #include "hci/address_with_type.h"
 #include "hci/hci_layer.h"
@@ -147,6 +148,9 @@ class AclConnection {
   virtual bool ReadRemoteSupportedFeatures();
   virtual bool ReadRemoteExtendedFeatures();
 
+  // Links of HIGH priority, such as A2DP media links, send their data before NORMAL ones
+  virtual bool SetAclPriority(AclPriority priority);
+
   // LE ACL Method
   virtual bool LeConnectionUpdate(uint16_t conn_interval_min, uint16_t conn_interval_max, uint16_t conn_latency,
                                   uint16_t supervision_timeout, common::OnceCallback<void(ErrorCode)> done_callback,
@@ -87,12 +87,21 @@ class TestController : public Controller {
     return le_local_supported_features_;
   }
 
+  LeBufferSize GetControllerLeBufferSize() const override {
+    LeBufferSize le_buffer_size;
+    le_buffer_size.le_data_packet_length_ = le_acl_buffer_length_;
+    le_buffer_size.total_num_le_packets_ = total_le_acl_buffers_;
+    return le_buffer_size;
+  }
+
   void CompletePackets(uint16_t handle, uint16_t packets) {
     acl_cb_handler_->Post(common::BindOnce(acl_cb_, handle, packets));
   }
 
   uint16_t acl_buffer_length_ = 1024;
   uint16_t total_acl_buffers_ = 2;
+  uint16_t le_acl_buffer_length_ = 27;
+  uint8_t total_le_acl_buffers_ = 2;
   uint64_t le_local_supported_features_ = 0;
   common::Callback<void(uint16_t /* handle */, uint16_t /* packets */)> acl_cb_;
   os::Handler* acl_cb_handler_ = nullptr;
@@ -767,6 +776,43 @@ TEST_F(AclManagerTest, acl_send_data_credits) {
   connection->Disconnect(DisconnectReason::AUTHENTICATION_FAILURE);
 }
 
+TEST_F(AclManagerWithConnectionTest, acl_send_data_separate_le_credits) {
+  uint16_t le_handle = 0x456;
+  AddressWithType remote_with_type(remote, AddressType::PUBLIC_DEVICE_ADDRESS);
+  test_hci_layer_->SetCommandFuture();
+  acl_manager_->CreateLeConnection(remote_with_type);
+  test_hci_layer_->GetCommandPacket(OpCode::LE_CREATE_CONNECTION);
+  test_hci_layer_->IncomingEvent(LeCreateConnectionStatusBuilder::Create(ErrorCode::SUCCESS, 0x01));
+
+  auto le_connection_future = GetLeConnectionFuture();
+  test_hci_layer_->IncomingLeMetaEvent(LeConnectionCompleteBuilder::Create(
+      ErrorCode::SUCCESS, le_handle, Role::SLAVE, AddressType::PUBLIC_DEVICE_ADDRESS, remote, 0x0100, 0x0010, 0x0011,
+      MasterClockAccuracy::PPM_30));
+  ASSERT_EQ(le_connection_future.wait_for(kTimeout), std::future_status::ready);
+  std::shared_ptr<AclConnection> le_connection = GetLastLeConnection();
+
+  // Use all the LE credits
+  for (uint16_t credits = 0; credits < test_controller_->total_le_acl_buffers_; credits++) {
+    SendAclData(le_handle, le_connection);
+    auto sent_packet = AclPacketView::Create(test_hci_layer_->OutgoingAclData());
+    ASSERT_TRUE(sent_packet.IsValid());
+    EXPECT_EQ(sent_packet.GetHandle(), le_handle);
+  }
+
+  // The LE link waits for credits, the BR/EDR link doesn't
+  SendAclData(le_handle, le_connection);
+  test_hci_layer_->AssertNoOutgoingAclData();
+  SendAclData(handle_, connection_);
+  auto classic_packet = AclPacketView::Create(test_hci_layer_->OutgoingAclData());
+  ASSERT_TRUE(classic_packet.IsValid());
+  EXPECT_EQ(classic_packet.GetHandle(), handle_);
+
+  test_controller_->CompletePackets(le_handle, 1);
+  auto le_packet = AclPacketView::Create(test_hci_layer_->OutgoingAclData());
+  ASSERT_TRUE(le_packet.IsValid());
+  EXPECT_EQ(le_packet.GetHandle(), le_handle);
+}
+
 TEST_F(AclManagerWithConnectionTest, send_switch_role) {
   test_hci_layer_->SetCommandFuture();
   acl_manager_->SwitchRole(connection_->GetAddress(), Role::SLAVE);
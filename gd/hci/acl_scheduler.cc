@@ -0,0 +1,156 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_scheduler.h"
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hci {
+
+AclScheduler::AclScheduler(uint16_t br_edr_credits, uint16_t le_credits, size_t quantum)
+    : br_edr_pool_{br_edr_credits, br_edr_credits},
+      le_pool_{le_credits, le_credits},
+      le_link_pool_(le_credits == 0 ? &br_edr_pool_ : &le_pool_),
+      quantum_(quantum) {
+  ASSERT_LOG(br_edr_credits > 0 || le_credits > 0, "Controller has no ACL buffers");
+  ASSERT(quantum > 0);
+}
+
+void AclScheduler::AddLink(uint16_t handle, Transport transport) {
+  ASSERT(links_.count(handle) == 0);
+  Link& link = links_[handle];
+  link.pool = transport == Transport::LE ? le_link_pool_ : &br_edr_pool_;
+}
+
+void AclScheduler::RemoveLink(uint16_t handle) {
+  auto it = links_.find(handle);
+  if (it == links_.end()) {
+    return;
+  }
+  Link& link = it->second;
+  if (!link.fragment_sizes.empty()) {
+    Deactivate(handle, link);
+  }
+  link.pool->credits += link.sent;
+  ASSERT(link.pool->credits <= link.pool->max_credits);
+  links_.erase(it);
+}
+
+void AclScheduler::SetPriority(uint16_t handle, AclPriority priority) {
+  Link& link = links_.at(handle);
+  if (link.priority == priority) {
+    return;
+  }
+  if (!link.fragment_sizes.empty()) {
+    active_links(link.priority).remove(handle);
+    active_links(priority).push_back(handle);
+    link.deficit = 0;
+    link.has_turn = false;
+  }
+  link.priority = priority;
+}
+
+void AclScheduler::Enqueue(uint16_t handle, size_t fragment_size) {
+  ASSERT_LOG(fragment_size <= quantum_, "Fragment of %zu bytes is larger than the quantum", fragment_size);
+  Link& link = links_.at(handle);
+  if (link.fragment_sizes.empty()) {
+    active_links(link.priority).push_back(handle);
+  }
+  link.fragment_sizes.push_back(fragment_size);
+}
+
+std::optional<uint16_t> AclScheduler::Dequeue() {
+  for (auto& active : active_links_) {
+    // A link is visited at most twice: once to end its turn, once to start the next one
+    for (size_t visits = 2 * active.size(); visits > 0; visits--) {
+      uint16_t handle = active.front();
+      Link& link = links_.at(handle);
+      if (link.pool->credits == 0) {
+        active.splice(active.end(), active, active.begin());
+        continue;
+      }
+      size_t fragment_size = link.fragment_sizes.front();
+      if (link.deficit < fragment_size) {
+        if (link.has_turn) {
+          link.has_turn = false;
+          active.splice(active.end(), active, active.begin());
+          continue;
+        }
+        link.deficit += quantum_;
+      }
+      link.has_turn = true;
+      link.deficit -= fragment_size;
+      link.fragment_sizes.pop_front();
+      link.pool->credits--;
+      link.sent++;
+      if (link.fragment_sizes.empty()) {
+        Deactivate(handle, link);
+      }
+      return handle;
+    }
+  }
+  return std::nullopt;
+}
+
+bool AclScheduler::CanDequeue() const {
+  for (const auto& active : active_links_) {
+    for (uint16_t handle : active) {
+      if (links_.at(handle).pool->credits > 0) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool AclScheduler::OnPacketsCompleted(uint16_t handle, uint16_t packets) {
+  auto it = links_.find(handle);
+  if (it == links_.end()) {
+    return false;
+  }
+  Link& link = it->second;
+  if (packets > link.sent) {
+    LOG_WARN("Controller completed %hu packets of 0x%04hx, only %hu were sent", packets, handle, link.sent);
+    packets = link.sent;
+  }
+  link.sent -= packets;
+  link.pool->credits += packets;
+  ASSERT(link.pool->credits <= link.pool->max_credits);
+  return true;
+}
+
+size_t AclScheduler::GetQueuedFragments(uint16_t handle) const {
+  auto it = links_.find(handle);
+  if (it == links_.end()) {
+    return 0;
+  }
+  return it->second.fragment_sizes.size();
+}
+
+uint16_t AclScheduler::GetCredits(Transport transport) const {
+  return transport == Transport::LE ? le_link_pool_->credits : br_edr_pool_.credits;
+}
+
+void AclScheduler::Deactivate(uint16_t handle, Link& link) {
+  active_links(link.priority).remove(handle);
+  link.fragment_sizes.clear();
+  link.deficit = 0;
+  link.has_turn = false;
+}
+
+}  // namespace hci
+}  // namespace bluetooth
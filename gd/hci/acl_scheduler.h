@@ -0,0 +1,113 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <map>
+#include <optional>
+
+namespace bluetooth {
+namespace hci {
+
+enum class AclPriority {
+  // e.g. A2DP media, served before any NORMAL link
+  HIGH,
+  NORMAL,
+};
+
+// Decides which connection sends the next ACL fragment to the controller.
+//
+// BR/EDR and LE links draw on separate pools of controller buffers, sized by Read Buffer Size and LE Read Buffer
+// Size. A controller reporting no LE buffers shares its BR/EDR buffers with LE links; an LE-only controller reports
+// no BR/EDR buffers.
+//
+// Links with fragments queued are served by priority class. Within a class, they share the controller in deficit
+// round robin at fragment granularity: each turn gives a link |quantum| bytes to send, so a long SDU doesn't hold
+// back the other links until all of its fragments are out, and links sending small packets get their fair share.
+class AclScheduler {
+ public:
+  enum class Transport {
+    BR_EDR,
+    LE,
+  };
+
+  // |quantum| must be at least the size of the largest fragment
+  AclScheduler(uint16_t br_edr_credits, uint16_t le_credits, size_t quantum);
+  AclScheduler(const AclScheduler&) = delete;
+  AclScheduler& operator=(const AclScheduler&) = delete;
+
+  void AddLink(uint16_t handle, Transport transport);
+
+  // Drop the fragments still queued for |handle| and reclaim the credits of those sent
+  void RemoveLink(uint16_t handle);
+
+  void SetPriority(uint16_t handle, AclPriority priority);
+
+  void Enqueue(uint16_t handle, size_t fragment_size);
+
+  // Returns the link whose next queued fragment is to be sent now, and takes a credit for it
+  std::optional<uint16_t> Dequeue();
+
+  // Whether Dequeue() would return a link
+  bool CanDequeue() const;
+
+  // Return the credits of |packets| completed by the controller. Returns false for unknown links.
+  bool OnPacketsCompleted(uint16_t handle, uint16_t packets);
+
+  size_t GetQueuedFragments(uint16_t handle) const;
+
+  uint16_t GetCredits(Transport transport) const;
+
+ private:
+  struct CreditPool {
+    uint16_t max_credits;
+    uint16_t credits;
+  };
+
+  struct Link {
+    CreditPool* pool;
+    AclPriority priority = AclPriority::NORMAL;
+    std::deque<size_t> fragment_sizes;
+    // Fragments sent, which the controller hasn't completed yet
+    uint16_t sent = 0;
+    size_t deficit = 0;
+    bool has_turn = false;
+  };
+
+  static constexpr size_t kNumPriorities = 2;
+
+  std::list<uint16_t>& active_links(AclPriority priority) {
+    return active_links_[static_cast<size_t>(priority)];
+  }
+
+  void Deactivate(uint16_t handle, Link& link);
+
+  CreditPool br_edr_pool_;
+  CreditPool le_pool_;
+  CreditPool* le_link_pool_;
+  const size_t quantum_;
+  std::map<uint16_t, Link> links_;
+  // Links with fragments queued, by priority; the front one has the turn
+  std::array<std::list<uint16_t>, kNumPriorities> active_links_;
+};
+
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_scheduler.h"
+
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace hci {
+namespace {
+
+constexpr size_t kMtu = 1021;
+constexpr uint16_t kHandle1 = 0x0001;
+constexpr uint16_t kHandle2 = 0x0002;
+constexpr uint16_t kHandle3 = 0x0003;
+
+std::vector<uint16_t> DequeueAll(AclScheduler* scheduler) {
+  std::vector<uint16_t> handles;
+  while (auto handle = scheduler->Dequeue()) {
+    handles.push_back(*handle);
+  }
+  return handles;
+}
+
+TEST(AclSchedulerTest, interleave_fragments_of_long_sdus) {
+  AclScheduler scheduler(100, 0, kMtu);
+  scheduler.AddLink(kHandle1, AclScheduler::Transport::BR_EDR);
+  scheduler.AddLink(kHandle2, AclScheduler::Transport::BR_EDR);
+  for (int i = 0; i < 3; i++) {
+    scheduler.Enqueue(kHandle1, kMtu);
+    scheduler.Enqueue(kHandle2, kMtu);
+  }
+
+  EXPECT_EQ(std::vector<uint16_t>({kHandle1, kHandle2, kHandle1, kHandle2, kHandle1, kHandle2}),
+            DequeueAll(&scheduler));
+  EXPECT_EQ(94, scheduler.GetCredits(AclScheduler::Transport::BR_EDR));
+}
+
+TEST(AclSchedulerTest, deficit_round_robin_shares_bytes) {
+  AclScheduler scheduler(100, 0, kMtu);
+  scheduler.AddLink(kHandle1, AclScheduler::Transport::BR_EDR);
+  scheduler.AddLink(kHandle2, AclScheduler::Transport::BR_EDR);
+  // Link 1 sends full fragments, link 2 small ones: a turn of link 2 sends several
+  for (int i = 0; i < 4; i++) {
+    scheduler.Enqueue(kHandle1, kMtu);
+  }
+  for (int i = 0; i < 8; i++) {
+    scheduler.Enqueue(kHandle2, 250);
+  }
+
+  std::map<uint16_t, size_t> bytes;
+  for (int i = 0; i < 6; i++) {
+    auto handle = scheduler.Dequeue();
+    ASSERT_TRUE(handle);
+    bytes[*handle] += *handle == kHandle1 ? kMtu : 250;
+  }
+  EXPECT_EQ(2 * kMtu, bytes[kHandle1]);
+  EXPECT_EQ(4 * 250u, bytes[kHandle2]);
+}
+
+TEST(AclSchedulerTest, separate_credit_pools) {
+  AclScheduler scheduler(2, 1, kMtu);
+  scheduler.AddLink(kHandle1, AclScheduler::Transport::BR_EDR);
+  scheduler.AddLink(kHandle2, AclScheduler::Transport::LE);
+  for (int i = 0; i < 3; i++) {
+    scheduler.Enqueue(kHandle1, kMtu);
+    scheduler.Enqueue(kHandle2, 27);
+  }
+
+  EXPECT_EQ(std::vector<uint16_t>({kHandle1, kHandle2, kHandle1}), DequeueAll(&scheduler));
+  EXPECT_FALSE(scheduler.CanDequeue());
+
+  // LE credits coming back only unblock the LE link
+  EXPECT_TRUE(scheduler.OnPacketsCompleted(kHandle2, 1));
+  EXPECT_EQ(std::vector<uint16_t>({kHandle2}), DequeueAll(&scheduler));
+  EXPECT_TRUE(scheduler.OnPacketsCompleted(kHandle1, 2));
+  EXPECT_EQ(std::vector<uint16_t>({kHandle1}), DequeueAll(&scheduler));
+}
+
+TEST(AclSchedulerTest, le_shares_br_edr_pool_without_le_buffers) {
+  AclScheduler scheduler(2, 0, kMtu);
+  scheduler.AddLink(kHandle1, AclScheduler::Transport::BR_EDR);
+  scheduler.AddLink(kHandle2, AclScheduler::Transport::LE);
+  scheduler.Enqueue(kHandle2, 27);
+  scheduler.Enqueue(kHandle2, 27);
+  scheduler.Enqueue(kHandle1, kMtu);
+
+  EXPECT_EQ(2u, DequeueAll(&scheduler).size());
+  EXPECT_EQ(0, scheduler.GetCredits(AclScheduler::Transport::BR_EDR));
+  EXPECT_EQ(0, scheduler.GetCredits(AclScheduler::Transport::LE));
+}
+
+TEST(AclSchedulerTest, le_only_controller) {
+  AclScheduler scheduler(0, 2, kMtu);
+  scheduler.AddLink(kHandle1, AclScheduler::Transport::LE);
+  for (int i = 0; i < 3; i++) {
+    scheduler.Enqueue(kHandle1, 27);
+  }
+
+  EXPECT_EQ(std::vector<uint16_t>({kHandle1, kHandle1}), DequeueAll(&scheduler));
+  EXPECT_EQ(0, scheduler.GetCredits(AclScheduler::Transport::BR_EDR));
+  EXPECT_TRUE(scheduler.OnPacketsCompleted(kHandle1, 1));
+  EXPECT_EQ(std::vector<uint16_t>({kHandle1}), DequeueAll(&scheduler));
+}
+
+TEST(AclSchedulerTest, high_priority_link_not_starved_by_bulk_traffic) {
+  AclScheduler scheduler(4, 0, kMtu);
+  scheduler.AddLink(kHandle1, AclScheduler::Transport::LE);
+  scheduler.AddLink(kHandle2, AclScheduler::Transport::LE);
+  scheduler.AddLink(kHandle3, AclScheduler::Transport::BR_EDR);
+  scheduler.SetPriority(kHandle3, AclPriority::HIGH);
+  for (int i = 0; i < 20; i++) {
+    scheduler.Enqueue(kHandle1, 251);
+    scheduler.Enqueue(kHandle2, 251);
+  }
+
+  // Media packets arrive while the bulk links keep the controller busy
+  size_t media_sent = 0;
+  for (int round = 0; round < 10; round++) {
+    scheduler.Enqueue(kHandle3, kMtu);
+    auto handles = DequeueAll(&scheduler);
+    ASSERT_FALSE(handles.empty());
+    EXPECT_EQ(kHandle3, handles.front());
+    for (uint16_t handle : handles) {
+      scheduler.OnPacketsCompleted(handle, 1);
+      if (handle == kHandle3) media_sent++;
+    }
+  }
+  EXPECT_EQ(10u, media_sent);
+}
+
+TEST(AclSchedulerTest, remove_link_reclaims_credits) {
+  AclScheduler scheduler(4, 0, kMtu);
+  scheduler.AddLink(kHandle1, AclScheduler::Transport::BR_EDR);
+  scheduler.AddLink(kHandle2, AclScheduler::Transport::BR_EDR);
+  for (int i = 0; i < 3; i++) {
+    scheduler.Enqueue(kHandle1, kMtu);
+  }
+  scheduler.Dequeue();
+  scheduler.Dequeue();
+  EXPECT_EQ(2, scheduler.GetCredits(AclScheduler::Transport::BR_EDR));
+
+  scheduler.RemoveLink(kHandle1);
+  EXPECT_EQ(4, scheduler.GetCredits(AclScheduler::Transport::BR_EDR));
+  EXPECT_FALSE(scheduler.CanDequeue());
+  EXPECT_FALSE(scheduler.OnPacketsCompleted(kHandle1, 2));
+  EXPECT_EQ(0u, scheduler.GetQueuedFragments(kHandle1));
+
+  scheduler.Enqueue(kHandle2, kMtu);
+  EXPECT_EQ(std::vector<uint16_t>({kHandle2}), DequeueAll(&scheduler));
+}
+
+TEST(AclSchedulerTest, completed_packets_clamped_to_sent) {
+  AclScheduler scheduler(4, 0, kMtu);
+  scheduler.AddLink(kHandle1, AclScheduler::Transport::BR_EDR);
+  scheduler.Enqueue(kHandle1, kMtu);
+  scheduler.Dequeue();
+
+  EXPECT_TRUE(scheduler.OnPacketsCompleted(kHandle1, 3));
+  EXPECT_EQ(4, scheduler.GetCredits(AclScheduler::Transport::BR_EDR));
+}
+
+}  // namespace
+}  // namespace hci
+}  // namespace bluetooth
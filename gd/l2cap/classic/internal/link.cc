@@ -98,6 +98,10 @@ void Link::ReadClockOffset() {
   acl_connection_->ReadClockOffset();
 }
 
+void Link::SetAclPriority(hci::AclPriority priority) {
+  acl_connection_->SetAclPriority(priority);
+}
+
 std::shared_ptr<FixedChannelImpl> Link::AllocateFixedChannel(Cid cid, SecurityPolicy security_policy) {
   auto channel = fixed_channel_allocator_.AllocateChannel(cid, security_policy);
   data_pipeline_manager_.AttachChannel(cid, channel, l2cap::internal::DataPipelineManager::ChannelMode::BASIC);
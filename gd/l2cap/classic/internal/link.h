@@ -84,6 +84,8 @@ class Link : public l2cap::internal::ILink, public hci::ConnectionManagementCall
 
   virtual void ReadClockOffset();
 
+  void SetAclPriority(hci::AclPriority priority) override;
+
   // FixedChannel methods
 
   std::shared_ptr<FixedChannelImpl> AllocateFixedChannel(Cid cid, SecurityPolicy security_policy);
@@ -35,6 +35,10 @@ void DynamicChannel::Close() {
   l2cap_handler_->Post(common::BindOnce(&l2cap::internal::DynamicChannelImpl::Close, impl_));
 }
 
+void DynamicChannel::SetAclPriority(hci::AclPriority priority) {
+  l2cap_handler_->Post(common::BindOnce(&l2cap::internal::DynamicChannelImpl::SetAclPriority, impl_, priority));
+}
+
 common::BidiQueueEnd<packet::BasePacketBuilder, packet::PacketView<packet::kLittleEndian>>*
 DynamicChannel::GetQueueUpEnd() const {
   return impl_->GetQueueUpEnd();
@@ -61,6 +61,11 @@ class DynamicChannel {
    */
   void Close();
 
+  /**
+   * Set the transmission priority of the ACL link carrying this channel, and so of every other channel on that link.
+   */
+  void SetAclPriority(hci::AclPriority priority);
+
   /**
    * This method will retrieve the data channel queue to send and receive packets.
    *
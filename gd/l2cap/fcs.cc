@@ -18,7 +18,7 @@
 
 namespace {
 // Table for optimizing the CRC calculation, which is a bitwise operation.
-static const uint16_t crctab[256] = {
+constexpr uint16_t crctab[256] = {
     0x0000, 0xc0c1, 0xc181, 0x0140, 0xc301, 0x03c0, 0x0280, 0xc241, 0xc601, 0x06c0, 0x0780, 0xc741, 0x0500, 0xc5c1,
     0xc481, 0x0440, 0xcc01, 0x0cc0, 0x0d80, 0xcd41, 0x0f00, 0xcfc1, 0xce81, 0x0e40, 0x0a00, 0xcac1, 0xcb81, 0x0b40,
     0xc901, 0x09c0, 0x0880, 0xc841, 0xd801, 0x18c0, 0x1980, 0xd941, 0x1b00, 0xdbc1, 0xda81, 0x1a40, 0x1e00, 0xdec1,
@@ -39,6 +39,27 @@ static const uint16_t crctab[256] = {
     0x4c80, 0x8c41, 0x4400, 0x84c1, 0x8581, 0x4540, 0x8701, 0x47c0, 0x4680, 0x8641, 0x8201, 0x42c0, 0x4380, 0x8341,
     0x4100, 0x81c1, 0x8081, 0x4040,
 };
+
+// Tables for processing 8 bytes at once (slice-by-8): table[k][byte] is the CRC of |byte| followed by k zero bytes.
+struct SliceTables {
+  uint16_t table[8][256];
+};
+
+constexpr SliceTables MakeSliceTables() {
+  SliceTables tables{};
+  for (int i = 0; i < 256; i++) {
+    tables.table[0][i] = crctab[i];
+  }
+  for (int k = 1; k < 8; k++) {
+    for (int i = 0; i < 256; i++) {
+      uint16_t previous = tables.table[k - 1][i];
+      tables.table[k][i] = (previous >> 8) ^ crctab[previous & 0x00ff];
+    }
+  }
+  return tables;
+}
+
+constexpr SliceTables kSliceTables = MakeSliceTables();
 }  // namespace
 
 namespace bluetooth {
@@ -52,6 +73,23 @@ void Fcs::AddByte(uint8_t byte) {
   crc = ((crc >> 8) & 0x00ff) ^ crctab[(crc & 0x00ff) ^ byte];
 }
 
+void Fcs::AddBytes(const uint8_t* data, size_t length) {
+  const auto& t = kSliceTables.table;
+  uint16_t value = crc;
+  while (length >= 8) {
+    uint8_t b0 = data[0] ^ static_cast<uint8_t>(value);
+    uint8_t b1 = data[1] ^ static_cast<uint8_t>(value >> 8);
+    value = t[7][b0] ^ t[6][b1] ^ t[5][data[2]] ^ t[4][data[3]] ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^
+            t[0][data[7]];
+    data += 8;
+    length -= 8;
+  }
+  while (length-- > 0) {
+    value = ((value >> 8) & 0x00ff) ^ crctab[(value & 0x00ff) ^ *data++];
+  }
+  crc = value;
+}
+
 uint16_t Fcs::GetChecksum() const {
   return crc;
 }
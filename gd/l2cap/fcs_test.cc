@@ -0,0 +1,59 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "l2cap/fcs.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+namespace bluetooth {
+namespace l2cap {
+
+TEST(L2capFcsTest, known_value) {
+  // CRC-16/ARC of "123456789"
+  const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  Fcs fcs;
+  fcs.Initialize();
+  fcs.AddBytes(check, sizeof(check));
+  ASSERT_EQ(0xbb3d, fcs.GetChecksum());
+}
+
+TEST(L2capFcsTest, add_bytes_matches_add_byte) {
+  std::vector<uint8_t> data(1031);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>(i * 31 + (i >> 3));
+  }
+
+  for (size_t length = 0; length < data.size(); length += 13) {
+    Fcs expected;
+    expected.Initialize();
+    for (size_t i = 0; i < length; i++) {
+      expected.AddByte(data[i]);
+    }
+
+    // Split the bytes in two calls, so that the second one is not aligned
+    Fcs fcs;
+    fcs.Initialize();
+    size_t split = length / 3;
+    fcs.AddBytes(data.data(), split);
+    fcs.AddBytes(data.data() + split, length - split);
+    ASSERT_EQ(expected.GetChecksum(), fcs.GetChecksum()) << "length " << length;
+  }
+}
+
+}  // namespace l2cap
+}  // namespace bluetooth
@@ -60,6 +60,10 @@ void DynamicChannelImpl::Close() {
   link_->SendDisconnectionRequest(cid_, remote_cid_);
 }
 
+void DynamicChannelImpl::SetAclPriority(hci::AclPriority priority) {
+  link_->SetAclPriority(priority);
+}
+
 void DynamicChannelImpl::OnClosed(hci::ErrorCode status) {
   ASSERT_LOG(!closed_, "Device %s Cid 0x%x closed twice, old status 0x%x, new status 0x%x", device_.ToString().c_str(),
              cid_, static_cast<int>(close_reason_), static_cast<int>(status));
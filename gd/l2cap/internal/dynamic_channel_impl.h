@@ -43,6 +43,7 @@ class DynamicChannelImpl : public l2cap::internal::ChannelImpl {
   virtual void RegisterOnCloseCallback(os::Handler* user_handler, DynamicChannel::OnCloseCallback on_close_callback);
 
   virtual void Close();
+  virtual void SetAclPriority(hci::AclPriority priority);
   virtual void OnClosed(hci::ErrorCode status);
   virtual std::string ToString();
 
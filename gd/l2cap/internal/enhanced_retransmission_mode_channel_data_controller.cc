@@ -16,7 +16,7 @@
 
 #include "l2cap/internal/enhanced_retransmission_mode_channel_data_controller.h"
 
-#include <map>
+#include <array>
 #include <queue>
 #include <vector>
 
@@ -76,13 +76,20 @@ struct ErtmController::impl {
   bool remote_busy_ = false;
   bool local_busy_ = false;
   int unacked_frames_ = 0;
-  // TODO: Instead of having a map, we may consider about a better data structure
-  // Map from TxSeq to (SAR, SDU size for START packet, information payload)
-  std::map<uint8_t, std::tuple<SegmentationAndReassembly, uint16_t, std::shared_ptr<packet::RawBuilder>>> unacked_list_;
+  // An I-frame sent and not yet acknowledged. The payload bytes are segmented from the SDU once and shared by every
+  // (re)transmission of the frame.
+  struct UnackedFrame {
+    bool in_use = false;
+    SegmentationAndReassembly sar = SegmentationAndReassembly::UNSEGMENTED;
+    uint16_t sdu_size = 0;  // Only applies to START packet
+    int retry_count = 0;
+    std::shared_ptr<packet::RawBuilder> payload;
+  };
+  // Ring indexed by TxSeq. The unacked frames are the contiguous slots from ExpectedAckSeq up to NextTxSeq.
+  std::array<UnackedFrame, kMaxTxWin> unacked_list_;
   // Stores (SAR, SDU size for START packet, information payload)
   std::queue<std::tuple<SegmentationAndReassembly, uint16_t, std::unique_ptr<packet::RawBuilder>>> pending_frames_;
   int retry_count_ = 0;
-  std::map<uint8_t /* tx_seq, */, int /* count */> retry_i_frames_;
   bool rnr_sent_ = false;
   bool rej_actioned_ = false;
   bool srej_actioned_ = false;
@@ -479,7 +486,7 @@ struct ErtmController::impl {
   }
 
   bool retry_i_frames_less_than_max_transmit(uint8_t req_seq) {
-    return retry_i_frames_[req_seq] < controller_->local_max_transmit_;
+    return unacked_list_[req_seq % kMaxTxWin].retry_count < controller_->local_max_transmit_;
   }
 
   bool retry_count_less_than_max_transmit() {
@@ -490,12 +497,17 @@ struct ErtmController::impl {
     return tx_seq == expected_tx_seq_;
   }
 
+  // Distance of a sequence number from ExpectedAckSeq, modulo the sequence space
+  uint8_t ack_seq_offset(uint8_t seq) {
+    return (seq - expected_ack_seq_ + kMaxTxWin) % kMaxTxWin;
+  }
+
   bool with_valid_req_seq(uint8_t req_seq) {
-    return expected_ack_seq_ <= req_seq && req_seq <= next_tx_seq_;
+    return ack_seq_offset(req_seq) <= ack_seq_offset(next_tx_seq_);
   }
 
   bool with_valid_req_seq_retrans(uint8_t req_seq) {
-    return expected_ack_seq_ <= req_seq && req_seq <= next_tx_seq_;
+    return ack_seq_offset(req_seq) <= ack_seq_offset(next_tx_seq_);
   }
 
   bool with_valid_f_bit(Final f) {
@@ -516,11 +528,11 @@ struct ErtmController::impl {
   }
 
   bool with_invalid_req_seq(uint8_t req_seq) {
-    return req_seq < expected_ack_seq_ || req_seq > next_tx_seq_;
+    return !with_valid_req_seq(req_seq);
   }
 
   bool with_invalid_req_seq_retrans(uint8_t req_seq) {
-    return req_seq < expected_ack_seq_ || req_seq >= next_tx_seq_;
+    return ack_seq_offset(req_seq) >= ack_seq_offset(next_tx_seq_);
   }
 
   bool not_with_expected_tx_seq(uint8_t tx_seq) {
@@ -528,11 +540,11 @@ struct ErtmController::impl {
   }
 
   bool with_valid_req_seq_rr(uint8_t req_seq) {
-    return expected_ack_seq_ < req_seq && req_seq <= next_tx_seq_;
+    return with_valid_req_seq(req_seq) && ack_seq_offset(req_seq) > 0;
   }
 
   bool with_invalid_req_seq_rr(uint8_t req_seq) {
-    return req_seq <= expected_ack_seq_ || req_seq > next_tx_seq_;
+    return !with_valid_req_seq_rr(req_seq);
   }
 
   bool with_expected_tx_seq_srej() {
@@ -562,8 +574,12 @@ struct ErtmController::impl {
 
   // Actions (@see 8.6.5.6)
 
-  void _send_i_frame(SegmentationAndReassembly sar, std::unique_ptr<CopyablePacketBuilder> segment, uint8_t req_seq,
-                     uint8_t tx_seq, uint16_t sdu_size = 0, Final f = Final::NOT_SET) {
+  // The control field (ReqSeq, F) differs between transmissions of the same frame, so only the payload is reused
+  void _send_i_frame(uint8_t tx_seq, uint8_t req_seq, Final f = Final::NOT_SET) {
+    const UnackedFrame& frame = unacked_list_[tx_seq];
+    SegmentationAndReassembly sar = frame.sar;
+    uint16_t sdu_size = frame.sdu_size;
+    auto segment = std::make_unique<CopyablePacketBuilder>(frame.payload);
     std::unique_ptr<packet::BasePacketBuilder> builder;
     if (sar == SegmentationAndReassembly::START) {
       if (controller_->fcs_enabled_) {
@@ -587,16 +603,16 @@ struct ErtmController::impl {
 
   void send_data(SegmentationAndReassembly sar, uint16_t sdu_size, std::unique_ptr<packet::RawBuilder> segment,
                  Final f = Final::NOT_SET) {
-    std::shared_ptr<packet::RawBuilder> shared_segment(segment.release());
-    unacked_list_.emplace(std::piecewise_construct, std::forward_as_tuple(next_tx_seq_),
-                          std::forward_as_tuple(sar, sdu_size, shared_segment));
-
-    std::unique_ptr<CopyablePacketBuilder> copyable_packet_builder =
-        std::make_unique<CopyablePacketBuilder>(std::get<2>(unacked_list_.find(next_tx_seq_)->second));
-    _send_i_frame(sar, std::move(copyable_packet_builder), buffer_seq_, next_tx_seq_, sdu_size, f);
+    UnackedFrame& frame = unacked_list_[next_tx_seq_];
+    frame.in_use = true;
+    frame.sar = sar;
+    frame.sdu_size = sdu_size;
+    frame.retry_count = 1;
+    frame.payload = std::move(segment);
+
+    _send_i_frame(next_tx_seq_, buffer_seq_, f);
     unacked_frames_++;
     frames_sent_++;
-    retry_i_frames_[next_tx_seq_] = 1;
     next_tx_seq_ = (next_tx_seq_ + 1) % kMaxTxWin;
     start_retrans_timer();
   }
@@ -606,11 +622,11 @@ struct ErtmController::impl {
   }
 
   void process_req_seq(uint8_t req_seq) {
-    for (int i = expected_ack_seq_; i < req_seq; i++) {
-      unacked_list_.erase(i);
-      retry_i_frames_[i] = 0;
+    for (uint8_t i = expected_ack_seq_; i != req_seq; i = (i + 1) % kMaxTxWin) {
+      unacked_list_[i] = UnackedFrame();
     }
-    unacked_frames_ -= ((req_seq - expected_ack_seq_) + kMaxTxWin) % kMaxTxWin;
+    unacked_frames_ -= ack_seq_offset(req_seq);
+    expected_ack_seq_ = req_seq;
     if (unacked_frames_ == 0) {
       stop_retrans_timer();
     }
@@ -737,19 +753,19 @@ struct ErtmController::impl {
   void retransmit_i_frames(uint8_t req_seq, Poll p = Poll::NOT_SET) {
     uint8_t i = req_seq;
     Final f = (p == Poll::NOT_SET ? Final::NOT_SET : Final::POLL_RESPONSE);
-    while (unacked_list_.find(i) != unacked_list_.end()) {
-      if (retry_i_frames_[i] == controller_->local_max_transmit_) {
+    while (unacked_list_[i].in_use) {
+      if (unacked_list_[i].retry_count == controller_->local_max_transmit_) {
         CloseChannel();
         return;
       }
-      std::unique_ptr<CopyablePacketBuilder> copyable_packet_builder =
-          std::make_unique<CopyablePacketBuilder>(std::get<2>(unacked_list_.find(i)->second));
-      _send_i_frame(std::get<0>(unacked_list_.find(i)->second), std::move(copyable_packet_builder), buffer_seq_, i,
-                    std::get<1>(unacked_list_.find(i)->second), f);
-      retry_i_frames_[i]++;
+      _send_i_frame(i, buffer_seq_, f);
+      unacked_list_[i].retry_count++;
       frames_sent_++;
       f = Final::NOT_SET;
-      i++;
+      i = (i + 1) % kMaxTxWin;
+      if (i == req_seq) {
+        break;
+      }
     }
     if (i != req_seq) {
       start_retrans_timer();
@@ -758,15 +774,12 @@ struct ErtmController::impl {
 
   void retransmit_requested_i_frame(uint8_t req_seq, Poll p) {
     Final f = p == Poll::POLL ? Final::POLL_RESPONSE : Final::NOT_SET;
-    if (unacked_list_.find(req_seq) == unacked_list_.end()) {
+    if (req_seq >= kMaxTxWin || !unacked_list_[req_seq].in_use) {
       LOG_ERROR("Received invalid SREJ");
       return;
     }
-    std::unique_ptr<CopyablePacketBuilder> copyable_packet_builder =
-        std::make_unique<CopyablePacketBuilder>(std::get<2>(unacked_list_.find(req_seq)->second));
-    _send_i_frame(std::get<0>(unacked_list_.find(req_seq)->second), std::move(copyable_packet_builder), buffer_seq_,
-                  req_seq, std::get<1>(unacked_list_.find(req_seq)->second), f);
-    retry_i_frames_[req_seq]++;
+    _send_i_frame(req_seq, buffer_seq_, f);
+    unacked_list_[req_seq].retry_count++;
     start_retrans_timer();
   }
 
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "l2cap/internal/enhanced_retransmission_mode_channel_data_controller.h"
+#include "l2cap/internal/ilink.h"
+#include "l2cap/internal/scheduler.h"
+#include "l2cap/l2cap_packets.h"
+#include "os/handler.h"
+#include "os/thread.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+
+namespace {
+constexpr Cid kCid = 0x41;
+constexpr size_t kSduSize = 1000;
+// One in this many I-frames is lost on the air and recovered with REJ
+constexpr int kLossInterval = 8;
+
+class FakeScheduler : public Scheduler {};
+
+class FakeLink : public ILink {
+ public:
+  void SendDisconnectionRequest(Cid local_cid, Cid remote_cid) override {
+    disconnected_ = true;
+  }
+  hci::AddressWithType GetDevice() override {
+    return hci::AddressWithType();
+  }
+  void SetAclPriority(hci::AclPriority priority) override {}
+  void SendLeCredit(Cid local_cid, uint16_t credit) override {}
+
+  bool disconnected_ = false;
+};
+
+std::unique_ptr<packet::BasePacketBuilder> CreateSdu() {
+  auto raw_builder = std::make_unique<packet::RawBuilder>();
+  raw_builder->AddOctets(std::vector<uint8_t>(kSduSize, 0xa5));
+  return raw_builder;
+}
+
+// Serializes the PDU as the sender would when handing it to the link
+size_t SendPdu(std::unique_ptr<packet::BasePacketBuilder> pdu, std::vector<uint8_t>* buffer) {
+  buffer->clear();
+  BitInserter it(*buffer);
+  pdu->Serialize(it);
+  return buffer->size();
+}
+
+packet::PacketView<kLittleEndian> CreateSFrame(SupervisoryFunction s, uint8_t req_seq) {
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  BitInserter it(*bytes);
+  EnhancedSupervisoryFrameBuilder::Create(kCid, s, Poll::NOT_SET, Final::NOT_SET, req_seq)->Serialize(it);
+  return packet::PacketView<kLittleEndian>(bytes);
+}
+}  // namespace
+
+// A full transmit window per iteration on a lossy link: every kLossInterval-th frame is rejected by the peer, the
+// remainder of the window is retransmitted, and the whole window is then acknowledged
+class BM_ErtmTransmitWindow : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    thread_ = new os::Thread("ertm_benchmark", os::Thread::Priority::NORMAL);
+    handler_ = new os::Handler(thread_);
+  }
+
+  void TearDown(State& st) override {
+    handler_->Clear();
+    delete handler_;
+    delete thread_;
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  os::Thread* thread_ = nullptr;
+  os::Handler* handler_ = nullptr;
+};
+
+BENCHMARK_DEFINE_F(BM_ErtmTransmitWindow, send_with_loss)(State& state) {
+  int tx_window = state.range(0);
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
+  FakeScheduler scheduler;
+  FakeLink link;
+  ErtmController controller{&link, kCid, kCid, channel_queue.GetDownEnd(), handler_, &scheduler};
+  RetransmissionAndFlowControlConfigurationOption option;
+  option.mode_ = RetransmissionAndFlowControlModeOption::ENHANCED_RETRANSMISSION;
+  option.tx_window_size_ = tx_window;
+  option.max_transmit_ = 3;
+  option.retransmission_time_out_ = 2000;
+  option.monitor_time_out_ = 12000;
+  controller.SetRetransmissionAndFlowControlOptions(option);
+
+  std::vector<uint8_t> buffer;
+  uint8_t next_seq = 0;
+  size_t bytes_sent = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < tx_window; i++) {
+      controller.OnSdu(CreateSdu());
+      bytes_sent += SendPdu(controller.GetNextPacket(), &buffer);
+    }
+    uint8_t lost_seq = (next_seq + kLossInterval - 1) % 64;
+    controller.OnPdu(CreateSFrame(SupervisoryFunction::REJECT, lost_seq));
+    for (int i = kLossInterval - 1; i < tx_window; i++) {
+      bytes_sent += SendPdu(controller.GetNextPacket(), &buffer);
+    }
+    next_seq = (next_seq + tx_window) % 64;
+    controller.OnPdu(CreateSFrame(SupervisoryFunction::RECEIVER_READY, next_seq));
+  }
+  if (link.disconnected_) {
+    state.SkipWithError("channel disconnected");
+  }
+  state.SetBytesProcessed(bytes_sent);
+}
+
+BENCHMARK_REGISTER_F(BM_ErtmTransmitWindow, send_with_loss)->Arg(16)->Arg(32)->Arg(63);
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
@@ -42,6 +42,19 @@ PacketView<kLittleEndian> GetPacketView(std::unique_ptr<packet::BasePacketBuilde
   return packet::PacketView<packet::kLittleEndian>(bytes);
 }
 
+std::string GetIFramePayload(std::unique_ptr<packet::BasePacketBuilder> packet, uint8_t* tx_seq) {
+  auto pdu_view = BasicFrameView::Create(GetPacketView(std::move(packet)));
+  auto i_frame_view = EnhancedInformationFrameView::Create(StandardFrameView::Create(pdu_view));
+  EXPECT_TRUE(i_frame_view.IsValid());
+  *tx_seq = i_frame_view.GetTxSeq();
+  auto payload = i_frame_view.GetPayload();
+  return std::string(payload.begin(), payload.end());
+}
+
+PacketView<kLittleEndian> CreateSFrame(SupervisoryFunction s, uint8_t req_seq) {
+  return GetPacketView(EnhancedSupervisoryFrameBuilder::Create(1, s, Poll::NOT_SET, Final::NOT_SET, req_seq));
+}
+
 void sync_handler(os::Handler* handler) {
   std::promise<void> promise;
   auto future = promise.get_future();
@@ -204,6 +217,51 @@ TEST_F(ErtmDataControllerTest, receive_packet_with_fcs) {
   EXPECT_EQ(data, "abcd");
 }
 
+TEST_F(ErtmDataControllerTest, retransmit_from_rej) {
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
+  testing::MockScheduler scheduler;
+  testing::MockILink link;
+  ErtmController controller{&link, 1, 1, channel_queue.GetDownEnd(), queue_handler_, &scheduler};
+  EXPECT_CALL(scheduler, OnPacketsReady(1, 1)).Times(5);
+  controller.OnSdu(CreateSdu({'a'}));
+  controller.OnSdu(CreateSdu({'b'}));
+  controller.OnSdu(CreateSdu({'c'}));
+  uint8_t tx_seq;
+  for (auto expected : {"a", "b", "c"}) {
+    EXPECT_EQ(GetIFramePayload(controller.GetNextPacket(), &tx_seq), expected);
+  }
+  // Peer lost the second frame: the first is acked, the second and third are sent again
+  controller.OnPdu(CreateSFrame(SupervisoryFunction::REJECT, 1));
+  EXPECT_EQ(GetIFramePayload(controller.GetNextPacket(), &tx_seq), "b");
+  EXPECT_EQ(tx_seq, 1);
+  EXPECT_EQ(GetIFramePayload(controller.GetNextPacket(), &tx_seq), "c");
+  EXPECT_EQ(tx_seq, 2);
+}
+
+TEST_F(ErtmDataControllerTest, transmit_window_wraps_around) {
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
+  testing::MockScheduler scheduler;
+  testing::MockILink link;
+  ErtmController controller{&link, 1, 1, channel_queue.GetDownEnd(), queue_handler_, &scheduler};
+  EXPECT_CALL(scheduler, OnPacketsReady(1, 1)).Times(::testing::AnyNumber());
+  EXPECT_CALL(link, SendDisconnectionRequest).Times(0);
+  // Two frames in flight at a time, acked one by one, across two wraps of the sequence space
+  for (int i = 0; i < 130; i++) {
+    controller.OnSdu(CreateSdu({static_cast<uint8_t>(i)}));
+    uint8_t tx_seq;
+    EXPECT_EQ(GetIFramePayload(controller.GetNextPacket(), &tx_seq), std::string(1, static_cast<char>(i)));
+    EXPECT_EQ(tx_seq, i % 64);
+    if (i > 0) {
+      controller.OnPdu(CreateSFrame(SupervisoryFunction::RECEIVER_READY, i % 64));
+    }
+  }
+  // Losing the last frame after the wrap still retransmits it
+  controller.OnPdu(CreateSFrame(SupervisoryFunction::REJECT, 129 % 64));
+  uint8_t tx_seq;
+  EXPECT_EQ(GetIFramePayload(controller.GetNextPacket(), &tx_seq), std::string(1, static_cast<char>(129)));
+  EXPECT_EQ(tx_seq, 129 % 64);
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace l2cap
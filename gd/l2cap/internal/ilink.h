@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "hci/acl_scheduler.h"
 #include "hci/address_with_type.h"
 #include "l2cap/cid.h"
 
@@ -31,6 +32,7 @@ class ILink {
   virtual ~ILink() = default;
   virtual void SendDisconnectionRequest(Cid local_cid, Cid remote_cid) = 0;
   virtual hci::AddressWithType GetDevice() = 0;
+  virtual void SetAclPriority(hci::AclPriority priority) = 0;
 
   // To be used by LE credit based channel data controller over LE link
   virtual void SendLeCredit(Cid local_cid, uint16_t credit) = 0;
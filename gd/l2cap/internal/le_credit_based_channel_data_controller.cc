@@ -16,10 +16,10 @@
 
 #include "l2cap/internal/le_credit_based_channel_data_controller.h"
 
+#include <algorithm>
+
 #include "l2cap/l2cap_packets.h"
 #include "l2cap/le/internal/link.h"
-#include "packet/fragmenting_inserter.h"
-#include "packet/raw_builder.h"
 
 namespace bluetooth {
 namespace l2cap {
@@ -40,27 +40,24 @@ void LeCreditBasedDataController::OnSdu(std::unique_ptr<packet::BasePacketBuilde
   if (sdu_size > mtu_) {
     LOG_WARN("Received sdu_size %d > mtu %d", static_cast<int>(sdu_size), mtu_);
   }
-  std::vector<std::unique_ptr<packet::RawBuilder>> segments;
+  // Serialize the SDU once; K-frames are later sent as subviews of these bytes
+  auto sdu_bytes = std::make_shared<std::vector<uint8_t>>();
+  sdu_bytes->reserve(sdu_size);
+  BitInserter it(*sdu_bytes);
+  sdu->Serialize(it);
   // TODO: We don't need to waste 2 bytes for continuation segment.
-  packet::FragmentingInserter fragmenting_inserter(mps_ - 2, std::back_insert_iterator(segments));
-  sdu->Serialize(fragmenting_inserter);
-  fragmenting_inserter.finalize();
-  std::unique_ptr<BasicFrameBuilder> builder;
-  builder = FirstLeInformationFrameBuilder::Create(remote_cid_, sdu_size, std::move(segments[0]));
-  pdu_queue_.emplace(std::move(builder));
-  for (auto i = 1; i < segments.size(); i++) {
-    builder = BasicFrameBuilder::Create(remote_cid_, std::move(segments[i]));
-    pdu_queue_.emplace(std::move(builder));
-  }
-  if (credits_ >= segments.size()) {
-    scheduler_->OnPacketsReady(cid_, segments.size());
-    credits_ -= segments.size();
+  uint16_t segment_size = mps_ - 2;
+  sdu_queue_.push({packet::PacketView<kLittleEndian>(sdu_bytes), segment_size});
+  uint16_t num_frames = (sdu_size + segment_size - 1) / segment_size;
+  if (credits_ >= num_frames) {
+    scheduler_->OnPacketsReady(cid_, num_frames);
+    credits_ -= num_frames;
   } else if (credits_ > 0) {
     scheduler_->OnPacketsReady(cid_, credits_);
-    pending_frames_count_ += (segments.size() - credits_);
+    pending_frames_count_ += (num_frames - credits_);
     credits_ = 0;
   } else {
-    pending_frames_count_ += segments.size();
+    pending_frames_count_ += num_frames;
   }
 }
 
@@ -74,6 +71,7 @@ void LeCreditBasedDataController::OnPdu(packet::PacketView<true> pdu) {
     LOG_WARN("Received frame size %d > mps %d, dropping the packet", static_cast<int>(basic_frame_view.size()), mps_);
     return;
   }
+  int remaining_sdu_size;
   if (remaining_sdu_continuation_packet_size_ == 0) {
     auto start_frame_view = FirstLeInformationFrameView::Create(basic_frame_view);
     if (!start_frame_view.IsValid()) {
@@ -81,30 +79,46 @@ void LeCreditBasedDataController::OnPdu(packet::PacketView<true> pdu) {
       return;
     }
     auto payload = start_frame_view.GetPayload();
-    auto sdu_size = start_frame_view.GetL2capSduLength();
-    remaining_sdu_continuation_packet_size_ = sdu_size - payload.size();
+    remaining_sdu_size = start_frame_view.GetL2capSduLength() - static_cast<int>(payload.size());
     reassembly_stage_ = payload;
   } else {
     auto payload = basic_frame_view.GetPayload();
-    remaining_sdu_continuation_packet_size_ -= payload.size();
+    remaining_sdu_size = remaining_sdu_continuation_packet_size_ - static_cast<int>(payload.size());
     reassembly_stage_.AppendPacketView(payload);
   }
-  if (remaining_sdu_continuation_packet_size_ == 0) {
+  if (remaining_sdu_size == 0) {
+    remaining_sdu_continuation_packet_size_ = 0;
     enqueue_buffer_.Enqueue(std::make_unique<PacketView<kLittleEndian>>(reassembly_stage_), handler_);
-  } else if (remaining_sdu_continuation_packet_size_ < 0 || reassembly_stage_.size() > mtu_) {
+    reassembly_stage_ = PacketViewForReassembly(std::make_shared<std::vector<uint8_t>>());
+  } else if (remaining_sdu_size < 0 || reassembly_stage_.size() > mtu_) {
     LOG_WARN("Received larger SDU size than expected");
     reassembly_stage_ = PacketViewForReassembly(std::make_shared<std::vector<uint8_t>>());
     remaining_sdu_continuation_packet_size_ = 0;
     link_->SendDisconnectionRequest(cid_, remote_cid_);
+  } else {
+    remaining_sdu_continuation_packet_size_ = remaining_sdu_size;
   }
   // TODO: Improve the logic by sending credit only after user dequeued the SDU
   link_->SendLeCredit(cid_, 1);
 }
 
 std::unique_ptr<packet::BasePacketBuilder> LeCreditBasedDataController::GetNextPacket() {
-  auto next = std::move(pdu_queue_.front());
-  pdu_queue_.pop();
-  return next;
+  auto& pending = sdu_queue_.front();
+  size_t sdu_size = pending.sdu.size();
+  size_t segment_end = std::min(sdu_offset_ + pending.segment_size, sdu_size);
+  auto segment = std::make_unique<SegmentBuilder>(pending.sdu.GetLittleEndianSubview(sdu_offset_, segment_end));
+  std::unique_ptr<BasicFrameBuilder> builder;
+  if (sdu_offset_ == 0) {
+    builder = FirstLeInformationFrameBuilder::Create(remote_cid_, sdu_size, std::move(segment));
+  } else {
+    builder = BasicFrameBuilder::Create(remote_cid_, std::move(segment));
+  }
+  sdu_offset_ = segment_end;
+  if (sdu_offset_ == sdu_size) {
+    sdu_queue_.pop();
+    sdu_offset_ = 0;
+  }
+  return builder;
 }
 
 void LeCreditBasedDataController::SetMtu(Mtu mtu) {
@@ -131,6 +145,18 @@ void LeCreditBasedDataController::OnCredit(uint16_t credits) {
   }
 }
 
+size_t LeCreditBasedDataController::SegmentBuilder::size() const {
+  return segment_.size();
+}
+
+void LeCreditBasedDataController::SegmentBuilder::Serialize(BitInserter& it) const {
+  segment_.ForEachFragment([&it](const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      it.insert_byte(data[i]);
+    }
+  });
+}
+
 }  // namespace internal
 }  // namespace l2cap
 }  // namespace bluetooth
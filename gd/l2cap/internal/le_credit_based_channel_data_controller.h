@@ -17,6 +17,7 @@
 #pragma once
 
 #include <memory>
+#include <queue>
 #include <unordered_map>
 #include <utility>
 
@@ -63,7 +64,15 @@ class LeCreditBasedDataController : public DataController {
   Cid remote_cid_;
   os::EnqueueBuffer<UpperEnqueue> enqueue_buffer_;
   os::Handler* handler_;
-  std::queue<std::unique_ptr<packet::BasePacketBuilder>> pdu_queue_;
+  // An SDU waiting to be segmented. K-frames are cut from it only when the scheduler asks for the next packet, i.e.
+  // once a credit has been spent on it and the link can take it.
+  struct PendingSdu {
+    packet::PacketView<kLittleEndian> sdu;
+    uint16_t segment_size;
+  };
+  std::queue<PendingSdu> sdu_queue_;
+  // Bytes of the front SDU already sent in earlier K-frames
+  size_t sdu_offset_ = 0;
   Scheduler* scheduler_;
   ILink* link_;
   Mtu mtu_ = 512;
@@ -78,6 +87,19 @@ class LeCreditBasedDataController : public DataController {
       Append(to_append);
     }
   };
+  // Payload of one K-frame: a subview of the SDU, serialized straight into the outgoing frame
+  class SegmentBuilder : public packet::BasePacketBuilder {
+   public:
+    SegmentBuilder(packet::PacketView<kLittleEndian> segment) : segment_(std::move(segment)) {}
+
+    void Serialize(BitInserter& it) const override;
+
+    size_t size() const override;
+
+   private:
+    packet::PacketView<kLittleEndian> segment_;
+  };
+
   PacketViewForReassembly reassembly_stage_{std::make_shared<std::vector<uint8_t>>()};
   uint16_t remaining_sdu_continuation_packet_size_ = 0;
 };
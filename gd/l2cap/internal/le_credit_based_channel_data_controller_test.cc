@@ -123,6 +123,47 @@ TEST_F(LeCreditBasedDataControllerTest, transmit_segmented) {
   EXPECT_EQ(data, "cd");
 }
 
+TEST_F(LeCreditBasedDataControllerTest, transmit_segmented_as_credits_arrive) {
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
+  testing::MockScheduler scheduler;
+  testing::MockILink link;
+  LeCreditBasedDataController controller{&link, 0x41, 0x41, channel_queue.GetDownEnd(), queue_handler_, &scheduler};
+  controller.OnCredit(1);
+  controller.SetMps(4);
+  EXPECT_CALL(scheduler, OnPacketsReady(0x41, 1));
+  // Should be divided into 'ab', 'cd', 'ef' and 'gh', over two SDUs
+  controller.OnSdu(CreateSdu({'a', 'b', 'c', 'd', 'e', 'f'}));
+  controller.OnSdu(CreateSdu({'g', 'h'}));
+  auto next_packet = controller.GetNextPacket();
+  EXPECT_NE(next_packet, nullptr);
+  auto view = GetPacketView(std::move(next_packet));
+  auto first_le_info_view = FirstLeInformationFrameView::Create(BasicFrameView::Create(view));
+  EXPECT_TRUE(first_le_info_view.IsValid());
+  auto payload = first_le_info_view.GetPayload();
+  EXPECT_EQ(std::string(payload.begin(), payload.end()), "ab");
+  EXPECT_EQ(first_le_info_view.GetL2capSduLength(), 6);
+
+  EXPECT_CALL(scheduler, OnPacketsReady(0x41, 3));
+  controller.OnCredit(5);
+  for (auto expected : {"cd", "ef"}) {
+    next_packet = controller.GetNextPacket();
+    EXPECT_NE(next_packet, nullptr);
+    view = GetPacketView(std::move(next_packet));
+    auto pdu_view = BasicFrameView::Create(view);
+    EXPECT_TRUE(pdu_view.IsValid());
+    payload = pdu_view.GetPayload();
+    EXPECT_EQ(std::string(payload.begin(), payload.end()), expected);
+  }
+  next_packet = controller.GetNextPacket();
+  EXPECT_NE(next_packet, nullptr);
+  view = GetPacketView(std::move(next_packet));
+  first_le_info_view = FirstLeInformationFrameView::Create(BasicFrameView::Create(view));
+  EXPECT_TRUE(first_le_info_view.IsValid());
+  payload = first_le_info_view.GetPayload();
+  EXPECT_EQ(std::string(payload.begin(), payload.end()), "gh");
+  EXPECT_EQ(first_le_info_view.GetL2capSduLength(), 2);
+}
+
 TEST_F(LeCreditBasedDataControllerTest, receive_unsegmented) {
   common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
   testing::MockScheduler scheduler;
@@ -175,6 +216,7 @@ TEST_F(LeCreditBasedDataControllerTest, receive_segmented_with_wrong_sdu_length)
   auto segment2 = CreateSdu({'e', 'f', 'g'});
   auto builder2 = BasicFrameBuilder::Create(0x41, std::move(segment2));
   base_view = GetPacketView(std::move(builder2));
+  EXPECT_CALL(link, SendDisconnectionRequest(0x41, 0x41));
   controller.OnPdu(base_view);
   sync_handler(queue_handler_);
   auto payload = channel_queue.GetUpEnd()->TryDequeue();
@@ -55,6 +55,10 @@ void Link::Disconnect() {
   acl_connection_->Disconnect(hci::DisconnectReason::REMOTE_USER_TERMINATED_CONNECTION);
 }
 
+void Link::SetAclPriority(hci::AclPriority priority) {
+  acl_connection_->SetAclPriority(priority);
+}
+
 void Link::UpdateConnectionParameter(SignalId signal_id, uint16_t conn_interval_min, uint16_t conn_interval_max,
                                      uint16_t conn_latency, uint16_t supervision_timeout) {
   acl_connection_->LeConnectionUpdate(
@@ -71,6 +71,8 @@ class Link : public l2cap::internal::ILink {
 
   virtual void Disconnect();
 
+  void SetAclPriority(hci::AclPriority priority) override;
+
   // Handles connection parameter update request from remote
   virtual void UpdateConnectionParameter(SignalId signal_id, uint16_t conn_interval_min, uint16_t conn_interval_max,
                                          uint16_t conn_latency, uint16_t supervision_timeout);
@@ -53,6 +53,9 @@ class Handler {
   template <typename T>
   friend class Queue;
 
+  template <typename T>
+  friend class MpscQueue;
+
   friend class Alarm;
 
   friend class RepeatingAlarm;
@@ -61,7 +64,13 @@ class Handler {
   inline bool was_cleared() const {
     return tasks_ == nullptr;
   };
+  // Maximum number of tasks run per reactor wakeup, so that a busy handler does not starve other reactables on the
+  // same thread.
+  static constexpr size_t kMaxTasksPerWakeup = 64;
+  // Tasks posted by other threads; protected by mutex_
   std::queue<OnceClosure>* tasks_;
+  // Tasks taken from tasks_ in one go and not run yet; only accessed on the handler thread
+  std::queue<OnceClosure> ready_tasks_;
   Thread* thread_;
   int fd_;
   Reactor::Reactable* reactable_;
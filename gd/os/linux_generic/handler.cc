@@ -26,15 +26,13 @@
 #include "os/reactor.h"
 #include "os/utils.h"
 
-#ifndef EFD_SEMAPHORE
-#define EFD_SEMAPHORE 1
-#endif
-
 namespace bluetooth {
 namespace os {
 
+// The eventfd is used as a counter: it is only written when tasks_ becomes non-empty (or when a batch is cut short),
+// and a single read clears it, however many tasks are pending.
 Handler::Handler(Thread* thread)
-    : tasks_(new std::queue<OnceClosure>()), thread_(thread), fd_(eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK)) {
+    : tasks_(new std::queue<OnceClosure>()), thread_(thread), fd_(eventfd(0, EFD_NONBLOCK)) {
   ASSERT(fd_ != -1);
   reactable_ = thread_->GetReactor()->Register(fd_, common::Bind(&Handler::handle_next_event, common::Unretained(this)),
                                                common::Closure());
@@ -57,7 +55,12 @@ void Handler::Post(OnceClosure closure) {
     if (was_cleared()) {
       return;
     }
+    bool was_empty = tasks_->empty();
     tasks_->emplace(std::move(closure));
+    if (!was_empty) {
+      // The handler has already been signalled and has not collected the pending tasks yet
+      return;
+    }
   }
   uint64_t val = 1;
   auto write_result = eventfd_write(fd_, val);
@@ -87,8 +90,7 @@ void Handler::WaitUntilStopped(std::chrono::milliseconds timeout) {
 }
 
 void Handler::handle_next_event() {
-  common::OnceClosure closure;
-  {
+  if (ready_tasks_.empty()) {
     std::lock_guard<std::mutex> lock(mutex_);
     uint64_t val = 0;
     auto read_result = eventfd_read(fd_, &val);
@@ -96,12 +98,35 @@ void Handler::handle_next_event() {
     if (was_cleared()) {
       return;
     }
+    // A leftover wakeup from a batch that was cut short may find nothing to do
+    if (read_result == -1 && errno == EAGAIN) {
+      return;
+    }
     ASSERT_LOG(read_result != -1, "eventfd read error %d %s", errno, strerror(errno));
 
-    closure = std::move(tasks_->front());
-    tasks_->pop();
+    std::swap(ready_tasks_, *tasks_);
+  }
+
+  for (size_t i = 0; i < kMaxTasksPerWakeup && !ready_tasks_.empty(); i++) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (was_cleared()) {
+        ready_tasks_ = std::queue<OnceClosure>();
+        return;
+      }
+    }
+    OnceClosure closure = std::move(ready_tasks_.front());
+    ready_tasks_.pop();
+    std::move(closure).Run();
+  }
+
+  if (!ready_tasks_.empty()) {
+    // Come back for the rest after other reactables had a chance to run. The eventfd may already be readable, in
+    // which case this write is harmless.
+    uint64_t val = 1;
+    auto write_result = eventfd_write(fd_, val);
+    ASSERT(write_result != -1);
   }
-  std::move(closure).Run();
 }
 
 }  // namespace os
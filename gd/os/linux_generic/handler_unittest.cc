@@ -19,6 +19,7 @@
 #include <sys/eventfd.h>
 #include <future>
 #include <thread>
+#include <vector>
 
 #include "common/bind.h"
 #include "common/callback.h"
@@ -84,6 +85,36 @@ TEST_F(HandlerTest, post_task_cleared) {
   ASSERT_EQ(val, 1);
 }
 
+TEST_F(HandlerTest, post_many_tasks_in_order) {
+  // More than one batch worth of tasks, posted while the handler thread is busy
+  constexpr int kNumTasks = 1000;
+  std::promise<void> can_continue;
+  auto can_continue_future = can_continue.get_future();
+  handler_->Post(common::BindOnce([](std::future<void> future) { future.wait(); }, std::move(can_continue_future)));
+
+  std::vector<int> order;
+  std::promise<void> all_ran;
+  auto all_ran_future = all_ran.get_future();
+  for (int i = 0; i < kNumTasks; i++) {
+    handler_->Post(common::BindOnce(
+        [](std::vector<int>* order, int i, std::promise<void>* all_ran) {
+          order->push_back(i);
+          if (i == kNumTasks - 1) {
+            all_ran->set_value();
+          }
+        },
+        common::Unretained(&order), i, common::Unretained(&all_ran)));
+  }
+  can_continue.set_value();
+  all_ran_future.wait();
+
+  ASSERT_EQ(order.size(), static_cast<size_t>(kNumTasks));
+  for (int i = 0; i < kNumTasks; i++) {
+    EXPECT_EQ(order[i], i);
+  }
+  handler_->Clear();
+}
+
 void check_int(std::unique_ptr<int> number, std::shared_ptr<int> to_change) {
   *to_change = *number;
 }
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+namespace mpsc_queue_internal {
+
+inline size_t RingSizeFor(size_t capacity) {
+  size_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  return size;
+}
+
+}  // namespace mpsc_queue_internal
+
+template <typename T>
+MpscQueue<T>::MpscQueue(size_t capacity)
+    : mask_(mpsc_queue_internal::RingSizeFor(capacity) - 1),
+      slots_(new Slot[mask_ + 1]),
+      tail_(0),
+      free_slots_(capacity),
+      ready_items_(0),
+      head_(0),
+      enqueue_(capacity > 0),
+      dequeue_(false) {
+  for (size_t i = 0; i <= mask_; i++) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue() {
+  ASSERT(enqueue_.handler_ == nullptr);
+  ASSERT(dequeue_.handler_ == nullptr);
+}
+
+template <typename T>
+void MpscQueue<T>::RegisterEnqueue(Handler* handler, EnqueueCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(enqueue_.handler_ == nullptr);
+  ASSERT(enqueue_.reactable_ == nullptr);
+  enqueue_.handler_ = handler;
+  enqueue_.reactable_ = enqueue_.handler_->thread_->GetReactor()->Register(
+      enqueue_.fd_, base::Bind(&MpscQueue<T>::EnqueueCallbackInternal, base::Unretained(this), std::move(callback)),
+      base::Closure());
+}
+
+template <typename T>
+void MpscQueue<T>::UnregisterEnqueue() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(enqueue_.reactable_ != nullptr);
+  enqueue_.handler_->thread_->GetReactor()->Unregister(enqueue_.reactable_);
+  enqueue_.reactable_ = nullptr;
+  enqueue_.handler_ = nullptr;
+}
+
+template <typename T>
+void MpscQueue<T>::RegisterDequeue(Handler* handler, DequeueCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(dequeue_.handler_ == nullptr);
+  ASSERT(dequeue_.reactable_ == nullptr);
+  dequeue_.handler_ = handler;
+  dequeue_.reactable_ = dequeue_.handler_->thread_->GetReactor()->Register(dequeue_.fd_, callback, base::Closure());
+}
+
+template <typename T>
+void MpscQueue<T>::UnregisterDequeue() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(dequeue_.reactable_ != nullptr);
+  dequeue_.handler_->thread_->GetReactor()->Unregister(dequeue_.reactable_);
+  dequeue_.reactable_ = nullptr;
+  dequeue_.handler_ = nullptr;
+}
+
+template <typename T>
+std::unique_ptr<T> MpscQueue<T>::TryDequeue() {
+  Slot& slot = slots_[head_ & mask_];
+  if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) {
+    // Either empty, or the producer that claimed this slot has not published yet. Only drop the wakeup in the
+    // first case, otherwise the dequeue callback runs again once the slot is published.
+    if (ready_items_.load() == 0) {
+      dequeue_.ClearUnless([this]() { return ready_items_.load() > 0; });
+    }
+    return nullptr;
+  }
+
+  std::unique_ptr<T> data = std::move(slot.data);
+  slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+  head_++;
+
+  if (ready_items_.fetch_sub(1) == 1) {
+    dequeue_.ClearUnless([this]() { return ready_items_.load() > 0; });
+  }
+  if (free_slots_.fetch_add(1) == 0) {
+    enqueue_.Signal();
+  }
+  return data;
+}
+
+template <typename T>
+bool MpscQueue<T>::ReserveSlot() {
+  size_t free_slots = free_slots_.load();
+  do {
+    if (free_slots == 0) {
+      return false;
+    }
+  } while (!free_slots_.compare_exchange_weak(free_slots, free_slots - 1));
+
+  if (free_slots == 1) {
+    enqueue_.ClearUnless([this]() { return free_slots_.load() > 0; });
+  }
+  return true;
+}
+
+template <typename T>
+void MpscQueue<T>::Publish(std::unique_ptr<T> data) {
+  size_t position = tail_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots_[position & mask_];
+  // A reservation guarantees the consumer has already released this slot
+  ASSERT(slot.sequence.load(std::memory_order_acquire) == position);
+  slot.data = std::move(data);
+
+  // Count the item before publishing it, so that the consumer never takes an item it has not been told about
+  size_t ready_items = ready_items_.fetch_add(1);
+  slot.sequence.store(position + 1, std::memory_order_release);
+  if (ready_items == 0) {
+    dequeue_.Signal();
+  }
+}
+
+template <typename T>
+void MpscQueue<T>::EnqueueCallbackInternal(EnqueueCallback callback) {
+  if (!ReserveSlot()) {
+    enqueue_.ClearUnless([this]() { return free_slots_.load() > 0; });
+    return;
+  }
+  std::unique_ptr<T> data = callback.Run();
+  ASSERT(data != nullptr);
+  Publish(std::move(data));
+}
+
+template <typename T>
+MpscQueue<T>::QueueEndpoint::QueueEndpoint(bool signalled)
+    : fd_(eventfd(signalled ? 1 : 0, EFD_NONBLOCK)), handler_(nullptr), reactable_(nullptr) {
+  ASSERT(fd_ != -1);
+}
+
+template <typename T>
+MpscQueue<T>::QueueEndpoint::~QueueEndpoint() {
+  int close_status;
+  RUN_NO_INTR(close_status = close(fd_));
+  ASSERT_LOG(close_status != -1, "close failed: %s", strerror(errno));
+}
+
+template <typename T>
+void MpscQueue<T>::QueueEndpoint::Signal() {
+  auto write_result = eventfd_write(fd_, 1);
+  ASSERT_LOG(write_result != -1, "signal failed: %s", strerror(errno));
+}
+
+template <typename T>
+template <typename Predicate>
+void MpscQueue<T>::QueueEndpoint::ClearUnless(Predicate still_ready) {
+  uint64_t val = 0;
+  auto read_result = eventfd_read(fd_, &val);
+  ASSERT_LOG(read_result != -1 || errno == EAGAIN, "clear failed: %s", strerror(errno));
+  // The other end may have signalled between its counter update and our read, re-check after clearing
+  if (still_ready()) {
+    Signal();
+  }
+}
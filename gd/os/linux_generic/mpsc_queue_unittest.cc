@@ -0,0 +1,225 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/mpsc_queue.h"
+
+#include <future>
+#include <vector>
+
+#include "common/bind.h"
+#include "gtest/gtest.h"
+
+namespace bluetooth {
+namespace os {
+namespace {
+
+constexpr int kQueueSize = 10;
+constexpr int kQueueSizeOne = 1;
+
+class MpscQueueTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    enqueue_thread_ = new Thread("enqueue_thread", Thread::Priority::NORMAL);
+    enqueue_handler_ = new Handler(enqueue_thread_);
+    dequeue_thread_ = new Thread("dequeue_thread", Thread::Priority::NORMAL);
+    dequeue_handler_ = new Handler(dequeue_thread_);
+  }
+  void TearDown() override {
+    enqueue_handler_->Clear();
+    delete enqueue_handler_;
+    delete enqueue_thread_;
+    dequeue_handler_->Clear();
+    delete dequeue_handler_;
+    delete dequeue_thread_;
+    enqueue_handler_ = nullptr;
+    enqueue_thread_ = nullptr;
+    dequeue_handler_ = nullptr;
+    dequeue_thread_ = nullptr;
+  }
+
+  void Sync(Handler* handler) {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler->Post(common::BindOnce([](std::promise<void>* promise) { promise->set_value(); },
+                                   common::Unretained(&promise)));
+    future.wait();
+  }
+
+  Thread* enqueue_thread_;
+  Handler* enqueue_handler_;
+  Thread* dequeue_thread_;
+  Handler* dequeue_handler_;
+};
+
+TEST_F(MpscQueueTest, try_dequeue_empty_queue) {
+  MpscQueue<int> queue(kQueueSize);
+  EXPECT_EQ(queue.TryDequeue(), nullptr);
+}
+
+TEST_F(MpscQueueTest, enqueue_until_full) {
+  MpscQueue<int> queue(kQueueSize);
+  int enqueued = 0;
+  std::promise<void> promise;
+  auto future = promise.get_future();
+
+  enqueue_handler_->Post(common::BindOnce(
+      [](MpscQueue<int>* queue, Handler* handler, int* enqueued, std::promise<void>* promise) {
+        queue->RegisterEnqueue(handler, common::Bind(
+                                            [](int* enqueued, std::promise<void>* promise) {
+                                              (*enqueued)++;
+                                              if (*enqueued == kQueueSize) {
+                                                promise->set_value();
+                                              }
+                                              return std::make_unique<int>(*enqueued);
+                                            },
+                                            common::Unretained(enqueued), common::Unretained(promise)));
+      },
+      common::Unretained(&queue), common::Unretained(enqueue_handler_), common::Unretained(&enqueued),
+      common::Unretained(&promise)));
+  future.wait();
+
+  // The queue is full, so the enqueue callback must not run again
+  Sync(enqueue_handler_);
+  Sync(enqueue_handler_);
+  EXPECT_EQ(enqueued, kQueueSize);
+
+  enqueue_handler_->Post(
+      common::BindOnce([](MpscQueue<int>* queue) { queue->UnregisterEnqueue(); }, common::Unretained(&queue)));
+  Sync(enqueue_handler_);
+
+  for (int i = 1; i <= kQueueSize; i++) {
+    auto data = queue.TryDequeue();
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(*data, i);
+  }
+  EXPECT_EQ(queue.TryDequeue(), nullptr);
+}
+
+TEST_F(MpscQueueTest, dequeue_until_empty) {
+  MpscQueue<int> queue(kQueueSize);
+  std::vector<int> dequeued;
+  std::promise<void> promise;
+  auto future = promise.get_future();
+
+  dequeue_handler_->Post(common::BindOnce(
+      [](MpscQueue<int>* queue, Handler* handler, std::vector<int>* dequeued, std::promise<void>* promise) {
+        queue->RegisterDequeue(handler, common::Bind(
+                                            [](MpscQueue<int>* queue, std::vector<int>* dequeued,
+                                               std::promise<void>* promise) {
+                                              auto data = queue->TryDequeue();
+                                              if (data == nullptr) {
+                                                return;
+                                              }
+                                              dequeued->push_back(*data);
+                                              if (dequeued->size() == static_cast<size_t>(kQueueSize)) {
+                                                queue->UnregisterDequeue();
+                                                promise->set_value();
+                                              }
+                                            },
+                                            common::Unretained(queue), common::Unretained(dequeued),
+                                            common::Unretained(promise)));
+      },
+      common::Unretained(&queue), common::Unretained(dequeue_handler_), common::Unretained(&dequeued),
+      common::Unretained(&promise)));
+  Sync(dequeue_handler_);
+
+  EnqueueBuffer<int> enqueue_buffer(&queue);
+  for (int i = 0; i < kQueueSize; i++) {
+    enqueue_buffer.Enqueue(std::make_unique<int>(i), enqueue_handler_);
+  }
+  future.wait();
+
+  ASSERT_EQ(dequeued.size(), static_cast<size_t>(kQueueSize));
+  for (int i = 0; i < kQueueSize; i++) {
+    EXPECT_EQ(dequeued[i], i);
+  }
+  EXPECT_EQ(queue.TryDequeue(), nullptr);
+}
+
+TEST_F(MpscQueueTest, enqueue_resumes_when_queue_becomes_non_full) {
+  constexpr int kTotal = kQueueSize * 10;
+  MpscQueue<int> queue(kQueueSizeOne);
+  std::vector<int> dequeued;
+  std::promise<void> promise;
+  auto future = promise.get_future();
+
+  dequeue_handler_->Post(common::BindOnce(
+      [](MpscQueue<int>* queue, Handler* handler, std::vector<int>* dequeued, std::promise<void>* promise) {
+        queue->RegisterDequeue(handler, common::Bind(
+                                            [](MpscQueue<int>* queue, std::vector<int>* dequeued,
+                                               std::promise<void>* promise) {
+                                              auto data = queue->TryDequeue();
+                                              if (data == nullptr) {
+                                                return;
+                                              }
+                                              dequeued->push_back(*data);
+                                              if (dequeued->size() == static_cast<size_t>(kTotal)) {
+                                                queue->UnregisterDequeue();
+                                                promise->set_value();
+                                              }
+                                            },
+                                            common::Unretained(queue), common::Unretained(dequeued),
+                                            common::Unretained(promise)));
+      },
+      common::Unretained(&queue), common::Unretained(dequeue_handler_), common::Unretained(&dequeued),
+      common::Unretained(&promise)));
+  Sync(dequeue_handler_);
+
+  EnqueueBuffer<int> enqueue_buffer(&queue);
+  for (int i = 0; i < kTotal; i++) {
+    enqueue_buffer.Enqueue(std::make_unique<int>(i), enqueue_handler_);
+  }
+  future.wait();
+
+  ASSERT_EQ(dequeued.size(), static_cast<size_t>(kTotal));
+  for (int i = 0; i < kTotal; i++) {
+    EXPECT_EQ(dequeued[i], i);
+  }
+}
+
+// Create all threads for death tests in the function that dies
+class MpscQueueDeathTest : public ::testing::Test {
+ public:
+  void RegisterEnqueueAndDelete() {
+    Thread* enqueue_thread = new Thread("enqueue_thread", Thread::Priority::NORMAL);
+    Handler* enqueue_handler = new Handler(enqueue_thread);
+    MpscQueue<std::string>* queue = new MpscQueue<std::string>(kQueueSizeOne);
+    queue->RegisterEnqueue(enqueue_handler,
+                           common::Bind([]() { return std::make_unique<std::string>("A string to fill the queue"); }));
+    delete queue;
+  }
+
+  void RegisterDequeueAndDelete() {
+    Thread* dequeue_thread = new Thread("dequeue_thread", Thread::Priority::NORMAL);
+    Handler* dequeue_handler = new Handler(dequeue_thread);
+    MpscQueue<std::string>* queue = new MpscQueue<std::string>(kQueueSizeOne);
+    queue->RegisterDequeue(dequeue_handler, common::Bind([](MpscQueue<std::string>* queue) { queue->TryDequeue(); },
+                                                         common::Unretained(queue)));
+    delete queue;
+  }
+};
+
+TEST_F(MpscQueueDeathTest, die_if_enqueue_not_unregistered) {
+  EXPECT_DEATH(RegisterEnqueueAndDelete(), "nqueue");
+}
+
+TEST_F(MpscQueueDeathTest, die_if_dequeue_not_unregistered) {
+  EXPECT_DEATH(RegisterDequeueAndDelete(), "equeue");
+}
+
+}  // namespace
+}  // namespace os
+}  // namespace bluetooth
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <unistd.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "common/bind.h"
+#include "common/callback.h"
+#include "os/handler.h"
+#ifdef OS_LINUX_GENERIC
+#include <sys/eventfd.h>
+#include <cerrno>
+#include <cstring>
+
+#include "os/utils.h"
+#endif
+#include "os/log.h"
+#include "os/queue.h"
+
+namespace bluetooth {
+namespace os {
+
+// A bounded, lock-free variant of |Queue| with the same IQueueEnqueue/IQueueDequeue contract.
+//
+// Data is kept in a ring of slots, each tagged with a sequence number, so producers publish and the single consumer
+// takes items without a mutex. Any number of threads may enqueue; TryDequeue must only be called from one thread at
+// a time (normally from the registered DequeueCallback).
+//
+// Unlike |Queue|, which signals a semaphore once per item, the reactive fds here are level flags: the dequeue end is
+// only signalled when the queue goes from empty to non-empty, and the enqueue end only when it goes from full to
+// not full. The registered callbacks are still invoked continually while the queue is non-empty / non-full.
+template <typename T>
+class MpscQueue : public IQueueEnqueue<T>, public IQueueDequeue<T> {
+ public:
+  // See |Queue::EnqueueCallback|
+  using EnqueueCallback = Callback<std::unique_ptr<T>()>;
+  // See |Queue::DequeueCallback|
+  using DequeueCallback = Callback<void()>;
+  // Create a queue with |capacity| is the maximum number of messages a queue can contain
+  explicit MpscQueue(size_t capacity);
+  ~MpscQueue();
+  // Register |callback| that will be called on |handler| when the queue is able to enqueue one piece of data.
+  // This will cause a crash if handler or callback has already been registered before.
+  void RegisterEnqueue(Handler* handler, EnqueueCallback callback) override;
+  // Unregister current EnqueueCallback from this queue, this will cause a crash if not registered yet.
+  void UnregisterEnqueue() override;
+  // Register |callback| that will be called on |handler| when the queue has at least one piece of data ready
+  // for dequeue. This will cause a crash if handler or callback has already been registered before.
+  void RegisterDequeue(Handler* handler, DequeueCallback callback) override;
+  // Unregister current DequeueCallback from this queue, this will cause a crash if not registered yet.
+  void UnregisterDequeue() override;
+
+  // Try to dequeue an item from this queue. Return nullptr when there is nothing in the queue.
+  std::unique_ptr<T> TryDequeue() override;
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    std::unique_ptr<T> data;
+  };
+
+  void EnqueueCallbackInternal(EnqueueCallback callback);
+  // Claim one of the |capacity| slots for an item that is about to be produced. Returns false when full.
+  bool ReserveSlot();
+  // Publish |data| into a previously reserved slot
+  void Publish(std::unique_ptr<T> data);
+
+  class QueueEndpoint {
+   public:
+    explicit QueueEndpoint(bool signalled);
+    ~QueueEndpoint();
+    // Make the endpoint fd readable. Signalling an already signalled endpoint is harmless.
+    void Signal();
+    // Make the endpoint fd not readable, then signal it again if |still_ready| became true in the meantime.
+    template <typename Predicate>
+    void ClearUnless(Predicate still_ready);
+    int fd_;
+    Handler* handler_;
+    Reactor::Reactable* reactable_;
+  };
+
+  const size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Next position producers will claim
+  alignas(kCacheLineSize) std::atomic<size_t> tail_;
+  // Number of slots not yet reserved by a producer
+  alignas(kCacheLineSize) std::atomic<size_t> free_slots_;
+  // Number of published items not yet taken by the consumer
+  alignas(kCacheLineSize) std::atomic<size_t> ready_items_;
+  // Next position the consumer will take, only touched by the consumer
+  alignas(kCacheLineSize) size_t head_;
+
+  // Guards registration only, the data path does not take it
+  std::mutex mutex_;
+
+  QueueEndpoint enqueue_;
+  QueueEndpoint dequeue_;
+};
+
+#ifdef OS_LINUX_GENERIC
+#include "os/linux_generic/mpsc_queue.tpp"
+#endif
+
+}  // namespace os
+}  // namespace bluetooth
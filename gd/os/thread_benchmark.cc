@@ -65,6 +65,7 @@ class BM_ReactorThread : public BM_ThreadPerformance {
     handler_ = std::make_unique<Handler>(thread_.get());
   }
   void TearDown(State& st) override {
+    handler_->Clear();
     handler_ = nullptr;
     thread_->Stop();
     thread_ = nullptr;
@@ -86,6 +87,7 @@ BENCHMARK_DEFINE_F(BM_ReactorThread, batch_enque_dequeue)(State& state) {
     }
     counter_future.wait();
   }
+  state.SetItemsProcessed(state.iterations() * num_messages_to_send_);
 };
 
 BENCHMARK_REGISTER_F(BM_ReactorThread, batch_enque_dequeue)
@@ -107,6 +109,7 @@ BENCHMARK_DEFINE_F(BM_ReactorThread, sequential_execution)(State& state) {
       counter_future.wait();
     }
   }
+  state.SetItemsProcessed(state.iterations() * num_messages_to_send_);
 };
 
 BENCHMARK_REGISTER_F(BM_ReactorThread, sequential_execution)
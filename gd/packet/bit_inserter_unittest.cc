@@ -78,5 +78,29 @@ TEST(BitInserterTest, observerTest) {
   ASSERT_EQ(result.size(), copy.size());
 }
 
+TEST(BitInserterTest, batchedObserverTest) {
+  std::vector<uint8_t> bytes;
+  BitInserter it(bytes);
+  std::vector<uint8_t> copy;
+  size_t batches = 0;
+
+  it.RegisterObserver(ByteObserver(
+      [&copy, &batches](const uint8_t* data, size_t length) {
+        copy.insert(copy.end(), data, data + length);
+        batches++;
+      },
+      [&copy]() { return static_cast<uint64_t>(copy.size()); }));
+
+  for (size_t i = 0; i < 1000; i++) {
+    it.insert_byte(static_cast<uint8_t>(i * 7));
+  }
+  ASSERT_LT(copy.size(), bytes.size());
+
+  ByteObserver observer = it.UnregisterObserver();
+  ASSERT_EQ(bytes.size(), observer.GetValue());
+  ASSERT_EQ(bytes, copy);
+  ASSERT_LT(batches, bytes.size() / 8);
+}
+
 }  // namespace packet
 }  // namespace bluetooth
@@ -22,13 +22,32 @@ namespace packet {
 ByteObserver::ByteObserver(const std::function<void(uint8_t)>& on_byte, const std::function<uint64_t()>& get_value)
     : on_byte_(on_byte), get_value_(get_value) {}
 
+ByteObserver::ByteObserver(const std::function<void(const uint8_t*, size_t)>& on_bytes,
+                           const std::function<uint64_t()>& get_value)
+    : on_bytes_(on_bytes), get_value_(get_value) {}
+
 void ByteObserver::OnByte(uint8_t byte) {
-  on_byte_(byte);
+  if (!on_bytes_) {
+    on_byte_(byte);
+    return;
+  }
+  batch_[batch_size_++] = byte;
+  if (batch_size_ == kBatchSize) {
+    Flush();
+  }
 }
 
 uint64_t ByteObserver::GetValue() {
+  Flush();
   return get_value_();
 }
 
+void ByteObserver::Flush() {
+  if (batch_size_ != 0) {
+    on_bytes_(batch_.data(), batch_size_);
+    batch_size_ = 0;
+  }
+}
+
 }  // namespace packet
 }  // namespace bluetooth
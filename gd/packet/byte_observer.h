@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 
@@ -26,13 +28,23 @@ class ByteObserver {
  public:
   ByteObserver(const std::function<void(uint8_t)>& on_byte_, const std::function<uint64_t()>& get_value_);
 
+  // Observer receiving the bytes in batches through |on_bytes|, all of them before |get_value| is called.
+  ByteObserver(const std::function<void(const uint8_t*, size_t)>& on_bytes, const std::function<uint64_t()>& get_value);
+
   void OnByte(uint8_t byte);
 
   uint64_t GetValue();
 
  private:
+  static constexpr size_t kBatchSize = 64;
+
+  void Flush();
+
   std::function<void(uint8_t)> on_byte_;
+  std::function<void(const uint8_t*, size_t)> on_bytes_;
   std::function<uint64_t()> get_value_;
+  std::array<uint8_t, kBatchSize> batch_;
+  size_t batch_size_ = 0;
 };
 
 }  // namespace packet
@@ -17,6 +17,7 @@
 #include "packet/packet_view.h"
 
 #include <algorithm>
+#include <iterator>
 
 #include "os/log.h"
 
@@ -25,15 +26,18 @@ namespace packet {
 
 template <bool little_endian>
 PacketView<little_endian>::PacketView(const std::forward_list<class View> fragments)
-    : fragments_(fragments), length_(0) {
-  for (auto fragment : fragments_) {
+    : fragments_(fragments), length_(0), contiguous_data_(nullptr) {
+  for (const auto& fragment : fragments_) {
     length_ += fragment.size();
   }
+  UpdateContiguousData();
 }
 
 template <bool little_endian>
 PacketView<little_endian>::PacketView(std::shared_ptr<std::vector<uint8_t>> packet)
-    : fragments_({View(packet, 0, packet->size())}), length_(packet->size()) {}
+    : fragments_({View(packet, 0, packet->size())}), length_(packet->size()), contiguous_data_(nullptr) {
+  UpdateContiguousData();
+}
 
 template <bool little_endian>
 Iterator<little_endian> PacketView<little_endian>::begin() const {
@@ -53,6 +57,9 @@ uint8_t PacketView<little_endian>::operator[](size_t index) const {
 template <bool little_endian>
 uint8_t PacketView<little_endian>::at(size_t index) const {
   ASSERT_LOG(index < length_, "Index %zu out of bounds", index);
+  if (contiguous_data_ != nullptr) {
+    return contiguous_data_[index];
+  }
   for (const auto& fragment : fragments_) {
     if (index < fragment.size()) {
       return fragment[index];
@@ -73,6 +80,10 @@ std::forward_list<View> PacketView<little_endian>::GetSubviewList(size_t begin,
   ASSERT(begin <= end);
   ASSERT(end <= length_);
 
+  if (contiguous_data_ != nullptr) {
+    return std::forward_list<View>({View(fragments_.front(), begin, end)});
+  }
+
   std::forward_list<View> view_list;
   std::forward_list<View>::iterator it = view_list.before_begin();
   size_t length = end - begin;
@@ -99,6 +110,15 @@ PacketView<false> PacketView<little_endian>::GetBigEndianSubview(size_t begin, s
   return PacketView<false>(GetSubviewList(begin, end));
 }
 
+template <bool little_endian>
+void PacketView<little_endian>::ForEachFragment(const std::function<void(const uint8_t*, size_t)>& on_fragment) const {
+  for (const auto& fragment : fragments_) {
+    if (fragment.size() != 0) {
+      on_fragment(fragment.data(), fragment.size());
+    }
+  }
+}
+
 template <bool little_endian>
 void PacketView<little_endian>::Append(PacketView to_add) {
   auto insertion_point = fragments_.begin();
@@ -115,6 +135,16 @@ void PacketView<little_endian>::Append(PacketView to_add) {
     insertion_point++;
   }
   length_ += to_add.length_;
+  UpdateContiguousData();
+}
+
+template <bool little_endian>
+void PacketView<little_endian>::UpdateContiguousData() {
+  if (!fragments_.empty() && std::next(fragments_.begin()) == fragments_.end()) {
+    contiguous_data_ = fragments_.front().data();
+  } else {
+    contiguous_data_ = nullptr;
+  }
 }
 
 // Explicit instantiations for both types of PacketViews.
@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <forward_list>
+#include <functional>
 
 #include "packet/iterator.h"
 #include "packet/view.h"
@@ -52,14 +53,20 @@ class PacketView {
 
   PacketView<false> GetBigEndianSubview(size_t begin, size_t end) const;
 
+  // Call |on_fragment| with the bytes of each fragment, in order.
+  void ForEachFragment(const std::function<void(const uint8_t*, size_t)>& on_fragment) const;
+
  protected:
   void Append(PacketView to_add);
 
  private:
   std::forward_list<View> fragments_;
   size_t length_;
+  // Bytes of the only fragment when this view is not fragmented, nullptr otherwise. Owned by fragments_.
+  const uint8_t* contiguous_data_;
   PacketView<little_endian>() = delete;
   std::forward_list<View> GetSubviewList(size_t begin, size_t end) const;
+  void UpdateContiguousData();
 };
 
 }  // namespace packet
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include <forward_list>
+#include <memory>
+#include <vector>
+
+#include "hci/hci_packets.h"
+#include "l2cap/l2cap_packets.h"
+#include "packet/bit_inserter.h"
+#include "packet/packet_view.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace packet {
+namespace {
+
+constexpr uint16_t kHandle = 0x0123;
+constexpr uint16_t kChannelId = 0x0040;
+constexpr size_t kNumPackets = 64;
+
+// Serialize an ACL packet carrying an L2CAP basic frame with |payload_size| bytes of payload
+std::shared_ptr<std::vector<uint8_t>> BuildAclBytes(size_t payload_size) {
+  auto payload = std::make_unique<RawBuilder>();
+  std::vector<uint8_t> payload_bytes(payload_size);
+  for (size_t i = 0; i < payload_size; i++) {
+    payload_bytes[i] = static_cast<uint8_t>(i);
+  }
+  payload->AddOctets(payload_bytes);
+  auto l2cap = l2cap::BasicFrameBuilder::Create(kChannelId, std::move(payload));
+  auto acl = hci::AclPacketBuilder::Create(kHandle, hci::PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE,
+                                           hci::BroadcastFlag::POINT_TO_POINT, std::move(l2cap));
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  bytes->reserve(acl->size());
+  BitInserter it(*bytes);
+  acl->Serialize(it);
+  return bytes;
+}
+
+// Parse the ACL and L2CAP headers, then read the whole L2CAP payload, as a receive path would
+uint32_t ParseAcl(PacketView<kLittleEndian> packet) {
+  auto acl = hci::AclPacketView::Create(packet);
+  if (!acl.IsValid() || acl.GetHandle() != kHandle) {
+    return 0;
+  }
+  auto l2cap = l2cap::BasicFrameView::Create(acl.GetPayload());
+  if (!l2cap.IsValid() || l2cap.GetChannelId() != kChannelId) {
+    return 0;
+  }
+  auto payload = l2cap.GetPayload();
+  uint32_t sum = 0;
+  auto it = payload.begin();
+  while (it.NumBytesRemaining() >= sizeof(uint32_t)) {
+    sum += it.extract<uint32_t>();
+  }
+  for (size_t i = payload.size() - it.NumBytesRemaining(); i < payload.size(); i++) {
+    sum += payload[i];
+  }
+  return sum;
+}
+
+void BM_ParseAcl(State& state, bool fragmented) {
+  size_t payload_size = state.range(0);
+  std::vector<PacketView<kLittleEndian>> packets;
+  for (size_t i = 0; i < kNumPackets; i++) {
+    auto bytes = BuildAclBytes(payload_size);
+    if (fragmented) {
+      // Split in the middle of the L2CAP payload, as if the packet had been received in two ACL fragments
+      size_t split = bytes->size() / 2;
+      packets.emplace_back(std::forward_list<View>({View(bytes, 0, split), View(bytes, split, bytes->size())}));
+    } else {
+      packets.emplace_back(bytes);
+    }
+  }
+
+  for (auto _ : state) {
+    for (const auto& packet : packets) {
+      benchmark::DoNotOptimize(ParseAcl(packet));
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * kNumPackets);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * kNumPackets * packets.front().size());
+}
+
+void BM_ParseAclSingleFragment(State& state) {
+  BM_ParseAcl(state, false);
+}
+
+void BM_ParseAclTwoFragments(State& state) {
+  BM_ParseAcl(state, true);
+}
+
+BENCHMARK(BM_ParseAclSingleFragment)->Arg(27)->Arg(251)->Arg(1021);
+BENCHMARK(BM_ParseAclTwoFragments)->Arg(27)->Arg(251)->Arg(1021);
+
+}  // namespace
+}  // namespace packet
+}  // namespace bluetooth
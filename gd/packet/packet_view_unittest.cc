@@ -535,6 +535,16 @@ TEST_F(PacketViewMultiViewTest, dereferenceTestBigEndian) {
   ASSERT_DEATH(*multi_itr, "");
 }
 
+TEST_F(PacketViewMultiViewTest, extractTest) {
+  auto single_itr = single_view.begin();
+  auto multi_itr = multi_view.begin();
+  // 32-bit reads that start in every fragment and cross both fragment boundaries
+  for (size_t i = 0; i + sizeof(uint32_t) <= single_view.size(); i += sizeof(uint32_t)) {
+    ASSERT_EQ(single_itr.extract<uint32_t>(), multi_itr.extract<uint32_t>());
+  }
+  ASSERT_EQ(single_itr, multi_itr);
+}
+
 TEST_F(PacketViewMultiViewTest, arrayOperatorTest) {
   for (size_t i = 0; i < single_view.size(); i++) {
     ASSERT_EQ(single_view[i], multi_view[i]);
@@ -209,8 +209,8 @@ void PacketDef::GenValidator(std::ostream& s) const {
       }
       s << started_field->GetDataType() << " checksum;";
       s << "checksum.Initialize();";
-      s << "for (uint8_t byte : checksum_view) { ";
-      s << "checksum.AddByte(byte);}";
+      s << "checksum_view.ForEachFragment([&checksum](const uint8_t* data, size_t length) {";
+      s << "checksum.AddBytes(data, length);});";
       s << "if (checksum.GetChecksum() != (begin() + end_sum_index).extract<"
         << util::GetTypeForSize(started_field->GetSize().bits()) << ">()) { return false; }";
 
@@ -35,6 +35,9 @@ class View {
 
   size_t size() const;
 
+  // Pointer to the first byte of this view. The bytes are contiguous and stay valid while the view exists.
+  const uint8_t* data() const;
+
  private:
   std::shared_ptr<const std::vector<uint8_t>> data_;
   size_t begin_;
@@ -161,6 +161,10 @@ class ConnectionInterface {
     return address_;
   }
 
+  void SetAclPriority(hci::AclPriority priority) {
+    channel_->SetAclPriority(priority);
+  }
+
  private:
   const ConnectionInterfaceDescriptor cid_;
   const std::unique_ptr<l2cap::classic::DynamicChannel> channel_;
@@ -191,6 +195,8 @@ class ConnectionInterfaceManager {
 
   bool Write(ConnectionInterfaceDescriptor cid, std::unique_ptr<packet::RawBuilder> packet);
 
+  bool SetAclPriority(hci::Address address, hci::AclPriority priority);
+
   size_t NumberOfActiveConnections() const {
     return cid_to_interface_map_.size();
   }
@@ -305,6 +311,17 @@ bool ConnectionInterfaceManager::Write(ConnectionInterfaceDescriptor cid, std::u
   return true;
 }
 
+bool ConnectionInterfaceManager::SetAclPriority(hci::Address address, hci::AclPriority priority) {
+  // The priority belongs to the ACL link, which any channel to the device reaches
+  for (auto& it : cid_to_interface_map_) {
+    if (it.second->GetRemoteAddress() == address) {
+      it.second->SetAclPriority(priority);
+      return true;
+    }
+  }
+  return false;
+}
+
 class PendingConnection {
  public:
   PendingConnection(ConnectionInterfaceDescriptor cid, l2cap::Psm psm, hci::Address address,
@@ -448,6 +465,8 @@ struct L2cap::impl {
 
   void Write(ConnectionInterfaceDescriptor cid, std::unique_ptr<packet::RawBuilder> packet);
 
+  void SetAclPriority(hci::Address address, hci::AclPriority priority, SetAclPriorityPromise promise);
+
   void SendLoopbackResponse(std::function<void()> function);
 
   void Dump(int fd);
@@ -630,6 +649,10 @@ void L2cap::impl::Write(ConnectionInterfaceDescriptor cid, std::unique_ptr<packe
   connection_interface_manager_.Write(cid, std::move(packet));
 }
 
+void L2cap::impl::SetAclPriority(hci::Address address, hci::AclPriority priority, SetAclPriorityPromise promise) {
+  promise.set_value(connection_interface_manager_.SetAclPriority(address, priority));
+}
+
 void L2cap::impl::SendLoopbackResponse(std::function<void()> function) {
   function();
 }
@@ -686,6 +709,15 @@ void L2cap::Write(uint16_t raw_cid, const uint8_t* data, size_t len) {
   GetHandler()->Post(common::BindOnce(&L2cap::impl::Write, common::Unretained(pimpl_.get()), cid, std::move(packet)));
 }
 
+void L2cap::SetAclPriority(const std::string address_string, bool high_priority, SetAclPriorityPromise promise) {
+  hci::Address address;
+  hci::Address::FromString(address_string, address);
+  hci::AclPriority priority = high_priority ? hci::AclPriority::HIGH : hci::AclPriority::NORMAL;
+
+  GetHandler()->Post(common::BindOnce(&L2cap::impl::SetAclPriority, common::Unretained(pimpl_.get()), address, priority,
+                                      std::move(promise)));
+}
+
 void L2cap::SendLoopbackResponse(std::function<void()> function) {
   GetHandler()->Post(common::BindOnce(&L2cap::impl::SendLoopbackResponse, common::Unretained(pimpl_.get()), function));
 }
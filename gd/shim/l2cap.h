@@ -34,6 +34,7 @@ using ReadDataReadyCallback = std::function<void(uint16_t cid, std::vector<const
 using RegisterServicePromise = std::promise<uint16_t>;
 using UnregisterServicePromise = std::promise<void>;
 using CreateConnectionPromise = std::promise<uint16_t>;
+using SetAclPriorityPromise = std::promise<bool>;
 
 class L2cap : public bluetooth::Module {
  public:
@@ -50,6 +51,9 @@ class L2cap : public bluetooth::Module {
 
   void Write(uint16_t cid, const uint8_t* data, size_t len);
 
+  // Resolves to false if there is no open connection to the device
+  void SetAclPriority(const std::string address_string, bool high_priority, SetAclPriorityPromise promise);
+
   void SendLoopbackResponse(std::function<void()>);
 
   L2cap() = default;
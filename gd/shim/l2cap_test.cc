@@ -65,6 +65,11 @@ class TestLink : public l2cap::internal::ILink {
     connection_closed_promise_.set_value();
   }
   std::promise<void> connection_closed_promise_;
+
+  void SetAclPriority(hci::AclPriority priority) {
+    acl_priority_promise_.set_value(priority);
+  }
+  std::promise<hci::AclPriority> acl_priority_promise_;
 };
 
 class TestDynamicChannelManagerImpl {
@@ -378,6 +383,47 @@ TEST_F(ShimL2capTest, ConnectOpen) {
   future.wait();
 }
 
+TEST_F(ShimL2capTest, SetAclPriority) {
+  SetConnectionFuture();
+  uint16_t cid = CreateConnection(kPsm, device_address);
+  ASSERT(cid != 0);
+  WaitConnectionFuture();
+
+  hci::Address address;
+  hci::Address::FromString(device_address, address);
+  test_link_.device_with_type_ = hci::AddressWithType(address, hci::AddressType::PUBLIC_DEVICE_ADDRESS);
+
+  std::shared_ptr<l2cap::internal::DynamicChannelImpl> impl =
+      std::make_shared<l2cap::internal::DynamicChannelImpl>(kPsm, kCid, kCid2, &test_link_, handler_);
+  auto channel = std::make_unique<l2cap::DynamicChannel>(impl, handler_);
+
+  std::promise<void> on_open_promise;
+  auto on_open_future = on_open_promise.get_future();
+  auto connection_complete_future = connection_complete_promise_.get_future();
+  handler_->Post(common::BindOnce(&TestDynamicChannelManagerImpl::SetConnectionOnOpen,
+                                  common::Unretained(test_l2cap_classic_module_->impl_.get()), std::move(channel),
+                                  std::move(on_open_promise)));
+  connection_complete_future.wait();
+  on_open_future.wait();
+
+  // No connection to the other device
+  SetAclPriorityPromise no_link_promise;
+  auto no_link_future = no_link_promise.get_future();
+  shim_l2cap_->SetAclPriority(device_address2, true, std::move(no_link_promise));
+  ASSERT(no_link_future.get() == false);
+
+  auto priority_future = test_link_.acl_priority_promise_.get_future();
+  SetAclPriorityPromise promise;
+  auto future = promise.get_future();
+  shim_l2cap_->SetAclPriority(device_address, true, std::move(promise));
+  ASSERT(future.get() == true);
+  ASSERT(priority_future.get() == hci::AclPriority::HIGH);
+
+  auto closed_future = test_link_.connection_closed_promise_.get_future();
+  shim_l2cap_->CloseConnection(cid);
+  closed_future.wait();
+}
+
 TEST_F(ShimL2capTest, RegisterService_Success) {
   std::promise<uint16_t> registration_promise;
   auto registration_pending = registration_promise.get_future();
@@ -0,0 +1,68 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Lock-free single-producer/single-consumer ring of variable length records,
+// used to hand snoop log records from the HCI thread to the snoop writer
+// thread. Only one thread may push and only one thread may pop at a time;
+// callers with several producers must serialize them.
+
+typedef struct btsnoop_ring_t btsnoop_ring_t;
+
+typedef enum {
+  // Discard the oldest records to make room for a new one.
+  BTSNOOP_RING_DROP_OLDEST,
+  // Block the producer until the consumer has made room.
+  BTSNOOP_RING_BLOCK,
+} btsnoop_ring_overflow_t;
+
+// Creates a ring holding up to |capacity| bytes of records. Returns NULL on
+// failure. The returned ring must be freed with |btsnoop_ring_free|.
+btsnoop_ring_t* btsnoop_ring_new(size_t capacity,
+                                 btsnoop_ring_overflow_t overflow);
+
+// Frees |ring|. Safe to call with NULL.
+void btsnoop_ring_free(btsnoop_ring_t* ring);
+
+// Producer side. Appends one record made of |header| followed by |payload|.
+// Returns false, and counts the record as dropped, if it can never fit.
+bool btsnoop_ring_push(btsnoop_ring_t* ring, const void* header,
+                       size_t header_length, const void* payload,
+                       size_t payload_length);
+
+// Consumer side. Copies up to |max_records| whole records, back to back, into
+// |buffer| without exceeding |size| bytes and removes them from the ring.
+// Returns the number of bytes copied; |*record_count| is set to the number of
+// records copied.
+size_t btsnoop_ring_pop(btsnoop_ring_t* ring, uint8_t* buffer, size_t size,
+                        size_t max_records, size_t* record_count);
+
+// Consumer side. Blocks until the ring is not empty or |btsnoop_ring_wake|
+// is called. May return spuriously.
+void btsnoop_ring_wait(btsnoop_ring_t* ring);
+
+// Wakes up a consumer blocked in |btsnoop_ring_wait|.
+void btsnoop_ring_wake(btsnoop_ring_t* ring);
+
+// Returns the number of records dropped because the ring overflowed.
+uint64_t btsnoop_ring_dropped_count(const btsnoop_ring_t* ring);
@@ -31,11 +31,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/prctl.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/uio.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -43,6 +48,7 @@
 #include "common/time_util.h"
 #include "hci/include/btsnoop.h"
 #include "hci/include/btsnoop_mem.h"
+#include "hci/include/btsnoop_ring.h"
 #include "hci_layer.h"
 #include "internal_include/bt_trace.h"
 #include "osi/include/log.h"
@@ -70,6 +76,19 @@
 #define DEFAULT_BTSNOOP_PATH "/data/misc/bluetooth/logs/btsnoop_hci.log"
 #define BTSNOOP_MAX_PACKETS_PROPERTY "persist.bluetooth.btsnoopsize"
 
+// Records are handed from |capture| to the writer thread through a ring of
+// this many bytes. When the ring is full, the oldest records are dropped
+// unless the overflow policy is set to "block".
+#define BTSNOOP_BUFFER_SIZE_PROPERTY "persist.bluetooth.btsnoopbuffersize"
+#define DEFAULT_BTSNOOP_BUFFER_SIZE (1024 * 1024)
+#define BTSNOOP_OVERFLOW_PROPERTY "persist.bluetooth.btsnoopoverflow"
+#define BTSNOOP_OVERFLOW_DROP_OLDEST "drop_oldest"
+#define BTSNOOP_OVERFLOW_BLOCK "block"
+
+// Size of the buffer the writer thread collects records in before writing
+// them out. Must hold at least one maximum size record.
+#define BTSNOOP_WRITE_BATCH_SIZE (128 * 1024)
+
 typedef enum {
   kCommandPacket = 1,
   kAclPacket = 2,
@@ -96,6 +115,13 @@ static std::mutex btsnoop_mutex;
 static int32_t packets_per_file;
 static int32_t packet_counter;
 
+// Log file writes happen on |writer_thread|; |capture| only queues records.
+static btsnoop_ring_t* snoop_ring;
+static std::thread writer_thread;
+static std::atomic<bool> writer_running;
+static uint64_t records_written;
+static uint64_t batches_written;
+
 // Channel tracking variables for filtering.
 
 // Keeps track of L2CAP channels that need to be filtered out of the snoop
@@ -171,6 +197,8 @@ static std::string get_btsnoop_last_log_path(std::string log_path);
 static void open_next_snoop_file();
 static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
                                  bool is_received, uint64_t timestamp_us);
+static void start_writer();
+static void stop_writer();
 
 // Module lifecycle functions
 
@@ -216,6 +244,7 @@ static future_t* start_up() {
     packets_per_file = osi_property_get_int32(BTSNOOP_MAX_PACKETS_PROPERTY,
                                               DEFAULT_BTSNOOP_SIZE);
     btsnoop_net_open();
+    if (logfile_fd != INVALID_FD) start_writer();
   }
 
   return NULL;
@@ -224,6 +253,8 @@ static future_t* start_up() {
 static future_t* shut_down(void) {
   std::lock_guard<std::mutex> lock(btsnoop_mutex);
 
+  stop_writer();
+
   if (is_btsnoop_enabled) {
     if (is_btsnoop_filtered) {
       delete_btsnoop_files(false);
@@ -264,7 +295,7 @@ static void capture(const BT_HDR* buffer, bool is_received) {
 
   btsnoop_mem_capture(buffer, timestamp_us);
 
-  if (logfile_fd == INVALID_FD) return;
+  if (snoop_ring == NULL) return;
 
   switch (buffer->event & MSG_EVT_MASK) {
     case MSG_HC_TO_STACK_HCI_EVT:
@@ -463,21 +494,100 @@ static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
       blacklisted ? htonl(L2C_HEADER_SIZE) : header.length_original;
   if (blacklisted) length_he = L2C_HEADER_SIZE;
   header.flags = htonl(flags);
-  header.dropped_packets = 0;
+  header.dropped_packets = htonl(btsnoop_ring_dropped_count(snoop_ring));
   header.timestamp = htonll(timestamp_us + BTSNOOP_EPOCH_DELTA);
   header.type = type;
 
-  btsnoop_net_write(&header, sizeof(btsnoop_header_t));
-  btsnoop_net_write(packet, length_he - 1);
+  btsnoop_ring_push(snoop_ring, &header, sizeof(btsnoop_header_t), packet,
+                    length_he - 1);
+}
 
-  if (logfile_fd != INVALID_FD) {
-    packet_counter++;
-    if (packet_counter > packets_per_file) {
-      open_next_snoop_file();
+// Writes |length| bytes of back to back records from |data| to the log file,
+// retrying on short writes.
+static void write_records(const uint8_t* data, size_t length) {
+  while (length > 0) {
+    iovec iov = {const_cast<uint8_t*>(data), length};
+    ssize_t ret = TEMP_FAILURE_RETRY(writev(logfile_fd, &iov, 1));
+    if (ret <= 0) {
+      LOG(ERROR) << __func__ << ": unable to write snoop log: "
+                 << strerror(errno);
+      return;
     }
+    data += ret;
+    length -= ret;
+  }
+}
 
-    iovec iov[] = {{&header, sizeof(btsnoop_header_t)},
-                   {reinterpret_cast<void*>(packet), length_he - 1}};
-    TEMP_FAILURE_RETRY(writev(logfile_fd, iov, 2));
+// Runs on |writer_thread|. Drains the ring in batches, rotating the log file
+// every |packets_per_file| records.
+static void writer_loop() {
+  prctl(PR_SET_NAME, (unsigned long)"bt_snoop_writer", 0, 0, 0);
+
+  std::unique_ptr<uint8_t[]> batch(new uint8_t[BTSNOOP_WRITE_BATCH_SIZE]);
+  bool running = true;
+  while (running) {
+    btsnoop_ring_wait(snoop_ring);
+    // Drain whatever is left before exiting.
+    running = writer_running.load();
+
+    while (true) {
+      size_t max_records = std::max(packets_per_file - packet_counter, 1);
+      size_t record_count = 0;
+      size_t length =
+          btsnoop_ring_pop(snoop_ring, batch.get(), BTSNOOP_WRITE_BATCH_SIZE,
+                           max_records, &record_count);
+      if (record_count == 0) break;
+
+      btsnoop_net_write(batch.get(), length);
+      if (logfile_fd != INVALID_FD) write_records(batch.get(), length);
+
+      records_written += record_count;
+      batches_written++;
+      packet_counter += record_count;
+      if (packet_counter >= packets_per_file) open_next_snoop_file();
+    }
   }
 }
+
+// NOTE: must be called with |btsnoop_mutex| held
+static void start_writer() {
+  int buffer_size = osi_property_get_int32(BTSNOOP_BUFFER_SIZE_PROPERTY,
+                                           DEFAULT_BTSNOOP_BUFFER_SIZE);
+  if (buffer_size < BTSNOOP_WRITE_BATCH_SIZE)
+    buffer_size = BTSNOOP_WRITE_BATCH_SIZE;
+
+  std::array<char, PROPERTY_VALUE_MAX> property = {};
+  int len = osi_property_get(BTSNOOP_OVERFLOW_PROPERTY, property.data(),
+                             BTSNOOP_OVERFLOW_DROP_OLDEST);
+  btsnoop_ring_overflow_t overflow =
+      std::string(property.data(), len) == BTSNOOP_OVERFLOW_BLOCK
+          ? BTSNOOP_RING_BLOCK
+          : BTSNOOP_RING_DROP_OLDEST;
+
+  snoop_ring = btsnoop_ring_new(buffer_size, overflow);
+  if (snoop_ring == NULL) {
+    LOG(ERROR) << __func__ << ": unable to allocate snoop ring";
+    return;
+  }
+
+  records_written = 0;
+  batches_written = 0;
+  writer_running = true;
+  writer_thread = std::thread(writer_loop);
+}
+
+// NOTE: must be called with |btsnoop_mutex| held
+static void stop_writer() {
+  if (snoop_ring == NULL) return;
+
+  writer_running = false;
+  btsnoop_ring_wake(snoop_ring);
+  writer_thread.join();
+
+  LOG(INFO) << __func__ << ": wrote " << records_written << " records in "
+            << batches_written << " batches, dropped "
+            << btsnoop_ring_dropped_count(snoop_ring);
+
+  btsnoop_ring_free(snoop_ring);
+  snoop_ring = NULL;
+}
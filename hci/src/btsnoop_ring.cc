@@ -0,0 +1,209 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "hci/include/btsnoop_ring.h"
+
+#include <base/logging.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "osi/include/allocator.h"
+#include "osi/include/semaphore.h"
+
+// Every record is stored as a 32 bit length followed by its bytes. Records
+// may wrap around the end of the buffer.
+typedef uint32_t record_length_t;
+
+struct btsnoop_ring_t {
+  uint8_t* buffer;
+  size_t capacity;
+  btsnoop_ring_overflow_t overflow;
+
+  // Positions are free running byte counters; only the producer advances
+  // |head|. |tail| is advanced by the consumer, and also by the producer when
+  // it drops the oldest records.
+  std::atomic<uint64_t> head;
+  std::atomic<uint64_t> tail;
+  std::atomic<uint64_t> dropped_count;
+
+  // Wakeups are only signalled when the other side said it is about to sleep.
+  std::atomic<bool> consumer_waiting;
+  std::atomic<bool> producer_waiting;
+  semaphore_t* data_available;
+  semaphore_t* space_available;
+};
+
+static void copy_in(btsnoop_ring_t* ring, uint64_t position, const void* data,
+                    size_t length) {
+  size_t index = position % ring->capacity;
+  size_t first = std::min(length, ring->capacity - index);
+  memcpy(ring->buffer + index, data, first);
+  memcpy(ring->buffer, static_cast<const uint8_t*>(data) + first,
+         length - first);
+}
+
+static void copy_out(const btsnoop_ring_t* ring, uint64_t position, void* data,
+                     size_t length) {
+  size_t index = position % ring->capacity;
+  size_t first = std::min(length, ring->capacity - index);
+  memcpy(data, ring->buffer + index, first);
+  memcpy(static_cast<uint8_t*>(data) + first, ring->buffer, length - first);
+}
+
+btsnoop_ring_t* btsnoop_ring_new(size_t capacity,
+                                 btsnoop_ring_overflow_t overflow) {
+  CHECK(capacity > sizeof(record_length_t));
+
+  btsnoop_ring_t* ring = new btsnoop_ring_t();
+  ring->buffer = static_cast<uint8_t*>(osi_malloc(capacity));
+  ring->capacity = capacity;
+  ring->overflow = overflow;
+  ring->data_available = semaphore_new(0);
+  ring->space_available = semaphore_new(0);
+  if (ring->data_available == NULL || ring->space_available == NULL) {
+    btsnoop_ring_free(ring);
+    return NULL;
+  }
+  return ring;
+}
+
+void btsnoop_ring_free(btsnoop_ring_t* ring) {
+  if (ring == NULL) return;
+  semaphore_free(ring->data_available);
+  semaphore_free(ring->space_available);
+  osi_free(ring->buffer);
+  delete ring;
+}
+
+// Makes room for |needed| bytes at |head|, according to the overflow policy.
+static void reserve(btsnoop_ring_t* ring, uint64_t head, size_t needed) {
+  while (true) {
+    uint64_t tail = ring->tail.load();
+    if (head - tail + needed <= ring->capacity) return;
+
+    if (ring->overflow == BTSNOOP_RING_DROP_OLDEST) {
+      // Only the producer writes record bytes, so reading the length of the
+      // oldest record here cannot race with anything.
+      record_length_t length;
+      copy_out(ring, tail, &length, sizeof(length));
+      if (ring->tail.compare_exchange_strong(tail,
+                                             tail + sizeof(length) + length))
+        ring->dropped_count++;
+      continue;
+    }
+
+    ring->producer_waiting.store(true);
+    if (head - ring->tail.load() + needed <= ring->capacity) {
+      ring->producer_waiting.store(false);
+      return;
+    }
+    semaphore_wait(ring->space_available);
+  }
+}
+
+bool btsnoop_ring_push(btsnoop_ring_t* ring, const void* header,
+                       size_t header_length, const void* payload,
+                       size_t payload_length) {
+  CHECK(ring != NULL);
+
+  record_length_t length = header_length + payload_length;
+  size_t needed = sizeof(length) + length;
+  if (needed > ring->capacity) {
+    ring->dropped_count++;
+    return false;
+  }
+
+  uint64_t head = ring->head.load(std::memory_order_relaxed);
+  reserve(ring, head, needed);
+
+  copy_in(ring, head, &length, sizeof(length));
+  copy_in(ring, head + sizeof(length), header, header_length);
+  copy_in(ring, head + sizeof(length) + header_length, payload,
+          payload_length);
+  ring->head.store(head + needed);
+
+  if (ring->consumer_waiting.exchange(false))
+    semaphore_post(ring->data_available);
+  return true;
+}
+
+size_t btsnoop_ring_pop(btsnoop_ring_t* ring, uint8_t* buffer, size_t size,
+                        size_t max_records, size_t* record_count) {
+  CHECK(ring != NULL);
+  CHECK(record_count != NULL);
+
+  while (true) {
+    uint64_t tail = ring->tail.load();
+    uint64_t head = ring->head.load();
+    uint64_t position = tail;
+    size_t copied = 0;
+    size_t records = 0;
+
+    while (position < head && records < max_records) {
+      record_length_t length;
+      copy_out(ring, position, &length, sizeof(length));
+      // With BTSNOOP_RING_DROP_OLDEST the producer may be overwriting what we
+      // read; the length is only trusted once |tail| is known to be unchanged.
+      if (position + sizeof(length) + length > head) break;
+      if (copied + length > size) break;
+      copy_out(ring, position + sizeof(length), buffer + copied, length);
+      copied += length;
+      position += sizeof(length) + length;
+      records++;
+    }
+
+    if (position == tail) {
+      *record_count = 0;
+      return 0;
+    }
+
+    if (!ring->tail.compare_exchange_strong(tail, position)) {
+      // The producer dropped records we were copying; start over.
+      continue;
+    }
+
+    if (ring->producer_waiting.exchange(false))
+      semaphore_post(ring->space_available);
+
+    *record_count = records;
+    return copied;
+  }
+}
+
+void btsnoop_ring_wait(btsnoop_ring_t* ring) {
+  CHECK(ring != NULL);
+
+  ring->consumer_waiting.store(true);
+  if (ring->head.load() != ring->tail.load()) {
+    ring->consumer_waiting.store(false);
+    return;
+  }
+  semaphore_wait(ring->data_available);
+}
+
+void btsnoop_ring_wake(btsnoop_ring_t* ring) {
+  CHECK(ring != NULL);
+  semaphore_post(ring->data_available);
+}
+
+uint64_t btsnoop_ring_dropped_count(const btsnoop_ring_t* ring) {
+  CHECK(ring != NULL);
+  return ring->dropped_count.load(std::memory_order_relaxed);
+}
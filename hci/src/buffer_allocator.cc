@@ -20,12 +20,13 @@
 
 #include "bt_common.h"
 #include "buffer_allocator.h"
+#include "osi/include/buffer_pool.h"
 
 static void* buffer_alloc(size_t size) {
   CHECK(size <= BT_DEFAULT_BUFFER_SIZE);
-  return osi_malloc(size);
+  return buffer_pool_alloc(size);
 }
 
-static const allocator_t interface = {buffer_alloc, osi_free};
+static const allocator_t interface = {buffer_alloc, buffer_pool_free};
 
 const allocator_t* buffer_allocator_get_interface() { return &interface; }
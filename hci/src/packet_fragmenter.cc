@@ -51,13 +51,30 @@ static const allocator_t* buffer_allocator;
 static const controller_t* controller;
 static const packet_fragmenter_callbacks_t* callbacks;
 
-static std::unordered_map<uint16_t /* handle */, BT_HDR*> partial_packets;
+// A packet being reassembled. The fragments are copied into a buffer of the
+// full length as they arrive, so that each of them is released right away.
+typedef struct {
+  BT_HDR* packet;
+  uint16_t full_length;
+  uint16_t received_length;
+} partial_packet_t;
+
+static std::unordered_map<uint16_t /* handle */, partial_packet_t>
+    partial_packets;
 
 static void init(const packet_fragmenter_callbacks_t* result_callbacks) {
   callbacks = result_callbacks;
 }
 
-static void cleanup() { partial_packets.clear(); }
+static void free_partial_packet(const partial_packet_t& partial_packet) {
+  buffer_allocator->free(partial_packet.packet);
+}
+
+static void cleanup() {
+  for (auto& partial_packet : partial_packets)
+    free_partial_packet(partial_packet.second);
+  partial_packets.clear();
+}
 
 static void fragment_and_dispatch(BT_HDR* packet) {
   CHECK(packet != NULL);
@@ -158,9 +175,9 @@ static void reassemble_and_dispatch(BT_HDR* packet) {
                  "Dropping old.",
                  __func__);
 
-        BT_HDR* hdl = map_iter->second;
+        partial_packet_t partial_packet = map_iter->second;
         partial_packets.erase(map_iter);
-        buffer_allocator->free(hdl);
+        free_partial_packet(partial_packet);
       }
 
       if (acl_length < L2CAP_HEADER_PDU_LEN_SIZE) {
@@ -194,19 +211,19 @@ static void reassemble_and_dispatch(BT_HDR* packet) {
         return;
       }
 
-      BT_HDR* partial_packet =
-          (BT_HDR*)buffer_allocator->alloc(full_length + sizeof(BT_HDR));
-      partial_packet->event = packet->event;
-      partial_packet->len = full_length;
-      partial_packet->offset = packet->len;
-
-      memcpy(partial_packet->data, packet->data, packet->len);
-
       // Update the ACL data size to indicate the full expected length
-      stream = partial_packet->data;
+      stream = packet->data;
       STREAM_SKIP_UINT16(stream);  // skip the handle
       UINT16_TO_STREAM(stream, full_length - HCI_ACL_PREAMBLE_SIZE);
 
+      partial_packet_t partial_packet = {NULL, full_length, packet->len};
+      partial_packet.packet =
+          (BT_HDR*)buffer_allocator->alloc(full_length + sizeof(BT_HDR));
+      partial_packet.packet->event = packet->event;
+      partial_packet.packet->len = full_length;
+      partial_packet.packet->offset = 0;
+      partial_packet.packet->layer_specific = packet->layer_specific;
+      memcpy(partial_packet.packet->data, packet->data, packet->len);
       partial_packets[handle] = partial_packet;
 
       // Free the old packet buffer, since we don't need it anymore
@@ -220,32 +237,33 @@ static void reassemble_and_dispatch(BT_HDR* packet) {
         buffer_allocator->free(packet);
         return;
       }
-      BT_HDR* partial_packet = map_iter->second;
+      partial_packet_t& partial_packet = map_iter->second;
 
+      // Only the payload after the ACL preamble belongs to the packet
       packet->offset = HCI_ACL_PREAMBLE_SIZE;
-      uint16_t projected_offset =
-          partial_packet->offset + (packet->len - HCI_ACL_PREAMBLE_SIZE);
-      if ((packet->len - packet->offset) >
-          (partial_packet->len - partial_packet->offset)) {
+      packet->len -= HCI_ACL_PREAMBLE_SIZE;
+      uint16_t remaining_length =
+          partial_packet.full_length - partial_packet.received_length;
+      if (packet->len > remaining_length) {
         LOG_WARN(LOG_TAG,
                  "%s got packet which would exceed expected length of %d. "
                  "Truncating.",
-                 __func__, partial_packet->len);
-        packet->len = (partial_packet->len - partial_packet->offset) + packet->offset;
-        projected_offset = partial_packet->len;
+                 __func__, partial_packet.full_length);
+        packet->len = remaining_length;
       }
+      uint16_t fragment_length = packet->len;
 
-      memcpy(partial_packet->data + partial_packet->offset,
-             packet->data + packet->offset, packet->len - packet->offset);
+      memcpy(partial_packet.packet->data + partial_packet.received_length,
+             packet->data + packet->offset, fragment_length);
 
       // Free the old packet buffer, since we don't need it anymore
       buffer_allocator->free(packet);
-      partial_packet->offset = projected_offset;
+      partial_packet.received_length += fragment_length;
 
-      if (partial_packet->offset == partial_packet->len) {
-        partial_packets.erase(handle);
-        partial_packet->offset = 0;
-        callbacks->reassembled(partial_packet);
+      if (partial_packet.received_length == partial_packet.full_length) {
+        BT_HDR* complete = partial_packet.packet;
+        partial_packets.erase(map_iter);
+        callbacks->reassembled(complete);
       }
     }
   } else {
@@ -0,0 +1,155 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+#include "hci/include/btsnoop_ring.h"
+
+class BtsnoopRingTest : public AllocationTestHarness {};
+
+// Pushes a record made of a 4 byte |id| followed by |length| bytes of |id|.
+static bool push_record(btsnoop_ring_t* ring, uint32_t id, size_t length) {
+  std::vector<uint8_t> payload(length, static_cast<uint8_t>(id));
+  return btsnoop_ring_push(ring, &id, sizeof(id), payload.data(), length);
+}
+
+TEST_F(BtsnoopRingTest, test_new_free) {
+  btsnoop_ring_t* ring = btsnoop_ring_new(1024, BTSNOOP_RING_DROP_OLDEST);
+  ASSERT_TRUE(ring != NULL);
+  EXPECT_EQ(0u, btsnoop_ring_dropped_count(ring));
+  btsnoop_ring_free(ring);
+}
+
+TEST_F(BtsnoopRingTest, test_free_null) { btsnoop_ring_free(NULL); }
+
+TEST_F(BtsnoopRingTest, test_pop_empty) {
+  btsnoop_ring_t* ring = btsnoop_ring_new(1024, BTSNOOP_RING_DROP_OLDEST);
+  uint8_t buffer[64];
+  size_t record_count = 1;
+  EXPECT_EQ(0u, btsnoop_ring_pop(ring, buffer, sizeof(buffer), 10,
+                                 &record_count));
+  EXPECT_EQ(0u, record_count);
+  btsnoop_ring_free(ring);
+}
+
+TEST_F(BtsnoopRingTest, test_push_pop_batch) {
+  btsnoop_ring_t* ring = btsnoop_ring_new(1024, BTSNOOP_RING_DROP_OLDEST);
+  for (uint32_t id = 0; id < 10; id++) EXPECT_TRUE(push_record(ring, id, id));
+
+  uint8_t buffer[1024];
+  size_t record_count = 0;
+  size_t length =
+      btsnoop_ring_pop(ring, buffer, sizeof(buffer), 100, &record_count);
+  EXPECT_EQ(10u, record_count);
+  EXPECT_EQ(10 * sizeof(uint32_t) + 45, length);
+
+  size_t offset = 0;
+  for (uint32_t id = 0; id < 10; id++) {
+    uint32_t read_id;
+    memcpy(&read_id, buffer + offset, sizeof(read_id));
+    EXPECT_EQ(id, read_id);
+    offset += sizeof(read_id);
+    for (uint32_t i = 0; i < id; i++) EXPECT_EQ(id, buffer[offset + i]);
+    offset += id;
+  }
+  btsnoop_ring_free(ring);
+}
+
+TEST_F(BtsnoopRingTest, test_pop_max_records) {
+  btsnoop_ring_t* ring = btsnoop_ring_new(1024, BTSNOOP_RING_DROP_OLDEST);
+  for (uint32_t id = 0; id < 10; id++) push_record(ring, id, 8);
+
+  uint8_t buffer[1024];
+  size_t record_count = 0;
+  btsnoop_ring_pop(ring, buffer, sizeof(buffer), 3, &record_count);
+  EXPECT_EQ(3u, record_count);
+  btsnoop_ring_pop(ring, buffer, sizeof(buffer), 100, &record_count);
+  EXPECT_EQ(7u, record_count);
+  btsnoop_ring_free(ring);
+}
+
+TEST_F(BtsnoopRingTest, test_drop_oldest) {
+  // Each record takes 4 (length) + 4 (id) + 56 bytes = 64 bytes.
+  btsnoop_ring_t* ring = btsnoop_ring_new(256, BTSNOOP_RING_DROP_OLDEST);
+  for (uint32_t id = 0; id < 6; id++) EXPECT_TRUE(push_record(ring, id, 56));
+  EXPECT_EQ(2u, btsnoop_ring_dropped_count(ring));
+
+  uint8_t buffer[256];
+  size_t record_count = 0;
+  btsnoop_ring_pop(ring, buffer, sizeof(buffer), 100, &record_count);
+  EXPECT_EQ(4u, record_count);
+  uint32_t first_id;
+  memcpy(&first_id, buffer, sizeof(first_id));
+  EXPECT_EQ(2u, first_id);
+  btsnoop_ring_free(ring);
+}
+
+TEST_F(BtsnoopRingTest, test_too_large_record) {
+  btsnoop_ring_t* ring = btsnoop_ring_new(64, BTSNOOP_RING_BLOCK);
+  EXPECT_FALSE(push_record(ring, 1, 64));
+  EXPECT_EQ(1u, btsnoop_ring_dropped_count(ring));
+  btsnoop_ring_free(ring);
+}
+
+// Streams records through a small ring from a producer thread and checks that
+// nothing is lost or reordered when the producer blocks.
+TEST_F(BtsnoopRingTest, test_block_threaded) {
+  const uint32_t kRecords = 10000;
+  btsnoop_ring_t* ring = btsnoop_ring_new(512, BTSNOOP_RING_BLOCK);
+  std::atomic<bool> done(false);
+
+  std::thread producer([ring, &done]() {
+    for (uint32_t id = 0; id < kRecords; id++) push_record(ring, id, id % 100);
+    done = true;
+    btsnoop_ring_wake(ring);
+  });
+
+  uint8_t buffer[512];
+  uint32_t expected_id = 0;
+  while (true) {
+    btsnoop_ring_wait(ring);
+    bool finished = done;
+    size_t record_count;
+    size_t length;
+    while ((length = btsnoop_ring_pop(ring, buffer, sizeof(buffer), 100,
+                                      &record_count)) > 0) {
+      size_t offset = 0;
+      for (size_t i = 0; i < record_count; i++) {
+        uint32_t id;
+        memcpy(&id, buffer + offset, sizeof(id));
+        EXPECT_EQ(expected_id++, id);
+        offset += sizeof(id) + id % 100;
+      }
+      EXPECT_EQ(length, offset);
+    }
+    if (finished) break;
+  }
+  producer.join();
+
+  EXPECT_EQ(kRecords, expected_id);
+  EXPECT_EQ(0u, btsnoop_ring_dropped_count(ring));
+  btsnoop_ring_free(ring);
+}
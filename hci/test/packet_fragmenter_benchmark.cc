@@ -0,0 +1,126 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "buffer_allocator.h"
+#include "hci_internals.h"
+#include "osi/include/allocator.h"
+#include "packet_fragmenter.h"
+
+using ::benchmark::State;
+
+// Needed for linkage
+const controller_t* controller_get_interface() { return nullptr; }
+
+namespace {
+
+constexpr uint16_t kHandle = 0x0040;
+constexpr uint16_t kCid = 0x0044;
+constexpr size_t kL2capHeaderSize = 4;
+
+const packet_fragmenter_t* g_fragmenter;
+const allocator_t* g_allocator;
+size_t g_reassembled_bytes;
+
+void OnFragmented(BT_HDR* packet, bool send_transmit_finished) {}
+
+void OnTransmitFinished(BT_HDR* packet, bool all_fragments_sent) {}
+
+void OnReassembled(BT_HDR* packet) {
+  g_reassembled_bytes += packet->len;
+  g_allocator->free(packet);
+}
+
+const packet_fragmenter_callbacks_t kCallbacks = {
+    OnFragmented, OnReassembled, OnTransmitFinished};
+
+BT_HDR* MakeFragment(bool start, const uint8_t* payload, uint16_t length) {
+  BT_HDR* packet = static_cast<BT_HDR*>(
+      g_allocator->alloc(sizeof(BT_HDR) + HCI_ACL_PREAMBLE_SIZE + length));
+  packet->event = MSG_HC_TO_STACK_HCI_ACL;
+  packet->offset = 0;
+  packet->layer_specific = 0;
+  packet->len = HCI_ACL_PREAMBLE_SIZE + length;
+  uint8_t* stream = packet->data;
+  UINT16_TO_STREAM(stream, kHandle | (start ? 0x2000 : 0x1000));
+  UINT16_TO_STREAM(stream, length);
+  memcpy(stream, payload, length);
+  return packet;
+}
+
+// Feeds one L2CAP PDU of |sdu_size| bytes through the fragmenter, split into
+// controller fragments of |fragment_size| bytes.
+void FeedPdu(const std::vector<uint8_t>& pdu, size_t fragment_size) {
+  for (size_t offset = 0; offset < pdu.size(); offset += fragment_size) {
+    uint16_t length = std::min(fragment_size, pdu.size() - offset);
+    g_fragmenter->reassemble_and_dispatch(
+        MakeFragment(offset == 0, pdu.data() + offset, length));
+  }
+}
+
+std::vector<uint8_t> MakePdu(size_t sdu_size) {
+  std::vector<uint8_t> pdu(kL2capHeaderSize + sdu_size);
+  uint8_t* stream = pdu.data();
+  UINT16_TO_STREAM(stream, sdu_size);
+  UINT16_TO_STREAM(stream, kCid);
+  for (size_t i = 0; i < sdu_size; i++) *stream++ = i;
+  return pdu;
+}
+
+void RunReassembly(State& state) {
+  g_allocator = buffer_allocator_get_interface();
+  g_fragmenter = packet_fragmenter_get_test_interface(nullptr, g_allocator);
+  g_fragmenter->init(&kCallbacks);
+  g_reassembled_bytes = 0;
+
+  const std::vector<uint8_t> pdu = MakePdu(state.range(0));
+  for (auto _ : state) {
+    FeedPdu(pdu, state.range(1));
+  }
+  g_fragmenter->cleanup();
+
+  state.SetBytesProcessed(g_reassembled_bytes);
+  state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+// Arguments: L2CAP SDU size, controller fragment size
+static void BM_Reassemble(State& state) { RunReassembly(state); }
+BENCHMARK(BM_Reassemble)
+    ->Args({1017, 27})
+    ->Args({1017, 251})
+    ->Args({1017, 1021})
+    ->Args({4000, 1021});
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
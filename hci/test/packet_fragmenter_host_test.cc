@@ -212,11 +212,9 @@ class HciPacketFragmenterTest : public AllocationTestHarness {
   }
 
   void FlushPartialPackets() const {
-    while (!partial_packets.empty()) {
-      BT_HDR* partial_packet = partial_packets.at(kHandle);
-      partial_packets.erase(kHandle);
-      osi_free(partial_packet);
-    }
+    for (auto& partial_packet : partial_packets)
+      free_partial_packet(partial_packet.second);
+    partial_packets.clear();
   }
 };
 
@@ -419,3 +417,20 @@ TEST_F(HciPacketFragmenterTest, TwoPacket_HugeBogusSecond) {
   CHECK(partial_packets.size() == 0);
   CHECK(test_state_.reassembled.access_count_ == 1);
 }
+
+TEST_F(HciPacketFragmenterTest, TwoPacket_SecondStartDropsFirst) {
+  const size_t packet_size = 512;
+  const std::vector<uint8_t> data = CreateData(packet_size);
+  const std::vector<uint8_t> first_part(data.cbegin(),
+                                        data.cbegin() + packet_size / 2);
+  reassemble_and_dispatch(AllocateL2capPacket(data.size(), first_part));
+  CHECK(partial_packets.size() == 1);
+
+  // The second start replaces the first packet, which is left partial until
+  // the fixture flushes it
+  reassemble_and_dispatch(AllocateL2capPacket(data.size(), first_part));
+  CHECK(partial_packets.size() == 1);
+  CHECK(partial_packets.at(kHandle).received_length ==
+        sizeof(AclL2capPacketHeader) + packet_size / 2);
+  CHECK(test_state_.reassembled.access_count_ == 0);
+}
@@ -300,9 +300,15 @@
 #define BTM_SCO_DATA_SIZE_MAX 240
 #endif
 
-/* The size in bytes of the BTM inquiry database. */
+/* The number of entries of the BTM inquiry database. */
 #ifndef BTM_INQ_DB_SIZE
-#define BTM_INQ_DB_SIZE 40
+#define BTM_INQ_DB_SIZE 128
+#endif
+
+/* Entries of the BTM inquiry database without a response for this long are
+ * freed when the database is full. */
+#ifndef BTM_INQ_DB_TTL_MS
+#define BTM_INQ_DB_TTL_MS (5 * 60 * 1000)
 #endif
 
 /* The default scan mode */
@@ -472,6 +478,17 @@
 #define BTM_BLE_CONFORMANCE_TESTING FALSE
 #endif
 
+/* The number of advertisers whose chained advertising or scan response data
+ * can be reassembled at the same time. */
+#ifndef BTM_BLE_ADV_REASSEMBLY_SIZE
+#define BTM_BLE_ADV_REASSEMBLY_SIZE 64
+#endif
+
+/* Partial advertising data without a new fragment for this long is dropped. */
+#ifndef BTM_BLE_ADV_REASSEMBLY_TIMEOUT_MS
+#define BTM_BLE_ADV_REASSEMBLY_TIMEOUT_MS 2000
+#endif
+
 /******************************************************************************
  *
  * L2CAP
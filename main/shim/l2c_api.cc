@@ -213,8 +213,7 @@ bool bluetooth::shim::L2CA_SetIdleTimeoutByBdAddr(const RawAddress& bd_addr,
 
 bool bluetooth::shim::L2CA_SetAclPriority(const RawAddress& bd_addr,
                                           uint8_t priority) {
-  LOG_INFO(LOG_TAG, "UNIMPLEMENTED %s", __func__);
-  return false;
+  return shim_l2cap.SetAclPriority(bd_addr, priority == L2CAP_PRIORITY_HIGH);
 }
 
 bool bluetooth::shim::L2CA_SetFlushTimeout(const RawAddress& bd_addr,
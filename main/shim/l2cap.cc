@@ -312,6 +312,23 @@ bool bluetooth::shim::legacy::L2cap::Write(uint16_t cid, BT_HDR* bt_hdr) {
   return true;
 }
 
+bool bluetooth::shim::legacy::L2cap::SetAclPriority(
+    const RawAddress& raw_address, bool high_priority) {
+  SetAclPriorityPromise priority_promise;
+  auto priority_set = priority_promise.get_future();
+  bluetooth::shim::GetL2cap()->SetAclPriority(
+      raw_address.ToString(), high_priority, std::move(priority_promise));
+
+  if (!priority_set.get()) {
+    LOG_WARN(LOG_TAG, "No connection to set acl priority address:%s",
+             raw_address.ToString().c_str());
+    return false;
+  }
+  LOG_DEBUG(LOG_TAG, "Set acl priority address:%s high:%d",
+            raw_address.ToString().c_str(), high_priority);
+  return true;
+}
+
 void bluetooth::shim::legacy::L2cap::SetDownstreamCallbacks(uint16_t cid) {
   bluetooth::shim::GetL2cap()->SetReadDataReadyCallback(
       cid, [this](uint16_t cid, std::vector<const uint8_t> data) {
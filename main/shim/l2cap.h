@@ -67,6 +67,8 @@ class L2cap {
 
   bool Write(uint16_t cid, BT_HDR* bt_hdr);
 
+  bool SetAclPriority(const RawAddress& raw_address, bool high_priority);
+
   void OnLocalInitiatedConnectionCreated(std::string string_address,
                                          uint16_t psm, uint16_t cid,
                                          bool connected);
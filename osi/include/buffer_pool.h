@@ -0,0 +1,55 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "osi/include/allocator.h"
+
+// Slab pool for packet (BT_HDR) buffers.
+//
+// Blocks are carved out of a single arena that is reserved on first use and
+// grouped into a few fixed size classes. Each thread keeps a small cache of
+// free blocks per size class, so most allocations and frees do not touch the
+// shared free lists. Requests larger than the biggest size class, or made
+// while a size class is exhausted, fall back to |osi_malloc|.
+// Pooled blocks are reported to the allocation tracker like |osi_malloc|
+// allocations.
+//
+// Blocks returned by |buffer_pool_alloc| may be released either with
+// |buffer_pool_free| or with |osi_free|, so buffers handed to the rest of the
+// stack do not need to remember where they came from.
+
+// allocator_t abstraction for the buffer pool.
+extern const allocator_t allocator_buffer_pool;
+
+// Allocates a buffer of at least |size| bytes. Never returns NULL.
+void* buffer_pool_alloc(size_t size);
+
+// Frees a buffer previously returned by |buffer_pool_alloc|. Safe to call
+// with NULL.
+void buffer_pool_free(void* ptr);
+
+// Returns true if |ptr| is a block that belongs to the buffer pool arena.
+bool buffer_pool_owns(const void* ptr);
+
+// Dump the pool occupancy and usage counters to the |fd| file descriptor.
+// The information is in user-readable text format. The |fd| must be valid.
+void buffer_pool_debug_dump(int fd);
@@ -37,10 +37,10 @@
 #include <hardware/bluetooth.h>
 
 #include <mutex>
+#include <vector>
 
 #include "osi/include/allocator.h"
 #include "osi/include/fixed_queue.h"
-#include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/semaphore.h"
@@ -105,8 +105,22 @@ struct alarm_t {
 
   bool for_msg_loop;  // True, if the alarm should be processed on message loop
   CancelableClosureInStruct closure;  // posted to message loop for processing
+
+  // Position of this alarm in |alarms| (1-based), or 0 if it is not pending.
+  size_t heap_index;
+  // Insertion order, used to break ties between alarms with equal deadlines
+  // so that they fire in the order they were scheduled.
+  uint64_t heap_sequence;
 };
 
+// Pending alarms, kept as a binary min-heap ordered by deadline. Each alarm
+// records its own position in the heap so it can be removed without a search.
+// Slot 0 is unused so that an index of 0 means "not pending".
+typedef struct {
+  std::vector<alarm_t*> nodes;
+  uint64_t next_sequence;
+} alarm_heap_t;
+
 // If the next wakeup time is less than this threshold, we should acquire
 // a wakelock instead of setting a wake alarm so we're not bouncing in
 // and out of suspend frequently. This value is externally visible to allow
@@ -116,9 +130,9 @@ static const clockid_t CLOCK_ID = CLOCK_BOOTTIME;
 
 // This mutex ensures that the |alarm_set|, |alarm_cancel|, and alarm callback
 // functions execute serially and not concurrently. As a result, this mutex
-// also protects the |alarms| list.
+// also protects the |alarms| heap.
 static std::mutex alarms_mutex;
-static list_t* alarms;
+static alarm_heap_t* alarms;
 static timer_t timer;
 static timer_t wakeup_timer;
 static bool timer_set;
@@ -153,6 +167,11 @@ static void update_scheduling_stats(alarm_stats_t* stats, uint64_t now_ms,
 static void alarm_register_processing_queue(fixed_queue_t* queue,
                                             thread_t* thread);
 
+static bool alarm_heap_is_empty(void);
+static alarm_t* alarm_heap_front(void);
+static void alarm_heap_push(alarm_t* alarm);
+static void alarm_heap_remove(alarm_t* alarm);
+
 static void update_stat(stat_t* stat, uint64_t delta_ms) {
   if (stat->max_ms < delta_ms) stat->max_ms = delta_ms;
   stat->total_ms += delta_ms;
@@ -166,7 +185,7 @@ alarm_t* alarm_new_periodic(const char* name) {
 }
 
 static alarm_t* alarm_new_internal(const char* name, bool is_periodic) {
-  // Make sure we have a list we can insert alarms into.
+  // Make sure we have a heap we can insert alarms into.
   if (!alarms && !lazy_initialize()) {
     CHECK(false);  // if initialization failed, we should not continue
     return NULL;
@@ -260,8 +279,7 @@ void alarm_cancel(alarm_t* alarm) {
 // Internal implementation of canceling an alarm.
 // The caller must hold the |alarms_mutex|
 static void alarm_cancel_internal(alarm_t* alarm) {
-  bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = (alarm_heap_front() == alarm);
 
   remove_pending_alarm(alarm);
 
@@ -301,7 +319,10 @@ void alarm_cleanup(void) {
   semaphore_free(alarm_expired);
   alarm_expired = NULL;
 
-  list_free(alarms);
+  // Alarms that are still pending may be freed or re-armed later.
+  for (size_t i = 1; i < alarms->nodes.size(); i++)
+    alarms->nodes[i]->heap_index = 0;
+  delete alarms;
   alarms = NULL;
 }
 
@@ -315,11 +336,9 @@ static bool lazy_initialize(void) {
 
   std::lock_guard<std::mutex> lock(alarms_mutex);
 
-  alarms = list_new(NULL);
-  if (!alarms) {
-    LOG_ERROR(LOG_TAG, "%s unable to allocate alarm list.", __func__);
-    goto error;
-  }
+  alarms = new alarm_heap_t();
+  alarms->nodes.push_back(NULL);  // Slot 0 is never used
+  alarms->next_sequence = 0;
 
   if (!timer_create_internal(CLOCK_ID, &timer)) goto error;
   timer_initialized = true;
@@ -382,7 +401,7 @@ error:
 
   if (timer_initialized) timer_delete(timer);
 
-  list_free(alarms);
+  delete alarms;
   alarms = NULL;
 
   return false;
@@ -401,10 +420,83 @@ static uint64_t now_ms(void) {
   return (ts.tv_sec * 1000LL) + (ts.tv_nsec / 1000000LL);
 }
 
-// Remove alarm from internal alarm list and the processing queue
+static bool alarm_heap_less(const alarm_t* a, const alarm_t* b) {
+  if (a->deadline_ms != b->deadline_ms) return a->deadline_ms < b->deadline_ms;
+  return a->heap_sequence < b->heap_sequence;
+}
+
+static void alarm_heap_set(size_t index, alarm_t* alarm) {
+  alarms->nodes[index] = alarm;
+  alarm->heap_index = index;
+}
+
+static void alarm_heap_sift_up(size_t index) {
+  alarm_t* alarm = alarms->nodes[index];
+  while (index > 1) {
+    size_t parent = index / 2;
+    if (!alarm_heap_less(alarm, alarms->nodes[parent])) break;
+    alarm_heap_set(index, alarms->nodes[parent]);
+    index = parent;
+  }
+  alarm_heap_set(index, alarm);
+}
+
+static void alarm_heap_sift_down(size_t index) {
+  const size_t size = alarms->nodes.size() - 1;
+  alarm_t* alarm = alarms->nodes[index];
+  while (true) {
+    size_t child = index * 2;
+    if (child > size) break;
+    if (child < size &&
+        alarm_heap_less(alarms->nodes[child + 1], alarms->nodes[child]))
+      child++;
+    if (!alarm_heap_less(alarms->nodes[child], alarm)) break;
+    alarm_heap_set(index, alarms->nodes[child]);
+    index = child;
+  }
+  alarm_heap_set(index, alarm);
+}
+
+// The caller must hold the |alarms_mutex|
+static bool alarm_heap_is_empty(void) { return alarms->nodes.size() <= 1; }
+
+// Returns the pending alarm with the earliest deadline, or NULL if there is
+// none. The caller must hold the |alarms_mutex|
+static alarm_t* alarm_heap_front(void) {
+  return alarm_heap_is_empty() ? NULL : alarms->nodes[1];
+}
+
+// The caller must hold the |alarms_mutex|
+static void alarm_heap_push(alarm_t* alarm) {
+  CHECK(alarm->heap_index == 0);
+  alarm->heap_sequence = alarms->next_sequence++;
+  alarms->nodes.push_back(alarm);
+  alarm_heap_sift_up(alarms->nodes.size() - 1);
+}
+
+// Removes |alarm| from the heap if it is pending there.
+// The caller must hold the |alarms_mutex|
+static void alarm_heap_remove(alarm_t* alarm) {
+  size_t index = alarm->heap_index;
+  if (index == 0) return;
+
+  alarm_t* last = alarms->nodes.back();
+  alarms->nodes.pop_back();
+  alarm->heap_index = 0;
+  if (last == alarm) return;
+
+  alarm_heap_set(index, last);
+  if (index > 1 && alarm_heap_less(last, alarms->nodes[index / 2])) {
+    alarm_heap_sift_up(index);
+  } else {
+    alarm_heap_sift_down(index);
+  }
+}
+
+// Remove alarm from internal alarm heap and the processing queue
 // The caller must hold the |alarms_mutex|
 static void remove_pending_alarm(alarm_t* alarm) {
-  list_remove(alarms, alarm);
+  alarm_heap_remove(alarm);
 
   if (alarm->for_msg_loop) {
     alarm->closure.i.Cancel();
@@ -419,10 +511,9 @@ static void remove_pending_alarm(alarm_t* alarm) {
 
 // Must be called with |alarms_mutex| held
 static void schedule_next_instance(alarm_t* alarm) {
-  // If the alarm is currently set and it's at the start of the list,
+  // If the alarm is currently set and it's at the top of the heap,
   // we'll need to re-schedule since we've adjusted the earliest deadline.
-  bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = (alarm_heap_front() == alarm);
   if (alarm->callback) remove_pending_alarm(alarm);
 
   // Calculate the next deadline for this alarm
@@ -433,26 +524,12 @@ static void schedule_next_instance(alarm_t* alarm) {
         ((just_now_ms - alarm->creation_time_ms) % alarm->period_ms);
   alarm->deadline_ms = just_now_ms + (alarm->period_ms - ms_into_period);
 
-  // Add it into the timer list sorted by deadline (earliest deadline first).
-  if (list_is_empty(alarms) ||
-      ((alarm_t*)list_front(alarms))->deadline_ms > alarm->deadline_ms) {
-    list_prepend(alarms, alarm);
-  } else {
-    for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
-         node = list_next(node)) {
-      list_node_t* next = list_next(node);
-      if (next == list_end(alarms) ||
-          ((alarm_t*)list_node(next))->deadline_ms > alarm->deadline_ms) {
-        list_insert_after(alarms, node, alarm);
-        break;
-      }
-    }
-  }
+  // Add it into the timer heap ordered by deadline (earliest deadline first).
+  alarm_heap_push(alarm);
 
   // If the new alarm has the earliest deadline, we need to re-evaluate our
   // schedule.
-  if (needs_reschedule ||
-      (!list_is_empty(alarms) && list_front(alarms) == alarm)) {
+  if (needs_reschedule || alarm_heap_front() == alarm) {
     reschedule_root_alarm();
   }
 }
@@ -469,9 +546,9 @@ static void reschedule_root_alarm(void) {
   struct itimerspec timer_time;
   memset(&timer_time, 0, sizeof(timer_time));
 
-  if (list_is_empty(alarms)) goto done;
+  if (alarm_heap_is_empty()) goto done;
 
-  next = static_cast<alarm_t*>(list_front(alarms));
+  next = alarm_heap_front();
   next_expiration = next->deadline_ms - now_ms();
   if (next_expiration < TIMER_INTERVAL_FOR_WAKELOCK_IN_MS) {
     if (!timer_set) {
@@ -532,7 +609,7 @@ done:
   // milliseconds) and the timer expired normally before we called
   // |timer_gettime|. Worst case, |alarm_expired| is signaled twice for that
   // alarm. Nothing bad should happen in that case though since the callback
-  // dispatch function checks to make sure the timer at the head of the list
+  // dispatch function checks to make sure the timer at the top of the heap
   // actually expired.
   if (timer_set) {
     struct itimerspec time_to_expire;
@@ -633,14 +710,13 @@ static void callback_dispatch(UNUSED_ATTR void* context) {
     // Take into account that the alarm may get cancelled before we get to it.
     // We're done here if there are no alarms or the alarm at the front is in
     // the future. Exit right away since there's nothing left to do.
-    if (list_is_empty(alarms) ||
-        (alarm = static_cast<alarm_t*>(list_front(alarms)))->deadline_ms >
-            now_ms()) {
+    if (alarm_heap_is_empty() ||
+        (alarm = alarm_heap_front())->deadline_ms > now_ms()) {
       reschedule_root_alarm();
       continue;
     }
 
-    list_remove(alarms, alarm);
+    alarm_heap_remove(alarm);
 
     if (alarm->is_periodic) {
       alarm->prev_deadline_ms = alarm->deadline_ms;
@@ -740,12 +816,11 @@ void alarm_debug_dump(int fd) {
 
   uint64_t just_now_ms = now_ms();
 
-  dprintf(fd, "  Total Alarms: %zu\n\n", list_length(alarms));
+  dprintf(fd, "  Total Alarms: %zu\n\n", alarms->nodes.size() - 1);
 
   // Dump info for each alarm
-  for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
-       node = list_next(node)) {
-    alarm_t* alarm = (alarm_t*)list_node(node);
+  for (size_t i = 1; i < alarms->nodes.size(); i++) {
+    alarm_t* alarm = alarms->nodes[i];
     alarm_stats_t* stats = &alarm->stats;
 
     dprintf(fd, "  Alarm : %s (%s)\n", stats->name,
@@ -21,6 +21,7 @@
 
 #include "osi/include/allocation_tracker.h"
 #include "osi/include/allocator.h"
+#include "osi/include/buffer_pool.h"
 
 static const allocator_id_t alloc_allocator_id = 42;
 
@@ -70,6 +71,12 @@ void* osi_calloc(size_t size) {
 }
 
 void osi_free(void* ptr) {
+  // Packet buffers from the buffer pool are released with osi_free() all over
+  // the stack; hand them back to the pool.
+  if (buffer_pool_owns(ptr)) {
+    buffer_pool_free(ptr);
+    return;
+  }
   free(allocation_tracker_notify_free(alloc_allocator_id, ptr));
 }
 
@@ -0,0 +1,278 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "internal_include/bt_target.h"
+
+#define LOG_TAG "bt_osi_buffer_pool"
+
+#include "osi/include/buffer_pool.h"
+
+#include <base/logging.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "osi/include/allocation_tracker.h"
+#include "osi/include/allocator.h"
+
+static const allocator_id_t buffer_pool_allocator_id = 43;
+
+// Blocks are aligned to this many bytes inside the arena.
+#define BUFFER_POOL_ALIGNMENT 16
+
+// Number of free blocks moved between a thread cache and the shared free list
+// at once, and the number of free blocks a thread may keep per size class.
+#define BUFFER_POOL_CACHE_BATCH 8
+#define BUFFER_POOL_CACHE_MAX (2 * BUFFER_POOL_CACHE_BATCH)
+
+typedef struct free_block_t {
+  struct free_block_t* next;
+} free_block_t;
+
+typedef struct {
+  size_t block_size;
+  size_t block_count;
+  uint8_t* begin;
+  uint8_t* end;
+
+  std::mutex mutex;  // Protects |free_list| and |unused|
+  free_block_t* free_list;
+  uint8_t* unused;  // First block that was never handed out
+
+  std::atomic<size_t> in_use;
+  std::atomic<size_t> high_water;
+  std::atomic<size_t> alloc_count;
+  std::atomic<size_t> exhausted_count;
+} size_class_t;
+
+typedef struct {
+  size_t block_size;
+  size_t block_count;
+} size_class_config_t;
+
+// Size classes, smallest first. The classes cover a full LE data length PDU,
+// a 2-DH5/3-DH5 ACL packet or A2DP media packet, and a full default buffer.
+static const size_class_config_t size_class_configs[] = {
+    {512, 512},
+    {1280, 256},
+    {BT_DEFAULT_BUFFER_SIZE, 128},
+};
+#define SIZE_CLASS_COUNT \
+  (sizeof(size_class_configs) / sizeof(size_class_configs[0]))
+
+static size_class_t size_classes[SIZE_CLASS_COUNT];
+
+static std::once_flag arena_once;
+static std::atomic<uint8_t*> arena_begin;
+static std::atomic<uint8_t*> arena_end;
+static std::atomic<size_t> oversized_count;
+
+// Per-thread cache of free blocks. Any blocks still cached when the thread
+// exits are handed back to the shared free lists.
+struct thread_cache_t {
+  free_block_t* head[SIZE_CLASS_COUNT];
+  size_t count[SIZE_CLASS_COUNT];
+
+  ~thread_cache_t();
+};
+static thread_local thread_cache_t thread_cache;
+
+static size_t align_up(size_t size) {
+  return (size + BUFFER_POOL_ALIGNMENT - 1) &
+         ~(size_t)(BUFFER_POOL_ALIGNMENT - 1);
+}
+
+static void arena_init(void) {
+  size_t arena_size = 0;
+  for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+    // Leave room for the allocation tracker canaries if it is enabled.
+    size_classes[i].block_size = align_up(
+        allocation_tracker_resize_for_canary(size_class_configs[i].block_size));
+    size_classes[i].block_count = size_class_configs[i].block_count;
+    arena_size += size_classes[i].block_size * size_classes[i].block_count;
+  }
+
+  // The arena lives for the lifetime of the process. Blocks are carved from
+  // it in address order as they are first needed, so its pages are only
+  // committed once a block in them is used.
+  void* arena = NULL;
+  int error = posix_memalign(&arena, BUFFER_POOL_ALIGNMENT, arena_size);
+  CHECK(error == 0 && arena != NULL);
+
+  uint8_t* p = static_cast<uint8_t*>(arena);
+  for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+    size_class_t* sc = &size_classes[i];
+    sc->begin = p;
+    sc->end = p + sc->block_size * sc->block_count;
+    sc->free_list = NULL;
+    sc->unused = sc->begin;
+    p = sc->end;
+  }
+
+  arena_end.store(p, std::memory_order_release);
+  arena_begin.store(static_cast<uint8_t*>(arena), std::memory_order_release);
+}
+
+static size_class_t* size_class_for_size(size_t size) {
+  for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+    if (size <= size_classes[i].block_size) return &size_classes[i];
+  }
+  return NULL;
+}
+
+static size_class_t* size_class_for_block(const void* ptr) {
+  const uint8_t* p = static_cast<const uint8_t*>(ptr);
+  for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+    if (p < size_classes[i].end) return &size_classes[i];
+  }
+  return NULL;
+}
+
+static void update_high_water(size_class_t* sc, size_t in_use) {
+  size_t high_water = sc->high_water.load(std::memory_order_relaxed);
+  while (in_use > high_water &&
+         !sc->high_water.compare_exchange_weak(high_water, in_use,
+                                               std::memory_order_relaxed)) {
+  }
+}
+
+// Moves up to |BUFFER_POOL_CACHE_BATCH| blocks of size class |index| into
+// the calling thread's cache, from the shared free list first and then from
+// the blocks that were never used.
+static void thread_cache_refill(size_t index) {
+  size_class_t* sc = &size_classes[index];
+  std::lock_guard<std::mutex> lock(sc->mutex);
+  while (thread_cache.count[index] < BUFFER_POOL_CACHE_BATCH) {
+    free_block_t* fb;
+    if (sc->free_list != NULL) {
+      fb = sc->free_list;
+      sc->free_list = fb->next;
+    } else if (sc->unused < sc->end) {
+      fb = reinterpret_cast<free_block_t*>(sc->unused);
+      sc->unused += sc->block_size;
+    } else {
+      break;
+    }
+    fb->next = thread_cache.head[index];
+    thread_cache.head[index] = fb;
+    thread_cache.count[index]++;
+  }
+}
+
+// Returns up to |count| blocks of size class |index| from |cache| to the
+// shared free list.
+static void thread_cache_flush(thread_cache_t* cache, size_t index,
+                               size_t count) {
+  size_class_t* sc = &size_classes[index];
+  std::lock_guard<std::mutex> lock(sc->mutex);
+  while (count-- > 0 && cache->head[index] != NULL) {
+    free_block_t* fb = cache->head[index];
+    cache->head[index] = fb->next;
+    cache->count[index]--;
+    fb->next = sc->free_list;
+    sc->free_list = fb;
+  }
+}
+
+thread_cache_t::~thread_cache_t() {
+  for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+    if (count[i] > 0) thread_cache_flush(this, i, count[i]);
+  }
+}
+
+void* buffer_pool_alloc(size_t size) {
+  std::call_once(arena_once, arena_init);
+
+  size_class_t* sc =
+      size_class_for_size(allocation_tracker_resize_for_canary(size));
+  if (sc == NULL) {
+    oversized_count.fetch_add(1, std::memory_order_relaxed);
+    return osi_malloc(size);
+  }
+
+  size_t index = sc - size_classes;
+  if (thread_cache.head[index] == NULL) thread_cache_refill(index);
+
+  free_block_t* fb = thread_cache.head[index];
+  if (fb == NULL) {
+    sc->exhausted_count.fetch_add(1, std::memory_order_relaxed);
+    return osi_malloc(size);
+  }
+  thread_cache.head[index] = fb->next;
+  thread_cache.count[index]--;
+
+  sc->alloc_count.fetch_add(1, std::memory_order_relaxed);
+  update_high_water(sc,
+                    sc->in_use.fetch_add(1, std::memory_order_relaxed) + 1);
+  return allocation_tracker_notify_alloc(buffer_pool_allocator_id, fb, size);
+}
+
+void buffer_pool_free(void* ptr) {
+  if (!buffer_pool_owns(ptr)) {
+    osi_free(ptr);
+    return;
+  }
+
+  void* block = allocation_tracker_notify_free(buffer_pool_allocator_id, ptr);
+  size_class_t* sc = size_class_for_block(block);
+  size_t index = sc - size_classes;
+  DCHECK((static_cast<uint8_t*>(block) - sc->begin) % sc->block_size == 0);
+
+  sc->in_use.fetch_sub(1, std::memory_order_relaxed);
+
+  free_block_t* fb = static_cast<free_block_t*>(block);
+  fb->next = thread_cache.head[index];
+  thread_cache.head[index] = fb;
+  if (++thread_cache.count[index] > BUFFER_POOL_CACHE_MAX)
+    thread_cache_flush(&thread_cache, index, BUFFER_POOL_CACHE_BATCH);
+}
+
+bool buffer_pool_owns(const void* ptr) {
+  const uint8_t* p = static_cast<const uint8_t*>(ptr);
+  const uint8_t* begin = arena_begin.load(std::memory_order_acquire);
+  return begin != NULL && p >= begin &&
+         p < arena_end.load(std::memory_order_relaxed);
+}
+
+const allocator_t allocator_buffer_pool = {buffer_pool_alloc,
+                                           buffer_pool_free};
+
+void buffer_pool_debug_dump(int fd) {
+  dprintf(fd, "\nBluetooth Buffer Pool Statistics:\n");
+
+  if (arena_begin.load(std::memory_order_acquire) == NULL) {
+    dprintf(fd, "  None\n");
+    return;
+  }
+
+  for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+    size_class_t* sc = &size_classes[i];
+    dprintf(fd, "  Block size %zu bytes:\n", sc->block_size);
+    dprintf(fd, "%-51s: %zu / %zu / %zu\n",
+            "    Blocks (in use/high water/capacity)",
+            sc->in_use.load(std::memory_order_relaxed),
+            sc->high_water.load(std::memory_order_relaxed), sc->block_count);
+    dprintf(fd, "%-51s: %zu / %zu\n", "    Allocations (pooled/exhausted)",
+            sc->alloc_count.load(std::memory_order_relaxed),
+            sc->exhausted_count.load(std::memory_order_relaxed));
+  }
+  dprintf(fd, "%-51s: %zu\n", "  Oversized allocations",
+          oversized_count.load(std::memory_order_relaxed));
+}
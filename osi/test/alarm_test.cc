@@ -297,6 +297,36 @@ TEST_F(AlarmTest, test_callback_ordering) {
   EXPECT_FALSE(WakeLockHeld());
 }
 
+// Test whether the callbacks are invoked in deadline order when the alarms
+// are armed out of order and some of them are canceled before they fire.
+TEST_F(AlarmTest, test_callback_ordering_with_cancel) {
+  alarm_t* alarms[50];
+
+  for (int i = 0; i < 50; i++) {
+    const std::string alarm_name =
+        "alarm_test.test_callback_ordering_with_cancel[" + std::to_string(i) +
+        "]";
+    alarms[i] = alarm_new(alarm_name.c_str());
+  }
+
+  // Arm in reverse deadline order; only the odd alarms are left to fire.
+  for (int i = 49; i >= 0; i--) {
+    alarm_set(alarms[i], 100 + i, ordered_cb, INT_TO_PTR(i / 2));
+  }
+  for (int i = 0; i < 50; i += 2) alarm_cancel(alarms[i]);
+
+  for (int i = 1; i <= 25; i++) {
+    semaphore_wait(semaphore);
+    EXPECT_GE(cb_counter, i);
+  }
+  EXPECT_EQ(cb_counter, 25);
+  EXPECT_EQ(cb_misordered_counter, 0);
+
+  for (int i = 0; i < 50; i++) alarm_free(alarms[i]);
+
+  EXPECT_FALSE(WakeLockHeld());
+}
+
 // Test whether the callbacks are involed in the expected order on a
 // message loop.
 TEST_F(AlarmTest, test_callback_ordering_on_mloop) {
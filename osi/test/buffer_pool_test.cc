@@ -0,0 +1,114 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+#include "internal_include/bt_target.h"
+#include "osi/include/allocation_tracker.h"
+#include "osi/include/allocator.h"
+#include "osi/include/buffer_pool.h"
+
+class BufferPoolTest : public AllocationTestHarness {};
+
+TEST_F(BufferPoolTest, test_alloc_free) {
+  void* ptr = buffer_pool_alloc(100);
+  ASSERT_TRUE(ptr != NULL);
+  EXPECT_TRUE(buffer_pool_owns(ptr));
+  memset(ptr, 0xAA, 100);
+  buffer_pool_free(ptr);
+}
+
+TEST_F(BufferPoolTest, test_free_null) { buffer_pool_free(NULL); }
+
+TEST_F(BufferPoolTest, test_allocator_interface) {
+  void* ptr = allocator_buffer_pool.alloc(BT_DEFAULT_BUFFER_SIZE);
+  ASSERT_TRUE(ptr != NULL);
+  EXPECT_TRUE(buffer_pool_owns(ptr));
+  memset(ptr, 0xAA, BT_DEFAULT_BUFFER_SIZE);
+  allocator_buffer_pool.free(ptr);
+}
+
+TEST_F(BufferPoolTest, test_osi_free_returns_to_pool) {
+  void* ptr = buffer_pool_alloc(BT_DEFAULT_BUFFER_SIZE);
+  ASSERT_TRUE(buffer_pool_owns(ptr));
+  osi_free(ptr);
+
+  // The block is reused from the thread cache.
+  void* again = buffer_pool_alloc(BT_DEFAULT_BUFFER_SIZE);
+  EXPECT_EQ(ptr, again);
+  osi_free(again);
+}
+
+TEST_F(BufferPoolTest, test_oversized_falls_back) {
+  void* ptr = buffer_pool_alloc(BT_DEFAULT_BUFFER_SIZE + 1);
+  ASSERT_TRUE(ptr != NULL);
+  EXPECT_FALSE(buffer_pool_owns(ptr));
+  memset(ptr, 0xAA, BT_DEFAULT_BUFFER_SIZE + 1);
+  buffer_pool_free(ptr);
+}
+
+TEST_F(BufferPoolTest, test_osi_malloc_not_owned) {
+  void* ptr = osi_malloc(64);
+  EXPECT_FALSE(buffer_pool_owns(ptr));
+  osi_free(ptr);
+}
+
+TEST_F(BufferPoolTest, test_allocation_tracked) {
+  void* ptr = buffer_pool_alloc(100);
+  ASSERT_TRUE(buffer_pool_owns(ptr));
+  EXPECT_EQ(100U, allocation_tracker_expect_no_allocations());
+  osi_free(ptr);
+  EXPECT_EQ(0U, allocation_tracker_expect_no_allocations());
+}
+
+TEST_F(BufferPoolTest, test_exhausted_falls_back) {
+  std::vector<void*> buffers;
+  void* ptr;
+  do {
+    ptr = buffer_pool_alloc(BT_DEFAULT_BUFFER_SIZE);
+    ASSERT_TRUE(ptr != NULL);
+    buffers.push_back(ptr);
+  } while (buffer_pool_owns(ptr) && buffers.size() < 100000);
+
+  EXPECT_FALSE(buffer_pool_owns(buffers.back()));
+  for (void* buffer : buffers) osi_free(buffer);
+}
+
+TEST_F(BufferPoolTest, test_free_on_other_thread) {
+  std::vector<void*> buffers;
+  for (int i = 0; i < 100; i++) buffers.push_back(buffer_pool_alloc(251));
+
+  std::thread thread([&buffers]() {
+    for (void* buffer : buffers) osi_free(buffer);
+  });
+  thread.join();
+
+  // The blocks cached by the exited thread are available again.
+  for (int i = 0; i < 100; i++) {
+    void* ptr = buffer_pool_alloc(251);
+    EXPECT_TRUE(buffer_pool_owns(ptr));
+    buffers[i] = ptr;
+  }
+  for (void* buffer : buffers) osi_free(buffer);
+}
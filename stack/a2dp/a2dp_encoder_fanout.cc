@@ -0,0 +1,186 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "a2dp_encoder_fanout"
+
+#include "a2dp_encoder_fanout.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "osi/include/log.h"
+
+constexpr size_t A2dpEncoderFanout::kMaxBufferedBytes;
+
+A2dpEncoderFanout::A2dpEncoderFanout(
+    A2dpEncoderSession::ReadCallback read_callback)
+    : read_callback_(std::move(read_callback)) {}
+
+void A2dpEncoderFanout::AddReader(const RawAddress& peer_address) {
+  Peer& peer = peers_[peer_address];
+  peer.session.reset();
+  peer.position = start_ + buffer_.size();
+}
+
+bool A2dpEncoderFanout::AddPeer(
+    const RawAddress& peer_address,
+    const tA2DP_ENCODER_INTERFACE* encoder_interface,
+    const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
+    A2dpCodecConfig* a2dp_codec_config,
+    A2dpEncoderSession::EnqueueCallback enqueue_callback) {
+  if (encoder_interface == nullptr ||
+      encoder_interface->create_session == nullptr) {
+    LOG_ERROR(LOG_TAG, "%s: peer %s: codec %s doesn't support sessions",
+              __func__, peer_address.ToString().c_str(),
+              a2dp_codec_config->name().c_str());
+    return false;
+  }
+
+  AddReader(peer_address);
+  A2dpEncoderSession::ReadCallback read_callback =
+      [this, peer_address](uint8_t* p_buf, uint32_t len) {
+        return Read(peer_address, p_buf, len);
+      };
+  peers_[peer_address].session = encoder_interface->create_session(
+      p_peer_params, a2dp_codec_config, std::move(read_callback),
+      std::move(enqueue_callback));
+  return true;
+}
+
+void A2dpEncoderFanout::RemovePeer(const RawAddress& peer_address) {
+  peers_.erase(peer_address);
+  Trim();
+}
+
+bool A2dpEncoderFanout::HasPeer(const RawAddress& peer_address) const {
+  return peers_.find(peer_address) != peers_.end();
+}
+
+uint32_t A2dpEncoderFanout::Read(const RawAddress& peer_address,
+                                 uint8_t* p_buf, uint32_t len) {
+  auto iter = peers_.find(peer_address);
+  if (iter == peers_.end()) return 0;
+  Peer& peer = iter->second;
+  uint32_t bytes_read;
+
+  if (peers_.size() == 1 && buffer_.empty()) {
+    // Nobody else needs the audio: read it in place
+    bytes_read = read_callback_(p_buf, len);
+    start_ += bytes_read;
+    peer.position = start_;
+  } else {
+    // Read the audio that no other peer has read yet
+    uint64_t end = start_ + buffer_.size();
+    if (peer.position + len > end) {
+      size_t size = buffer_.size();
+      uint32_t missing = peer.position + len - end;
+      buffer_.resize(size + missing);
+      buffer_.resize(size + read_callback_(buffer_.data() + size, missing));
+      end = start_ + buffer_.size();
+    }
+
+    bytes_read = std::min<uint64_t>(len, end - peer.position);
+    memcpy(p_buf, buffer_.data() + (peer.position - start_), bytes_read);
+    peer.position += bytes_read;
+    Trim();
+  }
+
+  peer.stats.read_bytes += bytes_read;
+  if (bytes_read < len) {
+    peer.stats.underflow_bytes += len - bytes_read;
+    peer.stats.underflow_count++;
+  }
+  return bytes_read;
+}
+
+void A2dpEncoderFanout::SendFrames(uint64_t timestamp_us) {
+  for (auto& entry : peers_) {
+    if (entry.second.session != nullptr) {
+      entry.second.session->SendFrames(timestamp_us);
+    }
+  }
+}
+
+void A2dpEncoderFanout::FeedingReset() {
+  for (auto& entry : peers_) {
+    if (entry.second.session != nullptr) entry.second.session->FeedingReset();
+  }
+}
+
+void A2dpEncoderFanout::FeedingFlush() {
+  start_ += buffer_.size();
+  buffer_.clear();
+  for (auto& entry : peers_) {
+    entry.second.position = start_;
+    if (entry.second.session != nullptr) entry.second.session->FeedingFlush();
+  }
+}
+
+const A2dpEncoderFanout::PeerStats* A2dpEncoderFanout::GetPeerStats(
+    const RawAddress& peer_address) const {
+  auto iter = peers_.find(peer_address);
+  if (iter == peers_.end()) return nullptr;
+  return &iter->second.stats;
+}
+
+void A2dpEncoderFanout::Trim() {
+  uint64_t end = start_ + buffer_.size();
+  uint64_t new_start = end;
+  for (const auto& entry : peers_) {
+    new_start = std::min(new_start, entry.second.position);
+  }
+
+  if (end - new_start > kMaxBufferedBytes) {
+    new_start = end - kMaxBufferedBytes;
+    for (auto& entry : peers_) {
+      Peer& peer = entry.second;
+      if (peer.position >= new_start) continue;
+      LOG_VERBOSE(LOG_TAG, "%s: peer %s is lagging: skipping %zu bytes",
+                  __func__, entry.first.ToString().c_str(),
+                  static_cast<size_t>(new_start - peer.position));
+      peer.stats.dropped_bytes += new_start - peer.position;
+      peer.position = new_start;
+    }
+  }
+
+  buffer_.erase(buffer_.begin(), buffer_.begin() + (new_start - start_));
+  start_ = new_start;
+}
+
+void A2dpEncoderFanout::DebugDump(int fd) {
+  dprintf(fd, "\nA2DP Encoder Fan-out:\n");
+  dprintf(fd,
+          "  Buffered bytes                                          : %zu\n",
+          buffer_.size());
+
+  for (auto& entry : peers_) {
+    const Peer& peer = entry.second;
+    dprintf(fd, "  Peer: %s (%s)\n", entry.first.ToString().c_str(),
+            peer.session != nullptr ? "encoder session" : "reader");
+    dprintf(fd,
+            "    PCM bytes read                                        : %zu\n",
+            peer.stats.read_bytes);
+    dprintf(fd,
+            "    Underflow (count/bytes)                               : %zu / "
+            "%zu\n",
+            peer.stats.underflow_count, peer.stats.underflow_bytes);
+    dprintf(fd,
+            "    Dropped bytes                                         : %zu\n",
+            peer.stats.dropped_bytes);
+    if (peer.session != nullptr) peer.session->DebugDump(fd);
+  }
+}
@@ -92,8 +92,8 @@ typedef struct {
 } a2dp_sbc_encoder_stats_t;
 
 typedef struct {
-  a2dp_source_read_callback_t read_callback;
-  a2dp_source_enqueue_callback_t enqueue_callback;
+  A2dpEncoderSession::ReadCallback read_callback;
+  A2dpEncoderSession::EnqueueCallback enqueue_callback;
   uint16_t TxAaMtuSize;
   uint8_t tx_sbc_frames;
   bool is_peer_edr;         /* True if the peer device supports EDR */
@@ -104,25 +104,83 @@ typedef struct {
   tA2DP_FEEDING_PARAMS feeding_params;
   tA2DP_SBC_FEEDING_STATE feeding_state;
   int16_t pcmBuffer[SBC_MAX_PCM_BUFFER_SIZE];
+  uint16_t up_sampled_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS *
+                             SBC_MAX_NUM_OF_CHANNELS *
+                             SBC_MAX_NUM_OF_SUBBANDS * 2];
+  uint16_t read_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS *
+                       SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS];
 
   a2dp_sbc_encoder_stats_t stats;
 } tA2DP_SBC_ENCODER_CB;
 
+// The encoder of the a2dp_sbc_* functions, the sessions have their own
 static tA2DP_SBC_ENCODER_CB a2dp_sbc_encoder_cb;
 
-static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
+static void a2dp_sbc_encoder_init(
+    tA2DP_SBC_ENCODER_CB* p_cb,
+    const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
+    A2dpCodecConfig* a2dp_codec_config,
+    A2dpEncoderSession::ReadCallback read_callback,
+    A2dpEncoderSession::EnqueueCallback enqueue_callback);
+static void a2dp_sbc_encoder_update(tA2DP_SBC_ENCODER_CB* p_cb,
+                                    uint16_t peer_mtu,
                                     A2dpCodecConfig* a2dp_codec_config,
                                     bool* p_restart_input,
                                     bool* p_restart_output,
                                     bool* p_config_updated);
-static bool a2dp_sbc_read_feeding(uint32_t* bytes);
-static void a2dp_sbc_encode_frames(uint8_t nb_frame);
-static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
+static void a2dp_sbc_feeding_reset(tA2DP_SBC_ENCODER_CB* p_cb);
+static void a2dp_sbc_feeding_flush(tA2DP_SBC_ENCODER_CB* p_cb);
+static void a2dp_sbc_send_frames(tA2DP_SBC_ENCODER_CB* p_cb,
+                                 uint64_t timestamp_us);
+static bool a2dp_sbc_read_feeding(tA2DP_SBC_ENCODER_CB* p_cb,
+                                  uint32_t* bytes);
+static void a2dp_sbc_encode_frames(tA2DP_SBC_ENCODER_CB* p_cb,
+                                   uint8_t nb_frame);
+static void a2dp_sbc_get_num_frame_iteration(tA2DP_SBC_ENCODER_CB* p_cb,
+                                             uint8_t* num_of_iterations,
                                              uint8_t* num_of_frames,
                                              uint64_t timestamp_us);
-static uint8_t calculate_max_frames_per_packet(void);
-static uint16_t a2dp_sbc_source_rate();
-static uint32_t a2dp_sbc_frame_length(void);
+static uint8_t calculate_max_frames_per_packet(tA2DP_SBC_ENCODER_CB* p_cb);
+static uint16_t a2dp_sbc_source_rate(const tA2DP_SBC_ENCODER_CB* p_cb);
+static uint32_t a2dp_sbc_frame_length(tA2DP_SBC_ENCODER_CB* p_cb);
+static void a2dp_sbc_debug_dump(int fd, const tA2DP_SBC_ENCODER_CB* p_cb);
+
+namespace {
+
+// An encoder session, with its own control block
+class A2dpSbcEncoderSession : public A2dpEncoderSession {
+ public:
+  A2dpSbcEncoderSession(const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
+                        A2dpCodecConfig* a2dp_codec_config,
+                        ReadCallback read_callback,
+                        EnqueueCallback enqueue_callback)
+      : cb_() {
+    a2dp_sbc_encoder_init(&cb_, p_peer_params, a2dp_codec_config,
+                          std::move(read_callback),
+                          std::move(enqueue_callback));
+  }
+
+  void FeedingReset() override { a2dp_sbc_feeding_reset(&cb_); }
+
+  void FeedingFlush() override { a2dp_sbc_feeding_flush(&cb_); }
+
+  uint64_t GetEncoderIntervalMs() const override {
+    return a2dp_sbc_get_encoder_interval_ms();
+  }
+
+  void SendFrames(uint64_t timestamp_us) override {
+    a2dp_sbc_send_frames(&cb_, timestamp_us);
+  }
+
+  int GetEffectiveMtu() const override { return cb_.TxAaMtuSize; }
+
+  void DebugDump(int fd) override { a2dp_sbc_debug_dump(fd, &cb_); }
+
+ private:
+  tA2DP_SBC_ENCODER_CB cb_;
+};
+
+}  // namespace
 
 bool A2DP_LoadEncoderSbc(void) {
   // Nothing to do - the library is statically linked
@@ -137,36 +195,56 @@ void a2dp_sbc_encoder_init(const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
                            A2dpCodecConfig* a2dp_codec_config,
                            a2dp_source_read_callback_t read_callback,
                            a2dp_source_enqueue_callback_t enqueue_callback) {
-  memset(&a2dp_sbc_encoder_cb, 0, sizeof(a2dp_sbc_encoder_cb));
+  a2dp_sbc_encoder_cb = tA2DP_SBC_ENCODER_CB();
+  a2dp_sbc_encoder_init(&a2dp_sbc_encoder_cb, p_peer_params, a2dp_codec_config,
+                        read_callback, enqueue_callback);
+}
 
-  a2dp_sbc_encoder_cb.stats.session_start_us =
-      bluetooth::common::time_get_os_boottime_us();
+std::unique_ptr<A2dpEncoderSession> a2dp_sbc_create_encoder_session(
+    const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
+    A2dpCodecConfig* a2dp_codec_config,
+    A2dpEncoderSession::ReadCallback read_callback,
+    A2dpEncoderSession::EnqueueCallback enqueue_callback) {
+  return std::make_unique<A2dpSbcEncoderSession>(
+      p_peer_params, a2dp_codec_config, std::move(read_callback),
+      std::move(enqueue_callback));
+}
 
-  a2dp_sbc_encoder_cb.read_callback = read_callback;
-  a2dp_sbc_encoder_cb.enqueue_callback = enqueue_callback;
-  a2dp_sbc_encoder_cb.is_peer_edr = p_peer_params->is_peer_edr;
-  a2dp_sbc_encoder_cb.peer_supports_3mbps = p_peer_params->peer_supports_3mbps;
-  a2dp_sbc_encoder_cb.peer_mtu = p_peer_params->peer_mtu;
-  a2dp_sbc_encoder_cb.timestamp = 0;
+static void a2dp_sbc_encoder_init(
+    tA2DP_SBC_ENCODER_CB* p_cb,
+    const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
+    A2dpCodecConfig* a2dp_codec_config,
+    A2dpEncoderSession::ReadCallback read_callback,
+    A2dpEncoderSession::EnqueueCallback enqueue_callback) {
+  p_cb->stats.session_start_us = bluetooth::common::time_get_os_boottime_us();
+
+  p_cb->read_callback = std::move(read_callback);
+  p_cb->enqueue_callback = std::move(enqueue_callback);
+  p_cb->is_peer_edr = p_peer_params->is_peer_edr;
+  p_cb->peer_supports_3mbps = p_peer_params->peer_supports_3mbps;
+  p_cb->peer_mtu = p_peer_params->peer_mtu;
+  p_cb->timestamp = 0;
 
   // NOTE: Ignore the restart_input / restart_output flags - this initization
   // happens when the connection is (re)started.
   bool restart_input = false;
   bool restart_output = false;
   bool config_updated = false;
-  a2dp_sbc_encoder_update(a2dp_sbc_encoder_cb.peer_mtu, a2dp_codec_config,
+  a2dp_sbc_encoder_update(p_cb, p_cb->peer_mtu, a2dp_codec_config,
                           &restart_input, &restart_output, &config_updated);
 }
 
 bool A2dpCodecConfigSbcSource::updateEncoderUserConfig(
     const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params, bool* p_restart_input,
     bool* p_restart_output, bool* p_config_updated) {
-  a2dp_sbc_encoder_cb.is_peer_edr = p_peer_params->is_peer_edr;
-  a2dp_sbc_encoder_cb.peer_supports_3mbps = p_peer_params->peer_supports_3mbps;
-  a2dp_sbc_encoder_cb.peer_mtu = p_peer_params->peer_mtu;
-  a2dp_sbc_encoder_cb.timestamp = 0;
+  tA2DP_SBC_ENCODER_CB* p_cb = &a2dp_sbc_encoder_cb;
+
+  p_cb->is_peer_edr = p_peer_params->is_peer_edr;
+  p_cb->peer_supports_3mbps = p_peer_params->peer_supports_3mbps;
+  p_cb->peer_mtu = p_peer_params->peer_mtu;
+  p_cb->timestamp = 0;
 
-  if (a2dp_sbc_encoder_cb.peer_mtu == 0) {
+  if (p_cb->peer_mtu == 0) {
     LOG_ERROR(LOG_TAG,
               "%s: Cannot update the codec encoder for %s: "
               "invalid peer MTU",
@@ -174,7 +252,7 @@ bool A2dpCodecConfigSbcSource::updateEncoderUserConfig(
     return false;
   }
 
-  a2dp_sbc_encoder_update(a2dp_sbc_encoder_cb.peer_mtu, this, p_restart_input,
+  a2dp_sbc_encoder_update(p_cb, p_cb->peer_mtu, this, p_restart_input,
                           p_restart_output, p_config_updated);
   return true;
 }
@@ -182,12 +260,13 @@ bool A2dpCodecConfigSbcSource::updateEncoderUserConfig(
 // Update the A2DP SBC encoder.
 // |peer_mtu| is the peer MTU.
 // |a2dp_codec_config| is the A2DP codec to use for the update.
-static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
+static void a2dp_sbc_encoder_update(tA2DP_SBC_ENCODER_CB* p_cb,
+                                    uint16_t peer_mtu,
                                     A2dpCodecConfig* a2dp_codec_config,
                                     bool* p_restart_input,
                                     bool* p_restart_output,
                                     bool* p_config_updated) {
-  SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+  SBC_ENC_PARAMS* p_encoder_params = &p_cb->sbc_encoder_params;
   uint8_t codec_info[AVDT_CODEC_SIZE];
   uint16_t s16SamplingFreq;
   int16_t s16BitPool = 0;
@@ -212,7 +291,7 @@ static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
   max_bitpool = A2DP_GetMaxBitpoolSbc(p_codec_info);
 
   // The feeding parameters
-  tA2DP_FEEDING_PARAMS* p_feeding_params = &a2dp_sbc_encoder_cb.feeding_params;
+  tA2DP_FEEDING_PARAMS* p_feeding_params = &p_cb->feeding_params;
   p_feeding_params->sample_rate = A2DP_GetTrackSampleRateSbc(p_codec_info);
   p_feeding_params->bits_per_sample =
       a2dp_codec_config->getAudioBitsPerSample();
@@ -220,7 +299,7 @@ static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
   LOG_DEBUG(LOG_TAG, "%s: sample_rate=%u bits_per_sample=%u channel_count=%u",
             __func__, p_feeding_params->sample_rate,
             p_feeding_params->bits_per_sample, p_feeding_params->channel_count);
-  a2dp_sbc_feeding_reset();
+  a2dp_sbc_feeding_reset(p_cb);
 
   // The codec parameters
   p_encoder_params->s16ChannelMode = A2DP_GetChannelModeCodeSbc(p_codec_info);
@@ -253,9 +332,9 @@ static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
 
   uint16_t mtu_size = A2DP_SBC_BUFFER_SIZE - A2DP_SBC_OFFSET - sizeof(BT_HDR);
   if (mtu_size < peer_mtu) {
-    a2dp_sbc_encoder_cb.TxAaMtuSize = mtu_size;
+    p_cb->TxAaMtuSize = mtu_size;
   } else {
-    a2dp_sbc_encoder_cb.TxAaMtuSize = peer_mtu;
+    p_cb->TxAaMtuSize = peer_mtu;
   }
 
   if (p_encoder_params->s16SamplingFreq == SBC_sf16000)
@@ -268,11 +347,10 @@ static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
     s16SamplingFreq = 48000;
 
   // Set the initial target bit rate
-  p_encoder_params->u16BitRate = a2dp_sbc_source_rate();
+  p_encoder_params->u16BitRate = a2dp_sbc_source_rate(p_cb);
 
   LOG_DEBUG(LOG_TAG, "%s: MTU=%d, peer_mtu=%d min_bitpool=%d max_bitpool=%d",
-            __func__, a2dp_sbc_encoder_cb.TxAaMtuSize, peer_mtu, min_bitpool,
-            max_bitpool);
+            __func__, p_cb->TxAaMtuSize, peer_mtu, min_bitpool, max_bitpool);
   LOG_DEBUG(LOG_TAG,
             "%s: ChannelMode=%d, NumOfSubBands=%d, NumOfBlocks=%d, "
             "AllocationMethod=%d, BitRate=%d, SamplingFreq=%d BitPool=%d",
@@ -368,33 +446,38 @@ static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
             p_encoder_params->u16BitRate, p_encoder_params->s16BitPool);
 
   /* Reset the SBC encoder */
-  SBC_Encoder_Init(&a2dp_sbc_encoder_cb.sbc_encoder_params);
-  a2dp_sbc_encoder_cb.tx_sbc_frames = calculate_max_frames_per_packet();
+  SBC_Encoder_Init(&p_cb->sbc_encoder_params);
+  p_cb->tx_sbc_frames = calculate_max_frames_per_packet(p_cb);
 }
 
 void a2dp_sbc_encoder_cleanup(void) {
-  memset(&a2dp_sbc_encoder_cb, 0, sizeof(a2dp_sbc_encoder_cb));
+  a2dp_sbc_encoder_cb = tA2DP_SBC_ENCODER_CB();
 }
 
 void a2dp_sbc_feeding_reset(void) {
+  a2dp_sbc_feeding_reset(&a2dp_sbc_encoder_cb);
+}
+
+static void a2dp_sbc_feeding_reset(tA2DP_SBC_ENCODER_CB* p_cb) {
   /* By default, just clear the entire state */
-  memset(&a2dp_sbc_encoder_cb.feeding_state, 0,
-         sizeof(a2dp_sbc_encoder_cb.feeding_state));
-
-  a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick =
-      (a2dp_sbc_encoder_cb.feeding_params.sample_rate *
-       a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8 *
-       a2dp_sbc_encoder_cb.feeding_params.channel_count *
-       A2DP_SBC_ENCODER_INTERVAL_MS) /
+  memset(&p_cb->feeding_state, 0, sizeof(p_cb->feeding_state));
+
+  p_cb->feeding_state.bytes_per_tick =
+      (p_cb->feeding_params.sample_rate * p_cb->feeding_params.bits_per_sample /
+       8 * p_cb->feeding_params.channel_count * A2DP_SBC_ENCODER_INTERVAL_MS) /
       1000;
 
   LOG_DEBUG(LOG_TAG, "%s: PCM bytes per tick %u", __func__,
-            a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick);
+            p_cb->feeding_state.bytes_per_tick);
 }
 
 void a2dp_sbc_feeding_flush(void) {
-  a2dp_sbc_encoder_cb.feeding_state.counter = 0;
-  a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue = 0;
+  a2dp_sbc_feeding_flush(&a2dp_sbc_encoder_cb);
+}
+
+static void a2dp_sbc_feeding_flush(tA2DP_SBC_ENCODER_CB* p_cb) {
+  p_cb->feeding_state.counter = 0;
+  p_cb->feeding_state.aa_feed_residue = 0;
 }
 
 uint64_t a2dp_sbc_get_encoder_interval_ms(void) {
@@ -402,56 +485,61 @@ uint64_t a2dp_sbc_get_encoder_interval_ms(void) {
 }
 
 void a2dp_sbc_send_frames(uint64_t timestamp_us) {
+  a2dp_sbc_send_frames(&a2dp_sbc_encoder_cb, timestamp_us);
+}
+
+static void a2dp_sbc_send_frames(tA2DP_SBC_ENCODER_CB* p_cb,
+                                 uint64_t timestamp_us) {
   uint8_t nb_frame = 0;
   uint8_t nb_iterations = 0;
 
-  a2dp_sbc_get_num_frame_iteration(&nb_iterations, &nb_frame, timestamp_us);
+  a2dp_sbc_get_num_frame_iteration(p_cb, &nb_iterations, &nb_frame,
+                                   timestamp_us);
   LOG_VERBOSE(LOG_TAG, "%s: Sending %d frames per iteration, %d iterations",
               __func__, nb_frame, nb_iterations);
   if (nb_frame == 0) return;
 
   for (uint8_t counter = 0; counter < nb_iterations; counter++) {
     // Transcode frame and enqueue
-    a2dp_sbc_encode_frames(nb_frame);
+    a2dp_sbc_encode_frames(p_cb, nb_frame);
   }
 }
 
 // Obtains the number of frames to send and number of iterations
 // to be used. |num_of_iterations| and |num_of_frames| parameters
 // are used as output param for returning the respective values.
-static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
+static void a2dp_sbc_get_num_frame_iteration(tA2DP_SBC_ENCODER_CB* p_cb,
+                                             uint8_t* num_of_iterations,
                                              uint8_t* num_of_frames,
                                              uint64_t timestamp_us) {
   uint8_t nof = 0;
   uint8_t noi = 1;
 
   uint32_t projected_nof = 0;
-  uint32_t pcm_bytes_per_frame =
-      a2dp_sbc_encoder_cb.sbc_encoder_params.s16NumOfSubBands *
-      a2dp_sbc_encoder_cb.sbc_encoder_params.s16NumOfBlocks *
-      a2dp_sbc_encoder_cb.feeding_params.channel_count *
-      a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8;
+  uint32_t pcm_bytes_per_frame = p_cb->sbc_encoder_params.s16NumOfSubBands *
+                                 p_cb->sbc_encoder_params.s16NumOfBlocks *
+                                 p_cb->feeding_params.channel_count *
+                                 p_cb->feeding_params.bits_per_sample / 8;
   LOG_VERBOSE(LOG_TAG, "%s: pcm_bytes_per_frame %u", __func__,
               pcm_bytes_per_frame);
 
   uint32_t hecto_ns_this_tick = A2DP_SBC_ENCODER_INTERVAL_MS * 10000;
-  uint64_t* last_100ns =
-      &a2dp_sbc_encoder_cb.feeding_state.last_frame_timestamp_100ns;
+  uint64_t* last_100ns = &p_cb->feeding_state.last_frame_timestamp_100ns;
   uint64_t now_100ns = timestamp_us * 10;
   if (*last_100ns != 0) {
     hecto_ns_this_tick = (now_100ns - *last_100ns);
   }
   *last_100ns = now_100ns;
 
-  uint32_t bytes_this_tick = a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick *
+  uint32_t bytes_this_tick = p_cb->feeding_state.bytes_per_tick *
                              hecto_ns_this_tick /
                              (A2DP_SBC_ENCODER_INTERVAL_MS * 10000);
-  a2dp_sbc_encoder_cb.feeding_state.counter += bytes_this_tick;
+  p_cb->feeding_state.counter += bytes_this_tick;
   // Without this erratum, there was a three microseocnd shift per tick which
   // would cause one SBC frame mismatched after every 20 seconds
   uint32_t erratum_100ns =
       ceil(1.0f * A2DP_SBC_ENCODER_INTERVAL_MS * 10000 * bytes_this_tick /
-           a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick);
+           p_cb->feeding_state.bytes_per_tick);
   if (erratum_100ns < hecto_ns_this_tick) {
     LOG_VERBOSE(LOG_TAG,
                 "%s: hecto_ns_this_tick=%d, bytes=%d, erratum_100ns=%d",
@@ -460,10 +548,9 @@ static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
   }
 
   /* Calculate the number of frames pending for this media tick */
-  projected_nof =
-      a2dp_sbc_encoder_cb.feeding_state.counter / pcm_bytes_per_frame;
+  projected_nof = p_cb->feeding_state.counter / pcm_bytes_per_frame;
   // Update the stats
-  a2dp_sbc_encoder_cb.stats.media_read_total_expected_frames += projected_nof;
+  p_cb->stats.media_read_total_expected_frames += projected_nof;
 
   if (projected_nof > MAX_PCM_FRAME_NUM_PER_TICK) {
     LOG_WARN(LOG_TAG, "%s: limiting frames to be sent from %d to %d", __func__,
@@ -471,7 +558,7 @@ static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
 
     // Update the stats
     size_t delta = projected_nof - MAX_PCM_FRAME_NUM_PER_TICK;
-    a2dp_sbc_encoder_cb.stats.media_read_total_dropped_frames += delta;
+    p_cb->stats.media_read_total_dropped_frames += delta;
 
     projected_nof = MAX_PCM_FRAME_NUM_PER_TICK;
   }
@@ -479,14 +566,14 @@ static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
   LOG_VERBOSE(LOG_TAG, "%s: frames for available PCM data %u", __func__,
               projected_nof);
 
-  if (a2dp_sbc_encoder_cb.is_peer_edr) {
-    if (!a2dp_sbc_encoder_cb.tx_sbc_frames) {
+  if (p_cb->is_peer_edr) {
+    if (!p_cb->tx_sbc_frames) {
       LOG_ERROR(LOG_TAG, "%s: tx_sbc_frames not updated, update from here",
                 __func__);
-      a2dp_sbc_encoder_cb.tx_sbc_frames = calculate_max_frames_per_packet();
+      p_cb->tx_sbc_frames = calculate_max_frames_per_packet(p_cb);
     }
 
-    nof = a2dp_sbc_encoder_cb.tx_sbc_frames;
+    nof = p_cb->tx_sbc_frames;
     if (!nof) {
       LOG_ERROR(LOG_TAG,
                 "%s: number of frames not updated, set calculated values",
@@ -500,8 +587,7 @@ static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
           LOG_ERROR(LOG_TAG, "%s: Audio Congestion (iterations:%d > max (%d))",
                     __func__, noi, A2DP_SBC_MAX_PCM_ITER_NUM_PER_TICK);
           noi = A2DP_SBC_MAX_PCM_ITER_NUM_PER_TICK;
-          a2dp_sbc_encoder_cb.feeding_state.counter =
-              noi * nof * pcm_bytes_per_frame;
+          p_cb->feeding_state.counter = noi * nof * pcm_bytes_per_frame;
         }
         projected_nof = nof;
       } else {
@@ -520,15 +606,14 @@ static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
 
       // Update the stats
       size_t delta = projected_nof - MAX_PCM_FRAME_NUM_PER_TICK;
-      a2dp_sbc_encoder_cb.stats.media_read_total_dropped_frames += delta;
+      p_cb->stats.media_read_total_dropped_frames += delta;
 
       projected_nof = MAX_PCM_FRAME_NUM_PER_TICK;
-      a2dp_sbc_encoder_cb.feeding_state.counter =
-          noi * projected_nof * pcm_bytes_per_frame;
+      p_cb->feeding_state.counter = noi * projected_nof * pcm_bytes_per_frame;
     }
     nof = projected_nof;
   }
-  a2dp_sbc_encoder_cb.feeding_state.counter -= noi * nof * pcm_bytes_per_frame;
+  p_cb->feeding_state.counter -= noi * nof * pcm_bytes_per_frame;
   LOG_VERBOSE(LOG_TAG, "%s: effective num of frames %u, iterations %u",
               __func__, nof, noi);
 
@@ -536,8 +621,9 @@ static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
   *num_of_iterations = noi;
 }
 
-static void a2dp_sbc_encode_frames(uint8_t nb_frame) {
-  SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+static void a2dp_sbc_encode_frames(tA2DP_SBC_ENCODER_CB* p_cb,
+                                   uint8_t nb_frame) {
+  SBC_ENC_PARAMS* p_encoder_params = &p_cb->sbc_encoder_params;
   uint8_t remain_nb_frame = nb_frame;
   uint16_t blocm_x_subband =
       p_encoder_params->s16NumOfSubBands * p_encoder_params->s16NumOfBlocks;
@@ -551,19 +637,19 @@ static void a2dp_sbc_encode_frames(uint8_t nb_frame) {
     p_buf->offset = A2DP_SBC_OFFSET;
     p_buf->len = 0;
     p_buf->layer_specific = 0;
-    a2dp_sbc_encoder_cb.stats.media_read_total_expected_packets++;
+    p_cb->stats.media_read_total_expected_packets++;
 
     do {
       /* Fill allocated buffer with 0 */
-      memset(a2dp_sbc_encoder_cb.pcmBuffer, 0,
+      memset(p_cb->pcmBuffer, 0,
              blocm_x_subband * p_encoder_params->s16NumOfChannels);
       //
       // Read the PCM data and encode it. If necessary, upsample the data.
       //
       uint32_t num_bytes = 0;
-      if (a2dp_sbc_read_feeding(&num_bytes)) {
+      if (a2dp_sbc_read_feeding(p_cb, &num_bytes)) {
         uint8_t* output = (uint8_t*)(p_buf + 1) + p_buf->offset + p_buf->len;
-        int16_t* input = a2dp_sbc_encoder_cb.pcmBuffer;
+        int16_t* input = p_cb->pcmBuffer;
         uint16_t output_len = SBC_Encode(p_encoder_params, input, output);
         last_frame_len = output_len;
 
@@ -575,56 +661,49 @@ static void a2dp_sbc_encode_frames(uint8_t nb_frame) {
         bytes_read += num_bytes;
       } else {
         LOG_WARN(LOG_TAG, "%s: underflow %d, %d", __func__, nb_frame,
-                 a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue);
-        a2dp_sbc_encoder_cb.feeding_state.counter +=
+                 p_cb->feeding_state.aa_feed_residue);
+        p_cb->feeding_state.counter +=
             nb_frame * p_encoder_params->s16NumOfSubBands *
             p_encoder_params->s16NumOfBlocks *
-            a2dp_sbc_encoder_cb.feeding_params.channel_count *
-            a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8;
+            p_cb->feeding_params.channel_count *
+            p_cb->feeding_params.bits_per_sample / 8;
         /* no more pcm to read */
         nb_frame = 0;
       }
-    } while (
-        ((p_buf->len + last_frame_len) < a2dp_sbc_encoder_cb.TxAaMtuSize) &&
-        (p_buf->layer_specific < 0x0F) && nb_frame);
+    } while (((p_buf->len + last_frame_len) < p_cb->TxAaMtuSize) &&
+             (p_buf->layer_specific < 0x0F) && nb_frame);
 
     if (p_buf->len) {
       /*
        * Timestamp of the media packet header represent the TS of the
        * first SBC frame, i.e the timestamp before including this frame.
        */
-      *((uint32_t*)(p_buf + 1)) = a2dp_sbc_encoder_cb.timestamp;
+      *((uint32_t*)(p_buf + 1)) = p_cb->timestamp;
 
-      a2dp_sbc_encoder_cb.timestamp += p_buf->layer_specific * blocm_x_subband;
+      p_cb->timestamp += p_buf->layer_specific * blocm_x_subband;
 
       uint8_t done_nb_frame = remain_nb_frame - nb_frame;
       remain_nb_frame = nb_frame;
-      if (!a2dp_sbc_encoder_cb.enqueue_callback(p_buf, done_nb_frame,
-                                                bytes_read))
-        return;
+      if (!p_cb->enqueue_callback(p_buf, done_nb_frame, bytes_read)) return;
     } else {
-      a2dp_sbc_encoder_cb.stats.media_read_total_dropped_packets++;
+      p_cb->stats.media_read_total_dropped_packets++;
       osi_free(p_buf);
     }
   }
 }
 
-static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
-  SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+static bool a2dp_sbc_read_feeding(tA2DP_SBC_ENCODER_CB* p_cb,
+                                  uint32_t* bytes_read) {
+  SBC_ENC_PARAMS* p_encoder_params = &p_cb->sbc_encoder_params;
   uint16_t blocm_x_subband =
       p_encoder_params->s16NumOfSubBands * p_encoder_params->s16NumOfBlocks;
   uint32_t read_size;
   uint32_t sbc_sampling = 48000;
   uint32_t src_samples;
   uint16_t bytes_needed = blocm_x_subband * p_encoder_params->s16NumOfChannels *
-                          a2dp_sbc_encoder_cb.feeding_params.bits_per_sample /
-                          8;
-  static uint16_t up_sampled_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS *
-                                    SBC_MAX_NUM_OF_CHANNELS *
-                                    SBC_MAX_NUM_OF_SUBBANDS * 2];
-  static uint16_t read_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS *
-                              SBC_MAX_NUM_OF_CHANNELS *
-                              SBC_MAX_NUM_OF_SUBBANDS];
+                          p_cb->feeding_params.bits_per_sample / 8;
+  uint16_t* up_sampled_buffer = p_cb->up_sampled_buffer;
+  uint16_t* read_buffer = p_cb->read_buffer;
   uint32_t src_size_used;
   uint32_t dst_size_used;
   bool fract_needed;
@@ -648,25 +727,22 @@ static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
       break;
   }
 
-  a2dp_sbc_encoder_cb.stats.media_read_total_expected_reads_count++;
-  if (sbc_sampling == a2dp_sbc_encoder_cb.feeding_params.sample_rate) {
-    read_size =
-        bytes_needed - a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue;
-    a2dp_sbc_encoder_cb.stats.media_read_total_expected_read_bytes += read_size;
-    nb_byte_read = a2dp_sbc_encoder_cb.read_callback(
-        ((uint8_t*)a2dp_sbc_encoder_cb.pcmBuffer) +
-            a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue,
+  p_cb->stats.media_read_total_expected_reads_count++;
+  if (sbc_sampling == p_cb->feeding_params.sample_rate) {
+    read_size = bytes_needed - p_cb->feeding_state.aa_feed_residue;
+    p_cb->stats.media_read_total_expected_read_bytes += read_size;
+    nb_byte_read = p_cb->read_callback(
+        ((uint8_t*)p_cb->pcmBuffer) + p_cb->feeding_state.aa_feed_residue,
         read_size);
-    a2dp_sbc_encoder_cb.stats.media_read_total_actual_read_bytes +=
-        nb_byte_read;
+    p_cb->stats.media_read_total_actual_read_bytes += nb_byte_read;
 
     *bytes_read = nb_byte_read;
     if (nb_byte_read != read_size) {
-      a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue += nb_byte_read;
+      p_cb->feeding_state.aa_feed_residue += nb_byte_read;
       return false;
     }
-    a2dp_sbc_encoder_cb.stats.media_read_total_actual_reads_count++;
-    a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue = 0;
+    p_cb->stats.media_read_total_actual_reads_count++;
+    p_cb->feeding_state.aa_feed_residue = 0;
     return true;
   }
 
@@ -676,7 +752,7 @@ static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
    * E.g 128 / 6 = 21.3333 => read 22 and 21 and 21 => max = 2; threshold = 0
    */
   fract_needed = false; /* Default */
-  switch (a2dp_sbc_encoder_cb.feeding_params.sample_rate) {
+  switch (p_cb->feeding_params.sample_rate) {
     case 32000:
     case 8000:
       fract_needed = true;
@@ -692,32 +768,31 @@ static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
 
   /* Compute number of sample to read from source */
   src_samples = blocm_x_subband;
-  src_samples *= a2dp_sbc_encoder_cb.feeding_params.sample_rate;
+  src_samples *= p_cb->feeding_params.sample_rate;
   src_samples /= sbc_sampling;
 
   /* The previous division may have a remainder not null */
   if (fract_needed) {
-    if (a2dp_sbc_encoder_cb.feeding_state.aa_feed_counter <= fract_threshold) {
+    if (p_cb->feeding_state.aa_feed_counter <= fract_threshold) {
       src_samples++; /* for every read before threshold add one sample */
     }
 
     /* do nothing if counter >= threshold */
-    a2dp_sbc_encoder_cb.feeding_state.aa_feed_counter++; /* one more read */
-    if (a2dp_sbc_encoder_cb.feeding_state.aa_feed_counter > fract_max) {
-      a2dp_sbc_encoder_cb.feeding_state.aa_feed_counter = 0;
+    p_cb->feeding_state.aa_feed_counter++; /* one more read */
+    if (p_cb->feeding_state.aa_feed_counter > fract_max) {
+      p_cb->feeding_state.aa_feed_counter = 0;
     }
   }
 
   /* Compute number of bytes to read from source */
   read_size = src_samples;
-  read_size *= a2dp_sbc_encoder_cb.feeding_params.channel_count;
-  read_size *= (a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8);
-  a2dp_sbc_encoder_cb.stats.media_read_total_expected_read_bytes += read_size;
+  read_size *= p_cb->feeding_params.channel_count;
+  read_size *= (p_cb->feeding_params.bits_per_sample / 8);
+  p_cb->stats.media_read_total_expected_read_bytes += read_size;
 
   /* Read Data from UIPC channel */
-  nb_byte_read =
-      a2dp_sbc_encoder_cb.read_callback((uint8_t*)read_buffer, read_size);
-  a2dp_sbc_encoder_cb.stats.media_read_total_actual_read_bytes += nb_byte_read;
+  nb_byte_read = p_cb->read_callback((uint8_t*)read_buffer, read_size);
+  p_cb->stats.media_read_total_actual_read_bytes += nb_byte_read;
 
   if (nb_byte_read < read_size) {
     if (nb_byte_read == 0) return false;
@@ -726,13 +801,12 @@ static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
     memset(((uint8_t*)read_buffer) + nb_byte_read, 0, read_size - nb_byte_read);
     nb_byte_read = read_size;
   }
-  a2dp_sbc_encoder_cb.stats.media_read_total_actual_reads_count++;
+  p_cb->stats.media_read_total_actual_reads_count++;
 
   /* Initialize PCM up-sampling engine */
-  a2dp_sbc_init_up_sample(a2dp_sbc_encoder_cb.feeding_params.sample_rate,
-                          sbc_sampling,
-                          a2dp_sbc_encoder_cb.feeding_params.bits_per_sample,
-                          a2dp_sbc_encoder_cb.feeding_params.channel_count);
+  a2dp_sbc_init_up_sample(p_cb->feeding_params.sample_rate, sbc_sampling,
+                          p_cb->feeding_params.bits_per_sample,
+                          p_cb->feeding_params.channel_count);
 
   /*
    * Re-sample the read buffer.
@@ -740,43 +814,39 @@ static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
    */
   dst_size_used = a2dp_sbc_up_sample(
       (uint8_t*)read_buffer,
-      (uint8_t*)up_sampled_buffer +
-          a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue,
-      nb_byte_read, sizeof(up_sampled_buffer) -
-                        a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue,
+      (uint8_t*)up_sampled_buffer + p_cb->feeding_state.aa_feed_residue,
+      nb_byte_read,
+      sizeof(p_cb->up_sampled_buffer) - p_cb->feeding_state.aa_feed_residue,
       &src_size_used);
 
   /* update the residue */
-  a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue += dst_size_used;
+  p_cb->feeding_state.aa_feed_residue += dst_size_used;
 
   /* only copy the pcm sample when we have up-sampled enough PCM */
-  if (a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue < bytes_needed)
-    return false;
+  if (p_cb->feeding_state.aa_feed_residue < bytes_needed) return false;
 
   /* Copy the output pcm samples in SBC encoding buffer */
-  memcpy((uint8_t*)a2dp_sbc_encoder_cb.pcmBuffer, (uint8_t*)up_sampled_buffer,
-         bytes_needed);
+  memcpy((uint8_t*)p_cb->pcmBuffer, (uint8_t*)up_sampled_buffer, bytes_needed);
   /* update the residue */
-  a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue -= bytes_needed;
+  p_cb->feeding_state.aa_feed_residue -= bytes_needed;
 
-  if (a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue != 0) {
+  if (p_cb->feeding_state.aa_feed_residue != 0) {
     memcpy((uint8_t*)up_sampled_buffer,
            (uint8_t*)up_sampled_buffer + bytes_needed,
-           a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue);
+           p_cb->feeding_state.aa_feed_residue);
   }
   return true;
 }
 
-static uint8_t calculate_max_frames_per_packet(void) {
-  uint16_t effective_mtu_size = a2dp_sbc_encoder_cb.TxAaMtuSize;
-  SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+static uint8_t calculate_max_frames_per_packet(tA2DP_SBC_ENCODER_CB* p_cb) {
+  uint16_t effective_mtu_size = p_cb->TxAaMtuSize;
+  SBC_ENC_PARAMS* p_encoder_params = &p_cb->sbc_encoder_params;
   uint16_t result = 0;
   uint32_t frame_len;
 
   LOG_VERBOSE(LOG_TAG, "%s: original AVDTP MTU size: %d", __func__,
-              a2dp_sbc_encoder_cb.TxAaMtuSize);
-  if (a2dp_sbc_encoder_cb.is_peer_edr &&
-      !a2dp_sbc_encoder_cb.peer_supports_3mbps) {
+              p_cb->TxAaMtuSize);
+  if (p_cb->is_peer_edr && !p_cb->peer_supports_3mbps) {
     // This condition would be satisfied only if the remote device is
     // EDR and supports only 2 Mbps, but the effective AVDTP MTU size
     // exceeds the 2DH5 packet size.
@@ -788,7 +858,7 @@ static uint8_t calculate_max_frames_per_packet(void) {
       LOG_WARN(LOG_TAG, "%s: Restricting AVDTP MTU size to %d", __func__,
                MAX_2MBPS_AVDTP_MTU);
       effective_mtu_size = MAX_2MBPS_AVDTP_MTU;
-      a2dp_sbc_encoder_cb.TxAaMtuSize = effective_mtu_size;
+      p_cb->TxAaMtuSize = effective_mtu_size;
     }
   }
 
@@ -808,7 +878,7 @@ static uint8_t calculate_max_frames_per_packet(void) {
     p_encoder_params->s16NumOfChannels = SBC_MAX_NUM_OF_CHANNELS;
   }
 
-  frame_len = a2dp_sbc_frame_length();
+  frame_len = a2dp_sbc_frame_length(p_cb);
 
   LOG_VERBOSE(LOG_TAG, "%s: Effective Tx MTU to be considered: %d", __func__,
               effective_mtu_size);
@@ -845,11 +915,11 @@ static uint8_t calculate_max_frames_per_packet(void) {
   return result;
 }
 
-static uint16_t a2dp_sbc_source_rate() {
+static uint16_t a2dp_sbc_source_rate(const tA2DP_SBC_ENCODER_CB* p_cb) {
   uint16_t rate = A2DP_SBC_DEFAULT_BITRATE;
 
   /* restrict bitrate if a2dp link is non-edr */
-  if (!a2dp_sbc_encoder_cb.is_peer_edr) {
+  if (!p_cb->is_peer_edr) {
     rate = A2DP_SBC_NON_EDR_MAX_RATE;
     LOG_VERBOSE(LOG_TAG, "%s: non-edr a2dp sink detected, restrict rate to %d",
                 __func__, rate);
@@ -858,8 +928,8 @@ static uint16_t a2dp_sbc_source_rate() {
   return rate;
 }
 
-static uint32_t a2dp_sbc_frame_length(void) {
-  SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+static uint32_t a2dp_sbc_frame_length(tA2DP_SBC_ENCODER_CB* p_cb) {
+  SBC_ENC_PARAMS* p_encoder_params = &p_cb->sbc_encoder_params;
   uint32_t frame_len = 0;
 
   LOG_VERBOSE(LOG_TAG,
@@ -931,9 +1001,12 @@ int A2dpCodecConfigSbcSource::getEffectiveMtu() const {
 }
 
 void A2dpCodecConfigSbcSource::debug_codec_dump(int fd) {
-  a2dp_sbc_encoder_stats_t* stats = &a2dp_sbc_encoder_cb.stats;
-
   A2dpCodecConfig::debug_codec_dump(fd);
+  a2dp_sbc_debug_dump(fd, &a2dp_sbc_encoder_cb);
+}
+
+static void a2dp_sbc_debug_dump(int fd, const tA2DP_SBC_ENCODER_CB* p_cb) {
+  const a2dp_sbc_encoder_stats_t* stats = &p_cb->stats;
 
   dprintf(fd,
           "  Packet counts (expected/dropped)                        : %zu / "
@@ -91,7 +91,9 @@ static const tA2DP_ENCODER_INTERFACE a2dp_encoder_interface_ldac = {
     a2dp_vendor_ldac_feeding_flush,
     a2dp_vendor_ldac_get_encoder_interval_ms,
     a2dp_vendor_ldac_send_frames,
-    a2dp_vendor_ldac_set_transmit_queue_length};
+    a2dp_vendor_ldac_set_transmit_queue_length,
+    nullptr  // create_session
+};
 
 static const tA2DP_DECODER_INTERFACE a2dp_decoder_interface_ldac = {
     a2dp_vendor_ldac_decoder_init,          a2dp_vendor_ldac_decoder_cleanup,
@@ -33,6 +33,7 @@
 #include "bt_types.h"
 #include "bt_utils.h"
 #include "btm_ble_api.h"
+#include "btm_ble_rpa_cache.h"
 #include "btm_int.h"
 #include "btu.h"
 #include "device/include/controller.h"
@@ -1386,6 +1387,8 @@ void btm_sec_save_le_key(const RawAddress& bd_addr, tBTM_LE_KEY_TYPE key_type,
 
       case BTM_LE_KEY_PID:
         p_rec->ble.keys.irk = p_keys->pid_key.irk;
+        /* addresses cached as unresolvable might resolve with the new IRK */
+        rpa_cache::clear();
         p_rec->ble.identity_addr = p_keys->pid_key.identity_addr;
         p_rec->ble.identity_addr_type = p_keys->pid_key.identity_addr_type;
         p_rec->ble.key_type |= BTM_LE_KEY_PID;
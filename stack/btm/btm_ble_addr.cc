@@ -33,6 +33,8 @@
 #include "hcimsgs.h"
 
 #include "btm_ble_int.h"
+#include "btm_ble_rpa_cache.h"
+#include "common/time_util.h"
 #include "stack/crypto_toolbox/crypto_toolbox.h"
 
 /* This function generates Resolvable Private Address (RPA) from Identity
@@ -176,28 +178,38 @@ bool btm_ble_init_pseudo_addr(tBTM_SEC_DEV_REC* p_dev_rec,
   return false;
 }
 
-/* Return true if given Resolvable Privae Address |rpa| matches Identity
- * Resolving Key |irk| */
-static bool rpa_matches_irk(const RawAddress& rpa, const Octet16& irk) {
-  /* use the 3 MSB of bd address as prand */
-  uint8_t rand[3];
-  rand[0] = rpa.address[2];
-  rand[1] = rpa.address[1];
-  rand[2] = rpa.address[0];
+/* Return true if |p_dev_rec| has an Identity Resolving Key of the peer */
+static bool btm_ble_dev_has_irk(const tBTM_SEC_DEV_REC* p_dev_rec) {
+  return (p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) &&
+         (p_dev_rec->ble.key_type & BTM_LE_KEY_PID);
+}
 
-  /* generate X = E irk(R0, R1, R2) and R is random address 3 LSO */
-  Octet16 x = crypto_toolbox::aes_128(irk, &rand[0], 3);
+/** Find the IRK that Resolvable Private Address |rpa| was generated with.
+ * The result is cached; on a miss, |rpa| is checked against the IRKs of all
+ * security records in one pass, in record order, so the first matching record
+ * is the same as when the records are tried one by one. */
+static std::optional<Octet16> btm_ble_resolve_irk(const RawAddress& rpa) {
+  std::optional<Octet16> irk;
+  if (rpa_cache::find(rpa, &irk)) return irk;
 
-  rand[0] = rpa.address[5];
-  rand[1] = rpa.address[4];
-  rand[2] = rpa.address[3];
+  uint64_t start_us = bluetooth::common::time_get_os_boottime_us();
 
-  if (memcmp(x.data(), &rand[0], 3) == 0) {
-    // match
-    return true;
+  static std::vector<Octet16> irks;
+  irks.clear();
+  list_node_t* end = list_end(btm_cb.sec_dev_rec);
+  for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
+       node = list_next(node)) {
+    tBTM_SEC_DEV_REC* p_dev_rec =
+        static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
+    if (btm_ble_dev_has_irk(p_dev_rec)) irks.push_back(p_dev_rec->ble.keys.irk);
   }
-  // not a match
-  return false;
+
+  const Octet16* match = rpa_cache::resolve(rpa, irks);
+  if (match != nullptr) irk = *match;
+
+  rpa_cache::put(rpa, irk,
+                 bluetooth::common::time_get_os_boottime_us() - start_us);
+  return irk;
 }
 
 /** This function checks if a RPA is resolvable by the device key.
@@ -207,11 +219,11 @@ bool btm_ble_addr_resolvable(const RawAddress& rpa,
                              tBTM_SEC_DEV_REC* p_dev_rec) {
   if (!BTM_BLE_IS_RESOLVE_BDA(rpa)) return false;
 
-  if ((p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) &&
-      (p_dev_rec->ble.key_type & BTM_LE_KEY_PID)) {
+  if (btm_ble_dev_has_irk(p_dev_rec)) {
     BTM_TRACE_DEBUG("%s try to resolve", __func__);
 
-    if (rpa_matches_irk(rpa, p_dev_rec->ble.keys.irk)) {
+    std::optional<Octet16> irk = btm_ble_resolve_irk(rpa);
+    if (irk && *irk == p_dev_rec->ble.keys.irk) {
       btm_ble_init_pseudo_addr(p_dev_rec, rpa);
       return true;
     }
@@ -219,23 +231,12 @@ bool btm_ble_addr_resolvable(const RawAddress& rpa,
   return false;
 }
 
-/** This function match the random address to the appointed device record,
- * starting from calculating IRK. If the record index exceeds the maximum record
- * number, matching failed and send a callback. */
+/** Match the IRK a random address was resolved with to a device record. */
 static bool btm_ble_match_random_bda(void* data, void* context) {
-  BTM_TRACE_EVENT("%s next iteration", __func__);
-  RawAddress* random_bda = (RawAddress*)context;
-
+  const Octet16* irk = static_cast<const Octet16*>(context);
   tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
 
-  BTM_TRACE_DEBUG("sec_flags = %02x device_type = %d", p_dev_rec->sec_flags,
-                  p_dev_rec->device_type);
-
-  if (!(p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) ||
-      !(p_dev_rec->ble.key_type & BTM_LE_KEY_PID))
-    return true;
-
-  if (rpa_matches_irk(*random_bda, p_dev_rec->ble.keys.irk)) {
+  if (btm_ble_dev_has_irk(p_dev_rec) && p_dev_rec->ble.keys.irk == *irk) {
     BTM_TRACE_EVENT("match is found");
     // if it was match, finish iteration, otherwise continue
     return false;
@@ -252,13 +253,13 @@ static bool btm_ble_match_random_bda(void* data, void* context) {
 tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
   BTM_TRACE_EVENT("%s", __func__);
 
-  /* start to resolve random address */
-  /* check for next security record */
-
-  list_node_t* n = list_foreach(btm_cb.sec_dev_rec, btm_ble_match_random_bda,
-                                (void*)&random_bda);
   tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
-  if (n != nullptr) p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  std::optional<Octet16> irk = btm_ble_resolve_irk(random_bda);
+  if (irk) {
+    list_node_t* n =
+        list_foreach(btm_cb.sec_dev_rec, btm_ble_match_random_bda, &*irk);
+    if (n != nullptr) p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  }
 
   BTM_TRACE_EVENT("%s:  %sresolved", __func__,
                   (p_dev_rec == nullptr ? "not " : ""));
@@ -0,0 +1,175 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "btm_ble_adv_reassembly.h"
+
+#include <stdio.h>
+#include <memory>
+
+#include "bt_target.h"
+#include "common/lru.h"
+#include "common/time_util.h"
+
+using bluetooth::common::LruCache;
+using bluetooth::common::time_get_os_boottime_ms;
+
+namespace adv_reassembly {
+
+namespace {
+struct Entry {
+  std::vector<uint8_t> data;
+  uint64_t updated_ms;
+};
+
+/* address type, address and SID fit in 64 bits */
+using Key = uint64_t;
+
+std::unique_ptr<LruCache<Key, Entry>> table;
+size_t table_capacity = BTM_BLE_ADV_REASSEMBLY_SIZE;
+uint64_t table_timeout_ms = BTM_BLE_ADV_REASSEMBLY_TIMEOUT_MS;
+/* buffers of dropped entries, kept for reuse */
+std::vector<std::vector<uint8_t>> pool;
+Stats stats;
+
+LruCache<Key, Entry>& get_table() {
+  if (!table) {
+    table = std::make_unique<LruCache<Key, Entry>>(table_capacity,
+                                                   "adv_reassembly");
+  }
+  return *table;
+}
+
+Key make_key(uint8_t addr_type, const RawAddress& addr, uint8_t sid) {
+  Key key = addr_type;
+  for (uint8_t octet : addr.address) key = (key << 8) | octet;
+  return (key << 8) | sid;
+}
+
+bool is_expired(const Entry& entry, uint64_t now_ms) {
+  return now_ms - entry.updated_ms >= table_timeout_ms;
+}
+
+void release(std::vector<uint8_t> data) {
+  if (pool.size() >= table_capacity) return;
+  data.clear();
+  pool.push_back(std::move(data));
+}
+
+/* Returns the entry of |key|, dropping it first if it has expired */
+Entry* find(Key key, uint64_t now_ms) {
+  Entry* entry = get_table().Find(key);
+  if (entry == nullptr || !is_expired(*entry, now_ms)) return entry;
+
+  stats.expired++;
+  release(std::move(entry->data));
+  get_table().Remove(key);
+  return nullptr;
+}
+
+/* Returns a new, empty entry for |key| */
+Entry* add(Key key, uint64_t now_ms) {
+  Entry entry{{}, now_ms};
+  if (!pool.empty()) {
+    entry.data = std::move(pool.back());
+    pool.pop_back();
+  }
+
+  auto dropped = get_table().Put(key, std::move(entry));
+  if (dropped) {
+    /* the least recently updated entry made room */
+    if (is_expired(dropped->second, now_ms))
+      stats.expired++;
+    else
+      stats.evicted++;
+    release(std::move(dropped->second.data));
+  }
+
+  size_t size = get_table().Size();
+  if (size > stats.max_entries) stats.max_entries = size;
+  return get_table().Find(key);
+}
+}  // namespace
+
+const std::vector<uint8_t>& set(uint8_t addr_type, const RawAddress& addr,
+                                uint8_t sid, const std::vector<uint8_t>& data) {
+  uint64_t now_ms = time_get_os_boottime_ms();
+  Key key = make_key(addr_type, addr, sid);
+
+  Entry* entry = find(key, now_ms);
+  if (entry == nullptr) {
+    entry = add(key, now_ms);
+  } else if (!entry->data.empty()) {
+    /* e.g. the scan response to the previous advertisement never came */
+    stats.restarted++;
+  }
+
+  entry->data.assign(data.begin(), data.end());
+  entry->updated_ms = now_ms;
+  return entry->data;
+}
+
+const std::vector<uint8_t>& append(uint8_t addr_type, const RawAddress& addr,
+                                   uint8_t sid,
+                                   const std::vector<uint8_t>& data) {
+  uint64_t now_ms = time_get_os_boottime_ms();
+  Key key = make_key(addr_type, addr, sid);
+
+  Entry* entry = find(key, now_ms);
+  if (entry == nullptr) entry = add(key, now_ms);
+
+  entry->data.insert(entry->data.end(), data.begin(), data.end());
+  entry->updated_ms = now_ms;
+  return entry->data;
+}
+
+void clear(uint8_t addr_type, const RawAddress& addr, uint8_t sid) {
+  if (!table) return;
+
+  Key key = make_key(addr_type, addr, sid);
+  Entry* entry = table->Find(key);
+  if (entry == nullptr) return;
+
+  release(std::move(entry->data));
+  table->Remove(key);
+}
+
+void reset(size_t capacity, uint64_t timeout_ms) {
+  table_capacity = capacity;
+  table_timeout_ms = timeout_ms;
+  table.reset();
+  pool.clear();
+  stats = {};
+}
+
+Stats get_stats() { return stats; }
+
+void dump(int fd) {
+  dprintf(fd, "\nadv_reassembly state:\n");
+  dprintf(fd, "\tentries: %d/%zu, max: %zu, pooled buffers: %zu\n",
+          table ? table->Size() : 0, table_capacity, stats.max_entries,
+          pool.size());
+  dprintf(fd,
+          "\tincomplete reports: %llu (evicted: %llu, expired: %llu, "
+          "restarted: %llu)\n",
+          (unsigned long long)(stats.evicted + stats.expired +
+                               stats.restarted),
+          (unsigned long long)stats.evicted, (unsigned long long)stats.expired,
+          (unsigned long long)stats.restarted);
+}
+
+}  // namespace adv_reassembly
@@ -0,0 +1,74 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "types/raw_address.h"
+
+/* adv_reassembly holds the advertising data of devices that are waiting for
+ * either a scan response, or chained packets on the secondary channel.
+ *
+ * Entries are keyed by address type, address and advertising SID, so an
+ * advertiser running several advertising sets doesn't mix their data. When
+ * the table is full, the least recently updated entry is dropped; entries
+ * without a new fragment for the timeout are dropped as well. Buffers of
+ * dropped entries are kept for reuse, so a busy scan doesn't allocate for
+ * every report.
+ */
+namespace adv_reassembly {
+
+struct Stats {
+  /* entries dropped while still fresh to make room for another advertiser */
+  uint64_t evicted;
+  /* entries dropped because no fragment came within the timeout */
+  uint64_t expired;
+  /* entries whose data was replaced by the start of new data */
+  uint64_t restarted;
+  /* most entries in use at the same time */
+  size_t max_entries;
+};
+
+/* Set the data of |addr_type, addr, sid| to |data|. The returned reference is
+ * valid until the next call. */
+extern const std::vector<uint8_t>& set(uint8_t addr_type,
+                                       const RawAddress& addr, uint8_t sid,
+                                       const std::vector<uint8_t>& data);
+
+/* Append |data| to the data of |addr_type, addr, sid|. The returned reference
+ * is valid until the next call. */
+extern const std::vector<uint8_t>& append(uint8_t addr_type,
+                                          const RawAddress& addr, uint8_t sid,
+                                          const std::vector<uint8_t>& data);
+
+/* Clear the data of |addr_type, addr, sid|, once reported or discarded */
+extern void clear(uint8_t addr_type, const RawAddress& addr, uint8_t sid);
+
+/* Drop all entries, buffers and counters, and change the size of the table and
+ * the entry timeout */
+extern void reset(size_t capacity, uint64_t timeout_ms);
+
+extern Stats get_stats();
+
+extern void dump(int fd);
+
+}  // namespace adv_reassembly
@@ -30,11 +30,11 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
-#include <list>
 #include <vector>
 
 #include "bt_types.h"
 #include "bt_utils.h"
+#include "btm_ble_adv_reassembly.h"
 #include "btm_ble_api.h"
 #include "btm_int.h"
 #include "btu.h"
@@ -67,82 +67,6 @@
   BTM_VSC_CHIP_CAPABILITY_RSP_LEN
 #define BTM_VSC_CHIP_CAPABILITY_RSP_LEN_M_RELEASE 15
 
-namespace {
-
-class AdvertisingCache {
- public:
-  /* Set the data to |data| for device |addr_type, addr| */
-  const std::vector<uint8_t>& Set(uint8_t addr_type, const RawAddress& addr,
-                                  std::vector<uint8_t> data) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      it->data = std::move(data);
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(addr_type, addr, std::move(data));
-    return items.front().data;
-  }
-
-  /* Append |data| for device |addr_type, addr| */
-  const std::vector<uint8_t>& Append(uint8_t addr_type, const RawAddress& addr,
-                                     std::vector<uint8_t> data) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      it->data.insert(it->data.end(), data.begin(), data.end());
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(addr_type, addr, std::move(data));
-    return items.front().data;
-  }
-
-  /* Clear data for device |addr_type, addr| */
-  void Clear(uint8_t addr_type, const RawAddress& addr) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      items.erase(it);
-    }
-  }
-
- private:
-  struct Item {
-    uint8_t addr_type;
-    RawAddress addr;
-    std::vector<uint8_t> data;
-
-    Item(uint8_t addr_type, const RawAddress& addr, std::vector<uint8_t> data)
-        : addr_type(addr_type), addr(addr), data(data) {}
-  };
-
-  std::list<Item>::iterator Find(uint8_t addr_type, const RawAddress& addr) {
-    for (auto it = items.begin(); it != items.end(); it++) {
-      if (it->addr_type == addr_type && it->addr == addr) {
-        return it;
-      }
-    }
-    return items.end();
-  }
-
-  /* we keep maximum 7 devices in the cache */
-  const size_t cache_max = 7;
-  std::list<Item> items;
-};
-
-/* Devices in this cache are waiting for eiter scan response, or chained packets
- * on secondary channel */
-AdvertisingCache cache;
-
-}  // namespace
-
 #if (BLE_VND_INCLUDED == TRUE)
 static tBTM_BLE_CTRL_FEATURES_CBACK* p_ctrl_le_feature_rd_cmpl_cback = NULL;
 #endif
@@ -1754,7 +1678,7 @@ void btm_clear_all_pending_le_entry(void) {
     if ((p_ent->in_use) &&
         (p_ent->inq_info.results.device_type == BT_DEVICE_TYPE_BLE) &&
         !p_ent->scan_rsp)
-      p_ent->in_use = false;
+      btm_inq_db_remove(p_ent);
   }
 }
 
@@ -1955,8 +1879,8 @@ void btm_ble_process_adv_pkt_cont(uint16_t evt_type, uint8_t addr_type,
   // response. In such case make sure data is put at start, not appended to
   // already existing data.
   std::vector<uint8_t> const& adv_data =
-      is_start ? cache.Set(addr_type, bda, std::move(tmp))
-               : cache.Append(addr_type, bda, std::move(tmp));
+      is_start ? adv_reassembly::set(addr_type, bda, advertising_sid, tmp)
+               : adv_reassembly::append(addr_type, bda, advertising_sid, tmp);
 
   bool data_complete = (ble_evt_type_data_status(evt_type) != 0x01);
 
@@ -2019,7 +1943,7 @@ void btm_ble_process_adv_pkt_cont(uint16_t evt_type, uint8_t addr_type,
 
   uint8_t result = btm_ble_is_discoverable(bda, adv_data);
   if (result == 0) {
-    cache.Clear(addr_type, bda);
+    adv_reassembly::clear(addr_type, bda, advertising_sid);
     LOG_WARN(LOG_TAG,
              "%s device no longer discoverable, discarding advertising packet",
              __func__);
@@ -2063,7 +1987,7 @@ void btm_ble_process_adv_pkt_cont(uint16_t evt_type, uint8_t addr_type,
                        const_cast<uint8_t*>(adv_data.data()), adv_data.size());
   }
 
-  cache.Clear(addr_type, bda);
+  adv_reassembly::clear(addr_type, bda, advertising_sid);
 }
 
 void btm_ble_process_phy_update_pkt(uint8_t len, uint8_t* data) {
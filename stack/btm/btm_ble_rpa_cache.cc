@@ -0,0 +1,123 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "btm_ble_rpa_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <memory>
+
+#include "common/lru.h"
+#include "common/time_util.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
+
+using bluetooth::common::LruCache;
+using bluetooth::common::time_get_os_boottime_ms;
+
+namespace rpa_cache {
+
+namespace {
+struct Entry {
+  std::optional<Octet16> irk;
+  uint64_t added_ms;
+};
+
+std::unique_ptr<LruCache<RawAddress, Entry>> cache;
+size_t cache_capacity = RPA_CACHE_SIZE;
+uint64_t cache_timeout_ms = RPA_CACHE_TIMEOUT_MS;
+Stats stats;
+
+LruCache<RawAddress, Entry>& get_cache() {
+  if (!cache) {
+    cache = std::make_unique<LruCache<RawAddress, Entry>>(cache_capacity,
+                                                          "rpa_cache");
+  }
+  return *cache;
+}
+}  // namespace
+
+bool find(const RawAddress& rpa, std::optional<Octet16>* irk) {
+  Entry* entry = get_cache().Find(rpa);
+  if (entry != nullptr &&
+      time_get_os_boottime_ms() - entry->added_ms >= cache_timeout_ms) {
+    get_cache().Remove(rpa);
+    stats.expired++;
+    entry = nullptr;
+  }
+
+  if (entry == nullptr) {
+    stats.misses++;
+    return false;
+  }
+
+  stats.hits++;
+  *irk = entry->irk;
+  return true;
+}
+
+void put(const RawAddress& rpa, const std::optional<Octet16>& irk,
+         uint64_t latency_us) {
+  get_cache().Put(rpa, Entry{irk, time_get_os_boottime_ms()});
+  stats.miss_latency_total_us += latency_us;
+  if (latency_us > stats.miss_latency_max_us)
+    stats.miss_latency_max_us = latency_us;
+}
+
+const Octet16* resolve(const RawAddress& rpa,
+                       const std::vector<Octet16>& irks) {
+  /* prand is the 3 MSB of the address, hash the 3 LSB; the plaintext is the
+   * same for every IRK, so it is built only once */
+  Octet16 prand{0};
+  prand[0] = rpa.address[2];
+  prand[1] = rpa.address[1];
+  prand[2] = rpa.address[0];
+  const uint8_t hash[3] = {rpa.address[5], rpa.address[4], rpa.address[3]};
+
+  for (const Octet16& irk : irks) {
+    Octet16 x = crypto_toolbox::aes_128(irk, prand);
+    if (memcmp(x.data(), hash, sizeof(hash)) == 0) return &irk;
+  }
+  return nullptr;
+}
+
+void clear() {
+  if (cache) cache->Clear();
+}
+
+void reset(size_t capacity, uint64_t timeout_ms) {
+  cache_capacity = capacity;
+  cache_timeout_ms = timeout_ms;
+  cache.reset();
+  stats = {};
+}
+
+Stats get_stats() { return stats; }
+
+void dump(int fd) {
+  dprintf(fd, "\nrpa_cache state:\n");
+  dprintf(fd, "\tentries: %d/%zu\n", cache ? cache->Size() : 0,
+          cache_capacity);
+  dprintf(fd, "\thits: %llu, misses: %llu, expired: %llu\n",
+          (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+          (unsigned long long)stats.expired);
+  dprintf(fd, "\tmiss latency: total %llu us, max %llu us\n",
+          (unsigned long long)stats.miss_latency_total_us,
+          (unsigned long long)stats.miss_latency_max_us);
+}
+
+}  // namespace rpa_cache
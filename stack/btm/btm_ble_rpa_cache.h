@@ -0,0 +1,77 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "stack/include/bt_types.h"
+#include "types/raw_address.h"
+
+/* rpa_cache remembers which Identity Resolving Key a Resolvable Private
+ * Address was resolved with, so that the advertising reports and device
+ * lookups that keep carrying the same RPA don't run AES over the IRK of every
+ * bonded device again.
+ *
+ * Entries store the matching IRK rather than the security record, so they
+ * can't dangle when a record is removed. Addresses that no IRK resolves are
+ * cached too, which is what keeps a crowded scan cheap; all entries are
+ * dropped when an IRK is added or changed, and each entry expires after
+ * RPA_CACHE_TIMEOUT_MS, as the peer would have rotated its address by then.
+ */
+namespace rpa_cache {
+
+constexpr size_t RPA_CACHE_SIZE = 256;
+/* Longest RPA lifetime peers use by default, as recommended by the spec */
+constexpr uint64_t RPA_CACHE_TIMEOUT_MS = 15 * 60 * 1000;
+
+struct Stats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t expired;
+  /* time spent resolving misses against the IRKs */
+  uint64_t miss_latency_total_us;
+  uint64_t miss_latency_max_us;
+};
+
+/* Look |rpa| up in the cache. Returns false on a miss; on a hit, |irk| is set
+ * to the IRK the address resolves with, or std::nullopt if none does. */
+extern bool find(const RawAddress& rpa, std::optional<Octet16>* irk);
+
+/* Cache the result of resolving |rpa|, which took |latency_us| */
+extern void put(const RawAddress& rpa, const std::optional<Octet16>& irk,
+                uint64_t latency_us);
+
+/* Check |rpa| against all of |irks| in a single pass. Returns the first
+ * matching IRK, or nullptr. */
+extern const Octet16* resolve(const RawAddress& rpa,
+                              const std::vector<Octet16>& irks);
+
+/* Drop all entries, must be called whenever a peer IRK is added or changed */
+extern void clear();
+
+/* Drop all entries and counters, and change the size and entry lifetime */
+extern void reset(size_t capacity = RPA_CACHE_SIZE,
+                  uint64_t timeout_ms = RPA_CACHE_TIMEOUT_MS);
+
+extern Stats get_stats();
+
+extern void dump(int fd);
+
+}  // namespace rpa_cache
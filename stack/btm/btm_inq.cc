@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <memory>
 
 #include "common/time_util.h"
 #include "device/include/controller.h"
@@ -39,6 +40,7 @@
 #include "bt_common.h"
 #include "bt_types.h"
 #include "btm_api.h"
+#include "btm_inq_db_index.h"
 #include "btm_int.h"
 #include "btu.h"
 #include "hcidefs.h"
@@ -62,6 +64,9 @@ using bluetooth::Uuid;
 static const LAP general_inq_lap = {0x9e, 0x8b, 0x33};
 static const LAP limited_inq_lap = {0x9e, 0x8b, 0x00};
 
+/* Index of btm_cb.btm_inq_vars.inq_db by address */
+static std::unique_ptr<InqDbIndex> inq_db_index;
+
 const uint16_t BTM_EIR_UUID_LKUP_TBL[BTM_EIR_MAX_SERVICES] = {
     UUID_SERVCLASS_SERVICE_DISCOVERY_SERVER,
     /*    UUID_SERVCLASS_BROWSE_GROUP_DESCRIPTOR,   */
@@ -1048,6 +1053,10 @@ void btm_inq_db_reset(void) {
  *
  ******************************************************************************/
 void btm_inq_db_init(void) {
+  /* btm_cb, with the database, was just cleared */
+  inq_db_index =
+      std::make_unique<InqDbIndex>(BTM_INQ_DB_SIZE, BTM_INQ_DB_TTL_MS);
+
   alarm_free(btm_cb.btm_inq_vars.remote_name_timer);
   btm_cb.btm_inq_vars.remote_name_timer =
       alarm_new("btm_inq.remote_name_timer");
@@ -1124,13 +1133,14 @@ void btm_clr_inq_db(const RawAddress* p_bda) {
   BTM_TRACE_DEBUG("btm_clr_inq_db: inq_active:0x%x state:%d",
                   btm_cb.btm_inq_vars.inq_active, btm_cb.btm_inq_vars.state);
 #endif
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (p_ent->in_use) {
-      /* If this is the specified BD_ADDR or clearing all devices */
-      if (p_bda == NULL || (p_ent->inq_info.results.remote_bd_addr == *p_bda)) {
-        p_ent->in_use = false;
-      }
-    }
+  if (p_bda != NULL) {
+    /* Clear the specified BD_ADDR */
+    p_ent = btm_inq_db_find(*p_bda);
+    if (p_ent) btm_inq_db_remove(p_ent);
+  } else {
+    /* Clear all devices */
+    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) p_ent->in_use = false;
+    if (inq_db_index) inq_db_index->Clear();
   }
 #if (BTM_INQ_DEBUG == TRUE)
   BTM_TRACE_DEBUG("inq_active:0x%x state:%d", btm_cb.btm_inq_vars.inq_active,
@@ -1201,57 +1211,60 @@ bool btm_inq_find_bdaddr(const RawAddress& p_bda) {
  *
  ******************************************************************************/
 tINQ_DB_ENT* btm_inq_db_find(const RawAddress& p_bda) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
+  if (!inq_db_index) return (NULL);
 
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (p_ent->in_use && p_ent->inq_info.results.remote_bd_addr == p_bda)
-      return (p_ent);
-  }
+  size_t slot = inq_db_index->Find(p_bda);
+  if (slot == InqDbIndex::NOT_FOUND) return (NULL);
 
-  /* If here, not found */
-  return (NULL);
+  return (&btm_cb.btm_inq_vars.inq_db[slot]);
 }
 
 /*******************************************************************************
  *
  * Function         btm_inq_db_new
  *
- * Description      This function looks through the inquiry database for an
- *                  unused entry. If no entry is free, it allocates the oldest
- *                  entry.
+ * Description      This function takes the lowest unused entry of the inquiry
+ *                  database. If no entry is free, it frees all the entries
+ *                  without a response for BTM_INQ_DB_TTL_MS, or else the
+ *                  oldest entry.
  *
  * Returns          pointer to entry
  *
  ******************************************************************************/
 tINQ_DB_ENT* btm_inq_db_new(const RawAddress& p_bda) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
-  tINQ_DB_ENT* p_old = btm_cb.btm_inq_vars.inq_db;
-  uint64_t ot = UINT64_MAX;
+  tINQ_DB_ENT* inq_db = btm_cb.btm_inq_vars.inq_db;
 
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (!p_ent->in_use) {
-      memset(p_ent, 0, sizeof(tINQ_DB_ENT));
-      p_ent->inq_info.results.remote_bd_addr = p_bda;
-      p_ent->in_use = true;
-
-      return (p_ent);
-    }
-
-    if (p_ent->time_of_resp < ot) {
-      p_old = p_ent;
-      ot = p_ent->time_of_resp;
-    }
+  if (!inq_db_index) {
+    inq_db_index =
+        std::make_unique<InqDbIndex>(BTM_INQ_DB_SIZE, BTM_INQ_DB_TTL_MS);
   }
 
-  /* If here, no free entry found. Return the oldest. */
+  size_t slot = inq_db_index->Add(
+      p_bda, bluetooth::common::time_get_os_boottime_ms(),
+      [inq_db](size_t slot) { return inq_db[slot].time_of_resp; },
+      [inq_db](size_t slot) { inq_db[slot].in_use = false; });
 
-  memset(p_old, 0, sizeof(tINQ_DB_ENT));
-  p_old->inq_info.results.remote_bd_addr = p_bda;
-  p_old->in_use = true;
+  tINQ_DB_ENT* p_ent = &inq_db[slot];
+  memset(p_ent, 0, sizeof(tINQ_DB_ENT));
+  p_ent->inq_info.results.remote_bd_addr = p_bda;
+  p_ent->in_use = true;
+
+  return (p_ent);
+}
 
-  return (p_old);
+/*******************************************************************************
+ *
+ * Function         btm_inq_db_remove
+ *
+ * Description      This function marks an entry of the inquiry database as
+ *                  unused.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_inq_db_remove(tINQ_DB_ENT* p_ent) {
+  p_ent->in_use = false;
+  if (inq_db_index) inq_db_index->Remove(p_ent - btm_cb.btm_inq_vars.inq_db);
 }
 
 /*******************************************************************************
@@ -1749,6 +1762,16 @@ void btm_sort_inq_result(void) {
   }
 
   osi_free(p_tmp);
+
+  /* entries moved to other slots */
+  if (inq_db_index) {
+    inq_db_index->Clear();
+    p_ent = btm_cb.btm_inq_vars.inq_db;
+    for (uint16_t slot = 0; slot < BTM_INQ_DB_SIZE; slot++, p_ent++) {
+      if (p_ent->in_use)
+        inq_db_index->Set(slot, p_ent->inq_info.results.remote_bd_addr);
+    }
+  }
 }
 
 /*******************************************************************************
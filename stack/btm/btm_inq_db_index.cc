@@ -0,0 +1,116 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "btm_inq_db_index.h"
+
+#include <base/logging.h>
+
+InqDbIndex::InqDbIndex(size_t capacity, uint64_t ttl_ms)
+    : ttl_ms_(ttl_ms), addresses_(capacity), in_use_(capacity, false) {
+  CHECK(capacity > 0);
+  for (size_t slot = 0; slot < capacity; slot++) free_slots_.insert(slot);
+}
+
+size_t InqDbIndex::Find(const RawAddress& address) const {
+  auto it = slot_by_address_.find(address);
+  if (it == slot_by_address_.end()) return NOT_FOUND;
+  return it->second;
+}
+
+size_t InqDbIndex::Add(const RawAddress& address, uint64_t now_ms,
+                       const TimeOfRespFunc& time_of_resp,
+                       const ReleaseFunc& release) {
+  size_t slot = Find(address);
+  if (slot != NOT_FOUND) return slot;
+
+  if (free_slots_.empty()) {
+    slot = Reclaim(now_ms, time_of_resp, release);
+  } else {
+    slot = *free_slots_.begin();
+    free_slots_.erase(free_slots_.begin());
+  }
+
+  addresses_[slot] = address;
+  in_use_[slot] = true;
+  slot_by_address_[address] = slot;
+  return slot;
+}
+
+size_t InqDbIndex::Reclaim(uint64_t now_ms, const TimeOfRespFunc& time_of_resp,
+                           const ReleaseFunc& release) {
+  size_t oldest = 0;
+  uint64_t oldest_time = UINT64_MAX;
+  for (size_t slot = 0; slot < addresses_.size(); slot++) {
+    uint64_t time = time_of_resp(slot);
+    if (time < oldest_time) {
+      oldest = slot;
+      oldest_time = time;
+    }
+    if (now_ms >= time && now_ms - time >= ttl_ms_) {
+      release(slot);
+      Remove(slot);
+      expired_++;
+    }
+  }
+
+  if (!free_slots_.empty()) {
+    size_t slot = *free_slots_.begin();
+    free_slots_.erase(free_slots_.begin());
+    return slot;
+  }
+
+  /* Nothing expired, make room by evicting the oldest entry */
+  release(oldest);
+  slot_by_address_.erase(addresses_[oldest]);
+  in_use_[oldest] = false;
+  evicted_++;
+  return oldest;
+}
+
+void InqDbIndex::Remove(size_t slot) {
+  if (slot >= addresses_.size() || !in_use_[slot]) return;
+
+  slot_by_address_.erase(addresses_[slot]);
+  in_use_[slot] = false;
+  free_slots_.insert(slot);
+}
+
+void InqDbIndex::Set(size_t slot, const RawAddress& address) {
+  CHECK(slot < addresses_.size());
+
+  if (in_use_[slot]) {
+    auto it = slot_by_address_.find(addresses_[slot]);
+    if (it != slot_by_address_.end() && it->second == slot)
+      slot_by_address_.erase(it);
+  } else {
+    free_slots_.erase(slot);
+  }
+
+  addresses_[slot] = address;
+  in_use_[slot] = true;
+  slot_by_address_[address] = slot;
+}
+
+void InqDbIndex::Clear() {
+  slot_by_address_.clear();
+  free_slots_.clear();
+  for (size_t slot = 0; slot < addresses_.size(); slot++) {
+    in_use_[slot] = false;
+    free_slots_.insert(slot);
+  }
+}
@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "types/raw_address.h"
+
+/* Index of the slots of the inquiry database by device address.
+ *
+ * Lookups by address take constant time instead of a scan of the database.
+ * Free slots are handed out lowest first, so entries fill the database in the
+ * same order as before and BTM_InqDbFirst()/BTM_InqDbNext() walk them in the
+ * same order.
+ *
+ * When the database is full, every entry that hasn't seen a response for
+ * |ttl_ms| is reclaimed in one sweep, which leaves room for the following new
+ * devices too; only if none has expired is the oldest entry evicted.
+ */
+class InqDbIndex {
+ public:
+  static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+  /* Time of the last response of the entry in a slot in use */
+  using TimeOfRespFunc = std::function<uint64_t(size_t slot)>;
+  /* Called for each slot reclaimed to make room for a new entry */
+  using ReleaseFunc = std::function<void(size_t slot)>;
+
+  InqDbIndex(size_t capacity, uint64_t ttl_ms);
+
+  /* Returns the slot of |address|, or NOT_FOUND */
+  size_t Find(const RawAddress& address) const;
+
+  /* Returns a slot for the new entry |address|, reclaiming expired or the
+   * oldest entries if the database is full */
+  size_t Add(const RawAddress& address, uint64_t now_ms,
+             const TimeOfRespFunc& time_of_resp, const ReleaseFunc& release);
+
+  void Remove(size_t slot);
+
+  /* Record that the entry in |slot| is |address|, for entries moved around by
+   * the database itself */
+  void Set(size_t slot, const RawAddress& address);
+
+  void Clear();
+
+  size_t Size() const { return slot_by_address_.size(); }
+  size_t Capacity() const { return addresses_.size(); }
+
+  /* Entries reclaimed because they expired, and evicted while still fresh */
+  uint64_t ExpiredCount() const { return expired_; }
+  uint64_t EvictedCount() const { return evicted_; }
+
+ private:
+  size_t Reclaim(uint64_t now_ms, const TimeOfRespFunc& time_of_resp,
+                 const ReleaseFunc& release);
+
+  const uint64_t ttl_ms_;
+  std::vector<RawAddress> addresses_;
+  std::vector<bool> in_use_;
+  std::unordered_map<RawAddress, size_t> slot_by_address_;
+  std::set<size_t> free_slots_;
+  uint64_t expired_ = 0;
+  uint64_t evicted_ = 0;
+};
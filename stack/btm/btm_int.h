@@ -274,6 +274,7 @@ extern tL2CAP_LE_RESULT_CODE btm_ble_start_sec_check(
     tBTM_SEC_CALLBACK* p_callback, void* p_ref_data);
 
 extern tINQ_DB_ENT* btm_inq_db_new(const RawAddress& p_bda);
+extern void btm_inq_db_remove(tINQ_DB_ENT* p_ent);
 
 extern void btm_rem_oob_req(uint8_t* p);
 extern void btm_read_local_oob_complete(uint8_t* p);
@@ -22,7 +22,7 @@
  *
  ******************************************************************************/
 
-#include "stack/crypto_toolbox/aes.h"
+#include "gd/crypto_toolbox/aes_backend.h"
 #include "stack/crypto_toolbox/crypto_toolbox.h"
 
 #include <base/logging.h>
@@ -30,6 +30,11 @@
 
 namespace crypto_toolbox {
 
+/* The AES-128 block cipher implementations are shared with the gd toolbox */
+using bluetooth::crypto_toolbox::AesEncryptFunc;
+using bluetooth::crypto_toolbox::aes_backend_default;
+using bluetooth::crypto_toolbox::aes_backend_get;
+
 namespace {
 
 typedef struct {
@@ -67,9 +72,9 @@ Octet16 aes_128(const Octet16& key, const Octet16& message) {
   std::reverse_copy(key.begin(), key.end(), key_reversed.begin());
   std::reverse_copy(message.begin(), message.end(), message_reversed.begin());
 
-  aes_context ctx;
-  aes_set_key(key_reversed.data(), key_reversed.size(), &ctx);
-  aes_encrypt(message_reversed.data(), output.data(), &ctx);
+  static const AesEncryptFunc aes_encrypt =
+      aes_backend_get(aes_backend_default());
+  aes_encrypt(key_reversed.data(), message_reversed.data(), output.data());
 
   std::reverse(output.begin(), output.end());
   return output;
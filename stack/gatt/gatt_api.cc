@@ -292,6 +292,7 @@ uint16_t GATTS_AddService(tGATT_IF gatt_if, btgatt_db_element_t* service,
   }
 
   gatt_update_last_srv_info();
+  gatt_sr_rebuild_index();
 
   VLOG(1) << __func__ << ": allocated el s_hdl=" << loghex(elem.s_hdl)
           << ", e_hdl=" << loghex(elem.e_hdl) << ", type=" << loghex(elem.type)
@@ -391,6 +392,7 @@ void GATTS_StopService(uint16_t service_handle) {
 
   gatt_cb.srv_list_info->erase(it);
   gatt_update_last_srv_info();
+  gatt_sr_rebuild_index();
 }
 /*******************************************************************************
  *
@@ -29,6 +29,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include "btm_int.h"
 #include "gatt_int.h"
 #include "l2c_api.h"
@@ -260,9 +261,17 @@ tGATT_STATUS gatts_db_read_attr_value_by_type(
   uint16_t len = 0;
   uint8_t* p = (uint8_t*)(p_rsp + 1) + p_rsp->len + L2CAP_MIN_OFFSET;
 
-  if (p_db) {
-    for (tGATT_ATTR& attr : p_db->attr_list) {
-      if (attr.handle >= s_handle && type == attr.uuid) {
+  const std::vector<uint16_t>* handles = gatt_sr_find_handles_by_type(type);
+  if (p_db && handles && !p_db->attr_list.empty()) {
+    /* walk the posting list of |type| within this database only */
+    uint16_t first_hdl = std::max(s_handle, p_db->attr_list.front().handle);
+    uint16_t last_hdl = std::min(e_handle, p_db->attr_list.back().handle);
+    for (auto it =
+             std::lower_bound(handles->begin(), handles->end(), first_hdl);
+         it != handles->end() && *it <= last_hdl; it++) {
+      tGATT_ATTR* p_attr = gatt_sr_find_attr_by_handle(*it);
+      if (p_attr) {
+        tGATT_ATTR& attr = *p_attr;
         if (*p_len <= 2) {
           status = GATT_NO_RESOURCES;
           break;
@@ -412,6 +421,11 @@ uint16_t gatts_add_char_descr(tGATT_SVC_DB& db, tGATT_PERM perm,
 tGATT_ATTR* find_attr_by_handle(tGATT_SVC_DB* p_db, uint16_t handle) {
   if (!p_db) return nullptr;
 
+  /* attributes of started services are resolved through the handle index */
+  auto it = gatt_sr_find_i_rcb_by_handle(handle);
+  if (it != gatt_cb.srv_list_info->end() && it->p_db == p_db)
+    return gatt_sr_find_attr_by_handle(handle);
+
   for (auto& attr : p_db->attr_list) {
     if (attr.handle == handle) return &attr;
     if (attr.handle > handle) return nullptr;
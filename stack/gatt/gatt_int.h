@@ -29,6 +29,7 @@
 #include <base/strings/stringprintf.h>
 #include <string.h>
 #include <list>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -263,6 +264,21 @@ typedef struct {
   bool is_primary;
 } tGATT_SRV_LIST_ELEM;
 
+/* Entry of the server handle index, one per attribute handle */
+typedef struct {
+  /* started service owning the handle, srv_list_info->end() if none */
+  std::list<tGATT_SRV_LIST_ELEM>::iterator srv;
+  tGATT_ATTR* p_attr; /* attribute with this handle, NULL if unused */
+} tGATT_SRV_HDL_ENTRY;
+
+/* Lookup tables over all started services, rebuilt whenever a service is
+ * started or stopped */
+typedef struct {
+  std::vector<tGATT_SRV_HDL_ENTRY> handles; /* indexed by attribute handle */
+  /* ascending attribute handles for each attribute type */
+  std::unordered_map<bluetooth::Uuid, std::vector<uint16_t>> uuid_handles;
+} tGATT_SRV_INDEX;
+
 typedef struct {
   std::queue<tGATT_CLCB*> pending_enc_clcb; /* pending encryption channel q */
   tGATT_SEC_ACTION sec_act;
@@ -363,6 +379,7 @@ typedef struct {
   tGATT_IF gatt_if;
   std::list<tGATT_HDL_LIST_ELEM>* hdl_list_info;
   std::list<tGATT_SRV_LIST_ELEM>* srv_list_info;
+  tGATT_SRV_INDEX* srv_index;
 
   fixed_queue_t* srv_chg_clt_q; /* service change clients queue */
   tGATT_REG cl_rcb[GATT_MAX_APPS];
@@ -475,6 +492,11 @@ extern bool gatt_auto_connect_dev_remove(tGATT_IF gatt_if,
 /* server function */
 extern std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
     uint16_t handle);
+extern void gatt_sr_rebuild_index(void);
+extern tGATT_ATTR* gatt_sr_find_attr_by_handle(uint16_t handle);
+extern uint16_t gatt_sr_get_max_indexed_handle(void);
+extern const std::vector<uint16_t>* gatt_sr_find_handles_by_type(
+    const bluetooth::Uuid& type);
 extern tGATT_STATUS gatt_sr_process_app_rsp(tGATT_TCB& tcb, tGATT_IF gatt_if,
                                             uint32_t trans_id, uint8_t op_code,
                                             tGATT_STATUS status,
@@ -28,6 +28,7 @@
 
 #include <log/log.h>
 #include <string.h>
+#include <algorithm>
 
 #include "gatt_int.h"
 #include "l2c_api.h"
@@ -528,10 +529,13 @@ static tGATT_STATUS gatt_build_find_info_rsp(tGATT_SRV_LIST_ELEM& el,
 
   uint8_t* p = (uint8_t*)(p_msg + 1) + L2CAP_MIN_OFFSET + p_msg->len;
 
-  for (auto& attr : el.p_db->attr_list) {
-    if (attr.handle > e_hdl) break;
+  uint32_t last_hdl = std::min(e_hdl, el.e_hdl);
+  for (uint32_t handle = std::max(s_hdl, el.s_hdl); handle <= last_hdl;
+       handle++) {
+    tGATT_ATTR* p_attr = gatt_sr_find_attr_by_handle(handle);
+    if (!p_attr) continue;
 
-    if (attr.handle < s_hdl) continue;
+    tGATT_ATTR& attr = *p_attr;
 
     uint8_t uuid_len = attr.uuid.GetShortestRepresentationSize();
     if (p_msg->offset == 0)
@@ -694,13 +698,21 @@ static void gatts_process_find_info(tGATT_TCB& tcb, uint8_t op_code,
 
   buf_len = tcb.payload_size - 2;
 
-  for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    if (el.s_hdl <= e_hdl && el.e_hdl >= s_hdl) {
-      reason = gatt_build_find_info_rsp(el, p_msg, buf_len, s_hdl, e_hdl);
-      if (reason == GATT_NO_RESOURCES) {
-        reason = GATT_SUCCESS;
-        break;
-      }
+  /* find the first started service that overlaps the requested range, the
+   * following ones in the sorted service list overlap it as long as they start
+   * before e_hdl */
+  auto it = gatt_cb.srv_list_info->end();
+  uint32_t last_hdl = std::min(e_hdl, gatt_sr_get_max_indexed_handle());
+  for (uint32_t handle = s_hdl; handle <= last_hdl; handle++) {
+    it = gatt_sr_find_i_rcb_by_handle(handle);
+    if (it != gatt_cb.srv_list_info->end()) break;
+  }
+
+  for (; it != gatt_cb.srv_list_info->end() && it->s_hdl <= e_hdl; it++) {
+    reason = gatt_build_find_info_rsp(*it, p_msg, buf_len, s_hdl, e_hdl);
+    if (reason == GATT_NO_RESOURCES) {
+      reason = GATT_SUCCESS;
+      break;
     }
   }
 
@@ -822,14 +834,21 @@ void gatts_process_read_by_type_req(tGATT_TCB& tcb, uint8_t op_code,
   uint16_t buf_len = tcb.payload_size - 2;
 
   reason = GATT_NOT_FOUND;
-  for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    if (el.s_hdl <= e_hdl && el.e_hdl >= s_hdl) {
-      uint8_t sec_flag, key_size;
-      gatt_sr_get_sec_info(tcb.peer_bda, tcb.transport, &sec_flag, &key_size);
+  /* only visit the services that have an attribute of the requested type in
+   * the range */
+  const std::vector<uint16_t>* handles = gatt_sr_find_handles_by_type(uuid);
+  if (handles) {
+    uint8_t sec_flag, key_size;
+    gatt_sr_get_sec_info(tcb.peer_bda, tcb.transport, &sec_flag, &key_size);
+
+    auto hdl_it = std::lower_bound(handles->begin(), handles->end(), s_hdl);
+    while (hdl_it != handles->end() && *hdl_it <= e_hdl) {
+      auto el = gatt_sr_find_i_rcb_by_handle(*hdl_it);
+      if (el == gatt_cb.srv_list_info->end()) break;
 
       tGATT_STATUS ret = gatts_db_read_attr_value_by_type(
-          tcb, el.p_db, op_code, p_msg, s_hdl, e_hdl, uuid, &buf_len, sec_flag,
-          key_size, 0, &err_hdl);
+          tcb, el->p_db, op_code, p_msg, *hdl_it, e_hdl, uuid, &buf_len,
+          sec_flag, key_size, 0, &err_hdl);
       if (ret != GATT_NOT_FOUND) {
         reason = ret;
         if (ret == GATT_NO_RESOURCES) reason = GATT_SUCCESS;
@@ -839,6 +858,9 @@ void gatts_process_read_by_type_req(tGATT_TCB& tcb, uint8_t op_code,
         s_hdl = err_hdl;
         break;
       }
+
+      /* the rest of this service has been answered, move to the next one */
+      hdl_it = std::upper_bound(hdl_it, handles->end(), el->e_hdl);
     }
   }
   *p = (uint8_t)p_msg->offset;
@@ -26,6 +26,7 @@
 #include "osi/include/osi.h"
 
 #include <string.h>
+#include <algorithm>
 #include "bt_common.h"
 #include "stdio.h"
 
@@ -652,16 +653,70 @@ void gatt_ind_ack_timeout(void* data) {
   p_tcb->ind_count = 0;
   attp_send_cl_msg(*p_tcb, nullptr, GATT_HANDLE_VALUE_CONF, NULL);
 }
+/*******************************************************************************
+ *
+ * Function         gatt_sr_rebuild_index
+ *
+ * Description      Rebuild the handle and attribute type lookup tables from
+ *                  the list of started services. Must be called whenever a
+ *                  service is started or stopped.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void gatt_sr_rebuild_index(void) {
+  if (!gatt_cb.srv_index) return;
+
+  tGATT_SRV_INDEX& index = *gatt_cb.srv_index;
+  index.handles.clear();
+  index.uuid_handles.clear();
+
+  if (gatt_cb.srv_list_info->empty()) return;
+
+  uint16_t max_handle = 0;
+  for (const tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
+    max_handle = std::max(max_handle, el.e_hdl);
+  }
+
+  tGATT_SRV_HDL_ENTRY unused_entry;
+  unused_entry.srv = gatt_cb.srv_list_info->end();
+  unused_entry.p_attr = NULL;
+  index.handles.assign(max_handle + 1, unused_entry);
+
+  /* srv_list_info is sorted by start handle, so the posting lists come out in
+   * ascending handle order */
+  for (auto it = gatt_cb.srv_list_info->begin();
+       it != gatt_cb.srv_list_info->end(); it++) {
+    for (uint32_t handle = it->s_hdl; handle <= it->e_hdl; handle++) {
+      index.handles[handle].srv = it;
+    }
+
+    if (!it->p_db) continue;
+
+    for (tGATT_ATTR& attr : it->p_db->attr_list) {
+      if (attr.handle < it->s_hdl || attr.handle > it->e_hdl) continue;
+      index.handles[attr.handle].p_attr = &attr;
+      index.uuid_handles[attr.uuid].push_back(attr.handle);
+    }
+  }
+}
+
 /*******************************************************************************
  *
  * Description      Search for a service that owns a specific handle.
  *
- * Returns          GATT_MAX_SR_PROFILES if not found. Otherwise the index of
- *                  the service.
+ * Returns          gatt_cb.srv_list_info->end() if not found. Otherwise the
+ *                  iterator of the service.
  *
  ******************************************************************************/
 std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
     uint16_t handle) {
+  if (gatt_cb.srv_index) {
+    if (handle >= gatt_cb.srv_index->handles.size())
+      return gatt_cb.srv_list_info->end();
+    return gatt_cb.srv_index->handles[handle].srv;
+  }
+
   auto it = gatt_cb.srv_list_info->begin();
 
   for (; it != gatt_cb.srv_list_info->end(); it++) {
@@ -673,6 +728,56 @@ std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
   return it;
 }
 
+/*******************************************************************************
+ *
+ * Function         gatt_sr_find_attr_by_handle
+ *
+ * Description      Find the attribute of a started service by its handle.
+ *
+ * Returns          NULL if no started service has an attribute at |handle|.
+ *
+ ******************************************************************************/
+tGATT_ATTR* gatt_sr_find_attr_by_handle(uint16_t handle) {
+  if (!gatt_cb.srv_index || handle >= gatt_cb.srv_index->handles.size())
+    return NULL;
+
+  return gatt_cb.srv_index->handles[handle].p_attr;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_sr_get_max_indexed_handle
+ *
+ * Description      Get the highest handle covered by a started service.
+ *
+ * Returns          0 if no service is started.
+ *
+ ******************************************************************************/
+uint16_t gatt_sr_get_max_indexed_handle(void) {
+  if (!gatt_cb.srv_index || gatt_cb.srv_index->handles.empty()) return 0;
+
+  return gatt_cb.srv_index->handles.size() - 1;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_sr_find_handles_by_type
+ *
+ * Description      Get the handles of all attributes of type |type| in the
+ *                  started services.
+ *
+ * Returns          Ascending list of handles, NULL if there is none.
+ *
+ ******************************************************************************/
+const std::vector<uint16_t>* gatt_sr_find_handles_by_type(const Uuid& type) {
+  if (!gatt_cb.srv_index) return NULL;
+
+  auto it = gatt_cb.srv_index->uuid_handles.find(type);
+  if (it == gatt_cb.srv_index->uuid_handles.end()) return NULL;
+
+  return &it->second;
+}
+
 /*******************************************************************************
  *
  * Function         gatt_sr_get_sec_info
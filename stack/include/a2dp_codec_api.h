@@ -26,6 +26,7 @@
 #include <functional>
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 
@@ -506,6 +507,41 @@ typedef uint32_t (*a2dp_source_read_callback_t)(uint8_t* p_buf, uint32_t len);
 typedef bool (*a2dp_source_enqueue_callback_t)(BT_HDR* p_buf, size_t frames_n,
                                                uint32_t num_bytes);
 
+//
+// A2DP encoder session: the state of the encoder for one peer. Sessions are
+// independent, so that the same audio can be streamed to several peers, each
+// with its own MTU and codec configuration.
+//
+class A2dpEncoderSession {
+ public:
+  // Same as |a2dp_source_read_callback_t| and
+  // |a2dp_source_enqueue_callback_t|, bound to the peer of the session.
+  using ReadCallback = std::function<uint32_t(uint8_t* p_buf, uint32_t len)>;
+  using EnqueueCallback =
+      std::function<bool(BT_HDR* p_buf, size_t frames_n, uint32_t num_bytes)>;
+
+  virtual ~A2dpEncoderSession() = default;
+
+  // Reset the feeding of the session.
+  virtual void FeedingReset() = 0;
+
+  // Flush the feeding of the session.
+  virtual void FeedingFlush() = 0;
+
+  // Get the encoder interval (in milliseconds).
+  virtual uint64_t GetEncoderIntervalMs() const = 0;
+
+  // Prepare and send encoded frames.
+  // |timestamp_us| is the current timestamp (in microseconds).
+  virtual void SendFrames(uint64_t timestamp_us) = 0;
+
+  // Get the effective MTU of the peer of the session.
+  virtual int GetEffectiveMtu() const = 0;
+
+  // Dump the statistics of the session to |fd|.
+  virtual void DebugDump(int fd) = 0;
+};
+
 //
 // A2DP encoder callbacks interface.
 //
@@ -538,6 +574,15 @@ typedef struct {
 
   // Set transmit queue length for the A2DP encoder.
   void (*set_transmit_queue_length)(size_t transmit_queue_length);
+
+  // Create an encoder session, independent of the encoder above and of the
+  // other sessions. nullptr if the codec supports only one encoder.
+  // The arguments are the same as for |encoder_init|.
+  std::unique_ptr<A2dpEncoderSession> (*create_session)(
+      const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
+      A2dpCodecConfig* a2dp_codec_config,
+      A2dpEncoderSession::ReadCallback read_callback,
+      A2dpEncoderSession::EnqueueCallback enqueue_callback);
 } tA2DP_ENCODER_INTERFACE;
 
 // Prototype for a callback to receive decoded audio data from a
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Fan-out of the audio input to the A2DP encoders of several peers
+//
+
+#ifndef A2DP_ENCODER_FANOUT_H
+#define A2DP_ENCODER_FANOUT_H
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "a2dp_codec_api.h"
+#include "types/raw_address.h"
+
+//
+// The PCM audio is read once from the audio input, and buffered until the
+// encoder of every peer has read it. Each peer either reads the audio with
+// |Read| from its own encoder, or has an encoder session owned by the fan-out.
+// An encoder lagging more than |kMaxBufferedBytes| behind the others skips
+// audio, so that it cannot hold the others back.
+// The fan-out is not thread-safe: it is used from the A2DP Source thread.
+//
+class A2dpEncoderFanout {
+ public:
+  // Max. number of bytes buffered for the lagging encoders: 170 ms of
+  // 48 kHz 16 bits stereo audio.
+  static constexpr size_t kMaxBufferedBytes = 32 * 1024;
+
+  // Statistics of the audio read by the encoder of a peer
+  struct PeerStats {
+    size_t read_bytes = 0;       // Bytes read
+    size_t underflow_bytes = 0;  // Bytes requested but not read
+    size_t underflow_count = 0;  // Reads that were short
+    size_t dropped_bytes = 0;    // Bytes skipped because the encoder lagged
+  };
+
+  // |read_callback| reads the audio input.
+  explicit A2dpEncoderFanout(A2dpEncoderSession::ReadCallback read_callback);
+
+  // Add |peer_address|, whose encoder reads the audio with |Read|.
+  // The peer reads the audio from the audio input that isn't read yet.
+  void AddReader(const RawAddress& peer_address);
+
+  // Add |peer_address| with an encoder session created with
+  // |encoder_interface|, that passes the encoded packets to
+  // |enqueue_callback|. |p_peer_params| and |a2dp_codec_config| are the
+  // parameters of the peer and of its codec.
+  // Returns true on success, or false if the codec doesn't support sessions.
+  bool AddPeer(const RawAddress& peer_address,
+               const tA2DP_ENCODER_INTERFACE* encoder_interface,
+               const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
+               A2dpCodecConfig* a2dp_codec_config,
+               A2dpEncoderSession::EnqueueCallback enqueue_callback);
+
+  // Remove |peer_address|, and its encoder session if any.
+  void RemovePeer(const RawAddress& peer_address);
+
+  // Returns true if |peer_address| was added.
+  bool HasPeer(const RawAddress& peer_address) const;
+
+  // Read up to |len| bytes of audio for |peer_address| into |p_buf|.
+  // Returns the number of bytes read.
+  uint32_t Read(const RawAddress& peer_address, uint8_t* p_buf, uint32_t len);
+
+  // Prepare and send the encoded frames of the encoder sessions.
+  // |timestamp_us| is the current timestamp (in microseconds).
+  void SendFrames(uint64_t timestamp_us);
+
+  // Reset the feeding of the encoder sessions.
+  void FeedingReset();
+
+  // Discard the buffered audio, and flush the feeding of the encoder sessions.
+  void FeedingFlush();
+
+  // Get the statistics of |peer_address|, or nullptr if it wasn't added.
+  const PeerStats* GetPeerStats(const RawAddress& peer_address) const;
+
+  // Get the number of bytes of audio buffered for the lagging encoders.
+  size_t BufferedBytes() const { return buffer_.size(); }
+
+  // Dump the peers and their statistics to |fd|.
+  void DebugDump(int fd);
+
+ private:
+  struct Peer {
+    // Position in the audio input of the next byte to read
+    uint64_t position = 0;
+    // The encoder session, or nullptr if the peer reads with |Read|
+    std::unique_ptr<A2dpEncoderSession> session;
+    PeerStats stats;
+  };
+
+  // Discard the audio read by every peer, and the audio of the peers lagging
+  // more than |kMaxBufferedBytes|.
+  void Trim();
+
+  A2dpEncoderSession::ReadCallback read_callback_;
+  std::map<RawAddress, Peer> peers_;
+  // The audio input from position |start_|
+  std::vector<uint8_t> buffer_;
+  uint64_t start_ = 0;
+};
+
+#endif  // A2DP_ENCODER_FANOUT_H
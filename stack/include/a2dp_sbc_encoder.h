@@ -43,6 +43,15 @@ void a2dp_sbc_encoder_init(const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
                            a2dp_source_read_callback_t read_callback,
                            a2dp_source_enqueue_callback_t enqueue_callback);
 
+// Create an A2DP SBC encoder session, independent from the encoder of the
+// other a2dp_sbc_* functions and from the other sessions.
+// The parameters are the same as for |a2dp_sbc_encoder_init|.
+std::unique_ptr<A2dpEncoderSession> a2dp_sbc_create_encoder_session(
+    const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
+    A2dpCodecConfig* a2dp_codec_config,
+    A2dpEncoderSession::ReadCallback read_callback,
+    A2dpEncoderSession::EnqueueCallback enqueue_callback);
+
 // Cleanup the A2DP SBC encoder.
 void a2dp_sbc_encoder_cleanup(void);
 
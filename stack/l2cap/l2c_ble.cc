@@ -911,6 +911,9 @@ void l2c_ble_link_adjust_allocation(void) {
       }
     }
   }
+
+  /* The round-robin quota may have changed, let waiting links try again */
+  l2c_link_sched_wake_rr_links(BT_TRANSPORT_LE, MAX_L2CAP_LINKS);
 }
 
 #if (BLE_LLT_INCLUDED == TRUE)
@@ -1395,6 +1395,6 @@ void l2c_enqueue_peer_data(tL2C_CCB* p_ccb, BT_HDR* p_buf) {
   }
 #endif
 
-  /* if we are doing a round robin scheduling, set the flag */
-  if (p_ccb->p_lcb->link_xmit_quota == 0) l2cb.check_round_robin = true;
+  /* the link has data to send, let the link scheduler know */
+  l2c_link_sched_set_ready(p_ccb->p_lcb);
 }
@@ -50,7 +50,7 @@ static const char* SAR_types[] = {"Unsegmented", "Start", "End",
 static const char* SUP_types[] = {"RR", "REJ", "RNR", "SREJ"};
 
 /* Look-up table for the CRC calculation */
-static const unsigned short crctab[256] = {
+static constexpr unsigned short crctab[256] = {
     0x0000, 0xc0c1, 0xc181, 0x0140, 0xc301, 0x03c0, 0x0280, 0xc241, 0xc601,
     0x06c0, 0x0780, 0xc741, 0x0500, 0xc5c1, 0xc481, 0x0440, 0xcc01, 0x0cc0,
     0x0d80, 0xcd41, 0x0f00, 0xcfc1, 0xce81, 0x0e40, 0x0a00, 0xcac1, 0xcb81,
@@ -82,6 +82,26 @@ static const unsigned short crctab[256] = {
     0x4100, 0x81c1, 0x8081, 0x4040,
 };
 
+/* Look-up tables for computing the CRC 8 bytes at a time (slice-by-8):
+ * table[k][byte] is the CRC of |byte| followed by k zero bytes */
+struct tL2C_FCR_CRC_TABLES {
+  unsigned short table[8][256];
+};
+
+static constexpr tL2C_FCR_CRC_TABLES l2c_fcr_make_crc_tables() {
+  tL2C_FCR_CRC_TABLES tables{};
+  for (int i = 0; i < 256; i++) tables.table[0][i] = crctab[i];
+  for (int k = 1; k < 8; k++) {
+    for (int i = 0; i < 256; i++) {
+      unsigned short prev = tables.table[k - 1][i];
+      tables.table[k][i] = ((prev >> 8) & 0xff) ^ crctab[prev & 0xff];
+    }
+  }
+  return tables;
+}
+
+static constexpr tL2C_FCR_CRC_TABLES crc_tables = l2c_fcr_make_crc_tables();
+
 /*******************************************************************************
  *  Static local functions
 */
@@ -104,18 +124,28 @@ static void l2c_fcr_collect_ack_delay(tL2C_CCB* p_ccb, uint8_t num_bufs_acked);
  *
  * Function         l2c_fcr_updcrc
  *
- * Description      This function computes the CRC using the look-up table.
+ * Description      This function computes the CRC using the look-up tables,
+ *                  8 bytes at a time and then byte by byte.
  *
  * Returns          CRC
  *
  ******************************************************************************/
 static unsigned short l2c_fcr_updcrc(unsigned short icrc, unsigned char* icp,
                                      int icnt) {
+  const auto& t = crc_tables.table;
   unsigned short crc = icrc;
   unsigned char* cp = icp;
   int cnt = icnt;
 
-  while (cnt--) {
+  while (cnt >= 8) {
+    crc = t[7][(cp[0] ^ crc) & 0xff] ^ t[6][(cp[1] ^ (crc >> 8)) & 0xff] ^
+          t[5][cp[2]] ^ t[4][cp[3]] ^ t[3][cp[4]] ^ t[2][cp[5]] ^
+          t[1][cp[6]] ^ t[0][cp[7]];
+    cp += 8;
+    cnt -= 8;
+  }
+
+  while (cnt-- > 0) {
     crc = ((crc >> 8) & 0xff) ^ crctab[(crc & 0xff) ^ *cp++];
   }
 
@@ -101,6 +101,14 @@ typedef enum {
   LST_DISCONNECTING
 } tL2C_LINK_STATE;
 
+/* Define the states of a link in the HCI transmit scheduler
+*/
+typedef enum {
+  L2C_LINK_SCHED_IDLE,    /* Nothing to send, or blocked until kicked */
+  L2C_LINK_SCHED_READY,   /* On the ready queue of its transport */
+  L2C_LINK_SCHED_RR_WAIT, /* Waiting for the round-robin quota to free up */
+} tL2C_LINK_SCHED_STATE;
+
 /* Define input events to the L2CAP link and channel state machines. The names
  * of the events may seem a bit strange, but they are taken from
  * the Bluetooth specification.
@@ -457,8 +465,22 @@ typedef struct t_l2c_linkcb {
   uint8_t rr_pri; /* current serving priority group */
 #endif
 
+  /* HCI transmit scheduler, see l2c_link_check_send_pkts() */
+  struct t_l2c_linkcb* p_sched_next; /* Next link in the scheduler queue */
+  struct t_l2c_linkcb* p_sched_prev; /* Previous link in the scheduler queue */
+  tL2C_LINK_SCHED_STATE sched_state; /* Queue the link is on, if any */
+  uint16_t sched_deficit; /* Segments left in this link's turn */
+
 } tL2C_LCB;
 
+/***********************************************************************
+ * Define a queue of linked LCBs, used by the HCI transmit scheduler.
+*/
+typedef struct {
+  tL2C_LCB* p_first; /* The first link in this queue */
+  tL2C_LCB* p_last;  /* The last  link in this queue */
+} tL2C_LINK_Q;
+
 /* Define the L2CAP control structure
 */
 typedef struct {
@@ -467,7 +489,8 @@ typedef struct {
 
   uint16_t round_robin_quota;   /* Round-robin link quota */
   uint16_t round_robin_unacked; /* Round-robin unacked */
-  bool check_round_robin;       /* Do a round robin check */
+  tL2C_LINK_Q ready_links;      /* Links with data to send */
+  tL2C_LINK_Q rr_wait_links;    /* Links waiting for round-robin quota */
 
   bool is_cong_cback_context;
 
@@ -512,7 +535,8 @@ typedef struct {
   uint16_t num_lm_ble_bufs;         /* # of ACL buffers on controller */
   uint16_t ble_round_robin_quota;   /* Round-robin link quota */
   uint16_t ble_round_robin_unacked; /* Round-robin unacked */
-  bool ble_check_round_robin;       /* Do a round robin check */
+  tL2C_LINK_Q ble_ready_links;      /* LE links with data to send */
+  tL2C_LINK_Q ble_rr_wait_links;    /* LE links waiting for RR quota */
   tL2C_RCB ble_rcb_pool[BLE_MAX_L2CAP_CLIENTS]; /* Registration info pool */
 
   tL2CA_ECHO_DATA_CB* p_echo_data_cb; /* Echo data callback */
@@ -713,6 +737,10 @@ extern void l2c_info_resp_timer_timeout(void* data);
 extern void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb,
                                      BT_HDR* p_buf);
 extern void l2c_link_adjust_allocation(void);
+extern void l2c_link_sched_set_ready(tL2C_LCB* p_lcb);
+extern void l2c_link_sched_wake_rr_links(tBT_TRANSPORT transport,
+                                         uint16_t num_links);
+extern void l2c_link_sched_remove(tL2C_LCB* p_lcb);
 extern void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len);
 extern void l2c_link_process_num_completed_blocks(uint8_t controller_id,
                                                   uint8_t* p, uint16_t evt_len);
@@ -780,6 +780,11 @@ void l2c_link_adjust_allocation(void) {
       }
     }
   }
+
+  /* The round-robin quota may have changed, let waiting links try again */
+  l2c_link_sched_wake_rr_links(BT_TRANSPORT_BR_EDR, MAX_L2CAP_LINKS);
+  if (is_share_buffer)
+    l2c_link_sched_wake_rr_links(BT_TRANSPORT_LE, MAX_L2CAP_LINKS);
 }
 
 /*******************************************************************************
@@ -959,6 +964,234 @@ bool l2c_link_check_power_mode(tL2C_LCB* p_lcb) {
 }
 #endif /* L2CAP_WAKE_PARKED_LINK == TRUE) */
 
+/*******************************************************************************
+ *
+ * Function         l2c_link_sched_ready_q
+ *
+ * Description      Returns the queue of links ready to send on a transport.
+ *
+ ******************************************************************************/
+static tL2C_LINK_Q* l2c_link_sched_ready_q(tBT_TRANSPORT transport) {
+  return (transport == BT_TRANSPORT_LE) ? &l2cb.ble_ready_links
+                                        : &l2cb.ready_links;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_link_sched_rr_wait_q
+ *
+ * Description      Returns the queue of round-robin links on a transport that
+ *                  are waiting for the shared round-robin quota.
+ *
+ ******************************************************************************/
+static tL2C_LINK_Q* l2c_link_sched_rr_wait_q(tBT_TRANSPORT transport) {
+  return (transport == BT_TRANSPORT_LE) ? &l2cb.ble_rr_wait_links
+                                        : &l2cb.rr_wait_links;
+}
+
+static void l2c_link_q_append(tL2C_LINK_Q* p_q, tL2C_LCB* p_lcb) {
+  p_lcb->p_sched_next = NULL;
+  p_lcb->p_sched_prev = p_q->p_last;
+
+  if (p_q->p_last != NULL)
+    p_q->p_last->p_sched_next = p_lcb;
+  else
+    p_q->p_first = p_lcb;
+
+  p_q->p_last = p_lcb;
+}
+
+static void l2c_link_q_remove(tL2C_LINK_Q* p_q, tL2C_LCB* p_lcb) {
+  if (p_lcb->p_sched_prev != NULL)
+    p_lcb->p_sched_prev->p_sched_next = p_lcb->p_sched_next;
+  else
+    p_q->p_first = p_lcb->p_sched_next;
+
+  if (p_lcb->p_sched_next != NULL)
+    p_lcb->p_sched_next->p_sched_prev = p_lcb->p_sched_prev;
+  else
+    p_q->p_last = p_lcb->p_sched_prev;
+
+  p_lcb->p_sched_next = NULL;
+  p_lcb->p_sched_prev = NULL;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_link_sched_remove
+ *
+ * Description      This function takes a link off whichever scheduler queue
+ *                  it is on. The link is put back by the next call to
+ *                  l2c_link_check_send_pkts() for it.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_link_sched_remove(tL2C_LCB* p_lcb) {
+  if (p_lcb->sched_state == L2C_LINK_SCHED_READY)
+    l2c_link_q_remove(l2c_link_sched_ready_q(p_lcb->transport), p_lcb);
+  else if (p_lcb->sched_state == L2C_LINK_SCHED_RR_WAIT)
+    l2c_link_q_remove(l2c_link_sched_rr_wait_q(p_lcb->transport), p_lcb);
+
+  p_lcb->sched_state = L2C_LINK_SCHED_IDLE;
+  p_lcb->sched_deficit = 0;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_link_sched_set_ready
+ *
+ * Description      This function puts a link that may have something to send
+ *                  at the tail of the ready queue of its transport. A link
+ *                  waiting for the round-robin quota keeps its place in the
+ *                  wait queue.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_link_sched_set_ready(tL2C_LCB* p_lcb) {
+  if ((!p_lcb->in_use) || (p_lcb->sched_state != L2C_LINK_SCHED_IDLE)) return;
+
+  l2c_link_q_append(l2c_link_sched_ready_q(p_lcb->transport), p_lcb);
+  p_lcb->sched_state = L2C_LINK_SCHED_READY;
+  p_lcb->sched_deficit = 0;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_link_sched_wake_rr_links
+ *
+ * Description      This function moves up to num_links round-robin links that
+ *                  were waiting for the round-robin quota back to the ready
+ *                  queue, in the order they started waiting.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_link_sched_wake_rr_links(tBT_TRANSPORT transport,
+                                  uint16_t num_links) {
+  tL2C_LINK_Q* p_wait_q = l2c_link_sched_rr_wait_q(transport);
+
+  while ((num_links > 0) && (p_wait_q->p_first != NULL)) {
+    tL2C_LCB* p_lcb = p_wait_q->p_first;
+
+    l2c_link_sched_remove(p_lcb);
+    l2c_link_sched_set_ready(p_lcb);
+    num_links--;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_link_sched_can_send
+ *
+ * Description      This function checks whether the link at the head of the
+ *                  ready queue may send now. A link that may not is taken off
+ *                  the ready queue: a round-robin link waits for the shared
+ *                  quota, any other link waits for the event that unblocks it
+ *                  (completed packets, segment sent, mode change or the flow
+ *                  control timer), all of which call l2c_link_check_send_pkts.
+ *
+ * Returns          true if the link may send a packet
+ *
+ ******************************************************************************/
+static bool l2c_link_sched_can_send(tL2C_LCB* p_lcb) {
+  if ((!p_lcb->in_use) || (p_lcb->partial_segment_being_sent) ||
+      (p_lcb->link_state != LST_CONNECTED) ||
+      (L2C_LINK_CHECK_POWER_MODE(p_lcb))) {
+    l2c_link_sched_remove(p_lcb);
+    return false;
+  }
+
+  if (p_lcb->link_xmit_quota == 0) {
+    bool rr_quota_full =
+        (p_lcb->transport == BT_TRANSPORT_LE)
+            ? (l2cb.ble_round_robin_unacked >= l2cb.ble_round_robin_quota)
+            : (l2cb.round_robin_unacked >= l2cb.round_robin_quota);
+
+    if (rr_quota_full) {
+      l2c_link_sched_remove(p_lcb);
+      l2c_link_q_append(l2c_link_sched_rr_wait_q(p_lcb->transport), p_lcb);
+      p_lcb->sched_state = L2C_LINK_SCHED_RR_WAIT;
+      return false;
+    }
+  } else if (p_lcb->sent_not_acked >= p_lcb->link_xmit_quota) {
+    l2c_link_sched_remove(p_lcb);
+    return false;
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_link_sched_run
+ *
+ * Description      This function sends packets from the ready links of a
+ *                  transport until the controller window is full or no link
+ *                  has anything left to send. Links are served in deficit
+ *                  round-robin: on its turn a link may send as many segments
+ *                  as its xmit quota (one for a round-robin link) before it
+ *                  moves to the tail of the queue.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void l2c_link_sched_run(tBT_TRANSPORT transport) {
+  tL2C_LINK_Q* p_ready_q = l2c_link_sched_ready_q(transport);
+  uint16_t* p_window = (transport == BT_TRANSPORT_LE)
+                           ? &l2cb.controller_le_xmit_window
+                           : &l2cb.controller_xmit_window;
+
+  while ((p_ready_q->p_first != NULL) && (*p_window != 0)) {
+    tL2C_LCB* p_lcb = p_ready_q->p_first;
+    BT_HDR* p_buf;
+    uint16_t sent_before, cost;
+
+    if (!l2c_link_sched_can_send(p_lcb)) continue;
+
+    if (p_lcb->sched_deficit == 0)
+      p_lcb->sched_deficit =
+          (p_lcb->link_xmit_quota == 0) ? 1 : p_lcb->link_xmit_quota;
+
+    sent_before = p_lcb->sent_not_acked;
+
+    /* See if we can send anything from the Link Queue */
+    if (!list_is_empty(p_lcb->link_xmit_data_q)) {
+      p_buf = (BT_HDR*)list_front(p_lcb->link_xmit_data_q);
+      list_remove(p_lcb->link_xmit_data_q, p_buf);
+      l2c_link_send_to_lower(p_lcb, p_buf, NULL);
+    }
+    /* If nothing on the link queue, check the channel queue */
+    else {
+      tL2C_TX_COMPLETE_CB_INFO cbi;
+      p_buf = l2cu_get_next_buffer_to_send(p_lcb, &cbi);
+      if (p_buf == NULL) {
+        l2c_link_sched_remove(p_lcb);
+        continue;
+      }
+      l2c_link_send_to_lower(p_lcb, p_buf, &cbi);
+    }
+
+    /* Charge the link for the segments it put on the controller */
+    cost = (p_lcb->sent_not_acked > sent_before)
+               ? (p_lcb->sent_not_acked - sent_before)
+               : 1;
+    if (cost < p_lcb->sched_deficit) {
+      p_lcb->sched_deficit -= cost;
+      continue;
+    }
+
+    /* Turn is over. The send may have re-entered the scheduler, so only */
+    /* rotate the link if it is still on the ready queue.                */
+    p_lcb->sched_deficit = 0;
+    if (p_lcb->sched_state == L2C_LINK_SCHED_READY) {
+      l2c_link_q_remove(p_ready_q, p_lcb);
+      l2c_link_q_append(p_ready_q, p_lcb);
+    }
+  }
+}
+
 /*******************************************************************************
  *
  * Function         l2c_link_check_send_pkts
@@ -967,11 +1200,14 @@ bool l2c_link_check_power_mode(tL2C_LCB* p_lcb) {
  *                  to the Host Controller. It may be passed the address of
  *                  a packet to send.
  *
+ *                  The link is put on the ready queue of its transport and
+ *                  the ready links of that transport are served. If p_lcb is
+ *                  NULL, the ready links of both transports are served.
+ *
  * Returns          void
  *
  ******************************************************************************/
 void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb, BT_HDR* p_buf) {
-  int xx;
   bool single_write = false;
 
   /* Save the channel ID for faster counting */
@@ -984,123 +1220,37 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb, BT_HDR* p_buf) {
 
     p_buf->layer_specific = 0;
     list_append(p_lcb->link_xmit_data_q, p_buf);
-
-    if (p_lcb->link_xmit_quota == 0) {
-      if (p_lcb->transport == BT_TRANSPORT_LE)
-        l2cb.ble_check_round_robin = true;
-      else
-        l2cb.check_round_robin = true;
-    }
   }
 
+  if (p_lcb != NULL) l2c_link_sched_set_ready(p_lcb);
+
   /* If this is called from uncongested callback context break recursive
   *calling.
   ** This LCB will be served when receiving number of completed packet event.
   */
   if (l2cb.is_cong_cback_context) return;
 
-  /* If we are in a scenario where there are not enough buffers for each link to
-  ** have at least 1, then do a round-robin for all the LCBs
-  */
-  if ((p_lcb == NULL) || (p_lcb->link_xmit_quota == 0)) {
-    if (p_lcb == NULL)
-      p_lcb = l2cb.lcb_pool;
-    else if (!single_write)
-      p_lcb++;
-
-    /* Loop through, starting at the next */
-    for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
-      /* Check for wraparound */
-      if (p_lcb == &l2cb.lcb_pool[MAX_L2CAP_LINKS]) p_lcb = &l2cb.lcb_pool[0];
-
-      /* If controller window is full, nothing to do */
-      if (((l2cb.controller_xmit_window == 0 ||
-            (l2cb.round_robin_unacked >= l2cb.round_robin_quota)) &&
-           (p_lcb->transport == BT_TRANSPORT_BR_EDR)) ||
-          (p_lcb->transport == BT_TRANSPORT_LE &&
-           (l2cb.ble_round_robin_unacked >= l2cb.ble_round_robin_quota ||
-            l2cb.controller_le_xmit_window == 0)))
-        continue;
+  /* A caller queueing a series of packets for one channel follows up with a */
+  /* final call without the channel, the link is served then.                */
+  if (single_write) return;
 
-      if ((!p_lcb->in_use) || (p_lcb->partial_segment_being_sent) ||
-          (p_lcb->link_state != LST_CONNECTED) ||
-          (p_lcb->link_xmit_quota != 0) || (L2C_LINK_CHECK_POWER_MODE(p_lcb)))
-        continue;
-
-      /* See if we can send anything from the Link Queue */
-      if (!list_is_empty(p_lcb->link_xmit_data_q)) {
-        p_buf = (BT_HDR*)list_front(p_lcb->link_xmit_data_q);
-        list_remove(p_lcb->link_xmit_data_q, p_buf);
-        l2c_link_send_to_lower(p_lcb, p_buf, NULL);
-      } else if (single_write) {
-        /* If only doing one write, break out */
-        break;
-      }
-      /* If nothing on the link queue, check the channel queue */
-      else {
-        tL2C_TX_COMPLETE_CB_INFO cbi;
-        p_buf = l2cu_get_next_buffer_to_send(p_lcb, &cbi);
-        if (p_buf != NULL) {
-          l2c_link_send_to_lower(p_lcb, p_buf, &cbi);
-        }
-      }
-    }
-
-    /* If we finished without using up our quota, no need for a safety check */
-    if ((l2cb.controller_xmit_window > 0) &&
-        (l2cb.round_robin_unacked < l2cb.round_robin_quota) &&
-        (p_lcb->transport == BT_TRANSPORT_BR_EDR))
-      l2cb.check_round_robin = false;
-
-    if ((l2cb.controller_le_xmit_window > 0) &&
-        (l2cb.ble_round_robin_unacked < l2cb.ble_round_robin_quota) &&
-        (p_lcb->transport == BT_TRANSPORT_LE))
-      l2cb.ble_check_round_robin = false;
-  } else /* if this is not round-robin service */
-  {
-    /* If a partial segment is being sent, can't send anything else */
-    if ((p_lcb->partial_segment_being_sent) ||
-        (p_lcb->link_state != LST_CONNECTED) ||
-        (L2C_LINK_CHECK_POWER_MODE(p_lcb)))
-      return;
-
-    /* See if we can send anything from the link queue */
-    while (((l2cb.controller_xmit_window != 0 &&
-             (p_lcb->transport == BT_TRANSPORT_BR_EDR)) ||
-            (l2cb.controller_le_xmit_window != 0 &&
-             (p_lcb->transport == BT_TRANSPORT_LE))) &&
-           (p_lcb->sent_not_acked < p_lcb->link_xmit_quota)) {
-      if (list_is_empty(p_lcb->link_xmit_data_q)) break;
-
-      p_buf = (BT_HDR*)list_front(p_lcb->link_xmit_data_q);
-      list_remove(p_lcb->link_xmit_data_q, p_buf);
-      if (!l2c_link_send_to_lower(p_lcb, p_buf, NULL)) break;
-    }
+  if (p_lcb == NULL) {
+    l2c_link_sched_run(BT_TRANSPORT_BR_EDR);
+    l2c_link_sched_run(BT_TRANSPORT_LE);
+    return;
+  }
 
-    if (!single_write) {
-      /* See if we can send anything for any channel */
-      while (((l2cb.controller_xmit_window != 0 &&
-               (p_lcb->transport == BT_TRANSPORT_BR_EDR)) ||
-              (l2cb.controller_le_xmit_window != 0 &&
-               (p_lcb->transport == BT_TRANSPORT_LE))) &&
-             (p_lcb->sent_not_acked < p_lcb->link_xmit_quota)) {
-        tL2C_TX_COMPLETE_CB_INFO cbi;
-        p_buf = l2cu_get_next_buffer_to_send(p_lcb, &cbi);
-        if (p_buf == NULL) break;
-
-        if (!l2c_link_send_to_lower(p_lcb, p_buf, &cbi)) break;
-      }
-    }
+  l2c_link_sched_run(p_lcb->transport);
 
-    /* There is a special case where we have readjusted the link quotas and  */
-    /* this link may have sent anything but some other link sent packets so  */
-    /* so we may need a timer to kick off this link's transmissions.         */
-    if ((!list_is_empty(p_lcb->link_xmit_data_q)) &&
-        (p_lcb->sent_not_acked < p_lcb->link_xmit_quota)) {
-      alarm_set_on_mloop(p_lcb->l2c_lcb_timer,
-                         L2CAP_LINK_FLOW_CONTROL_TIMEOUT_MS,
-                         l2c_lcb_timer_timeout, p_lcb);
-    }
+  /* There is a special case where we have readjusted the link quotas and  */
+  /* this link may have sent anything but some other link sent packets so  */
+  /* so we may need a timer to kick off this link's transmissions.         */
+  if ((p_lcb->link_xmit_quota != 0) &&
+      (!list_is_empty(p_lcb->link_xmit_data_q)) &&
+      (p_lcb->sent_not_acked < p_lcb->link_xmit_quota)) {
+    alarm_set_on_mloop(p_lcb->l2c_lcb_timer,
+                       L2CAP_LINK_FLOW_CONTROL_TIMEOUT_MS,
+                       l2c_lcb_timer_timeout, p_lcb);
   }
 }
 
@@ -1225,6 +1375,8 @@ void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len) {
   uint16_t handle;
   uint16_t num_sent;
   tL2C_LCB* p_lcb;
+  bool serve_br_edr = false;
+  bool serve_le = false;
 
   if (evt_len > 0) {
     STREAM_TO_UINT8(num_handles, p);
@@ -1272,6 +1424,9 @@ void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len) {
           else
             l2cb.round_robin_unacked = 0;
         }
+
+        /* Give the freed round-robin quota to the links waiting for it */
+        l2c_link_sched_wake_rr_links(p_lcb->transport, num_sent);
       }
 
       /* Don't go negative */
@@ -1280,44 +1435,40 @@ void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len) {
       else
         p_lcb->sent_not_acked = 0;
 
-      l2c_link_check_send_pkts(p_lcb, NULL, NULL);
+      l2c_link_sched_set_ready(p_lcb);
 
-      /* If we were doing round-robin for low priority links, check 'em */
-      if ((p_lcb->acl_priority == L2CAP_PRIORITY_HIGH) &&
-          (l2cb.check_round_robin) &&
-          (l2cb.round_robin_unacked < l2cb.round_robin_quota)) {
-        l2c_link_check_send_pkts(NULL, NULL, NULL);
-      }
-      if ((p_lcb->transport == BT_TRANSPORT_LE) &&
-          (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH) &&
-          ((l2cb.ble_check_round_robin) &&
-           (l2cb.ble_round_robin_unacked < l2cb.ble_round_robin_quota))) {
-        l2c_link_check_send_pkts(NULL, NULL, NULL);
-      }
+      if (p_lcb->transport == BT_TRANSPORT_LE)
+        serve_le = true;
+      else
+        serve_br_edr = true;
     }
 
 #if (L2CAP_HCI_FLOW_CONTROL_DEBUG == TRUE)
     if (p_lcb) {
       if (p_lcb->transport == BT_TRANSPORT_LE) {
         L2CAP_TRACE_DEBUG(
-            "TotalWin=%d,LinkUnack(0x%x)=%d,RRCheck=%d,RRUnack=%d",
+            "TotalWin=%d,LinkUnack(0x%x)=%d,Sched=%d,RRUnack=%d",
             l2cb.controller_le_xmit_window, p_lcb->handle,
-            p_lcb->sent_not_acked, l2cb.ble_check_round_robin,
+            p_lcb->sent_not_acked, p_lcb->sched_state,
             l2cb.ble_round_robin_unacked);
       } else {
         L2CAP_TRACE_DEBUG(
-            "TotalWin=%d,LinkUnack(0x%x)=%d,RRCheck=%d,RRUnack=%d",
+            "TotalWin=%d,LinkUnack(0x%x)=%d,Sched=%d,RRUnack=%d",
             l2cb.controller_xmit_window, p_lcb->handle, p_lcb->sent_not_acked,
-            l2cb.check_round_robin, l2cb.round_robin_unacked);
+            p_lcb->sched_state, l2cb.round_robin_unacked);
       }
     } else {
       L2CAP_TRACE_DEBUG(
-          "TotalWin=%d  LE_Win: %d, Handle=0x%x, RRCheck=%d, RRUnack=%d",
+          "TotalWin=%d  LE_Win: %d, Handle=0x%x, RRUnack=%d, LE_RRUnack=%d",
           l2cb.controller_xmit_window, l2cb.controller_le_xmit_window, handle,
-          l2cb.ble_check_round_robin, l2cb.ble_round_robin_unacked);
+          l2cb.round_robin_unacked, l2cb.ble_round_robin_unacked);
     }
 #endif
   }
+
+  /* Serve the links unblocked by this event in one pass per transport */
+  if (serve_br_edr) l2c_link_sched_run(BT_TRANSPORT_BR_EDR);
+  if (serve_le) l2c_link_sched_run(BT_TRANSPORT_LE);
 }
 
 /*******************************************************************************
@@ -141,6 +141,9 @@ void l2cu_update_lcb_4_bonding(const RawAddress& p_bd_addr, bool is_bonding) {
 void l2cu_release_lcb(tL2C_LCB* p_lcb) {
   tL2C_CCB* p_ccb;
 
+  /* Take the link off the transmit scheduler before it can be reused */
+  l2c_link_sched_remove(p_lcb);
+
   p_lcb->in_use = false;
   p_lcb->is_bonding = false;
 
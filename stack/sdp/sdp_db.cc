@@ -25,19 +25,95 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <memory>
+#include <vector>
+
 #include "bt_target.h"
 
 #include "bt_common.h"
 
 #include "sdp_api.h"
+#include "sdp_db_cache.h"
 #include "sdpint.h"
 
+using bluetooth::Uuid;
+
 #if (SDP_SERVER_ENABLED == TRUE)
 /******************************************************************************/
 /*            L O C A L    F U N C T I O N     P R O T O T Y P E S            */
 /******************************************************************************/
-static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_his_uuid,
-                             uint16_t his_len, int nest_level);
+static void index_uuids_in_seq(SdpDbCache& cache, size_t slot, uint8_t* p,
+                               uint32_t seq_len, int nest_level);
+
+static std::unique_ptr<SdpDbCache> sdp_db_cache;
+
+static SdpDbCache& sdp_db_get_cache(void) {
+  if (!sdp_db_cache)
+    sdp_db_cache = std::make_unique<SdpDbCache>(SDP_MAX_RECORDS);
+  return *sdp_db_cache;
+}
+
+/*******************************************************************************
+ *
+ * Function         uuid_from_array
+ *
+ * Description      This function converts a BE UUID of 2, 4 or 16 bytes to its
+ *                  128-bit form, so that it can be looked up in the index.
+ *
+ * Returns          true if converted, false if the length is not a UUID length
+ *
+ ******************************************************************************/
+static bool uuid_from_array(uint8_t* p, uint32_t len, Uuid* p_uuid) {
+  switch (len) {
+    case Uuid::kNumBytes16: {
+      uint16_t uuid16;
+      BE_STREAM_TO_UINT16(uuid16, p);
+      *p_uuid = Uuid::From16Bit(uuid16);
+      return true;
+    }
+    case Uuid::kNumBytes32: {
+      uint32_t uuid32;
+      BE_STREAM_TO_UINT32(uuid32, p);
+      *p_uuid = Uuid::From32Bit(uuid32);
+      return true;
+    }
+    case Uuid::kNumBytes128:
+      *p_uuid = Uuid::From128BitBE(p);
+      return true;
+    default:
+      return false;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         build_uuid_index
+ *
+ * Description      This function rebuilds the UUID index from the UUIDs of
+ *                  every record, both UUID attributes and UUIDs in data
+ *                  element sequences.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void build_uuid_index(SdpDbCache& cache) {
+  tSDP_RECORD* p_rec = &sdp_cb.server_db.record[0];
+  Uuid uuid;
+
+  cache.ClearIndex();
+  for (uint16_t xx = 0; xx < sdp_cb.server_db.num_records; xx++, p_rec++) {
+    tSDP_ATTRIBUTE* p_attr = &p_rec->attribute[0];
+    for (uint16_t yy = 0; yy < p_rec->num_attributes; yy++, p_attr++) {
+      if (p_attr->type == UUID_DESC_TYPE) {
+        if (uuid_from_array(p_attr->value_ptr, p_attr->len, &uuid))
+          cache.AddUuid(xx, uuid);
+      } else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE) {
+        index_uuids_in_seq(cache, xx, p_attr->value_ptr, p_attr->len, 0);
+      }
+    }
+  }
+  cache.IndexBuilt();
+}
 
 /*******************************************************************************
  *
@@ -51,64 +127,47 @@ static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_his_uuid,
  *
  ******************************************************************************/
 tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
-  uint16_t xx, yy;
-  tSDP_ATTRIBUTE* p_attr;
-  tSDP_RECORD* p_end = &sdp_cb.server_db.record[sdp_cb.server_db.num_records];
+  SdpDbCache& cache = sdp_db_get_cache();
+  std::vector<Uuid> uuids(p_seq->num_uids);
+  size_t slot;
 
-  /* If NULL, start at the beginning, else start at the first specified record
-   */
-  if (!p_rec)
-    p_rec = &sdp_cb.server_db.record[0];
-  else
-    p_rec++;
-
-  /* Look through the records. The spec says that a match occurs if */
-  /* the record contains all the passed UUIDs in it.                */
-  for (; p_rec < p_end; p_rec++) {
-    for (yy = 0; yy < p_seq->num_uids; yy++) {
-      p_attr = &p_rec->attribute[0];
-      for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++) {
-        if (p_attr->type == UUID_DESC_TYPE) {
-          if (sdpu_compare_uuid_arrays(p_attr->value_ptr, p_attr->len,
-                                       &p_seq->uuid_entry[yy].value[0],
-                                       p_seq->uuid_entry[yy].len))
-            break;
-        } else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE) {
-          if (find_uuid_in_seq(p_attr->value_ptr, p_attr->len,
-                               &p_seq->uuid_entry[yy].value[0],
-                               p_seq->uuid_entry[yy].len, 0))
-            break;
-        }
-      }
-      /* If any UUID was not found,  on to the next record */
-      if (xx == p_rec->num_attributes) break;
-    }
+  if (!cache.IsIndexValid()) build_uuid_index(cache);
 
-    /* If every UUID was found in the record, return the record */
-    if (yy == p_seq->num_uids) return (p_rec);
+  /* A record matches if it contains all the passed UUIDs */
+  for (uint16_t yy = 0; yy < p_seq->num_uids; yy++) {
+    if (!uuid_from_array(&p_seq->uuid_entry[yy].value[0],
+                         p_seq->uuid_entry[yy].len, &uuids[yy]))
+      return (NULL);
   }
 
-  /* If here, no more records found */
-  return (NULL);
+  /* If NULL, start at the beginning, else start after the specified record */
+  slot = p_rec ? (p_rec - &sdp_cb.server_db.record[0]) + 1 : 0;
+  slot = cache.FindRecord(slot, uuids);
+  if (slot == SdpDbCache::NOT_FOUND || slot >= sdp_cb.server_db.num_records)
+    return (NULL);
+
+  return (&sdp_cb.server_db.record[slot]);
 }
 
 /*******************************************************************************
  *
- * Function         find_uuid_in_seq
+ * Function         index_uuids_in_seq
  *
- * Description      This function searches a data element sequenct for a UUID.
+ * Description      This function adds the UUIDs of a data element sequence of
+ *                  the record in a slot to the UUID index.
  *
- * Returns          true if found, else false
+ * Returns          void
  *
  ******************************************************************************/
-static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_uuid,
-                             uint16_t uuid_len, int nest_level) {
+static void index_uuids_in_seq(SdpDbCache& cache, size_t slot, uint8_t* p,
+                               uint32_t seq_len, int nest_level) {
   uint8_t* p_end = p + seq_len;
   uint8_t type;
   uint32_t len;
+  Uuid uuid;
 
   /* A little safety check to avoid excessive recursion */
-  if (nest_level > 3) return (false);
+  if (nest_level > 3) return;
 
   while (p < p_end) {
     type = *p++;
@@ -119,16 +178,12 @@ static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_uuid,
     }
     type = type >> 3;
     if (type == UUID_DESC_TYPE) {
-      if (sdpu_compare_uuid_arrays(p, len, p_uuid, uuid_len)) return (true);
+      if (uuid_from_array(p, len, &uuid)) cache.AddUuid(slot, uuid);
     } else if (type == DATA_ELE_SEQ_DESC_TYPE) {
-      if (find_uuid_in_seq(p, len, p_uuid, uuid_len, nest_level + 1))
-        return (true);
+      index_uuids_in_seq(cache, slot, p, len, nest_level + 1);
     }
     p = p + len;
   }
-
-  /* If here, failed to match */
-  return (false);
 }
 
 /*******************************************************************************
@@ -181,6 +236,66 @@ tSDP_ATTRIBUTE* sdp_db_find_attr_in_rec(tSDP_RECORD* p_rec, uint16_t start_attr,
   return (NULL);
 }
 
+/*******************************************************************************
+ *
+ * Function         sdp_db_build_attrib_entry
+ *
+ * Description      This function copies an attribute entry of a record, or a
+ *                  part of it, into the output buffer. The entries of the
+ *                  record are serialized once and then served from the cache
+ *                  until the record changes.
+ *
+ *                  p_out: output buffer
+ *                  p_rec: record of the attribute
+ *                  p_attr: attribute to be copied, normally one of p_rec
+ *                  len: maximum number of bytes to copy into p_out
+ *                  offset: current start offset within the attribute entry
+ *
+ * Returns          Pointer to next byte in the output buffer.
+ *                  offset is also updated
+ *
+ ******************************************************************************/
+uint8_t* sdp_db_build_attrib_entry(uint8_t* p_out, tSDP_RECORD* p_rec,
+                                   tSDP_ATTRIBUTE* p_attr, uint16_t len,
+                                   uint16_t* offset) {
+  tSDP_ATTRIBUTE* p_first = &p_rec->attribute[0];
+
+  /* Attributes rewritten for a particular peer are not in the cache */
+  if (p_attr < p_first || p_attr >= p_first + p_rec->num_attributes)
+    return sdpu_build_partial_attrib_entry(p_out, p_attr, len, offset);
+
+  SdpDbCache& cache = sdp_db_get_cache();
+  size_t slot = p_rec - &sdp_cb.server_db.record[0];
+  const SdpDbCache::Entries* p_entries =
+      cache.GetEntries(slot, p_rec->record_handle);
+
+  if (!p_entries) {
+    SdpDbCache::Entries entries;
+    entries.record_handle = p_rec->record_handle;
+    for (uint16_t xx = 0; xx < p_rec->num_attributes; xx++) {
+      size_t start = entries.data.size();
+      entries.offsets.push_back(start);
+      entries.data.resize(start +
+                          sdpu_get_attrib_entry_len(&p_rec->attribute[xx]));
+      sdpu_build_attrib_entry(&entries.data[start], &p_rec->attribute[xx]);
+    }
+    entries.offsets.push_back(entries.data.size());
+    p_entries = &cache.SetEntries(slot, std::move(entries));
+  }
+
+  size_t xx = p_attr - p_first;
+  uint16_t entry_start = p_entries->offsets[xx];
+  uint16_t entry_len = p_entries->offsets[xx + 1] - entry_start;
+  if (*offset >= entry_len) return p_out;
+
+  uint16_t len_to_copy = entry_len - *offset;
+  if (len_to_copy > len) len_to_copy = len;
+  memcpy(p_out, &p_entries->data[entry_start + *offset], len_to_copy);
+  *offset += len_to_copy;
+
+  return p_out + len_to_copy;
+}
+
 /*******************************************************************************
  *
  * Function         sdp_compose_proto_list
@@ -301,6 +416,7 @@ bool SDP_DeleteRecord(uint32_t handle) {
   if (handle == 0 || sdp_cb.server_db.num_records == 0) {
     /* Delete all records in the database */
     sdp_cb.server_db.num_records = 0;
+    sdp_db_get_cache().Clear();
 
     /* require new DI record to be created in SDP_SetLocalDiRecord */
     sdp_cb.server_db.di_primary_handle = 0;
@@ -310,6 +426,8 @@ bool SDP_DeleteRecord(uint32_t handle) {
     /* Find the record in the database */
     for (xx = 0; xx < sdp_cb.server_db.num_records; xx++, p_rec++) {
       if (p_rec->record_handle == handle) {
+        sdp_db_get_cache().RemoveRecord(xx);
+
         /* Found it. Shift everything up one */
         for (yy = xx; yy < sdp_cb.server_db.num_records - 1; yy++, p_rec++) {
           *p_rec = *(p_rec + 1);
@@ -393,6 +511,8 @@ bool SDP_AddAttribute(uint32_t handle, uint16_t attr_id, uint8_t attr_type,
     if (p_rec->record_handle == handle) {
       tSDP_ATTRIBUTE* p_attr = &p_rec->attribute[0];
 
+      sdp_db_get_cache().InvalidateRecord(zz);
+
       /* Found the record. Now, see if the attribute already exists */
       for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++) {
         /* The attribute exists. replace it */
@@ -804,6 +924,8 @@ bool SDP_DeleteAttribute(uint32_t handle, uint16_t attr_id) {
       /* Found it. Now, find the attribute */
       for (uint16_t yy = 0; yy < p_rec->num_attributes; yy++, p_attr++) {
         if (p_attr->id == attr_id) {
+          sdp_db_get_cache().InvalidateRecord(xx);
+
           pad_ptr = p_attr->value_ptr;
           len = p_attr->len;
 
@@ -817,7 +939,7 @@ bool SDP_DeleteAttribute(uint32_t handle, uint16_t attr_id) {
           /* Found it. Shift everything up one */
           p_rec->num_attributes--;
 
-          for (uint16_t zz = xx; zz < p_rec->num_attributes; zz++, p_attr++) {
+          for (uint16_t zz = yy; zz < p_rec->num_attributes; zz++, p_attr++) {
             *p_attr = *(p_attr + 1);
           }
 
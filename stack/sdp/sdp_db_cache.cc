@@ -0,0 +1,107 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "sdp_db_cache.h"
+
+#include <base/logging.h>
+
+SdpDbCache::SdpDbCache(size_t max_records)
+    : max_records_(max_records),
+      entries_(max_records),
+      entries_valid_(max_records, false) {
+  CHECK(max_records > 0);
+}
+
+void SdpDbCache::ClearIndex() {
+  records_by_uuid_.clear();
+  index_valid_ = false;
+}
+
+void SdpDbCache::AddUuid(size_t slot, const bluetooth::Uuid& uuid) {
+  CHECK(slot < max_records_);
+  auto it = records_by_uuid_.find(uuid);
+  if (it == records_by_uuid_.end())
+    it = records_by_uuid_.emplace(uuid, std::vector<bool>(max_records_)).first;
+  it->second[slot] = true;
+}
+
+size_t SdpDbCache::FindRecord(
+    size_t slot, const std::vector<bluetooth::Uuid>& uuids) const {
+  std::vector<const std::vector<bool>*> records;
+  for (const auto& uuid : uuids) {
+    auto it = records_by_uuid_.find(uuid);
+    if (it == records_by_uuid_.end()) return NOT_FOUND;
+    records.push_back(&it->second);
+  }
+
+  for (; slot < max_records_; slot++) {
+    bool match = true;
+    for (const auto* in_record : records) {
+      if (!(*in_record)[slot]) {
+        match = false;
+        break;
+      }
+    }
+    if (match) return slot;
+  }
+  return NOT_FOUND;
+}
+
+const SdpDbCache::Entries* SdpDbCache::GetEntries(
+    size_t slot, uint32_t record_handle) const {
+  if (slot >= max_records_ || !entries_valid_[slot] ||
+      entries_[slot].record_handle != record_handle)
+    return nullptr;
+  return &entries_[slot];
+}
+
+const SdpDbCache::Entries& SdpDbCache::SetEntries(size_t slot,
+                                                  Entries entries) {
+  CHECK(slot < max_records_);
+  CHECK(!entries.offsets.empty() &&
+        entries.offsets.back() == entries.data.size());
+  entries_[slot] = std::move(entries);
+  entries_valid_[slot] = true;
+  return entries_[slot];
+}
+
+void SdpDbCache::InvalidateRecord(size_t slot) {
+  if (slot < max_records_) {
+    entries_valid_[slot] = false;
+    entries_[slot] = Entries();
+  }
+  index_valid_ = false;
+}
+
+void SdpDbCache::RemoveRecord(size_t slot) {
+  if (slot < max_records_) {
+    entries_.erase(entries_.begin() + slot);
+    entries_.emplace_back();
+    entries_valid_.erase(entries_valid_.begin() + slot);
+    entries_valid_.push_back(false);
+  }
+  index_valid_ = false;
+}
+
+void SdpDbCache::Clear() {
+  ClearIndex();
+  for (size_t slot = 0; slot < max_records_; slot++) {
+    entries_valid_[slot] = false;
+    entries_[slot] = Entries();
+  }
+}
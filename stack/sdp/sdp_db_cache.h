@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+#include "types/bluetooth/uuid.h"
+
+/* Data derived from the records of the SDP server database, so that client
+ * requests neither walk every attribute of every record nor serialize the
+ * attributes again for each response.
+ *
+ * The UUID index maps each UUID found in a record, directly or nested in data
+ * element sequences, to the database slots of the records containing it. It
+ * is rebuilt as a whole after any change to the database.
+ *
+ * Each record slot also keeps its attribute entries serialized once, as they
+ * appear in an attribute list, so responses and their continuations are
+ * copied out of these bytes. They are dropped when the record changes.
+ */
+class SdpDbCache {
+ public:
+  static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+  /* Attribute entries of one record, concatenated in attribute order */
+  struct Entries {
+    uint32_t record_handle;
+    std::vector<uint8_t> data;
+    /* Start of each entry in |data|, followed by the end of the last one */
+    std::vector<uint16_t> offsets;
+  };
+
+  explicit SdpDbCache(size_t max_records);
+
+  bool IsIndexValid() const { return index_valid_; }
+
+  /* Starts a rebuild of the UUID index, to be followed by AddUuid() for every
+   * UUID of every record and then by IndexBuilt() */
+  void ClearIndex();
+  void AddUuid(size_t slot, const bluetooth::Uuid& uuid);
+  void IndexBuilt() { index_valid_ = true; }
+
+  /* Returns the first slot from |slot| on holding a record that contains all
+   * of |uuids|, or NOT_FOUND */
+  size_t FindRecord(size_t slot,
+                    const std::vector<bluetooth::Uuid>& uuids) const;
+
+  /* Returns the entries cached for the record |record_handle| in |slot|, or
+   * nullptr if they have to be built */
+  const Entries* GetEntries(size_t slot, uint32_t record_handle) const;
+  const Entries& SetEntries(size_t slot, Entries entries);
+
+  /* The attributes of the record in |slot| changed */
+  void InvalidateRecord(size_t slot);
+  /* The record in |slot| was deleted and the following ones moved up */
+  void RemoveRecord(size_t slot);
+  void Clear();
+
+ private:
+  const size_t max_records_;
+  bool index_valid_ = false;
+  /* For each UUID, whether the record in each slot contains it */
+  std::map<bluetooth::Uuid, std::vector<bool>> records_by_uuid_;
+  std::vector<Entries> entries_;
+  std::vector<bool> entries_valid_;
+};
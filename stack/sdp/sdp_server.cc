@@ -426,8 +426,8 @@ static void process_service_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
                                   SDP_TEXT_BAD_CONT_LEN);
           return;
         }
-        p_rsp = sdpu_build_partial_attrib_entry(p_rsp, p_attr, rem_len,
-                                                &p_ccb->cont_info.attr_offset);
+        p_rsp = sdp_db_build_attrib_entry(p_rsp, p_rec, p_attr, rem_len,
+                                          &p_ccb->cont_info.attr_offset);
 
         /* If the partial attrib could not been fully added yet */
         if (p_ccb->cont_info.attr_offset != attr_len)
@@ -445,14 +445,19 @@ static void process_service_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
         }
 
         /* add the partial attribute if possible */
-        p_rsp = sdpu_build_partial_attrib_entry(
-            p_rsp, p_attr, (uint16_t)rem_len, &p_ccb->cont_info.attr_offset);
+        p_rsp = sdp_db_build_attrib_entry(p_rsp, p_rec, p_attr,
+                                          (uint16_t)rem_len,
+                                          &p_ccb->cont_info.attr_offset);
 
         p_ccb->cont_info.next_attr_index = xx;
         p_ccb->cont_info.next_attr_start_id = p_attr->id;
         break;
       } else /* build the whole attribute */
-        p_rsp = sdpu_build_attrib_entry(p_rsp, p_attr);
+      {
+        uint16_t attr_offset = 0;
+        p_rsp = sdp_db_build_attrib_entry(p_rsp, p_rec, p_attr, attr_len,
+                                          &attr_offset);
+      }
 
       /* If doing a range, stick with this one till no more attributes found */
       if (attr_seq.attr_entry[xx].start != attr_seq.attr_entry[xx].end) {
@@ -555,6 +560,7 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
   tSDP_ATTR_SEQ attr_seq, attr_seq_sav;
   tSDP_ATTRIBUTE* p_attr;
   tSDP_ATTRIBUTE attr_sav;
+  uint8_t attr_value_sav[8];
   bool maxxed_out = false, is_cont = false;
   uint8_t* p_seq_start;
   uint16_t seq_len, attr_len;
@@ -662,8 +668,11 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
               "%s, device=%s is only accept AVRCP 1.4, reply AVRCP 1.4 "
               "instead.",
               __func__, p_ccb->device_address.ToString().c_str());
+          /* Reply from a copy, the record is shared with all other peers */
           memcpy(&attr_sav, p_attr, sizeof(tSDP_ATTRIBUTE));
-          attr_sav.value_ptr[attr_sav.len - 1] = 0x04;
+          memcpy(attr_value_sav, p_attr->value_ptr, sizeof(attr_value_sav));
+          attr_value_sav[sizeof(attr_value_sav) - 1] = 0x04;
+          attr_sav.value_ptr = attr_value_sav;
           p_attr = &attr_sav;
         }
         /* Check if attribute fits. Assume 3-byte value type/length */
@@ -687,8 +696,8 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
                                     SDP_TEXT_BAD_CONT_LEN);
             return;
           }
-          p_rsp = sdpu_build_partial_attrib_entry(
-              p_rsp, p_attr, rem_len, &p_ccb->cont_info.attr_offset);
+          p_rsp = sdp_db_build_attrib_entry(
+              p_rsp, p_rec, p_attr, rem_len, &p_ccb->cont_info.attr_offset);
 
           /* If the partial attrib could not been fully added yet */
           if (p_ccb->cont_info.attr_offset != attr_len) {
@@ -707,15 +716,20 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
           }
 
           /* add the partial attribute if possible */
-          p_rsp = sdpu_build_partial_attrib_entry(
-              p_rsp, p_attr, (uint16_t)rem_len, &p_ccb->cont_info.attr_offset);
+          p_rsp = sdp_db_build_attrib_entry(p_rsp, p_rec, p_attr,
+                                            (uint16_t)rem_len,
+                                            &p_ccb->cont_info.attr_offset);
 
           p_ccb->cont_info.next_attr_index = xx;
           p_ccb->cont_info.next_attr_start_id = p_attr->id;
           maxxed_out = true;
           break;
         } else /* build the whole attribute */
-          p_rsp = sdpu_build_attrib_entry(p_rsp, p_attr);
+        {
+          uint16_t attr_offset = 0;
+          p_rsp = sdp_db_build_attrib_entry(p_rsp, p_rec, p_attr, attr_len,
+                                            &attr_offset);
+        }
 
         /* If doing a range, stick with this one till no more attributes found
          */
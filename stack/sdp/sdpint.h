@@ -245,6 +245,9 @@ extern tSDP_RECORD* sdp_db_find_record(uint32_t handle);
 extern tSDP_ATTRIBUTE* sdp_db_find_attr_in_rec(tSDP_RECORD* p_rec,
                                                uint16_t start_attr,
                                                uint16_t end_attr);
+extern uint8_t* sdp_db_build_attrib_entry(uint8_t* p_out, tSDP_RECORD* p_rec,
+                                          tSDP_ATTRIBUTE* p_attr, uint16_t len,
+                                          uint16_t* offset);
 
 /* Functions provided by sdp_server.cc
  */
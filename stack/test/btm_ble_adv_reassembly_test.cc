@@ -0,0 +1,123 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "stack/btm/btm_ble_adv_reassembly.h"
+
+#include <gtest/gtest.h>
+
+namespace adv_reassembly {
+
+namespace {
+constexpr uint8_t kPublic = 0x00;
+constexpr uint8_t kRandom = 0x01;
+constexpr uint64_t kNoTimeout = UINT64_MAX;
+
+RawAddress MakeAddress(uint8_t n) {
+  return RawAddress({0x11, 0x22, 0x33, 0x44, 0x55, n});
+}
+
+class AdvReassemblyTest : public ::testing::Test {
+ protected:
+  void TearDown() override { reset(16, kNoTimeout); }
+};
+}  // namespace
+
+TEST_F(AdvReassemblyTest, chained_fragments) {
+  reset(16, kNoTimeout);
+  RawAddress addr = MakeAddress(1);
+
+  EXPECT_EQ(std::vector<uint8_t>({1, 2}), set(kPublic, addr, 0, {1, 2}));
+  EXPECT_EQ(std::vector<uint8_t>({1, 2, 3}), append(kPublic, addr, 0, {3}));
+  EXPECT_EQ(std::vector<uint8_t>({1, 2, 3, 4}),
+            append(kPublic, addr, 0, {4}));
+
+  clear(kPublic, addr, 0);
+  EXPECT_EQ(std::vector<uint8_t>({5}), append(kPublic, addr, 0, {5}));
+}
+
+TEST_F(AdvReassemblyTest, keyed_by_address_type_and_sid) {
+  reset(16, kNoTimeout);
+  RawAddress addr = MakeAddress(1);
+
+  append(kPublic, addr, 0, {1});
+  append(kRandom, addr, 0, {2});
+  append(kPublic, addr, 1, {3});
+
+  EXPECT_EQ(std::vector<uint8_t>({1, 4}), append(kPublic, addr, 0, {4}));
+  EXPECT_EQ(std::vector<uint8_t>({2, 5}), append(kRandom, addr, 0, {5}));
+  EXPECT_EQ(std::vector<uint8_t>({3, 6}), append(kPublic, addr, 1, {6}));
+}
+
+TEST_F(AdvReassemblyTest, set_restarts_data) {
+  reset(16, kNoTimeout);
+  RawAddress addr = MakeAddress(1);
+
+  set(kPublic, addr, 0, {1, 2});
+  EXPECT_EQ(std::vector<uint8_t>({3}), set(kPublic, addr, 0, {3}));
+  EXPECT_EQ(1u, get_stats().restarted);
+}
+
+/* More advertisers interleaving chained reports than the old cache held */
+TEST_F(AdvReassemblyTest, interleaved_advertisers) {
+  constexpr uint8_t kAdvertisers = 32;
+  reset(kAdvertisers, kNoTimeout);
+
+  for (uint8_t i = 0; i < kAdvertisers; i++)
+    set(kRandom, MakeAddress(i), 0, {i});
+  for (uint8_t i = 0; i < kAdvertisers; i++) {
+    const std::vector<uint8_t>& data =
+        append(kRandom, MakeAddress(i), 0, {0xff});
+    EXPECT_EQ(std::vector<uint8_t>({i, 0xff}), data);
+    clear(kRandom, MakeAddress(i), 0);
+  }
+
+  Stats stats = get_stats();
+  EXPECT_EQ(0u, stats.evicted);
+  EXPECT_EQ(0u, stats.expired);
+  EXPECT_EQ(kAdvertisers, stats.max_entries);
+}
+
+TEST_F(AdvReassemblyTest, least_recently_updated_evicted) {
+  reset(2, kNoTimeout);
+
+  set(kPublic, MakeAddress(1), 0, {1});
+  set(kPublic, MakeAddress(2), 0, {2});
+  append(kPublic, MakeAddress(1), 0, {1});
+  set(kPublic, MakeAddress(3), 0, {3});
+  EXPECT_EQ(1u, get_stats().evicted);
+
+  EXPECT_EQ(std::vector<uint8_t>({1, 1, 1}),
+            append(kPublic, MakeAddress(1), 0, {1}));
+  EXPECT_EQ(std::vector<uint8_t>({2}), append(kPublic, MakeAddress(2), 0, {2}));
+  EXPECT_EQ(2u, get_stats().evicted);
+}
+
+TEST_F(AdvReassemblyTest, expired_data_dropped) {
+  reset(16, 0);
+  RawAddress addr = MakeAddress(1);
+
+  set(kPublic, addr, 0, {1});
+  EXPECT_EQ(std::vector<uint8_t>({2}), append(kPublic, addr, 0, {2}));
+
+  Stats stats = get_stats();
+  EXPECT_EQ(1u, stats.expired);
+  EXPECT_EQ(0u, stats.evicted);
+  EXPECT_EQ(0u, stats.restarted);
+}
+
+}  // namespace adv_reassembly
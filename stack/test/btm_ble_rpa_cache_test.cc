@@ -0,0 +1,189 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "stack/btm/btm_ble_rpa_cache.h"
+
+#include <gtest/gtest.h>
+
+#include "stack/crypto_toolbox/crypto_toolbox.h"
+
+namespace rpa_cache {
+
+namespace {
+Octet16 MakeIrk(uint8_t seed) {
+  Octet16 irk;
+  for (size_t i = 0; i < irk.size(); i++) irk[i] = seed + i;
+  return irk;
+}
+
+/* Generate a Resolvable Private Address from |irk|, as the peer would */
+RawAddress MakeRpa(const Octet16& irk, uint32_t prand) {
+  Octet16 message{0};
+  message[0] = prand & 0xff;
+  message[1] = (prand >> 8) & 0xff;
+  message[2] = ((prand >> 16) & 0x3f) | 0x40;
+  Octet16 hash = crypto_toolbox::aes_128(irk, message);
+
+  RawAddress rpa;
+  rpa.address[0] = message[2];
+  rpa.address[1] = message[1];
+  rpa.address[2] = message[0];
+  rpa.address[3] = hash[2];
+  rpa.address[4] = hash[1];
+  rpa.address[5] = hash[0];
+  return rpa;
+}
+
+/* Resolve through the cache, the way btm_ble_addr.cc does */
+std::optional<Octet16> Resolve(const RawAddress& rpa,
+                               const std::vector<Octet16>& irks) {
+  std::optional<Octet16> irk;
+  if (find(rpa, &irk)) return irk;
+
+  const Octet16* match = resolve(rpa, irks);
+  if (match != nullptr) irk = *match;
+  put(rpa, irk, 1);
+  return irk;
+}
+}  // namespace
+
+class RpaCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    reset();
+    for (uint8_t i = 0; i < 8; i++) irks_.push_back(MakeIrk(i * 16));
+  }
+
+  void TearDown() override { reset(); }
+
+  std::vector<Octet16> irks_;
+};
+
+TEST_F(RpaCacheTest, resolve_finds_matching_irk) {
+  for (size_t i = 0; i < irks_.size(); i++) {
+    const Octet16* match = resolve(MakeRpa(irks_[i], 0x123456 + i), irks_);
+    ASSERT_NE(match, nullptr);
+    EXPECT_EQ(*match, irks_[i]);
+  }
+
+  EXPECT_EQ(resolve(MakeRpa(MakeIrk(0xff), 0x123456), irks_), nullptr);
+  EXPECT_EQ(resolve(MakeRpa(irks_[0], 0x123456), {}), nullptr);
+}
+
+/* Of several records with the same IRK, the first one is reported */
+TEST_F(RpaCacheTest, resolve_returns_first_match) {
+  std::vector<Octet16> irks = {MakeIrk(0x80), irks_[3], irks_[3]};
+  const Octet16* match = resolve(MakeRpa(irks_[3], 0x2a2a2a), irks);
+  EXPECT_EQ(match, &irks[1]);
+}
+
+TEST_F(RpaCacheTest, hit_after_miss) {
+  RawAddress rpa = MakeRpa(irks_[5], 0x010203);
+  std::optional<Octet16> irk;
+  EXPECT_FALSE(find(rpa, &irk));
+
+  put(rpa, irks_[5], 10);
+  ASSERT_TRUE(find(rpa, &irk));
+  EXPECT_EQ(irk, irks_[5]);
+
+  Stats stats = get_stats();
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.miss_latency_total_us, 10u);
+  EXPECT_EQ(stats.miss_latency_max_us, 10u);
+}
+
+/* Addresses of unknown devices are cached too, so they are not checked against
+ * every IRK again for each advertising report */
+TEST_F(RpaCacheTest, unresolvable_address_cached) {
+  RawAddress rpa = MakeRpa(MakeIrk(0xff), 0x010203);
+  EXPECT_EQ(Resolve(rpa, irks_), std::nullopt);
+
+  std::optional<Octet16> irk = irks_[0];
+  ASSERT_TRUE(find(rpa, &irk));
+  EXPECT_EQ(irk, std::nullopt);
+}
+
+/* A new IRK may resolve an address that was cached as unresolvable */
+TEST_F(RpaCacheTest, clear_on_irk_change) {
+  Octet16 new_irk = MakeIrk(0xf0);
+  RawAddress rpa = MakeRpa(new_irk, 0x0a0b0c);
+  EXPECT_EQ(Resolve(rpa, irks_), std::nullopt);
+
+  irks_.push_back(new_irk);
+  clear();
+  EXPECT_EQ(Resolve(rpa, irks_), new_irk);
+  EXPECT_EQ(get_stats().misses, 2u);
+}
+
+TEST_F(RpaCacheTest, entries_expire) {
+  reset(RPA_CACHE_SIZE, 0);
+  RawAddress rpa = MakeRpa(irks_[1], 0x010203);
+  put(rpa, irks_[1], 1);
+
+  std::optional<Octet16> irk;
+  EXPECT_FALSE(find(rpa, &irk));
+  EXPECT_EQ(get_stats().expired, 1u);
+}
+
+TEST_F(RpaCacheTest, evict_least_recently_used) {
+  reset(2);
+  RawAddress rpa_1 = MakeRpa(irks_[1], 1);
+  RawAddress rpa_2 = MakeRpa(irks_[2], 2);
+  RawAddress rpa_3 = MakeRpa(irks_[3], 3);
+  std::optional<Octet16> irk;
+
+  put(rpa_1, irks_[1], 1);
+  put(rpa_2, irks_[2], 1);
+  /* rpa_1 is now more recently used than rpa_2 */
+  EXPECT_TRUE(find(rpa_1, &irk));
+  put(rpa_3, irks_[3], 1);
+
+  EXPECT_TRUE(find(rpa_1, &irk));
+  EXPECT_FALSE(find(rpa_2, &irk));
+  EXPECT_TRUE(find(rpa_3, &irk));
+}
+
+/* Many reports from a few devices in a crowded scan: only the first report of
+ * each address costs a pass over the IRKs */
+TEST_F(RpaCacheTest, crowded_scan) {
+  std::vector<Octet16> irks;
+  for (int i = 0; i < 200; i++) irks.push_back(MakeIrk(i));
+
+  std::vector<RawAddress> addresses;
+  for (int i = 0; i < 25; i++) addresses.push_back(MakeRpa(irks[i * 8], i));
+  for (int i = 0; i < 25; i++)
+    addresses.push_back(MakeRpa(MakeIrk(0xff), 0x1000 + i));
+
+  for (int report = 0; report < 1000; report++) {
+    const RawAddress& rpa = addresses[report % addresses.size()];
+    std::optional<Octet16> irk = Resolve(rpa, irks);
+    size_t index = report % addresses.size();
+    if (index < 25) {
+      EXPECT_EQ(irk, irks[index * 8]);
+    } else {
+      EXPECT_EQ(irk, std::nullopt);
+    }
+  }
+
+  Stats stats = get_stats();
+  EXPECT_EQ(stats.misses, addresses.size());
+  EXPECT_EQ(stats.hits, 1000 - addresses.size());
+}
+
+}  // namespace rpa_cache
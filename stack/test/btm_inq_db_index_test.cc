@@ -0,0 +1,167 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "stack/btm/btm_inq_db_index.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kTtlMs = 1000;
+
+RawAddress MakeAddress(uint16_t n) {
+  return RawAddress({0xbe, 0xac, 0x01, 0x55, (uint8_t)(n >> 8),
+                     (uint8_t)(n & 0xff)});
+}
+
+/* Stand-in for the inquiry database the index is kept alongside */
+class InqDbIndexTest : public ::testing::Test {
+ protected:
+  void Init(size_t capacity) {
+    index_.reset(new InqDbIndex(capacity, kTtlMs));
+    time_of_resp_.assign(capacity, 0);
+    released_.clear();
+  }
+
+  size_t Add(const RawAddress& address, uint64_t now_ms) {
+    size_t slot = index_->Add(
+        address, now_ms, [this](size_t s) { return time_of_resp_[s]; },
+        [this](size_t s) { released_.push_back(s); });
+    time_of_resp_[slot] = now_ms;
+    return slot;
+  }
+
+  std::unique_ptr<InqDbIndex> index_;
+  std::vector<uint64_t> time_of_resp_;
+  std::vector<size_t> released_;
+};
+
+}  // namespace
+
+TEST_F(InqDbIndexTest, find_after_add) {
+  Init(8);
+  EXPECT_EQ(InqDbIndex::NOT_FOUND, index_->Find(MakeAddress(1)));
+
+  size_t slot = Add(MakeAddress(1), 0);
+  EXPECT_EQ(slot, index_->Find(MakeAddress(1)));
+  EXPECT_EQ(slot, Add(MakeAddress(1), 10));
+  EXPECT_EQ(1u, index_->Size());
+}
+
+TEST_F(InqDbIndexTest, slots_handed_out_lowest_first) {
+  Init(4);
+  for (uint16_t i = 0; i < 4; i++) EXPECT_EQ(i, Add(MakeAddress(i), 0));
+
+  index_->Remove(2);
+  index_->Remove(1);
+  EXPECT_EQ(InqDbIndex::NOT_FOUND, index_->Find(MakeAddress(1)));
+  EXPECT_EQ(1u, Add(MakeAddress(10), 0));
+  EXPECT_EQ(2u, Add(MakeAddress(11), 0));
+  EXPECT_TRUE(released_.empty());
+}
+
+TEST_F(InqDbIndexTest, full_database_reclaims_expired_entries) {
+  Init(4);
+  Add(MakeAddress(0), 0);
+  Add(MakeAddress(1), 500);
+  Add(MakeAddress(2), 0);
+  Add(MakeAddress(3), 900);
+
+  /* Entries 0 and 2 expired: both go in one sweep */
+  EXPECT_EQ(0u, Add(MakeAddress(4), 1200));
+  EXPECT_EQ(std::vector<size_t>({0, 2}), released_);
+  EXPECT_EQ(2u, index_->ExpiredCount());
+  EXPECT_EQ(0u, index_->EvictedCount());
+  EXPECT_EQ(InqDbIndex::NOT_FOUND, index_->Find(MakeAddress(2)));
+
+  /* The next new device takes the other slot freed by the sweep */
+  EXPECT_EQ(2u, Add(MakeAddress(5), 1200));
+  EXPECT_EQ(2u, released_.size());
+}
+
+TEST_F(InqDbIndexTest, full_database_evicts_oldest_when_none_expired) {
+  Init(3);
+  Add(MakeAddress(0), 300);
+  Add(MakeAddress(1), 100);
+  Add(MakeAddress(2), 200);
+
+  EXPECT_EQ(1u, Add(MakeAddress(3), 400));
+  EXPECT_EQ(std::vector<size_t>({1}), released_);
+  EXPECT_EQ(1u, index_->EvictedCount());
+  EXPECT_EQ(InqDbIndex::NOT_FOUND, index_->Find(MakeAddress(1)));
+  EXPECT_EQ(1u, index_->Find(MakeAddress(3)));
+  EXPECT_EQ(3u, index_->Size());
+}
+
+TEST_F(InqDbIndexTest, set_follows_entries_moved_by_sort) {
+  Init(4);
+  Add(MakeAddress(0), 0);
+  Add(MakeAddress(1), 0);
+
+  /* The database swapped its two entries */
+  index_->Set(0, MakeAddress(1));
+  index_->Set(1, MakeAddress(0));
+  EXPECT_EQ(0u, index_->Find(MakeAddress(1)));
+  EXPECT_EQ(1u, index_->Find(MakeAddress(0)));
+  EXPECT_EQ(2u, index_->Size());
+
+  /* Setting a free slot takes it out of the free list */
+  index_->Set(2, MakeAddress(2));
+  EXPECT_EQ(3u, Add(MakeAddress(3), 0));
+}
+
+TEST_F(InqDbIndexTest, clear) {
+  Init(4);
+  for (uint16_t i = 0; i < 4; i++) Add(MakeAddress(i), 0);
+
+  index_->Clear();
+  EXPECT_EQ(0u, index_->Size());
+  EXPECT_EQ(InqDbIndex::NOT_FOUND, index_->Find(MakeAddress(3)));
+  EXPECT_EQ(0u, Add(MakeAddress(3), 0));
+  EXPECT_TRUE(released_.empty());
+}
+
+/* Addresses of a beacon swarm, as advertised by the BeaconSwarm test device of
+ * the test vendor library: the low byte of the address is incremented on every
+ * advertisement, so the scanner keeps seeing new devices. */
+TEST_F(InqDbIndexTest, beacon_swarm) {
+  constexpr size_t kCapacity = 128;
+  constexpr int kAdvertisements = 20000;
+  constexpr uint64_t kIntervalMs = 10;
+  Init(kCapacity);
+
+  RawAddress address = MakeAddress(0);
+  for (int i = 0; i < kAdvertisements; i++) {
+    uint64_t now_ms = i * kIntervalMs;
+    size_t slot = Add(address, now_ms);
+    ASSERT_LT(slot, kCapacity);
+    ASSERT_EQ(slot, index_->Find(address));
+    ASSERT_LE(index_->Size(), kCapacity);
+    address.address[5]++;
+  }
+
+  /* 256 addresses cycle through a 128 entry database: every address is seen
+   * again only after it got reclaimed. Fewer devices than the database holds
+   * answer within the TTL, so expired entries always make enough room and no
+   * entry is evicted while still fresh. */
+  EXPECT_EQ((uint64_t)kAdvertisements, index_->Size() + index_->ExpiredCount());
+  EXPECT_EQ(0u, index_->EvictedCount());
+}
@@ -24,6 +24,7 @@
 
 #include <base/logging.h>
 #include <base/strings/string_number_conversions.h>
+#include <random>
 #include <vector>
 
 using ::testing::ElementsAreArray;
@@ -397,4 +398,27 @@ TEST(CryptoToolboxTest, bt_spec_example_d_12_test) {
   EXPECT_EQ(expected_ltk, ltk);
 }
 
+/* aes_128() keeps the reversed byte order, whichever backend it runs on */
+TEST(CryptoToolboxTest, aes_128_matches_table_test) {
+  std::mt19937 random(0xae5);
+  for (int i = 0; i < 100; i++) {
+    Octet16 key, message;
+    for (int j = 0; j < OCTET16_LEN; j++) {
+      key[j] = random();
+      message[j] = random();
+    }
+
+    Octet16 key_reversed, message_reversed, expected;
+    std::reverse_copy(key.begin(), key.end(), key_reversed.begin());
+    std::reverse_copy(message.begin(), message.end(),
+                      message_reversed.begin());
+    aes_context ctx;
+    aes_set_key(key_reversed.data(), key_reversed.size(), &ctx);
+    aes_encrypt(message_reversed.data(), expected.data(), &ctx);
+    std::reverse(expected.begin(), expected.end());
+
+    EXPECT_EQ(aes_128(key, message), expected);
+  }
+}
+
 }  // namespace crypto_toolbox
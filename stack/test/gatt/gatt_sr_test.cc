@@ -18,11 +18,17 @@
 #include <gtest/gtest.h>
 #include <stdio.h>
 #include <cstdint>
+#include <vector>
 
 #include "osi/test/AllocationTestHarness.h"
 #include "stack/gatt/gatt_int.h"
 #undef LOG_TAG
 #include "stack/gatt/gatt_sr.cc"
+// Discovery requests are answered from the real attribute database, the write
+// tests keep their fake permission check
+#define gatts_write_attr_perm_check gatts_db_write_attr_perm_check
+#include "stack/gatt/gatt_db.cc"
+#undef gatts_write_attr_perm_check
 #include "types/raw_address.h"
 
 #define MAX_UINT16 ((uint16_t)0xffff)
@@ -34,7 +40,11 @@ namespace {
 struct TestMutables {
   struct {
     uint8_t op_code_;
+    tGATT_SR_MSG msg_;
   } attp_build_sr_msg;
+  struct {
+    std::vector<uint8_t> pdu_;
+  } attp_send_sr_msg;
   struct {
     uint16_t conn_id_{0};
     uint32_t trans_id_{0};
@@ -62,13 +72,19 @@ bool direct_connect_remove(uint8_t app_id, const RawAddress& address) {
 BT_HDR* attp_build_sr_msg(tGATT_TCB& tcb, uint8_t op_code,
                           tGATT_SR_MSG* p_msg) {
   test_state_.attp_build_sr_msg.op_code_ = op_code;
+  test_state_.attp_build_sr_msg.msg_ = *p_msg;
   return nullptr;
 }
 tGATT_STATUS attp_send_cl_msg(tGATT_TCB& tcb, tGATT_CLCB* p_clcb,
                               uint8_t op_code, tGATT_CL_MSG* p_msg) {
   return 0;
 }
-tGATT_STATUS attp_send_sr_msg(tGATT_TCB& tcb, BT_HDR* p_msg) { return 0; }
+tGATT_STATUS attp_send_sr_msg(tGATT_TCB& tcb, BT_HDR* p_msg) {
+  uint8_t* p = (uint8_t*)(p_msg + 1) + p_msg->offset;
+  test_state_.attp_send_sr_msg.pdu_.assign(p, p + p_msg->len);
+  osi_free(p_msg);
+  return 0;
+}
 uint8_t btm_ble_read_sec_key_size(const RawAddress& bd_addr) { return 0; }
 bool BTM_GetSecurityFlagsByTransport(const RawAddress& bd_addr,
                                      uint8_t* p_sec_flags,
@@ -78,31 +94,11 @@ bool BTM_GetSecurityFlagsByTransport(const RawAddress& bd_addr,
 void gatt_act_discovery(tGATT_CLCB* p_clcb) {}
 bool gatt_disconnect(tGATT_TCB* p_tcb) { return false; }
 tGATT_CH_STATE gatt_get_ch_state(tGATT_TCB* p_tcb) { return 0; }
-tGATT_STATUS gatts_db_read_attr_value_by_type(
-    tGATT_TCB& tcb, tGATT_SVC_DB* p_db, uint8_t op_code, BT_HDR* p_rsp,
-    uint16_t s_handle, uint16_t e_handle, const Uuid& type, uint16_t* p_len,
-    tGATT_SEC_FLAG sec_flag, uint8_t key_size, uint32_t trans_id,
-    uint16_t* p_cur_handle) {
-  return 0;
-}
 void gatt_set_ch_state(tGATT_TCB* p_tcb, tGATT_CH_STATE ch_state) {}
-Uuid* gatts_get_service_uuid(tGATT_SVC_DB* p_db) { return nullptr; }
 tGATT_STATUS GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_handle,
                                          uint16_t val_len, uint8_t* p_val) {
   return GATT_SUCCESS;
 }
-tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB* p_db, bool is_long,
-                                        uint16_t handle,
-                                        tGATT_SEC_FLAG sec_flag,
-                                        uint8_t key_size) {
-  return GATT_SUCCESS;
-}
-tGATT_STATUS gatts_read_attr_value_by_handle(
-    tGATT_TCB& tcb, tGATT_SVC_DB* p_db, uint8_t op_code, uint16_t handle,
-    uint16_t offset, uint8_t* p_value, uint16_t* p_len, uint16_t mtu,
-    tGATT_SEC_FLAG sec_flag, uint8_t key_size, uint32_t trans_id) {
-  return GATT_SUCCESS;
-}
 tGATT_STATUS gatts_write_attr_perm_check(tGATT_SVC_DB* p_db, uint8_t op_code,
                                          uint16_t handle, uint16_t offset,
                                          uint8_t* p_data, uint16_t len,
@@ -318,3 +314,211 @@ TEST_F(GattSrTest, gatts_process_write_req_request_write_typical) {
         false);
   CHECK(test_state_.application_request_callback.data_.write_req.len == length);
 }
+
+TEST_F(GattSrTest, handle_index_resolves_services_and_attributes) {
+  const Uuid kCharUuid = Uuid::From16Bit(0x2A00);
+  tGATT_SVC_DB db;
+  for (uint16_t handle = 10; handle <= 12; handle++) {
+    db.attr_list.emplace_back();
+    db.attr_list.back().handle = handle;
+  }
+  db.attr_list[0].uuid = Uuid::From16Bit(GATT_UUID_PRI_SERVICE);
+  db.attr_list[1].uuid = Uuid::From16Bit(GATT_UUID_CHAR_DECLARE);
+  db.attr_list[2].uuid = kCharUuid;
+
+  std::list<tGATT_SRV_LIST_ELEM> srv_list(1);
+  srv_list.front().s_hdl = 10;
+  srv_list.front().e_hdl = 15;
+  srv_list.front().p_db = &db;
+  gatt_cb.srv_list_info = &srv_list;
+  gatt_cb.srv_index = new tGATT_SRV_INDEX();
+  gatt_sr_rebuild_index();
+
+  CHECK(gatt_sr_find_i_rcb_by_handle(9) == srv_list.end());
+  CHECK(gatt_sr_find_i_rcb_by_handle(10) == srv_list.begin());
+  CHECK(gatt_sr_find_i_rcb_by_handle(15) == srv_list.begin());
+  CHECK(gatt_sr_find_i_rcb_by_handle(16) == srv_list.end());
+  CHECK(gatt_sr_get_max_indexed_handle() == 15);
+
+  CHECK(gatt_sr_find_attr_by_handle(12) == &db.attr_list[2]);
+  CHECK(gatt_sr_find_attr_by_handle(13) == nullptr);
+
+  const std::vector<uint16_t>* handles =
+      gatt_sr_find_handles_by_type(kCharUuid);
+  CHECK(handles != nullptr);
+  CHECK(*handles == std::vector<uint16_t>{12});
+  CHECK(gatt_sr_find_handles_by_type(Uuid::From16Bit(0x2A01)) == nullptr);
+
+  srv_list.clear();
+  gatt_sr_rebuild_index();
+  CHECK(gatt_sr_find_i_rcb_by_handle(10) == srv_list.end());
+  CHECK(gatt_sr_find_attr_by_handle(12) == nullptr);
+
+  delete gatt_cb.srv_index;
+  gatt_cb.srv_index = nullptr;
+  gatt_cb.srv_list_info = nullptr;
+}
+
+/**
+ * Two started services, answering discovery requests:
+ *
+ *   1  Primary service 0x180F     10  Primary service 0x1800
+ *   2  Characteristic             11  Characteristic
+ *   3    Value 0x2A19             12    Value 0x2A00
+ *   4    Descriptor 0x2902        13    Descriptor 0x2901
+ *   5  Characteristic             14  (unused)
+ *   6    Value 0x2A1A
+ *   7  (unused)
+ */
+class GattSrDiscoveryTest : public GattSrTest {
+ protected:
+  void SetUp() override {
+    GattSrTest::SetUp();
+
+    gatts_init_service_db(db_[0], Uuid::From16Bit(0x180F), true, 1, 7);
+    gatts_add_characteristic(db_[0], GATT_PERM_READ, GATT_CHAR_PROP_BIT_READ,
+                             Uuid::From16Bit(0x2A19));
+    gatts_add_char_descr(db_[0], GATT_PERM_READ,
+                         Uuid::From16Bit(GATT_UUID_CHAR_CLIENT_CONFIG));
+    gatts_add_characteristic(db_[0], GATT_PERM_READ, GATT_CHAR_PROP_BIT_READ,
+                             Uuid::From16Bit(0x2A1A));
+
+    gatts_init_service_db(db_[1], Uuid::From16Bit(0x1800), true, 10, 5);
+    gatts_add_characteristic(db_[1], GATT_PERM_READ, GATT_CHAR_PROP_BIT_READ,
+                             Uuid::From16Bit(0x2A00));
+    gatts_add_char_descr(db_[1], GATT_PERM_READ,
+                         Uuid::From16Bit(GATT_UUID_CHAR_DESCRIPTION));
+
+    srv_list_.resize(2);
+    AddService(srv_list_.front(), db_[0], 1, 7);
+    AddService(srv_list_.back(), db_[1], 10, 14);
+    gatt_cb.srv_list_info = &srv_list_;
+    gatt_cb.srv_index = new tGATT_SRV_INDEX();
+    gatt_sr_rebuild_index();
+
+    tcb_.payload_size = GATT_DEF_BLE_MTU_SIZE;
+  }
+
+  void TearDown() override {
+    delete gatt_cb.srv_index;
+    gatt_cb.srv_index = nullptr;
+    gatt_cb.srv_list_info = nullptr;
+    GattSrTest::TearDown();
+  }
+
+  void AddService(tGATT_SRV_LIST_ELEM& el, tGATT_SVC_DB& db, uint16_t s_hdl,
+                  uint16_t e_hdl) {
+    el.gatt_if = el_.gatt_if;
+    el.s_hdl = s_hdl;
+    el.e_hdl = e_hdl;
+    el.p_db = &db;
+  }
+
+  void ReadByType(uint16_t s_hdl, uint16_t e_hdl, uint16_t uuid) {
+    uint8_t req[6];
+    uint8_t* p = req;
+    UINT16_TO_STREAM(p, s_hdl);
+    UINT16_TO_STREAM(p, e_hdl);
+    UINT16_TO_STREAM(p, uuid);
+    gatt_server_handle_client_req(tcb_, GATT_REQ_READ_BY_TYPE, sizeof(req),
+                                  req);
+  }
+
+  void FindInfo(uint16_t s_hdl, uint16_t e_hdl) {
+    uint8_t req[4];
+    uint8_t* p = req;
+    UINT16_TO_STREAM(p, s_hdl);
+    UINT16_TO_STREAM(p, e_hdl);
+    gatt_server_handle_client_req(tcb_, GATT_REQ_FIND_INFO, sizeof(req), req);
+  }
+
+  const std::vector<uint8_t>& Response() {
+    return test_state_.attp_send_sr_msg.pdu_;
+  }
+
+  bool IsErrorResponse(uint8_t op_code, uint16_t handle, uint8_t reason) {
+    const tGATT_ERROR& error = test_state_.attp_build_sr_msg.msg_.error;
+    return test_state_.attp_build_sr_msg.op_code_ == GATT_RSP_ERROR &&
+           error.cmd_code == op_code && error.handle == handle &&
+           error.reason == reason;
+  }
+
+  tGATT_SVC_DB db_[2];
+  std::list<tGATT_SRV_LIST_ELEM> srv_list_;
+};
+
+TEST_F(GattSrDiscoveryTest, read_by_type_discovers_characteristics) {
+  ReadByType(0x0001, 0xFFFF, GATT_UUID_CHAR_DECLARE);
+
+  // Declarations across both services, as many as fit in the MTU
+  CHECK(Response() == std::vector<uint8_t>({
+                          0x09, 0x07,                               // header
+                          0x02, 0x00, 0x02, 0x03, 0x00, 0x19, 0x2A,  // 2
+                          0x05, 0x00, 0x02, 0x06, 0x00, 0x1A, 0x2A,  // 5
+                          0x0B, 0x00, 0x02, 0x0C, 0x00, 0x00, 0x2A,  // 11
+                      }));
+}
+
+TEST_F(GattSrDiscoveryTest, read_by_type_range_spans_services) {
+  ReadByType(0x0004, 0x000C, GATT_UUID_CHAR_DECLARE);
+
+  CHECK(Response() == std::vector<uint8_t>({
+                          0x09, 0x07,                               // header
+                          0x05, 0x00, 0x02, 0x06, 0x00, 0x1A, 0x2A,  // 5
+                          0x0B, 0x00, 0x02, 0x0C, 0x00, 0x00, 0x2A,  // 11
+                      }));
+}
+
+TEST_F(GattSrDiscoveryTest, read_by_type_stops_at_end_handle) {
+  // Handle 5 is past the end of the range. It used to be returned because
+  // the service overlaps the range and only its start handle was checked.
+  ReadByType(0x0001, 0x0004, GATT_UUID_CHAR_DECLARE);
+
+  CHECK(Response() == std::vector<uint8_t>({
+                          0x09, 0x07,                               // header
+                          0x02, 0x00, 0x02, 0x03, 0x00, 0x19, 0x2A,  // 2
+                      }));
+}
+
+TEST_F(GattSrDiscoveryTest, read_by_type_nothing_before_end_handle) {
+  // Handle 11 used to be returned for this range too
+  ReadByType(0x000A, 0x000A, GATT_UUID_CHAR_DECLARE);
+
+  CHECK(Response().empty());
+  CHECK(IsErrorResponse(GATT_REQ_READ_BY_TYPE, 0x000A, GATT_NOT_FOUND));
+}
+
+TEST_F(GattSrDiscoveryTest, find_info_one_entry_per_service) {
+  FindInfo(0x0001, 0xFFFF);
+
+  // The first attribute in range of each service
+  CHECK(Response() == std::vector<uint8_t>({
+                          0x05, 0x01,              // header, 16-bit UUIDs
+                          0x01, 0x00, 0x00, 0x28,  // 1
+                          0x0A, 0x00, 0x00, 0x28,  // 10
+                      }));
+}
+
+TEST_F(GattSrDiscoveryTest, find_info_descriptors) {
+  FindInfo(0x0003, 0x0004);
+  CHECK(Response() == std::vector<uint8_t>({
+                          0x05, 0x01,              // header, 16-bit UUIDs
+                          0x03, 0x00, 0x19, 0x2A,  // 3
+                      }));
+
+  FindInfo(0x0004, 0x000C);
+  CHECK(Response() == std::vector<uint8_t>({
+                          0x05, 0x01,              // header, 16-bit UUIDs
+                          0x04, 0x00, 0x02, 0x29,  // 4
+                          0x0A, 0x00, 0x00, 0x28,  // 10
+                      }));
+}
+
+TEST_F(GattSrDiscoveryTest, find_info_unused_handles) {
+  // Handle 7 belongs to the first service but holds no attribute, handles 8
+  // and 9 belong to no service
+  FindInfo(0x0007, 0x0009);
+
+  CHECK(Response().empty());
+  CHECK(IsErrorResponse(GATT_REQ_FIND_INFO, 0x0007, GATT_NOT_FOUND));
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Drives the L2CAP HCI transmit scheduler in l2c_link.cc against a simulated
+// controller: every link always has data queued, and the controller acks its
+// oldest outstanding packet with one Number Of Completed Packets event per
+// benchmark iteration.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "btm_int.h"
+#include "device/include/controller.h"
+#include "hcimsgs.h"
+#include "l2c_int.h"
+#include "osi/include/list.h"
+#include "stack/include/btu.h"
+
+using ::benchmark::State;
+
+tL2C_CB l2cb;
+tBTM_CB btm_cb;
+
+namespace {
+
+// ACL buffers advertised by a typical controller
+constexpr uint16_t kControllerBuffers = 8;
+constexpr uint16_t kAclPacketSize = 1021 + HCI_DATA_PREAMBLE_SIZE;
+constexpr uint16_t kPacketLen = 100;
+constexpr uint16_t kFirstHandle = 0x0040;
+
+// One packet per link, handed out again each time the link is polled so that
+// the links never run dry
+alignas(BT_HDR) uint8_t link_packets[MAX_L2CAP_LINKS]
+                                    [sizeof(BT_HDR) + kPacketLen];
+// Handles of the packets sitting in the controller buffers, oldest first
+std::deque<uint16_t> controller_buffers;
+std::vector<uint64_t> link_packets_sent(MAX_L2CAP_LINKS);
+
+uint16_t get_acl_packet_size() { return kAclPacketSize; }
+uint16_t get_acl_data_size() { return kAclPacketSize - HCI_DATA_PREAMBLE_SIZE; }
+
+const controller_t* FakeController() {
+  static controller_t controller = [] {
+    controller_t c = {};
+    c.get_acl_packet_size_classic = get_acl_packet_size;
+    c.get_acl_packet_size_ble = get_acl_packet_size;
+    c.get_acl_data_size_classic = get_acl_data_size;
+    c.get_acl_data_size_ble = get_acl_data_size;
+    return c;
+  }();
+  return &controller;
+}
+
+void SetUpLinks(int num_links, tBT_TRANSPORT transport) {
+  memset(&l2cb, 0, sizeof(l2cb));
+  controller_buffers.clear();
+  std::fill(link_packets_sent.begin(), link_packets_sent.end(), 0);
+
+  for (int i = 0; i < num_links; i++) {
+    tL2C_LCB* p_lcb = &l2cb.lcb_pool[i];
+    p_lcb->in_use = true;
+    p_lcb->link_state = LST_CONNECTED;
+    p_lcb->handle = kFirstHandle + i;
+    p_lcb->transport = transport;
+    p_lcb->acl_priority = L2CAP_PRIORITY_NORMAL;
+    p_lcb->link_xmit_data_q = list_new(NULL);
+  }
+
+  if (transport == BT_TRANSPORT_LE) {
+    // Same split as l2c_ble_link_adjust_allocation() for low priority links
+    l2cb.num_lm_ble_bufs = kControllerBuffers;
+    l2cb.controller_le_xmit_window = kControllerBuffers;
+    l2cb.num_ble_links_active = num_links;
+    if (num_links > kControllerBuffers) {
+      l2cb.ble_round_robin_quota = kControllerBuffers;
+    } else {
+      for (int i = 0; i < num_links; i++)
+        l2cb.lcb_pool[i].link_xmit_quota =
+            kControllerBuffers / num_links +
+            (i < kControllerBuffers % num_links ? 1 : 0);
+    }
+  } else {
+    l2cb.num_lm_acl_bufs = kControllerBuffers;
+    l2cb.controller_xmit_window = kControllerBuffers;
+    l2cb.num_links_active = num_links;
+    l2c_link_adjust_allocation();
+  }
+
+  for (int i = 0; i < num_links; i++)
+    l2c_link_check_send_pkts(&l2cb.lcb_pool[i], NULL, NULL);
+}
+
+void TearDownLinks(int num_links) {
+  for (int i = 0; i < num_links; i++)
+    list_free(l2cb.lcb_pool[i].link_xmit_data_q);
+}
+
+void CompleteOldestPacket() {
+  uint8_t event[1 + 2 * sizeof(uint16_t)];
+  uint8_t* p = event;
+  uint16_t handle = controller_buffers.front();
+  controller_buffers.pop_front();
+
+  UINT8_TO_STREAM(p, 1);
+  UINT16_TO_STREAM(p, handle);
+  UINT16_TO_STREAM(p, 1);
+  l2c_link_process_num_completed_pkts(event, sizeof(event));
+}
+
+void BM_L2capLinkScheduler(State& state, tBT_TRANSPORT transport) {
+  int num_links = state.range(0);
+  SetUpLinks(num_links, transport);
+
+  for (auto _ : state) {
+    if (controller_buffers.empty()) {
+      state.SkipWithError("scheduler stalled");
+      break;
+    }
+    CompleteOldestPacket();
+  }
+
+  // Share of the airtime given to the least served link, 1.0 is perfectly fair
+  uint64_t total = 0, least = UINT64_MAX;
+  for (int i = 0; i < num_links; i++) {
+    total += link_packets_sent[i];
+    least = std::min(least, link_packets_sent[i]);
+  }
+  state.counters["min_share"] =
+      total ? (double)least * num_links / (double)total : 0;
+  state.SetItemsProcessed(state.iterations());
+
+  TearDownLinks(num_links);
+}
+
+void BM_L2capLinkSchedulerClassic(State& state) {
+  BM_L2capLinkScheduler(state, BT_TRANSPORT_BR_EDR);
+}
+
+void BM_L2capLinkSchedulerLe(State& state) {
+  BM_L2capLinkScheduler(state, BT_TRANSPORT_LE);
+}
+
+}  // namespace
+
+BENCHMARK(BM_L2capLinkSchedulerClassic)->DenseRange(2, 30, 4);
+BENCHMARK(BM_L2capLinkSchedulerLe)->DenseRange(2, 30, 4);
+
+// Simulated controller and the parts of the stack l2c_link.cc calls into
+
+const controller_t* controller_get_interface() { return FakeController(); }
+
+void bte_main_hci_send(BT_HDR* p_msg, uint16_t event) {
+  uint8_t* p = (uint8_t*)(p_msg + 1) + p_msg->offset;
+  uint16_t handle;
+
+  STREAM_TO_UINT16(handle, p);
+  controller_buffers.push_back(handle);
+  link_packets_sent[handle - kFirstHandle]++;
+}
+
+BT_HDR* l2cu_get_next_buffer_to_send(tL2C_LCB* p_lcb,
+                                     tL2C_TX_COMPLETE_CB_INFO* p_cbi) {
+  BT_HDR* p_buf = (BT_HDR*)link_packets[p_lcb - l2cb.lcb_pool];
+  uint8_t* p = (uint8_t*)(p_buf + 1);
+
+  p_cbi->cb = NULL;
+  p_buf->offset = 0;
+  p_buf->len = kPacketLen;
+  UINT16_TO_STREAM(p, p_lcb->handle);
+  return p_buf;
+}
+
+tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle) {
+  for (int i = 0; i < MAX_L2CAP_LINKS; i++) {
+    if (l2cb.lcb_pool[i].in_use && l2cb.lcb_pool[i].handle == handle)
+      return &l2cb.lcb_pool[i];
+  }
+  return NULL;
+}
+
+tBTM_STATUS BTM_ReadPowerMode(const RawAddress& remote_bda,
+                              tBTM_PM_MODE* p_mode) {
+  *p_mode = BTM_PM_STS_ACTIVE;
+  return BTM_SUCCESS;
+}
+
+void l2cu_tx_complete(tL2C_TX_COMPLETE_CB_INFO* p_cbi) {}
+void alarm_set_on_mloop(alarm_t* alarm, uint64_t interval_ms,
+                        alarm_callback_t cb, void* data) {}
+void alarm_cancel(alarm_t* alarm) {}
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+// Not reached by the benchmark
+tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr) { return NULL; }
+void btm_acl_created(const RawAddress& bda, DEV_CLASS dc, BD_NAME bdn,
+                     uint16_t hci_handle, uint8_t link_role,
+                     tBT_TRANSPORT transport) {}
+void btm_acl_removed(const RawAddress& bda, tBT_TRANSPORT transport) {}
+void btm_acl_update_busy_level(tBTM_BLI_EVENT event) {}
+void btm_ble_update_link_topology_mask(uint8_t link_role, bool increase) {}
+bool btm_dev_support_switch(const RawAddress& bd_addr) { return false; }
+void btm_sco_acl_removed(const RawAddress* bda) {}
+tBTM_STATUS btm_sec_disconnect(uint16_t handle, uint8_t reason) {
+  return BTM_SUCCESS;
+}
+tBTM_STATUS BTM_SetLinkSuperTout(const RawAddress& remote_bda,
+                                 uint16_t timeout) {
+  return BTM_SUCCESS;
+}
+void btsnd_hcic_accept_conn(const RawAddress& bd_addr, uint8_t role) {}
+void btsnd_hcic_disconnect(uint16_t handle, uint8_t reason) {}
+void btsnd_hcic_reject_conn(const RawAddress& bd_addr, uint8_t reason) {}
+bool fixed_queue_is_empty(fixed_queue_t* queue) { return true; }
+void l2c_ccb_timer_timeout(void* data) {}
+void l2c_csm_execute(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {}
+void l2c_lcb_timer_timeout(void* data) {}
+void l2c_process_held_packets(bool timed_out) {}
+tL2C_LCB* l2cu_allocate_lcb(const RawAddress& p_bd_addr, bool is_bonding,
+                            tBT_TRANSPORT transport) {
+  return NULL;
+}
+void l2cu_check_channel_congestion(tL2C_CCB* p_ccb) {}
+bool l2cu_create_conn_after_switch(tL2C_LCB* p_lcb) { return false; }
+bool l2cu_create_conn_br_edr(tL2C_LCB* p_lcb) { return false; }
+bool l2cu_create_conn_le(tL2C_LCB* p_lcb) { return false; }
+tL2C_LCB* l2cu_find_lcb_by_bd_addr(const RawAddress& p_bd_addr,
+                                   tBT_TRANSPORT transport) {
+  return NULL;
+}
+tL2C_LCB* l2cu_find_lcb_by_state(tL2C_LINK_STATE state) { return NULL; }
+uint8_t l2cu_get_conn_role(tL2C_LCB* p_this_lcb) { return HCI_ROLE_MASTER; }
+bool l2cu_lcb_disconnecting(void) { return false; }
+void l2cu_process_fixed_disc_cback(tL2C_LCB* p_lcb) {}
+void l2cu_release_ccb(tL2C_CCB* p_ccb) {}
+void l2cu_release_lcb(tL2C_LCB* p_lcb) {}
+void l2cu_send_peer_echo_req(tL2C_LCB* p_lcb, uint8_t* p_data,
+                             uint16_t data_len) {}
+void l2cu_send_peer_info_req(tL2C_LCB* p_lcb, uint16_t info_type) {}
+bool l2cu_set_acl_priority(const RawAddress& bd_addr, uint8_t priority,
+                           bool reset_after_rs) {
+  return false;
+}
+bool l2cu_start_post_bond_timer(uint16_t handle) { return false; }
+
+BENCHMARK_MAIN();
@@ -0,0 +1,449 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tests of the L2CAP HCI transmit scheduler in l2c_link.cc. The links and
+// channels are set up by l2c_utils.cc, the controller is simulated.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "btm_int.h"
+#include "device/include/controller.h"
+#include "hci/include/btsnoop.h"
+#include "hcimsgs.h"
+#include "l2c_int.h"
+#include "osi/include/allocator.h"
+#include "osi/include/fixed_queue.h"
+#include "osi/include/list.h"
+#include "stack/include/btu.h"
+
+tL2C_CB l2cb;
+tBTM_CB btm_cb;
+
+namespace {
+
+constexpr uint16_t kAclPacketSize = 1021 + HCI_DATA_PREAMBLE_SIZE;
+constexpr uint16_t kPacketLen = 100;
+constexpr uint16_t kFirstHandle = 0x0040;
+constexpr uint16_t kFixedCid = L2CAP_FIRST_FIXED_CHNL;
+
+// Handles of the packets sent to the controller, in order
+std::vector<uint16_t> sent_handles;
+
+uint16_t get_acl_packet_size() { return kAclPacketSize; }
+uint16_t get_acl_data_size() { return kAclPacketSize - HCI_DATA_PREAMBLE_SIZE; }
+uint16_t get_ble_default_data_packet_length() { return 27; }
+
+const controller_t* FakeController() {
+  static controller_t controller = [] {
+    controller_t c = {};
+    c.get_acl_packet_size_classic = get_acl_packet_size;
+    c.get_acl_packet_size_ble = get_acl_packet_size;
+    c.get_acl_data_size_classic = get_acl_data_size;
+    c.get_acl_data_size_ble = get_acl_data_size;
+    c.get_ble_default_data_packet_length = get_ble_default_data_packet_length;
+    return c;
+  }();
+  return &controller;
+}
+
+// An HCI ACL packet as queued on the link by l2c_link_check_send_pkts()
+BT_HDR* MakeAclPacket(uint16_t handle) {
+  BT_HDR* p_buf = (BT_HDR*)osi_calloc(sizeof(BT_HDR) + kPacketLen);
+  uint8_t* p = (uint8_t*)(p_buf + 1);
+
+  UINT16_TO_STREAM(p, handle);
+  p_buf->len = kPacketLen;
+  return p_buf;
+}
+
+// An L2CAP SDU as queued on a channel, with room for the HCI header
+BT_HDR* MakeSdu() {
+  BT_HDR* p_buf =
+      (BT_HDR*)osi_calloc(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + kPacketLen);
+
+  p_buf->offset = L2CAP_MIN_OFFSET;
+  p_buf->len = kPacketLen;
+  return p_buf;
+}
+
+// Scheduler queues must stay doubly linked whatever happens to their links
+std::vector<tL2C_LCB*> QueueLinks(const tL2C_LINK_Q& q) {
+  std::vector<tL2C_LCB*> links;
+  tL2C_LCB* p_prev = NULL;
+
+  for (tL2C_LCB* p_lcb = q.p_first; p_lcb != NULL;
+       p_lcb = p_lcb->p_sched_next) {
+    EXPECT_EQ(p_prev, p_lcb->p_sched_prev);
+    links.push_back(p_lcb);
+    p_prev = p_lcb;
+  }
+  EXPECT_EQ(p_prev, q.p_last);
+  return links;
+}
+
+void CompletePackets(uint16_t handle, uint16_t num_packets) {
+  uint8_t event[1 + 2 * sizeof(uint16_t)];
+  uint8_t* p = event;
+
+  UINT8_TO_STREAM(p, 1);
+  UINT16_TO_STREAM(p, handle);
+  UINT16_TO_STREAM(p, num_packets);
+  l2c_link_process_num_completed_pkts(event, sizeof(event));
+}
+
+class L2capLinkSchedTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    memset(&l2cb, 0, sizeof(l2cb));
+    for (int xx = 0; xx < MAX_L2CAP_CHANNELS - 1; xx++)
+      l2cb.ccb_pool[xx].p_next_ccb = &l2cb.ccb_pool[xx + 1];
+    l2cb.p_free_ccb_first = &l2cb.ccb_pool[0];
+    l2cb.p_free_ccb_last = &l2cb.ccb_pool[MAX_L2CAP_CHANNELS - 1];
+    l2cb.non_flushable_pbf = L2CAP_PKT_START << L2CAP_PKT_TYPE_SHIFT;
+    // Not shared with BR/EDR
+    l2cb.num_lm_ble_bufs = 4;
+    sent_handles.clear();
+  }
+
+  void TearDown() override {
+    for (int i = 0; i < MAX_L2CAP_LINKS; i++) {
+      if (l2cb.lcb_pool[i].in_use) l2cu_release_lcb(&l2cb.lcb_pool[i]);
+    }
+  }
+
+  void SetControllerBuffers(uint16_t num_bufs) {
+    l2cb.num_lm_acl_bufs = num_bufs;
+    l2cb.controller_xmit_window = num_bufs;
+  }
+
+  tL2C_LCB* Connect(uint8_t id,
+                    tBT_TRANSPORT transport = BT_TRANSPORT_BR_EDR) {
+    RawAddress bd_addr = RawAddress::kEmpty;
+    bd_addr.address[5] = id;
+
+    tL2C_LCB* p_lcb = l2cu_allocate_lcb(bd_addr, false, transport);
+    EXPECT_NE(nullptr, p_lcb);
+    p_lcb->link_state = LST_CONNECTED;
+    p_lcb->handle = kFirstHandle + id;
+    return p_lcb;
+  }
+
+  // Only LE links are ever round-robin: l2c_link_adjust_allocation() gives
+  // every BR/EDR link at least one buffer. l2c_ble_link_adjust_allocation()
+  // is not linked in, this sets up the LE links the way it does when some of
+  // the LE buffers are held for high priority links.
+  void SetLeRoundRobin(uint16_t num_bufs, uint16_t rr_quota) {
+    l2cb.controller_le_xmit_window = num_bufs;
+    l2cb.ble_round_robin_quota = rr_quota;
+    for (int i = 0; i < MAX_L2CAP_LINKS; i++) {
+      tL2C_LCB* p_lcb = &l2cb.lcb_pool[i];
+      if (p_lcb->in_use && p_lcb->transport == BT_TRANSPORT_LE)
+        p_lcb->link_xmit_quota = 0;
+    }
+  }
+
+  // Queues packets on the links without serving them, so that the scheduler
+  // sees all of them on its next run
+  void QueuePackets(tL2C_LCB* p_lcb, int num_packets) {
+    uint16_t window = l2cb.controller_xmit_window;
+    uint16_t le_window = l2cb.controller_le_xmit_window;
+
+    l2cb.controller_xmit_window = l2cb.controller_le_xmit_window = 0;
+    for (int i = 0; i < num_packets; i++)
+      l2c_link_check_send_pkts(p_lcb, NULL, MakeAclPacket(p_lcb->handle));
+    l2cb.controller_xmit_window = window;
+    l2cb.controller_le_xmit_window = le_window;
+  }
+
+  void Serve() { l2c_link_check_send_pkts(NULL, NULL, NULL); }
+};
+
+TEST_F(L2capLinkSchedTest, rr_link_waits_for_quota_and_wakes_in_order) {
+  tL2C_LCB* p_a = Connect(0, BT_TRANSPORT_LE);
+  tL2C_LCB* p_b = Connect(1, BT_TRANSPORT_LE);
+  tL2C_LCB* p_c = Connect(2, BT_TRANSPORT_LE);
+  SetLeRoundRobin(4, 2);
+
+  QueuePackets(p_a, 2);
+  QueuePackets(p_b, 2);
+  QueuePackets(p_c, 2);
+  Serve();
+
+  // Every link found the round-robin quota used up after A and B sent, even
+  // though the controller has room left
+  EXPECT_EQ(std::vector<uint16_t>({p_a->handle, p_b->handle}), sent_handles);
+  EXPECT_EQ(2, l2cb.controller_le_xmit_window);
+  EXPECT_EQ(nullptr, l2cb.ble_ready_links.p_first);
+  EXPECT_EQ(std::vector<tL2C_LCB*>({p_c, p_a, p_b}),
+            QueueLinks(l2cb.ble_rr_wait_links));
+  EXPECT_EQ(L2C_LINK_SCHED_RR_WAIT, p_a->sched_state);
+
+  // Each completed packet wakes the link that has waited longest, the link
+  // whose packet completed keeps its place. The woken link sends one packet
+  // and waits again at the tail.
+  CompletePackets(p_a->handle, 1);
+  EXPECT_EQ(std::vector<uint16_t>({p_a->handle, p_b->handle, p_c->handle}),
+            sent_handles);
+  EXPECT_EQ(std::vector<tL2C_LCB*>({p_a, p_b, p_c}),
+            QueueLinks(l2cb.ble_rr_wait_links));
+
+  CompletePackets(p_b->handle, 1);
+  EXPECT_EQ(p_a->handle, sent_handles.back());
+  EXPECT_EQ(std::vector<tL2C_LCB*>({p_b, p_c, p_a}),
+            QueueLinks(l2cb.ble_rr_wait_links));
+
+  CompletePackets(p_c->handle, 1);
+  CompletePackets(p_a->handle, 1);
+  EXPECT_EQ(std::vector<uint16_t>({p_a->handle, p_b->handle, p_c->handle,
+                                   p_a->handle, p_b->handle, p_c->handle}),
+            sent_handles);
+  EXPECT_EQ(2, l2cb.ble_round_robin_unacked);
+  EXPECT_EQ(nullptr, l2cb.ble_ready_links.p_first);
+}
+
+TEST_F(L2capLinkSchedTest, quota_link_leaves_and_reenters_ready_queue) {
+  SetControllerBuffers(4);
+  tL2C_LCB* p_a = Connect(0);
+  tL2C_LCB* p_b = Connect(1);
+  ASSERT_EQ(2, p_a->link_xmit_quota);
+
+  QueuePackets(p_a, 3);
+  QueuePackets(p_b, 1);
+  Serve();
+
+  // A sent its quota in one turn and left the queue, B was served after it
+  EXPECT_EQ(std::vector<uint16_t>({p_a->handle, p_a->handle, p_b->handle}),
+            sent_handles);
+  EXPECT_EQ(L2C_LINK_SCHED_IDLE, p_a->sched_state);
+  EXPECT_EQ(1u, list_length(p_a->link_xmit_data_q));
+  for (tL2C_LCB* p_lcb : QueueLinks(l2cb.ready_links))
+    EXPECT_NE(p_a, p_lcb);
+
+  // Its completed packet puts A back on the queue
+  CompletePackets(p_a->handle, 1);
+  EXPECT_EQ(p_a->handle, sent_handles.back());
+  EXPECT_TRUE(list_is_empty(p_a->link_xmit_data_q));
+  EXPECT_EQ(2, p_a->sent_not_acked);
+  EXPECT_EQ(4u, sent_handles.size());
+}
+
+TEST_F(L2capLinkSchedTest, release_lcb_unlinks_queued_link) {
+  tL2C_LCB* p_a = Connect(0, BT_TRANSPORT_LE);
+  tL2C_LCB* p_b = Connect(1, BT_TRANSPORT_LE);
+  tL2C_LCB* p_c = Connect(2, BT_TRANSPORT_LE);
+  SetLeRoundRobin(4, 1);
+  SetControllerBuffers(2);
+  tL2C_LCB* p_d = Connect(3);
+  tL2C_LCB* p_e = Connect(4);
+
+  QueuePackets(p_a, 1);
+  QueuePackets(p_b, 1);
+  QueuePackets(p_c, 1);
+  Serve();
+  QueuePackets(p_d, 1);
+  QueuePackets(p_e, 1);
+  ASSERT_EQ(std::vector<tL2C_LCB*>({p_b, p_c, p_a}),
+            QueueLinks(l2cb.ble_rr_wait_links));
+  ASSERT_EQ(std::vector<tL2C_LCB*>({p_d, p_e}), QueueLinks(l2cb.ready_links));
+
+  // One link in the middle of the round-robin wait queue, one at the head of
+  // the ready queue
+  l2cu_release_lcb(p_c);
+  l2cu_release_lcb(p_d);
+  EXPECT_EQ(L2C_LINK_SCHED_IDLE, p_c->sched_state);
+  EXPECT_EQ(nullptr, p_c->p_sched_next);
+  EXPECT_EQ(nullptr, p_c->p_sched_prev);
+  EXPECT_EQ(L2C_LINK_SCHED_IDLE, p_d->sched_state);
+  EXPECT_EQ(std::vector<tL2C_LCB*>({p_b, p_a}),
+            QueueLinks(l2cb.ble_rr_wait_links));
+  EXPECT_EQ(std::vector<tL2C_LCB*>({p_e}), QueueLinks(l2cb.ready_links));
+
+  // The released link's packet is gone, the remaining links are served
+  CompletePackets(p_a->handle, 1);
+  Serve();
+  EXPECT_EQ(std::vector<uint16_t>({p_a->handle, p_b->handle, p_e->handle}),
+            sent_handles);
+  EXPECT_EQ(std::vector<tL2C_LCB*>({p_a, p_b}),
+            QueueLinks(l2cb.ble_rr_wait_links));
+
+  // A new link reuses the slot of a released one
+  tL2C_LCB* p_f = Connect(5, BT_TRANSPORT_LE);
+  EXPECT_EQ(p_c, p_f);
+  EXPECT_EQ(L2C_LINK_SCHED_IDLE, p_f->sched_state);
+  p_f->link_xmit_quota = 0;
+  QueuePackets(p_f, 1);
+  EXPECT_EQ(std::vector<tL2C_LCB*>({p_f}), QueueLinks(l2cb.ble_ready_links));
+
+  CompletePackets(p_b->handle, 1);
+  EXPECT_EQ(p_f->handle, sent_handles.back());
+  EXPECT_EQ(4u, sent_handles.size());
+}
+
+// The fixed channel TX complete callback queues a packet on another link, and
+// so runs the scheduler while it is serving the first link
+tL2C_LCB* p_reentry_lcb;
+int tx_complete_count;
+
+void FixedChannelConnected(uint16_t chan, const RawAddress& bd_addr,
+                           bool connected, uint16_t reason,
+                           tBT_TRANSPORT transport) {}
+
+void ReenterOnTxComplete(uint16_t cid, uint16_t num_sdu) {
+  if (tx_complete_count++ == 0)
+    l2c_link_check_send_pkts(p_reentry_lcb, NULL,
+                             MakeAclPacket(p_reentry_lcb->handle));
+}
+
+TEST_F(L2capLinkSchedTest, reentry_from_tx_complete_callback) {
+  SetControllerBuffers(4);
+  tL2C_LCB* p_a = Connect(0);
+  tL2C_LCB* p_b = Connect(1);
+  ASSERT_EQ(2, p_a->link_xmit_quota);
+
+  tL2CAP_FIXED_CHNL_REG& reg =
+      l2cb.fixed_reg[kFixedCid - L2CAP_FIRST_FIXED_CHNL];
+  reg.pL2CA_FixedConn_Cb = FixedChannelConnected;
+  reg.pL2CA_FixedTxComplete_Cb = ReenterOnTxComplete;
+  ASSERT_TRUE(l2cu_initialize_fixed_ccb(p_a, kFixedCid, NULL));
+  tL2C_CCB* p_ccb = p_a->p_fixed_ccbs[kFixedCid - L2CAP_FIRST_FIXED_CHNL];
+  p_ccb->xmit_hold_q = fixed_queue_new(SIZE_MAX);
+  fixed_queue_enqueue(p_ccb->xmit_hold_q, MakeSdu());
+  fixed_queue_enqueue(p_ccb->xmit_hold_q, MakeSdu());
+  p_reentry_lcb = p_b;
+  tx_complete_count = 0;
+
+  l2c_link_check_send_pkts(p_a, NULL, NULL);
+
+  // The nested run finished A's turn and served B, the outer run must neither
+  // send again nor put A back on the queue
+  EXPECT_EQ(std::vector<uint16_t>({p_a->handle, p_a->handle, p_b->handle}),
+            sent_handles);
+  EXPECT_EQ(2, tx_complete_count);
+  EXPECT_EQ(2, p_a->sent_not_acked);
+  EXPECT_EQ(1, p_b->sent_not_acked);
+  EXPECT_EQ(L2C_LINK_SCHED_IDLE, p_a->sched_state);
+  EXPECT_EQ(L2C_LINK_SCHED_IDLE, p_b->sched_state);
+  EXPECT_TRUE(QueueLinks(l2cb.ready_links).empty());
+
+  CompletePackets(p_a->handle, 2);
+  EXPECT_EQ(3u, sent_handles.size());
+  EXPECT_EQ(0, p_a->sent_not_acked);
+}
+
+}  // namespace
+
+// Simulated controller and the parts of the stack the L2CAP link code calls
+
+const controller_t* controller_get_interface() { return FakeController(); }
+
+void bte_main_hci_send(BT_HDR* p_msg, uint16_t event) {
+  uint8_t* p = (uint8_t*)(p_msg + 1) + p_msg->offset;
+  uint16_t handle;
+
+  STREAM_TO_UINT16(handle, p);
+  sent_handles.push_back(handle & HCI_DATA_HANDLE_MASK);
+  osi_free(p_msg);
+}
+
+tBTM_STATUS BTM_ReadPowerMode(const RawAddress& remote_bda,
+                              tBTM_PM_MODE* p_mode) {
+  *p_mode = BTM_PM_STS_ACTIVE;
+  return BTM_SUCCESS;
+}
+
+alarm_t* alarm_new(const char* name) { return NULL; }
+void alarm_free(alarm_t* alarm) {}
+void alarm_set_on_mloop(alarm_t* alarm, uint64_t interval_ms,
+                        alarm_callback_t cb, void* data) {}
+void alarm_cancel(alarm_t* alarm) {}
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+uint8_t appl_trace_level = BT_TRACE_LEVEL_WARNING;
+
+static void capture(const BT_HDR*, bool) {}
+static void whitelist_l2c_channel(uint16_t, uint16_t, uint16_t) {}
+static void whitelist_rfc_dlci(uint16_t, uint8_t) {}
+static void add_rfc_l2c_channel(uint16_t, uint16_t, uint16_t) {}
+static void clear_l2cap_whitelist(uint16_t, uint16_t, uint16_t) {}
+static const btsnoop_t fake_snoop = {capture, whitelist_l2c_channel,
+                                     whitelist_rfc_dlci, add_rfc_l2c_channel,
+                                     clear_l2cap_whitelist};
+const btsnoop_t* btsnoop_get_interface() { return &fake_snoop; }
+
+// Not reached by the tests
+uint16_t BTM_GetNumAclLinks(void) { return 0; }
+tBTM_INQ_INFO* BTM_InqDbRead(const RawAddress& p_bda) { return NULL; }
+void BTM_ReadDevInfo(const RawAddress& remote_bda, tBT_DEVICE_TYPE* p_dev_type,
+                     tBLE_ADDR_TYPE* p_addr_type) {}
+uint8_t* BTM_ReadLocalFeatures(void) { return NULL; }
+tBTM_STATUS BTM_SetLinkSuperTout(const RawAddress& remote_bda,
+                                 uint16_t timeout) {
+  return BTM_SUCCESS;
+}
+tBTM_STATUS BTM_SwitchRole(const RawAddress& remote_bd_addr, uint8_t new_role,
+                           tBTM_CMPL_CB* p_cb) {
+  return BTM_SUCCESS;
+}
+void BTM_VendorSpecificCommand(uint16_t opcode, uint8_t param_len,
+                               uint8_t* p_param_buf, tBTM_VSC_CMPL_CB* p_cb) {}
+void L2CA_FreeLePSM(uint16_t psm) {}
+void btm_acl_created(const RawAddress& bda, DEV_CLASS dc, BD_NAME bdn,
+                     uint16_t hci_handle, uint8_t link_role,
+                     tBT_TRANSPORT transport) {}
+void btm_acl_removed(const RawAddress& bda, tBT_TRANSPORT transport) {}
+void btm_acl_update_busy_level(tBTM_BLI_EVENT event) {}
+void btm_ble_update_link_topology_mask(uint8_t link_role, bool increase) {}
+bool btm_dev_support_switch(const RawAddress& bd_addr) { return false; }
+tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr) { return NULL; }
+uint16_t btm_get_max_packet_size(const RawAddress& addr) { return 0; }
+bool btm_is_sco_active_by_bdaddr(const RawAddress& remote_bda) {
+  return false;
+}
+void btm_remove_sco_links(const RawAddress& bda) {}
+void btm_sco_acl_removed(const RawAddress* bda) {}
+uint8_t btm_sec_clr_service_by_psm(uint16_t psm) { return 0; }
+void btm_sec_clr_temp_auth_service(const RawAddress& bda) {}
+tBTM_STATUS btm_sec_disconnect(uint16_t handle, uint8_t reason) {
+  return BTM_SUCCESS;
+}
+void btsnd_hcic_accept_conn(const RawAddress& bd_addr, uint8_t role) {}
+void btsnd_hcic_create_conn(const RawAddress& dest, uint16_t packet_types,
+                            uint8_t page_scan_rep_mode, uint8_t page_scan_mode,
+                            uint16_t clock_offset, uint8_t allow_switch) {}
+void btsnd_hcic_disconnect(uint16_t handle, uint8_t reason) {}
+void btsnd_hcic_reject_conn(const RawAddress& bd_addr, uint8_t reason) {}
+void btsnd_hcic_write_auto_flush_tout(uint16_t handle, uint16_t timeout) {}
+void l2c_ble_link_adjust_allocation(void) {}
+void l2c_ccb_timer_timeout(void* data) {}
+void l2c_csm_execute(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {}
+void l2c_fcr_adj_our_rsp_options(tL2C_CCB* p_ccb, tL2CAP_CFG_INFO* p_cfg) {}
+void l2c_fcr_cleanup(tL2C_CCB* p_ccb) {}
+BT_HDR* l2c_fcr_get_next_xmit_sdu_seg(tL2C_CCB* p_ccb,
+                                      uint16_t max_packet_length) {
+  return NULL;
+}
+bool l2c_fcr_is_flow_controlled(tL2C_CCB* p_ccb) { return false; }
+uint8_t l2c_fcr_process_peer_cfg_req(tL2C_CCB* p_ccb, tL2CAP_CFG_INFO* p_cfg) {
+  return 0;
+}
+void l2c_lcb_timer_timeout(void* data) {}
+BT_HDR* l2c_lcc_get_next_xmit_sdu_seg(tL2C_CCB* p_ccb,
+                                      bool* last_piece_of_sdu) {
+  return NULL;
+}
+void l2c_process_held_packets(bool timed_out) {}
+bool l2cble_create_conn(tL2C_LCB* p_lcb) { return false; }
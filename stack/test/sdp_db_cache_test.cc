@@ -0,0 +1,149 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "stack/sdp/sdp_db_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using bluetooth::Uuid;
+
+namespace {
+
+constexpr size_t kMaxRecords = 8;
+
+const Uuid kL2cap = Uuid::From16Bit(0x0100);
+const Uuid kRfcomm = Uuid::From16Bit(0x0003);
+const Uuid kAudioSink = Uuid::From16Bit(0x110b);
+const Uuid kAvrcp = Uuid::From16Bit(0x110e);
+
+SdpDbCache::Entries MakeEntries(uint32_t record_handle,
+                                std::vector<std::vector<uint8_t>> attributes) {
+  SdpDbCache::Entries entries;
+  entries.record_handle = record_handle;
+  for (const auto& attribute : attributes) {
+    entries.offsets.push_back(entries.data.size());
+    entries.data.insert(entries.data.end(), attribute.begin(),
+                        attribute.end());
+  }
+  entries.offsets.push_back(entries.data.size());
+  return entries;
+}
+
+}  // namespace
+
+TEST(SdpDbCacheTest, find_records_with_all_uuids) {
+  SdpDbCache cache(kMaxRecords);
+  EXPECT_FALSE(cache.IsIndexValid());
+
+  cache.ClearIndex();
+  cache.AddUuid(0, kL2cap);
+  cache.AddUuid(0, kAudioSink);
+  cache.AddUuid(2, kL2cap);
+  cache.AddUuid(2, kRfcomm);
+  cache.AddUuid(5, kL2cap);
+  cache.AddUuid(5, kAudioSink);
+  cache.IndexBuilt();
+  EXPECT_TRUE(cache.IsIndexValid());
+
+  EXPECT_EQ(0u, cache.FindRecord(0, {kL2cap}));
+  EXPECT_EQ(2u, cache.FindRecord(1, {kL2cap}));
+  EXPECT_EQ(5u, cache.FindRecord(3, {kL2cap}));
+  EXPECT_EQ(SdpDbCache::NOT_FOUND, cache.FindRecord(6, {kL2cap}));
+
+  EXPECT_EQ(0u, cache.FindRecord(0, {kAudioSink, kL2cap}));
+  EXPECT_EQ(5u, cache.FindRecord(1, {kAudioSink, kL2cap}));
+  EXPECT_EQ(2u, cache.FindRecord(0, {kRfcomm}));
+  EXPECT_EQ(SdpDbCache::NOT_FOUND, cache.FindRecord(0, {kRfcomm, kAudioSink}));
+  EXPECT_EQ(SdpDbCache::NOT_FOUND, cache.FindRecord(0, {kAvrcp}));
+}
+
+TEST(SdpDbCacheTest, uuids_compare_in_128_bit_form) {
+  SdpDbCache cache(kMaxRecords);
+  cache.ClearIndex();
+  cache.AddUuid(3, Uuid::From32Bit(0x0000110b));
+  cache.IndexBuilt();
+
+  EXPECT_EQ(3u, cache.FindRecord(0, {kAudioSink}));
+}
+
+TEST(SdpDbCacheTest, database_changes_invalidate_index) {
+  SdpDbCache cache(kMaxRecords);
+  cache.ClearIndex();
+  cache.IndexBuilt();
+
+  cache.InvalidateRecord(1);
+  EXPECT_FALSE(cache.IsIndexValid());
+
+  cache.ClearIndex();
+  cache.IndexBuilt();
+  cache.RemoveRecord(1);
+  EXPECT_FALSE(cache.IsIndexValid());
+
+  cache.ClearIndex();
+  cache.IndexBuilt();
+  cache.Clear();
+  EXPECT_FALSE(cache.IsIndexValid());
+}
+
+TEST(SdpDbCacheTest, entries_kept_until_record_changes) {
+  SdpDbCache cache(kMaxRecords);
+  EXPECT_EQ(nullptr, cache.GetEntries(0, 0x10000));
+
+  const SdpDbCache::Entries& set =
+      cache.SetEntries(0, MakeEntries(0x10000, {{1, 2, 3}, {4, 5}}));
+  EXPECT_EQ(std::vector<uint16_t>({0, 3, 5}), set.offsets);
+
+  const SdpDbCache::Entries* entries = cache.GetEntries(0, 0x10000);
+  ASSERT_NE(nullptr, entries);
+  EXPECT_EQ(std::vector<uint8_t>({1, 2, 3, 4, 5}), entries->data);
+
+  /* Another record now lives in the slot */
+  EXPECT_EQ(nullptr, cache.GetEntries(0, 0x10001));
+
+  cache.InvalidateRecord(0);
+  EXPECT_EQ(nullptr, cache.GetEntries(0, 0x10000));
+}
+
+TEST(SdpDbCacheTest, remove_record_moves_following_entries_up) {
+  SdpDbCache cache(kMaxRecords);
+  cache.SetEntries(0, MakeEntries(0x10000, {{0}}));
+  cache.SetEntries(1, MakeEntries(0x10001, {{1}}));
+  cache.SetEntries(2, MakeEntries(0x10002, {{2}}));
+
+  cache.RemoveRecord(1);
+  ASSERT_NE(nullptr, cache.GetEntries(0, 0x10000));
+  EXPECT_EQ(nullptr, cache.GetEntries(1, 0x10001));
+  const SdpDbCache::Entries* entries = cache.GetEntries(1, 0x10002);
+  ASSERT_NE(nullptr, entries);
+  EXPECT_EQ(std::vector<uint8_t>({2}), entries->data);
+  EXPECT_EQ(nullptr, cache.GetEntries(2, 0x10002));
+}
+
+TEST(SdpDbCacheTest, clear) {
+  SdpDbCache cache(kMaxRecords);
+  cache.SetEntries(0, MakeEntries(0x10000, {{0}}));
+  cache.ClearIndex();
+  cache.AddUuid(0, kL2cap);
+  cache.IndexBuilt();
+
+  cache.Clear();
+  EXPECT_EQ(nullptr, cache.GetEntries(0, 0x10000));
+  EXPECT_EQ(SdpDbCache::NOT_FOUND, cache.FindRecord(0, {kL2cap}));
+}
@@ -0,0 +1,348 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+// Tests of the SDP server database in sdp_db.cc, through the database
+// maintenance API and the lookups the SDP server uses.
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <vector>
+
+#include "osi/include/allocator.h"
+#include "sdp_api.h"
+#include "sdpdefs.h"
+#include "sdpint.h"
+
+tSDP_CB sdp_cb;
+
+namespace {
+
+// Returns the ids and the values of the attributes of a record
+std::vector<uint16_t> AttributeIds(uint32_t handle) {
+  std::vector<uint16_t> ids;
+  tSDP_RECORD* p_rec = sdp_db_find_record(handle);
+  for (uint16_t xx = 0; xx < p_rec->num_attributes; xx++)
+    ids.push_back(p_rec->attribute[xx].id);
+  return ids;
+}
+
+std::vector<uint8_t> AttributeValue(uint32_t handle, uint16_t attr_id) {
+  tSDP_RECORD* p_rec = sdp_db_find_record(handle);
+  tSDP_ATTRIBUTE* p_attr = sdp_db_find_attr_in_rec(p_rec, attr_id, attr_id);
+  if (p_attr == NULL) return {};
+  return std::vector<uint8_t>(p_attr->value_ptr,
+                              p_attr->value_ptr + p_attr->len);
+}
+
+// A 16-bit UUID as found in a request, in its 2, 4 or 16 byte big endian form
+tUID_ENT MakeUid(uint16_t uuid16, uint16_t len = 2) {
+  static const uint8_t kBaseUuid[16] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                        0x10, 0x00, 0x80, 0x00, 0x00, 0x80,
+                                        0x5F, 0x9B, 0x34, 0xFB};
+  tUID_ENT uid = {};
+  uint8_t* p = uid.value;
+
+  uid.len = len;
+  if (len == 2) {
+    UINT16_TO_BE_STREAM(p, uuid16);
+  } else {
+    memcpy(uid.value, kBaseUuid, len);
+    p += 2;
+    UINT16_TO_BE_STREAM(p, uuid16);
+  }
+  return uid;
+}
+
+// Handles of all the records matching a search, as a Service Search request
+// and its continuations walk them
+std::vector<uint32_t> Search(std::vector<tUID_ENT> uids) {
+  tSDP_UUID_SEQ seq = {};
+  std::vector<uint32_t> handles;
+
+  seq.num_uids = uids.size();
+  for (size_t xx = 0; xx < uids.size(); xx++) seq.uuid_entry[xx] = uids[xx];
+
+  for (tSDP_RECORD* p_rec = sdp_db_service_search(NULL, &seq); p_rec != NULL;
+       p_rec = sdp_db_service_search(p_rec, &seq))
+    handles.push_back(p_rec->record_handle);
+  return handles;
+}
+
+// The attribute entry as serialized without the cache
+std::vector<uint8_t> Entry(tSDP_ATTRIBUTE* p_attr) {
+  std::vector<uint8_t> entry(sdpu_get_attrib_entry_len(p_attr));
+  sdpu_build_attrib_entry(entry.data(), p_attr);
+  return entry;
+}
+
+// Copies an attribute entry out from |offset| on, |len| bytes at a time, as
+// an attribute response and its continuations do
+std::vector<uint8_t> BuildEntry(tSDP_RECORD* p_rec, tSDP_ATTRIBUTE* p_attr,
+                                uint16_t len, uint16_t* offset) {
+  std::vector<uint8_t> entry;
+  std::vector<uint8_t> buf(len);
+
+  for (;;) {
+    uint8_t* p_end =
+        sdp_db_build_attrib_entry(buf.data(), p_rec, p_attr, len, offset);
+    if (p_end == buf.data()) break;
+    entry.insert(entry.end(), buf.data(), p_end);
+  }
+  return entry;
+}
+
+class SdpDbTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    memset(&sdp_cb, 0, sizeof(sdp_cb));
+    SDP_DeleteRecord(0);
+  }
+
+  void TearDown() override { SDP_DeleteRecord(0); }
+
+  // Adds a text attribute holding |value|
+  bool AddText(uint32_t handle, uint16_t attr_id, const char* value) {
+    return SDP_AddAttribute(handle, attr_id, TEXT_STR_DESC_TYPE,
+                            strlen(value), (uint8_t*)value);
+  }
+
+  std::vector<uint8_t> Text(const char* value) {
+    return std::vector<uint8_t>(value, value + strlen(value));
+  }
+
+  // Adds a record for a service running over L2CAP and |protocol_uuid|
+  uint32_t AddService(uint16_t service_uuid, uint16_t protocol_uuid) {
+    uint32_t handle = SDP_CreateRecord();
+    tSDP_PROTOCOL_ELEM protocols[2] = {};
+
+    protocols[0].protocol_uuid = UUID_PROTOCOL_L2CAP;
+    protocols[0].num_params = 1;
+    protocols[0].params[0] = 0x0019;
+    protocols[1].protocol_uuid = protocol_uuid;
+    EXPECT_TRUE(SDP_AddServiceClassIdList(handle, 1, &service_uuid));
+    EXPECT_TRUE(SDP_AddProtocolList(handle, 2, protocols));
+    return handle;
+  }
+};
+
+}  // namespace
+
+TEST_F(SdpDbTest, delete_attribute_in_later_record) {
+  SDP_CreateRecord();
+  SDP_CreateRecord();
+  uint32_t handle = SDP_CreateRecord();
+  ASSERT_NE(0u, handle);
+  ASSERT_TRUE(AddText(handle, 0x0100, "first"));
+  ASSERT_TRUE(AddText(handle, 0x0101, "second"));
+  ASSERT_TRUE(AddText(handle, 0x0102, "third"));
+  ASSERT_TRUE(AddText(handle, 0x0103, "fourth"));
+
+  // The record is in the third slot, and the attribute comes before that
+  // index in the record: every attribute after it moves up
+  ASSERT_TRUE(SDP_DeleteAttribute(handle, 0x0100));
+
+  EXPECT_EQ(std::vector<uint16_t>({ATTR_ID_SERVICE_RECORD_HDL, 0x0101, 0x0102,
+                                   0x0103}),
+            AttributeIds(handle));
+  EXPECT_EQ(Text("second"), AttributeValue(handle, 0x0101));
+  EXPECT_EQ(Text("third"), AttributeValue(handle, 0x0102));
+  EXPECT_EQ(Text("fourth"), AttributeValue(handle, 0x0103));
+}
+
+TEST_F(SdpDbTest, delete_attribute_compacts_values) {
+  uint32_t handle = SDP_CreateRecord();
+  ASSERT_TRUE(AddText(handle, 0x0100, "first"));
+  ASSERT_TRUE(AddText(handle, 0x0101, "second"));
+  ASSERT_TRUE(AddText(handle, 0x0102, "third"));
+  tSDP_RECORD* p_rec = sdp_db_find_record(handle);
+  uint32_t free_pad_ptr = p_rec->free_pad_ptr;
+
+  ASSERT_TRUE(SDP_DeleteAttribute(handle, 0x0101));
+  EXPECT_EQ(std::vector<uint16_t>({ATTR_ID_SERVICE_RECORD_HDL, 0x0100, 0x0102}),
+            AttributeIds(handle));
+  EXPECT_EQ(Text("first"), AttributeValue(handle, 0x0100));
+  EXPECT_EQ(Text("third"), AttributeValue(handle, 0x0102));
+  EXPECT_EQ(free_pad_ptr - strlen("second"), p_rec->free_pad_ptr);
+
+  // The freed space is reused
+  ASSERT_TRUE(AddText(handle, 0x0103, "fourth"));
+  EXPECT_EQ(Text("first"), AttributeValue(handle, 0x0100));
+  EXPECT_EQ(Text("third"), AttributeValue(handle, 0x0102));
+  EXPECT_EQ(Text("fourth"), AttributeValue(handle, 0x0103));
+}
+
+TEST_F(SdpDbTest, delete_attribute_not_found) {
+  uint32_t handle = SDP_CreateRecord();
+  ASSERT_TRUE(AddText(handle, 0x0100, "first"));
+
+  EXPECT_FALSE(SDP_DeleteAttribute(handle, 0x0101));
+  EXPECT_FALSE(SDP_DeleteAttribute(handle + 1, 0x0100));
+  EXPECT_EQ(std::vector<uint16_t>({ATTR_ID_SERVICE_RECORD_HDL, 0x0100}),
+            AttributeIds(handle));
+}
+
+TEST_F(SdpDbTest, service_search_finds_records_with_all_uuids) {
+  uint32_t sink = AddService(UUID_SERVCLASS_AUDIO_SINK, UUID_PROTOCOL_AVDTP);
+  uint32_t avrcp =
+      AddService(UUID_SERVCLASS_AV_REMOTE_CONTROL, UUID_PROTOCOL_AVCTP);
+  uint32_t spp = AddService(UUID_SERVCLASS_SERIAL_PORT, UUID_PROTOCOL_RFCOMM);
+
+  EXPECT_EQ(std::vector<uint32_t>({sink, avrcp, spp}),
+            Search({MakeUid(UUID_PROTOCOL_L2CAP)}));
+  EXPECT_EQ(std::vector<uint32_t>({avrcp}),
+            Search({MakeUid(UUID_PROTOCOL_L2CAP),
+                    MakeUid(UUID_SERVCLASS_AV_REMOTE_CONTROL)}));
+  EXPECT_TRUE(Search({MakeUid(UUID_PROTOCOL_RFCOMM),
+                      MakeUid(UUID_SERVCLASS_AUDIO_SINK)})
+                  .empty());
+
+  // Any form of a UUID matches
+  EXPECT_EQ(std::vector<uint32_t>({sink}),
+            Search({MakeUid(UUID_SERVCLASS_AUDIO_SINK, 4)}));
+  EXPECT_EQ(std::vector<uint32_t>({sink}),
+            Search({MakeUid(UUID_SERVCLASS_AUDIO_SINK, 16)}));
+  EXPECT_TRUE(Search({MakeUid(UUID_SERVCLASS_AUDIO_SINK, 3)}).empty());
+}
+
+TEST_F(SdpDbTest, service_search_follows_database_changes) {
+  uint32_t sink = AddService(UUID_SERVCLASS_AUDIO_SINK, UUID_PROTOCOL_AVDTP);
+  uint32_t avrcp =
+      AddService(UUID_SERVCLASS_AV_REMOTE_CONTROL, UUID_PROTOCOL_AVCTP);
+  EXPECT_EQ(std::vector<uint32_t>({sink}),
+            Search({MakeUid(UUID_SERVCLASS_AUDIO_SINK)}));
+
+  uint16_t service_uuid = UUID_SERVCLASS_AUDIO_SINK;
+  ASSERT_TRUE(SDP_AddServiceClassIdList(avrcp, 1, &service_uuid));
+  EXPECT_EQ(std::vector<uint32_t>({sink, avrcp}),
+            Search({MakeUid(UUID_SERVCLASS_AUDIO_SINK)}));
+  EXPECT_TRUE(Search({MakeUid(UUID_SERVCLASS_AV_REMOTE_CONTROL)}).empty());
+
+  ASSERT_TRUE(SDP_DeleteAttribute(sink, ATTR_ID_SERVICE_CLASS_ID_LIST));
+  EXPECT_EQ(std::vector<uint32_t>({avrcp}),
+            Search({MakeUid(UUID_SERVCLASS_AUDIO_SINK)}));
+
+  // The records after a deleted one move up
+  ASSERT_TRUE(SDP_DeleteRecord(sink));
+  uint32_t spp = AddService(UUID_SERVCLASS_SERIAL_PORT, UUID_PROTOCOL_RFCOMM);
+  EXPECT_EQ(std::vector<uint32_t>({avrcp, spp}),
+            Search({MakeUid(UUID_PROTOCOL_L2CAP)}));
+  EXPECT_EQ(std::vector<uint32_t>({spp}),
+            Search({MakeUid(UUID_PROTOCOL_RFCOMM)}));
+}
+
+TEST_F(SdpDbTest, build_attrib_entry_in_pieces) {
+  uint32_t handle = AddService(UUID_SERVCLASS_AUDIO_SINK, UUID_PROTOCOL_AVDTP);
+  tSDP_RECORD* p_rec = sdp_db_find_record(handle);
+  tSDP_ATTRIBUTE* p_attr = sdp_db_find_attr_in_rec(
+      p_rec, ATTR_ID_PROTOCOL_DESC_LIST, ATTR_ID_PROTOCOL_DESC_LIST);
+  ASSERT_NE(nullptr, p_attr);
+  std::vector<uint8_t> entry = Entry(p_attr);
+
+  uint16_t offset = 0;
+  EXPECT_EQ(entry, BuildEntry(p_rec, p_attr, entry.size(), &offset));
+  EXPECT_EQ(entry.size(), offset);
+
+  // A response cut after a few bytes, and its continuations
+  offset = 0;
+  EXPECT_EQ(entry, BuildEntry(p_rec, p_attr, 5, &offset));
+  EXPECT_EQ(entry.size(), offset);
+
+  // A continuation request picking up in the middle of the entry
+  offset = 7;
+  EXPECT_EQ(std::vector<uint8_t>(entry.begin() + 7, entry.end()),
+            BuildEntry(p_rec, p_attr, 3, &offset));
+}
+
+TEST_F(SdpDbTest, build_attrib_entry_follows_database_changes) {
+  uint32_t sink = AddService(UUID_SERVCLASS_AUDIO_SINK, UUID_PROTOCOL_AVDTP);
+  uint32_t avrcp =
+      AddService(UUID_SERVCLASS_AV_REMOTE_CONTROL, UUID_PROTOCOL_AVCTP);
+  tSDP_RECORD* p_rec = sdp_db_find_record(avrcp);
+  tSDP_ATTRIBUTE* p_attr = sdp_db_find_attr_in_rec(
+      p_rec, ATTR_ID_SERVICE_CLASS_ID_LIST, ATTR_ID_SERVICE_CLASS_ID_LIST);
+  uint16_t offset = 0;
+  EXPECT_EQ(Entry(p_attr), BuildEntry(p_rec, p_attr, 64, &offset));
+
+  // A changed attribute is served with its new value
+  uint16_t service_uuids[] = {UUID_SERVCLASS_AV_REMOTE_CONTROL,
+                              UUID_SERVCLASS_AUDIO_SINK};
+  ASSERT_TRUE(SDP_AddServiceClassIdList(avrcp, 2, service_uuids));
+  p_attr = sdp_db_find_attr_in_rec(p_rec, ATTR_ID_SERVICE_CLASS_ID_LIST,
+                                   ATTR_ID_SERVICE_CLASS_ID_LIST);
+  offset = 0;
+  EXPECT_EQ(Entry(p_attr), BuildEntry(p_rec, p_attr, 64, &offset));
+
+  // The record moves up a slot when the one before it is deleted
+  ASSERT_TRUE(SDP_DeleteRecord(sink));
+  p_rec = sdp_db_find_record(avrcp);
+  p_attr = sdp_db_find_attr_in_rec(p_rec, ATTR_ID_SERVICE_RECORD_HDL,
+                                   ATTR_ID_SERVICE_RECORD_HDL);
+  offset = 0;
+  EXPECT_EQ(Entry(p_attr), BuildEntry(p_rec, p_attr, 64, &offset));
+}
+
+TEST_F(SdpDbTest, build_attrib_entry_of_rewritten_attribute) {
+  uint32_t handle = AddService(UUID_SERVCLASS_AUDIO_SINK, UUID_PROTOCOL_AVDTP);
+  tSDP_RECORD* p_rec = sdp_db_find_record(handle);
+  tSDP_ATTRIBUTE* p_attr = sdp_db_find_attr_in_rec(
+      p_rec, ATTR_ID_SERVICE_CLASS_ID_LIST, ATTR_ID_SERVICE_CLASS_ID_LIST);
+  uint16_t offset = 0;
+  BuildEntry(p_rec, p_attr, 64, &offset);
+
+  // A copy of the attribute rewritten for one peer, which is not cached
+  std::vector<uint8_t> value(p_attr->value_ptr,
+                             p_attr->value_ptr + p_attr->len);
+  value.back() ^= 0xFF;
+  tSDP_ATTRIBUTE attr = *p_attr;
+  attr.value_ptr = value.data();
+
+  offset = 0;
+  EXPECT_EQ(Entry(&attr), BuildEntry(p_rec, &attr, 4, &offset));
+  EXPECT_NE(Entry(p_attr), Entry(&attr));
+}
+
+// Parts of the stack that sdp_utils.cc calls, not reached by the tests
+
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+uint8_t L2CA_DataWrite(uint16_t cid, BT_HDR* p_data) {
+  osi_free(p_data);
+  return L2CAP_DW_FAILED;
+}
+
+tSDP_DISC_ATTR* SDP_FindAttributeInRec(tSDP_DISC_REC* p_rec, uint16_t attr_id) {
+  return NULL;
+}
+
+bool SDP_FindProtocolListElemInRec(tSDP_DISC_REC* p_rec, uint16_t layer_uuid,
+                                   tSDP_PROTOCOL_ELEM* p_elem) {
+  return false;
+}
+
+uint16_t SDP_GetDiRecord(uint8_t getRecordIndex,
+                         tSDP_DI_GET_RECORD* device_info,
+                         tSDP_DISCOVERY_DB* p_db) {
+  return SDP_NO_RECS_MATCH;
+}
+
+bool btif_config_set_int(const std::string& section, const std::string& key,
+                         int value) {
+  return false;
+}
@@ -25,7 +25,9 @@
 
 #include "stack/include/a2dp_aac.h"
 #include "stack/include/a2dp_api.h"
+#include "osi/include/allocator.h"
 #include "stack/include/a2dp_codec_api.h"
+#include "stack/include/a2dp_encoder_fanout.h"
 #include "stack/include/a2dp_sbc.h"
 #include "stack/include/a2dp_vendor.h"
 
@@ -1002,3 +1004,158 @@ TEST_F(A2dpCodecConfigTest, init) {
       codecs.orderedSinkCodecs();
   EXPECT_FALSE(orderedSinkCodecs.empty());
 }
+
+namespace {
+const RawAddress kPeerAddress1({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kPeerAddress2({0x11, 0x22, 0x33, 0x44, 0x55, 0x77});
+
+// Audio input of the fan-out: the bytes 0, 1, 2, ... up to |available| bytes
+class FakeAudioInput {
+ public:
+  A2dpEncoderSession::ReadCallback Callback() {
+    return [this](uint8_t* p_buf, uint32_t len) {
+      uint32_t bytes_read = std::min(len, available);
+      for (uint32_t i = 0; i < bytes_read; i++) p_buf[i] = next_byte++;
+      available -= bytes_read;
+      total_read_bytes += bytes_read;
+      return bytes_read;
+    };
+  }
+
+  uint32_t available = UINT32_MAX;
+  uint8_t next_byte = 0;
+  size_t total_read_bytes = 0;
+};
+}  // namespace
+
+TEST_F(StackA2dpTest, test_a2dp_encoder_fanout_read) {
+  FakeAudioInput input;
+  A2dpEncoderFanout fanout(input.Callback());
+  uint8_t buf1[300];
+  uint8_t buf2[300];
+
+  // A single peer reads the audio input directly
+  fanout.AddReader(kPeerAddress1);
+  EXPECT_EQ(fanout.Read(kPeerAddress1, buf1, 100), 100u);
+  EXPECT_EQ(buf1[0], 0);
+  EXPECT_EQ(fanout.BufferedBytes(), 0u);
+
+  // The audio is read once for both peers
+  fanout.AddReader(kPeerAddress2);
+  EXPECT_TRUE(fanout.HasPeer(kPeerAddress2));
+  EXPECT_EQ(fanout.Read(kPeerAddress1, buf1, 200), 200u);
+  EXPECT_EQ(fanout.BufferedBytes(), 200u);
+  EXPECT_EQ(fanout.Read(kPeerAddress2, buf2, 150), 150u);
+  EXPECT_EQ(buf2[0], 100);
+  EXPECT_EQ(memcmp(buf1, buf2, 150), 0);
+  EXPECT_EQ(fanout.BufferedBytes(), 50u);
+  EXPECT_EQ(fanout.Read(kPeerAddress2, buf2, 100), 100u);
+  EXPECT_EQ(memcmp(buf1 + 150, buf2, 50), 0);
+  EXPECT_EQ(input.total_read_bytes, 350u);
+  EXPECT_EQ(fanout.BufferedBytes(), 50u);
+
+  // The audio not read yet by the remaining peer is kept
+  fanout.RemovePeer(kPeerAddress2);
+  EXPECT_FALSE(fanout.HasPeer(kPeerAddress2));
+  EXPECT_EQ(fanout.GetPeerStats(kPeerAddress2), nullptr);
+  EXPECT_EQ(fanout.BufferedBytes(), 50u);
+  EXPECT_EQ(fanout.Read(kPeerAddress1, buf1, 100), 100u);
+  EXPECT_EQ(buf1[0], 300 % 256);
+  EXPECT_EQ(fanout.BufferedBytes(), 0u);
+  EXPECT_EQ(input.total_read_bytes, 400u);
+  EXPECT_EQ(fanout.GetPeerStats(kPeerAddress1)->read_bytes, 400u);
+
+  // Unknown peers read nothing
+  EXPECT_EQ(fanout.Read(kPeerAddress2, buf2, 100), 0u);
+}
+
+TEST_F(StackA2dpTest, test_a2dp_encoder_fanout_stats) {
+  FakeAudioInput input;
+  A2dpEncoderFanout fanout(input.Callback());
+  uint8_t buf[64];
+
+  // The lagging peer skips what exceeds the max. buffered audio
+  fanout.AddReader(kPeerAddress1);
+  fanout.AddReader(kPeerAddress2);
+  for (size_t i = 0; i < A2dpEncoderFanout::kMaxBufferedBytes / 64 + 2; i++) {
+    EXPECT_EQ(fanout.Read(kPeerAddress1, buf, sizeof(buf)), sizeof(buf));
+  }
+  EXPECT_EQ(fanout.BufferedBytes(), A2dpEncoderFanout::kMaxBufferedBytes);
+  EXPECT_EQ(fanout.Read(kPeerAddress2, buf, sizeof(buf)), sizeof(buf));
+  EXPECT_EQ(buf[0], 128);
+  EXPECT_EQ(fanout.GetPeerStats(kPeerAddress2)->dropped_bytes, 128u);
+  EXPECT_EQ(fanout.GetPeerStats(kPeerAddress1)->dropped_bytes, 0u);
+
+  // Underflows are accounted to the peer that reads
+  input.available = 32;
+  EXPECT_EQ(fanout.Read(kPeerAddress1, buf, sizeof(buf)), 32u);
+  const A2dpEncoderFanout::PeerStats* stats =
+      fanout.GetPeerStats(kPeerAddress1);
+  EXPECT_EQ(stats->underflow_count, 1u);
+  EXPECT_EQ(stats->underflow_bytes, 32u);
+  EXPECT_EQ(fanout.GetPeerStats(kPeerAddress2)->underflow_count, 0u);
+
+  // Flushing discards the buffered audio
+  fanout.FeedingFlush();
+  EXPECT_EQ(fanout.BufferedBytes(), 0u);
+  EXPECT_EQ(fanout.Read(kPeerAddress2, buf, sizeof(buf)), 0u);
+}
+
+TEST_F(StackA2dpTest, test_a2dp_encoder_fanout_sbc_sessions) {
+  uint8_t codec_info_result[AVDT_CODEC_SIZE];
+  std::vector<btav_a2dp_codec_config_t> default_priorities;
+  A2dpCodecs a2dp_codecs(default_priorities);
+  ASSERT_TRUE(a2dp_codecs.init());
+  ASSERT_TRUE(a2dp_codecs.setCodecConfig(
+      codec_info_sbc_sink_capability, true /* is_capability */,
+      codec_info_result, true /* select_current_codec */));
+  A2dpCodecConfig* codec_config = a2dp_codecs.getCurrentCodecConfig();
+  ASSERT_NE(codec_config, nullptr);
+  const tA2DP_ENCODER_INTERFACE* encoder_interface =
+      A2DP_GetEncoderInterface(codec_info_result);
+  ASSERT_NE(encoder_interface, nullptr);
+  ASSERT_NE(encoder_interface->create_session, nullptr);
+
+  // An EDR peer, and a non-EDR peer with a smaller MTU and bitrate
+  const RawAddress peer_addresses[] = {kPeerAddress1, kPeerAddress2};
+  const tA2DP_ENCODER_INIT_PEER_PARAMS peer_params[] = {{true, true, 895},
+                                                        {false, false, 400}};
+
+  // Encodes 200 ms of audio with the encoders of |peers_n| peers, and returns
+  // the packets of each peer
+  auto encode = [&](size_t peers_n) {
+    FakeAudioInput input;
+    A2dpEncoderFanout fanout(input.Callback());
+    std::vector<std::vector<uint8_t>> packets[2];
+    for (size_t i = 0; i < peers_n; i++) {
+      EXPECT_TRUE(fanout.AddPeer(
+          peer_addresses[i], encoder_interface, &peer_params[i],
+          codec_config,
+          [&packets, i](BT_HDR* p_buf, size_t frames_n, uint32_t num_bytes) {
+            uint8_t* data = reinterpret_cast<uint8_t*>(p_buf + 1) +
+                            p_buf->offset;
+            packets[i].emplace_back(data, data + p_buf->len);
+            osi_free(p_buf);
+            return true;
+          }));
+    }
+    fanout.FeedingReset();
+    for (uint64_t timestamp_us = 20000; timestamp_us <= 200000;
+         timestamp_us += 20000) {
+      fanout.SendFrames(timestamp_us);
+    }
+    return std::vector<std::vector<std::vector<uint8_t>>>(packets,
+                                                          packets + peers_n);
+  };
+
+  auto alone = encode(1);
+  auto together = encode(2);
+  ASSERT_FALSE(alone[0].empty());
+  ASSERT_FALSE(together[1].empty());
+  // The second session doesn't change the packets of the first one
+  EXPECT_EQ(alone[0], together[0]);
+  EXPECT_NE(together[0], together[1]);
+  for (const auto& packet : together[1]) {
+    EXPECT_LE(packet.size(), peer_params[1].peer_mtu);
+  }
+}
@@ -10,6 +10,7 @@ known_tests=(
   net_test_bluetooth
   net_test_btcore
   net_test_bta
+  net_test_bta_gattc_db_hash
   net_test_btif
   net_test_btif_profile_queue
   net_test_btif_config_cache